@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/include/Atomic.h
+ */
+
+#ifndef RAM_CORE_ATOMIC_H_12_02_2010
+#define RAM_CORE_ATOMIC_H_12_02_2010
+
+// Library Includes
+#include <boost/utility.hpp>
+#include <boost/static_assert.hpp>
+
+// Project Includes
+#include "core/include/Platform.h"
+
+#if RAM_COMPILER == RAM_COMPILER_MSVC
+#   include <windows.h>
+#endif
+
+namespace ram {
+namespace core {
+
+/** How much ordering an atomic operation imposes on the memory around it
+ *
+ *  These follow the C++0x orders of the same name.  Every read-modify-write
+ *  operation is a full barrier on both compilers we support, so the order
+ *  only makes a difference to plain loads and stores.
+ */
+enum MemoryOrder
+{
+    MEMORY_ORDER_RELAXED,
+    MEMORY_ORDER_ACQUIRE,
+    MEMORY_ORDER_RELEASE,
+    MEMORY_ORDER_SEQ_CST
+};
+
+namespace detail {
+
+#if RAM_COMPILER == RAM_COMPILER_GNUC
+
+inline void fullFence() { __sync_synchronize(); }
+
+template<typename T>
+inline T fetchAdd(volatile T* value, T delta)
+{
+    return __sync_fetch_and_add(value, delta);
+}
+
+template<typename T>
+inline T compareAndSwap(volatile T* value, T expected, T desired)
+{
+    return __sync_val_compare_and_swap(value, expected, desired);
+}
+
+#else // RAM_COMPILER_MSVC
+
+inline void fullFence() { MemoryBarrier(); }
+
+template<size_t Size>
+struct Interlocked;
+
+template<>
+struct Interlocked<4>
+{
+    template<typename T>
+    static T fetchAdd(volatile T* value, T delta)
+    {
+        return (T)InterlockedExchangeAdd((volatile LONG*)value, (LONG)delta);
+    }
+
+    template<typename T>
+    static T compareAndSwap(volatile T* value, T expected, T desired)
+    {
+        return (T)InterlockedCompareExchange((volatile LONG*)value,
+                                             (LONG)desired, (LONG)expected);
+    }
+};
+
+template<>
+struct Interlocked<8>
+{
+    template<typename T>
+    static T fetchAdd(volatile T* value, T delta)
+    {
+        return (T)InterlockedExchangeAdd64((volatile LONGLONG*)value,
+                                           (LONGLONG)delta);
+    }
+
+    template<typename T>
+    static T compareAndSwap(volatile T* value, T expected, T desired)
+    {
+        return (T)InterlockedCompareExchange64((volatile LONGLONG*)value,
+                                               (LONGLONG)desired,
+                                               (LONGLONG)expected);
+    }
+};
+
+template<typename T>
+inline T fetchAdd(volatile T* value, T delta)
+{
+    return Interlocked<sizeof(T)>::fetchAdd(value, delta);
+}
+
+template<typename T>
+inline T compareAndSwap(volatile T* value, T expected, T desired)
+{
+    return Interlocked<sizeof(T)>::compareAndSwap(value, expected, desired);
+}
+
+#endif // RAM_COMPILER
+
+} // namespace detail
+
+/** A full memory barrier, nothing moves across it in either direction */
+inline void atomicFence()
+{
+    detail::fullFence();
+}
+
+/** An integer which can be shared between threads without a lock
+ *
+ *  Built on the compiler's own atomic operations, so it works with the old
+ *  versions of Boost we still support.  T must be an integer type of 4 or 8
+ *  bytes, use int in place of bool.
+ */
+template<typename T>
+class Atomic : boost::noncopyable
+{
+    BOOST_STATIC_ASSERT(sizeof(T) == 4 || sizeof(T) == 8);
+
+public:
+    explicit Atomic(T value = T()) : m_value(value) {}
+
+    T load(MemoryOrder order = MEMORY_ORDER_SEQ_CST) const
+    {
+        T value = m_value;
+        if (MEMORY_ORDER_RELAXED != order)
+            detail::fullFence();
+        return value;
+    }
+
+    void store(T value, MemoryOrder order = MEMORY_ORDER_SEQ_CST)
+    {
+        if (MEMORY_ORDER_RELAXED != order)
+            detail::fullFence();
+        m_value = value;
+        if (MEMORY_ORDER_SEQ_CST == order)
+            detail::fullFence();
+    }
+
+    /** Adds delta and returns the value from before */
+    T fetchAdd(T delta)
+    {
+        return detail::fetchAdd(&m_value, delta);
+    }
+
+    /** Subtracts delta and returns the value from before */
+    T fetchSub(T delta)
+    {
+        return detail::fetchAdd(&m_value, (T)(0 - delta));
+    }
+
+    /** Sets the value to desired if it still equals expected
+     *
+     *  @return  true if the value was changed, otherwise expected is set
+     *           to the current value
+     */
+    bool compareExchange(T& expected, T desired)
+    {
+        T previous = detail::compareAndSwap(&m_value, expected, desired);
+        if (previous == expected)
+            return true;
+        expected = previous;
+        return false;
+    }
+
+private:
+    volatile T m_value;
+};
+
+} // namespace core
+} // namespace ram
+
+#endif // RAM_CORE_ATOMIC_H_12_02_2010
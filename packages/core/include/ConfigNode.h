@@ -29,6 +29,13 @@ typedef NodeNameList::iterator NodeNameListIter;
 class RAM_EXPORT ConfigNode
 {
 public:
+    /** Which implementation parses and holds the config */
+    enum Backend
+    {
+        PYTHON, /** Python yaml module, nodes are Python objects */
+        NATIVE  /** Parsed once in C++, queries never take the GIL */
+    };
+
     /** <b>DO NOT USE THIS</b> */
     ConfigNode();
     
@@ -79,19 +86,32 @@ public:
     /** Map a value to the the given int inside a config node */
     void set(std::string key, int value);
     
-    /** Builds a config node from the given string, this uses the python ver. */
+    /** Builds a config node from the given string, with the default backend
+     */
     static ConfigNode fromString(std::string data);
 
+    /** Builds a config node from the given string with the given backend */
+    static ConfigNode fromString(std::string data, Backend backend);
+
     /** Returns the config file in a python evalable format */
     std::string toString();
 
-    /** Attempts to load the config from file, the extension determines the
-     backend used (NOT YET!!! - see below)
+    /** Attempts to load the config from file with the default backend
 
-     @warning: This currently assume yml files and python yaml library 
+     @warning: This currently assumes yml files
     */
     static ConfigNode fromFile(std::string fileName);
 
+    /** Loads the config from file with the given backend */
+    static ConfigNode fromFile(std::string fileName, Backend backend);
+
+    /** The backend used when none is given
+     *
+     *  Set by the RAM_CONFIG_BACKEND environment variable, "native" or
+     *  "python", the default is PYTHON.
+     */
+    static Backend defaultBackend();
+
     void writeToFile(std::string fileName, bool silent = false);
 
 private:    
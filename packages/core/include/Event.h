@@ -12,6 +12,7 @@
 
 // STD Includes
 #include <string>
+#include <cstddef>
 
 // Library Includes
 #include <boost/shared_ptr.hpp>
@@ -29,6 +30,12 @@ namespace core {
 struct RAM_EXPORT Event
 {
     typedef std::string EventType;
+
+    /** Compact integer handle for an EventType, see registerType */
+    typedef size_t TypeId;
+
+    /** The TypeId of an event which has not been published yet */
+    static const TypeId UNKNOWN_TYPE = 0;
     
     Event();
     
@@ -37,9 +44,31 @@ struct RAM_EXPORT Event
     /** Provides a deep copy of the event object */
     virtual EventPtr clone();
 
+    /** Interns the given event type and returns its compact id
+     *
+     *  The first call for a given type assigns it the next free id, later
+     *  calls return that same id.  Ids start at 1 and are dense, so they can
+     *  be used to directly index tables of subscribers.  All types declared
+     *  with RAM_CORE_EVENT_TYPE are registered during static initialization.
+     */
+    static TypeId registerType(const EventType& type);
+
+    /** Returns the type string for the given id, or "" if unknown */
+    static EventType typeName(TypeId id);
+
+    /** Registers the type and returns it, used by RAM_CORE_EVENT_TYPE */
+    static EventType declareType(const EventType& type);
+
     /** A unique identifier for a stream of events from an EventPublisher */
     EventType type;
 
+    /** The interned id of type, filled in when the event is published
+     *
+     *  If you set type by hand leave this as UNKNOWN_TYPE, the EventHub
+     *  will then look up the id itself.
+     */
+    TypeId typeId;
+
     /** The original source who published the event */
     EventPublisher* sender;
 
@@ -62,7 +91,8 @@ struct RAM_EXPORT Event
 #define RAM_CORE_EVENT_STR(S) RAM_CORE_EVENT_STRINGIFY(S)
 #define RAM_CORE_EVENT_TYPE(_class, name) \
     const ram::core::Event::EventType _class  :: name  \
-    (std::string(__FILE__ ":" RAM_CORE_EVENT_STR(__LINE__) " ") \
-                 + RAM_CORE_EVENT_STR(name))
+    (ram::core::Event::declareType( \
+        std::string(__FILE__ ":" RAM_CORE_EVENT_STR(__LINE__) " ") \
+        + RAM_CORE_EVENT_STR(name)))
 
 #endif // RAM_CORE_EVENT_H_11_19_2007
@@ -105,6 +105,11 @@ public:
      */
     virtual void publish(Event::EventType type, EventPtr event);
 
+    /** Publishs an event of the given type as the event hub, without the
+     *  type lookup */
+    virtual void publish(Event::TypeId typeId, Event::EventType type,
+                         EventPtr event);
+
     /** Does nothing for this class */
     virtual void update(double timestep);
     /** Does nothing for this class */
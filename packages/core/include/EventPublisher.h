@@ -57,6 +57,20 @@ public:
     /** Call all handlers of the given type with the given event */
     virtual void publish(Event::EventType type, EventPtr event);
 
+    /** Same as above, without looking up the id of the type
+     *
+     *  Events published often should use this, with the id looked up once:
+     *  @code
+     *  static const core::Event::TypeId UPDATE_ID =
+     *      core::Event::registerType(IFoo::UPDATE);
+     *  publish(UPDATE_ID, IFoo::UPDATE, event);
+     *  @endcode
+     *
+     *  @param typeId  Must be Event::registerType(type)
+     */
+    virtual void publish(Event::TypeId typeId, Event::EventType type,
+                         EventPtr event);
+
     /** Gets the id of the EventPublisher, or "UNNAMED" if it has no name */
     std::string getPublisherName();
 
@@ -11,6 +11,10 @@
 #ifndef RAM_CORE_EVENTPUBLISHERBASE_H_11_30_2007
 #define RAM_CORE_EVENTPUBLISHERBASE_H_11_30_2007
 
+// STD Includes
+#include <utility>
+#include <vector>
+
 // Library Includes
 #include <boost/shared_ptr.hpp>
 #include <boost/signal.hpp>
@@ -35,6 +39,41 @@ public:
     virtual ~EventPublisherBase() {}
 };
 
+/** Splits a subscription key into the interned type and sender it matches
+ *
+ *  Subscribers are stored in a flat table indexed by Event::TypeId, with
+ *  sender specific subscribers (sender != 0) kept inside each entry.  The
+ *  default handles plain Event::EventType keys.
+ */
+template<typename T>
+struct EventSlotKey
+{
+    static Event::TypeId keyType(const T& key)
+    {
+        return Event::registerType(key);
+    }
+
+    static EventPublisher* keySender(const T&) { return 0; }
+
+    static EventPublisher* eventSender(EventPtr) { return 0; }
+};
+
+/** Keys used by the EventHub for events of a type from a single sender */
+template<>
+struct EventSlotKey<std::pair<Event::EventType, EventPublisher*> >
+{
+    typedef std::pair<Event::EventType, EventPublisher*> KeyType;
+    
+    static Event::TypeId keyType(const KeyType& key)
+    {
+        return Event::registerType(key.first);
+    }
+
+    static EventPublisher* keySender(const KeyType& key) { return key.second; }
+
+    static EventPublisher* eventSender(EventPtr event) { return event->sender; }
+};
+    
 template<typename T>
 class EventPublisherBaseTemplate :
     public EventPublisherBase
@@ -49,10 +88,36 @@ public:
         T type,
         boost::function<void (EventPtr)> handler);
     
+    /** Looks up the id of etype, then publishes as below
+     *
+     *  The lookup hashes the type string under a lock, code which publishes
+     *  often should look the id up once and use the other overload.
+     */
+    void publish(Event::EventType etype, EventPublisher* sender,
+                 EventPtr event);
 
-    virtual void publish(T subscribeType, Event::EventType etype,
+    /** Fills in the type and sender of the event, then publishes it
+     *
+     *  The event goes to the subscribers of its type (and sender when keyed
+     *  that way), and then on to the hub if there is one.
+     *
+     *  @param typeId  Event::registerType(etype), looked up by the caller
+     */
+    virtual void publish(Event::TypeId typeId, Event::EventType etype,
                          EventPublisher* sender, EventPtr event);
 
+    /** Calls the subscribers of the given slot, with no string lookups
+     *
+     *  The event must already have its type, typeId and sender filled in.
+     *  This does not forward the event to the hub.
+     *
+     *  @param typeId  The interned type subscribers registered for
+     *  @param sender  The sender subscribers registered for, or 0
+     *  @param event   The event to pass to the subscribers
+     */
+    void publishToSlot(Event::TypeId typeId, EventPublisher* sender,
+                       EventPtr event);
+
     std::string getPublisherName();
     
 protected:
@@ -60,7 +125,7 @@ protected:
     class Connection : public EventConnection
     {
     public:
-        Connection(T type,
+        Connection(T type, Event::TypeId typeId,
                    EventPublisherBaseTemplate<T>* publisher,
                    boost::signals::connection connection);
     
@@ -75,6 +140,9 @@ protected:
         
         /** Type of the event */
         T m_type;
+
+        /** The interned type, so disconnecting needs no lookup */
+        Event::TypeId m_typeId;
         
         /** Publisher to which the event is connection */
         EventPublisherBaseTemplate* m_publisher;
@@ -86,8 +154,25 @@ protected:
     typedef boost::shared_ptr<Connection> ConnectionPtr;
     
 private:
+    typedef boost::signal<void (EventPtr)>  EventSignal;
+
+    /** All the subscribers for a single Event::TypeId */
+    struct SignalSlot
+    {
+        /// Protects the signals (they are not thread safe)
+        boost::recursive_mutex mutex;
+
+        /// Maps sender -> signal, sender is 0 for plain type subscribers
+        boost::ptr_map<EventPublisher*, EventSignal> signals;
+    };
+
+    typedef boost::shared_ptr<SignalSlot> SignalSlotPtr;
+    
+    /** Returns the slot for given type, 0 if no one has subscribed to it */
+    SignalSlot* findSlot(Event::TypeId typeId);
+    
     /** Remove handler from recieving particular event types */
-    void unSubscribe(T type,
+    void unSubscribe(Event::TypeId typeId,
                      boost::signals::connection connection);
     
     // So it can call unSubscribe
@@ -99,15 +184,11 @@ private:
     /// The hub to which all messages are puslished
     EventHubPtr m_hub;
     
-    /// Protects access to map of types->signals
-    ReadWriteMutex m_signalMapMutex;
+    /// Protects access to the slot table (not the slots themselves)
+    ReadWriteMutex m_slotsMutex;
 
-    /// Protects access to each signal (they are not thread safe)
-    boost::ptr_map<T, boost::recursive_mutex> m_signalMutexes;
-
-    typedef boost::signal<void (EventPtr)>  EventSignal;
-    /// Maps types -> signals
-    boost::ptr_map<T, EventSignal>  m_signals;
+    /// Maps Event::TypeId -> slot, entries are null until subscribed to
+    std::vector<SignalSlotPtr> m_slots;
 };
 
 // ------------------------------------------------------------------------- //
@@ -127,64 +208,102 @@ EventConnectionPtr EventPublisherBaseTemplate<T>::subscribe(
     T type,
     boost::function<void (EventPtr)> handler)
 {
-    ReadWriteMutex::ScopedWriteLock lock(m_signalMapMutex);
+    Event::TypeId typeId = EventSlotKey<T>::keyType(type);
+    EventPublisher* sender = EventSlotKey<T>::keySender(type);
+    
+    SignalSlot* slot = 0;
+    {
+        ReadWriteMutex::ScopedWriteLock lock(m_slotsMutex);
+        if (m_slots.size() <= typeId)
+            m_slots.resize(typeId + 1);
+        if (!m_slots[typeId])
+            m_slots[typeId] = SignalSlotPtr(new SignalSlot());
+        slot = m_slots[typeId].get();
+    }
+
+    boost::recursive_mutex::scoped_lock lock(slot->mutex);
     return EventConnectionPtr(
-        new typename EventPublisherBaseTemplate<T>::Connection(type, this,
-            m_signals[type].connect(handler)));
+        new typename EventPublisherBaseTemplate<T>::Connection(type, typeId,
+            this, slot->signals[sender].connect(handler)));
+}
+
+template<typename T>
+void EventPublisherBaseTemplate<T>::publish(Event::EventType etype,
+                                            EventPublisher* sender,
+                                            EventPtr event)
+{
+    publish(Event::registerType(etype), etype, sender, event);
 }
 
 template<typename T>
-void EventPublisherBaseTemplate<T>::publish(T subscribeType,
+void EventPublisherBaseTemplate<T>::publish(Event::TypeId typeId,
                                             Event::EventType etype,
                                             EventPublisher* sender,
                                             EventPtr event)
 {
     // Set event property
     event->type = etype;
+    event->typeId = typeId;
     event->sender = sender;
 
-    boost::recursive_mutex* signalMutex;
-    {
-        ReadWriteMutex::ScopedReadLock mapLock(m_signalMapMutex);
-        signalMutex = &m_signalMutexes[subscribeType];
-    }
-    {
-        boost::recursive_mutex::scoped_lock lock(*signalMutex);
-        
-        // Call subscribers
-        m_signals[subscribeType](event);
-    }
+    // Call subscribers
+    publishToSlot(event->typeId, EventSlotKey<T>::eventSender(event), event);
 
     if (m_hub)
         m_hub->publish(event);
 }
 
+template<typename T>
+void EventPublisherBaseTemplate<T>::publishToSlot(Event::TypeId typeId,
+                                                  EventPublisher* sender,
+                                                  EventPtr event)
+{
+    SignalSlot* slot = findSlot(typeId);
+    if (!slot)
+        return;
+
+    boost::recursive_mutex::scoped_lock lock(slot->mutex);
+    typename boost::ptr_map<EventPublisher*, EventSignal>::iterator iter =
+        slot->signals.find(sender);
+    if (slot->signals.end() != iter)
+        (*iter->second)(event);
+}
+
 template<typename T>
 std::string EventPublisherBaseTemplate<T>::getPublisherName()
 {
     return m_name;
 }
+
+template<typename T>
+typename EventPublisherBaseTemplate<T>::SignalSlot*
+EventPublisherBaseTemplate<T>::findSlot(Event::TypeId typeId)
+{
+    ReadWriteMutex::ScopedReadLock lock(m_slotsMutex);
+    if (typeId < m_slots.size())
+        return m_slots[typeId].get();
+    return 0;
+}
     
 template<typename T>
-void EventPublisherBaseTemplate<T>::unSubscribe(T type,
+void EventPublisherBaseTemplate<T>::unSubscribe(Event::TypeId typeId,
     boost::signals::connection connection)
 {
-    boost::recursive_mutex* signalMutex;
-    {
-        ReadWriteMutex::ScopedReadLock mapLock(m_signalMapMutex);
-        signalMutex = &m_signalMutexes[type];
-    }
+    // The slot always exists, subscribe created it
+    SignalSlot* slot = findSlot(typeId);
     
-    boost::recursive_mutex::scoped_lock lock(*signalMutex);
+    boost::recursive_mutex::scoped_lock lock(slot->mutex);
     connection.disconnect();
 }
 
 template<typename T>
 EventPublisherBaseTemplate<T>::Connection::Connection(T type,
+                   Event::TypeId typeId,
                    EventPublisherBaseTemplate<T>* publisher,
                    boost::signals::connection connection) :
     m_connected(true),
     m_type(type),
+    m_typeId(typeId),
     m_publisher(publisher),
     m_connection(connection)
 {
@@ -199,7 +318,7 @@ T EventPublisherBaseTemplate<T>::Connection::getType()
 template<typename T>
 void EventPublisherBaseTemplate<T>::Connection::disconnect()
 {
-    m_publisher->unSubscribe(m_type, m_connection);
+    m_publisher->unSubscribe(m_typeId, m_connection);
     m_connected = false;
 }
 
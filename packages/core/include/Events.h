@@ -37,6 +37,41 @@ struct IntEvent : public core::Event
 };
 
 typedef boost::shared_ptr<IntEvent> IntEventPtr;
+
+/** Loop timing of a backgrounded Updatable over the last second
+ *
+ *  All times are in seconds.  The period is measured between the start of
+ *  successive update calls.
+ */
+struct UpdateTimingEvent : public core::Event
+{
+    UpdateTimingEvent();
+
+    virtual EventPtr clone();
+
+    /** Number of update calls in the window */
+    int updates;
+
+    /** Number of updates which finished after the next one was due */
+    int overruns;
+
+    double minPeriod;
+    double meanPeriod;
+    double maxPeriod;
+
+    /** 99th percentile period */
+    double p99Period;
+
+    /** Standard deviation of the period */
+    double jitter;
+
+    /** Time spent inside update() */
+    double minExecTime;
+    double meanExecTime;
+    double maxExecTime;
+};
+
+typedef boost::shared_ptr<UpdateTimingEvent> UpdateTimingEventPtr;
     
 } // namespace core
 } // namespace ram
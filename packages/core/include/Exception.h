@@ -38,6 +38,28 @@ private:
     std::string m_key;
 };
 
+/** Thrown by the native ConfigNode backend for bad files and conversions */
+class ConfigNodeException : public std::exception
+{
+public:
+    ConfigNodeException(std::string message) :
+        m_message(message)
+    {
+    }
+
+    virtual ~ConfigNodeException() throw ()
+    {
+    }
+
+    virtual const char* what() const throw()
+    {
+        return m_message.c_str();
+    }
+
+private:
+    std::string m_message;
+};
+
 } // namespace core
 } // namespace ram
 
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/include/Executor.h
+ */
+
+#ifndef RAM_CORE_EXECUTOR_H_10_17_2010
+#define RAM_CORE_EXECUTOR_H_10_17_2010
+
+// STD Includes
+#include <map>
+#include <set>
+#include <list>
+#include <deque>
+#include <vector>
+
+// Library Includes
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+// Project Includes
+#include "core/include/Subsystem.h"
+#include "core/include/ConfigNode.h"
+
+// Must Be Included last
+#include "core/include/Export.h"
+
+namespace ram {
+namespace core {
+
+class Updatable;
+class Executor;
+typedef boost::shared_ptr<Executor> ExecutorPtr;
+
+/** Runs backgrounded Updatables on a shared pool of worker threads
+ *
+ *  Instead of each Updatable getting its own thread which sleeps most of the
+ *  time, Updatables given to Updatable::setExecutor are run as tasks on a
+ *  fixed set of workers.  Periodic tasks are parked in a hashed timer wheel
+ *  until their deadline comes up, tasks with an interval <= 0 are requeued as
+ *  soon as they finish.  Each worker runs its own queue first and steals
+ *  from the back of the others when it runs dry.
+ *
+ *  Config values:
+ *   - threads:   number of workers, defaults to the number of CPUs
+ *   - cpus:      CPU list ("2-3") the workers are pinned to, round robin
+ *   - tick:      timer wheel resolution in microseconds, default 1000
+ *   - wheelSize: number of slots in the timer wheel, default 512
+ *
+ *  Subsystems pick the pool with "executor: <name of executor>" in their
+ *  config, and should list the executor in their "depends_on" so it outlives
+ *  them.  If the pool does go first they carry on with a thread each.  Pooled Updatables keep their interval and overrun policy, but
+ *  their priority and affinity settings are replaced by the pool's.
+ */
+class RAM_EXPORT Executor : public Subsystem
+{
+public:
+    /** Easier to use contructor */
+    Executor(std::string name = "Executor", size_t threads = 0,
+             std::set<size_t> cpus = std::set<size_t>(), int tickUSec = 1000,
+             size_t wheelSize = 512);
+
+    /** Standard subsystem constructor */
+    Executor(ConfigNode config, SubsystemList deps = SubsystemList());
+
+    /** Stops all workers
+     *
+     *  Any Updatables still scheduled are moved back to their own threads
+     *  with the same interval, and keep running.
+     */
+    virtual ~Executor();
+
+    /** Starts running the given Updatable every interval milliseconds
+     *
+     *  If the Updatable is already scheduled only its interval is changed.
+     *  Called by Updatable::background.
+     */
+    void schedule(Updatable* updatable, int interval);
+
+    /** Stops running the given Updatable
+     *
+     *  @param join
+     *      Wait for the current update to finish, ignored when called from
+     *      inside that update.  Called by Updatable::unbackground.
+     */
+    void cancel(Updatable* updatable, bool join);
+
+    /** Number of worker threads */
+    size_t getThreadCount();
+
+    /** Does nothing for this class */
+    virtual void update(double timestep);
+    /** Does nothing for this class */
+    virtual void setPriority(IUpdatable::Priority priority);
+    /** Does nothing for this class, always returns NORMAL_PRIORITY */
+    virtual IUpdatable::Priority getPriority();
+    /** Does nothing for this class */
+    virtual void setAffinity(size_t affinity);
+    /** Does nothing for this class, always returns -1 */
+    virtual int getAffinity();
+    /** Does nothing for this class, the workers always run */
+    virtual void background(int interval);
+    /** Does nothing for this class */
+    virtual void unbackground(bool join);
+    /** Does nothing for this class, always returns true */
+    virtual bool backgrounded();
+
+private:
+    struct Task;
+    typedef boost::shared_ptr<Task> TaskPtr;
+    typedef std::list<TaskPtr> TaskList;
+
+    /** Starts up the workers and the timer thread */
+    void init(size_t threads, std::set<size_t> cpus, int tickUSec,
+              size_t wheelSize);
+
+    /** Body of each worker thread */
+    void workerLoop(size_t worker, int cpu);
+
+    /** Body of the thread which advances the timer wheel */
+    void timerLoop();
+
+    /** Runs a task once, then schedules it again */
+    void runTask(size_t worker, TaskPtr task);
+
+    /** Pops the next task for the given worker, stealing if needed
+     *
+     *  Must hold m_mutex.
+     */
+    TaskPtr nextTask(size_t worker);
+
+    /** Puts the task on its worker queue, or on the wheel if its deadline
+     *  has not come up yet.  Must hold m_mutex. */
+    void enqueue(TaskPtr task);
+
+    /** Puts the task on its worker queue.  Must hold m_mutex. */
+    void makeReady(TaskPtr task);
+
+    /** Forgets a cancelled task, unless it was rescheduled.  Must hold
+     *  m_mutex. */
+    void dropTask(TaskPtr task);
+
+    /** Guards everything below */
+    boost::mutex m_mutex;
+
+    /** Signaled when there is work in a queue, or we are shutting down */
+    boost::condition m_workAvailable;
+
+    /** Signaled when the wheel gets an earlier deadline, or we are shutting
+     *  down */
+    boost::condition m_timerWake;
+
+    /** Signaled when a task finishes an update */
+    boost::condition m_taskDone;
+
+    /** Set when the threads should exit */
+    bool m_shutdown;
+
+    /** Every scheduled Updatable */
+    std::map<Updatable*, TaskPtr> m_tasks;
+
+    /** Ready tasks, one queue per worker */
+    std::vector<std::deque<TaskPtr> > m_queues;
+
+    /** Next worker to give a new task to */
+    size_t m_nextWorker;
+
+    /** Slots of the timer wheel, each holds tasks by deadline tick */
+    std::vector<TaskList> m_wheel;
+
+    /** Timer wheel resolution in microseconds */
+    boost::int64_t m_tick;
+
+    /** The last tick the timer thread processed */
+    boost::int64_t m_lastTick;
+
+    /** Deadline tick of every task on the wheel, the first is the next one
+     *  the timer has to wake up for */
+    std::multiset<boost::int64_t> m_wheelTicks;
+
+    /** All worker threads and the timer thread */
+    boost::thread_group m_threads;
+    size_t m_threadCount;
+};
+
+} // namespace core
+} // namespace ram
+
+#endif // RAM_CORE_EXECUTOR_H_10_17_2010
@@ -29,6 +29,9 @@ class RAM_EXPORT IUpdatable
 public:
     static const ram::core::Event::EventType PROFILE;
 
+    /** Published once a second with an UpdateTimingEvent */
+    static const ram::core::Event::EventType TIMING;
+
     enum Priority
     {
         RT_HIGH_PRIORITY,
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/include/NativeConfigNodeImp.h
+ */
+
+#ifndef RAM_CORE_NATIVECONFIGNODEIMP_11_06_2010
+#define RAM_CORE_NATIVECONFIGNODEIMP_11_06_2010
+
+// STD Includes
+#include <string>
+
+// Library Includes
+#include <boost/shared_ptr.hpp>
+
+// Project Includes
+#include "core/include/ConfigNode.h"
+#include "core/include/ConfigNodeImp.h"
+
+// Must Be Included last
+#include "core/include/Export.h"
+
+namespace ram {
+namespace core {
+
+/**
+ * Implements the ConfigNodeImp with a tree parsed once in C++
+ *
+ * Reads the YAML used by our config files: block and flow mappings and
+ * sequences, plain and quoted scalars and comments, plus the Python literals
+ * made by toString.  INCLUDE keys are resolved while loading, relative to
+ * RAM_SVN_DIR, just like the Python version.  Anchors, tags and block
+ * scalars are not supported.
+ *
+ * Nodes share the parsed tree, so copying and querying never touch Python.
+ * Reads are safe from any thread, set must not be called while other
+ * threads are reading.  Errors throw ConfigNodeException.
+ */
+class RAM_EXPORT NativeConfigNodeImp : public ConfigNodeImp
+{
+public:
+    /** A node of the parsed tree */
+    struct Value;
+    typedef boost::shared_ptr<Value> ValuePtr;
+
+    /** A config node for the given part of a parsed tree */
+    NativeConfigNodeImp(ValuePtr value, std::string debugPath = "ROOT");
+
+    virtual ~NativeConfigNodeImp() {};
+
+    /** Grab a section of the config like an array */
+    virtual ConfigNodeImpPtr idx(int index);
+
+    /** Grab a sub node with the same name */
+    virtual ConfigNodeImpPtr map(std::string key);
+
+    /** Convert the node to a string value */
+    virtual std::string asString();
+
+    /** Attempts conversion to string, if it fails return def */
+    virtual std::string asString(const std::string& def);
+
+    /** Convert the node to a double */
+    virtual double asDouble();
+
+    /** Attempts conversion to string, if it fails return def */
+    virtual double asDouble(const double def);
+
+    /** Convert the node to an int */
+    virtual int asInt();
+
+    /** Attempts conversion to int, if it fails return def */
+    virtual int asInt(const int def);
+
+    /** Returns the list of sub nodes of the current config node */
+    virtual NodeNameList subNodes();
+
+    /** The number of elements in an array or map node */
+    virtual size_t size();
+
+    /** Map a key to a given value */
+    virtual void set(std::string key, std::string str);
+
+    virtual void set(std::string key, int value);
+
+    /** Parse the given YAML file */
+    static ConfigNodeImpPtr fromYamlFile(std::string filename);
+
+    /** Parse the given YAML (or Python literal) string */
+    static ConfigNodeImpPtr fromYamlString(std::string data);
+
+    /** Returns the node as a Python literal, like the Python version */
+    virtual std::string toString();
+
+    /**
+     * Dumps the config file to disk as YAML.
+     *
+     * @param fileName File to dump data to
+     * @param silent A silent write will never throw, errors are only
+     *               printed. Default is false.
+     */
+    virtual void writeToFile(std::string fileName, bool silent);
+
+private:
+    /** Throws a ConfigNodeException naming this node */
+    void error(const std::string& operation, const std::string& message);
+
+    ValuePtr m_value;
+
+    std::string m_debugPath;
+};
+
+} // namespace core
+} // namespace ram
+
+#endif // RAM_CORE_NATIVECONFIGNODEIMP_11_06_2010
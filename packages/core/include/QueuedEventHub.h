@@ -52,6 +52,10 @@ public:
 
     /** Publishs the event into the internal event queue (with sender=this) */
     virtual void publish(Event::EventType type, EventPtr event);
+
+    /** Same as above, without the type lookup */
+    virtual void publish(Event::TypeId typeId, Event::EventType type,
+                         EventPtr event);
     
     /** @copydoc QueuedEventPublisher::publishEvents() */
     int publishEvents();
@@ -10,8 +10,12 @@
 #ifndef RAM_CORE_QUEUEDEVENTHUBIMP_12_26_2007
 #define RAM_CORE_QUEUEDEVENTHUBIMP_12_26_2007
 
+// STD Includes
+#include <vector>
+
 // Library Includes
 #include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
 
 // Project Includes
 #include "core/include/ThreadedQueue.h"
@@ -24,8 +28,14 @@ namespace core {
 class QueuedEventHubImp
 {
 public:
-    /** Creates a new instance */ 
-    QueuedEventHubImp();
+    /** Creates a new instance
+     *
+     *  @param queueSize  If non-zero the event queue is a bounded RingQueue
+     *  @param policy     What to do when a bounded queue is full
+     */ 
+    QueuedEventHubImp(int queueSize = 0,
+                      RingQueueBase::OverflowPolicy policy =
+                      RingQueueBase::BLOCK);
 
     /** Set the function used twhich publishes use the given function */
     void setPublishFunction(boost::function<void (EventPtr)> publishFunction);
@@ -45,6 +55,12 @@ private:
     
     /** Thread safe queue for events */
     ThreadedQueue<EventPtr> m_eventQueue;
+
+    /** Kept between publishEvents calls so its memory is reused */
+    std::vector<EventPtr> m_eventBuffer;
+
+    /** Protects m_eventBuffer, publishEvents can be called from any thread */
+    boost::mutex m_eventBufferMutex;
 };
 
 } // namespace core
@@ -54,6 +54,10 @@ public:
     /**Publish the event to the internal queue */
     virtual void publish(Event::EventType type, EventPtr event);
 
+    /** Publish the event to the internal queue, without the type lookup */
+    virtual void publish(Event::TypeId typeId, Event::EventType type,
+                         EventPtr event);
+
     /** Publishes all queued events and any that arrive while publishing those events
      *
      *  @return
@@ -12,10 +12,13 @@
 
 // STD Includes
 #include <map>
+#include <vector>
 
 // Library Includes
 #include <boost/tuple/tuple.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
 
 // Project Includes
 #include "core/include/EventPublisherBase.h"
@@ -43,9 +46,10 @@ public:
     virtual EventConnectionPtr subscribe(T type,
         boost::function<void (EventPtr)>  handler);
     
-    virtual void publish(T subscribeType, Event::EventType etype,
-                         EventPublisher* sender,
-                         EventPtr event);
+    using EventPublisherBaseTemplate<T>::publish;
+
+    virtual void publish(Event::TypeId typeId, Event::EventType etype,
+                         EventPublisher* sender, EventPtr event);
 
     int publishEvents();
     
@@ -88,6 +92,12 @@ private:
     /** Thread safe queue for events */
     ThreadedQueue<EventPtr> m_eventQueue;
 
+    /** Kept between publishEvents calls so its memory is reused */
+    std::vector<EventPtr> m_eventBuffer;
+
+    /** Protects m_eventBuffer, publishEvents can be called from any thread */
+    boost::mutex m_eventBufferMutex;
+
     /** Protects access to map of types->signals */
     ReadWriteMutex m_connectionsMutex;
     
@@ -182,13 +192,14 @@ EventConnectionPtr QueuedEventPublisherBaseTemplate<T>::subscribe(
 }
 
 template<typename T>
-void QueuedEventPublisherBaseTemplate<T>::publish(T subscribeType,
+void QueuedEventPublisherBaseTemplate<T>::publish(Event::TypeId typeId,
                                                   Event::EventType etype,
                                                   EventPublisher* sender,
                                                   EventPtr event)
 {
     // Queue event internally
     event->type = etype;
+    event->typeId = typeId;
     event->sender = sender;
     queueEvent(event);
 };
@@ -196,16 +207,28 @@ void QueuedEventPublisherBaseTemplate<T>::publish(T subscribeType,
 template<typename T>
 int QueuedEventPublisherBaseTemplate<T>::publishEvents()
 {
-    EventPtr event;
+    // See QueuedEventHubImp::publishEvents
+    std::vector<EventPtr> events;
+    {
+        boost::mutex::scoped_lock lock(m_eventBufferMutex);
+        events.swap(m_eventBuffer);
+    }
+    
     int published = 0;
-    while(m_eventQueue.popNoWait(event))
+    while(m_eventQueue.popAll(events))
     {
-        EventPublisherBaseTemplate<T>::publish(event->type,
-                                               event->type,
-                                               event->sender,
-                                               event);
-        published++;
+        BOOST_FOREACH(EventPtr& event, events)
+        {
+            EventPublisherBaseTemplate<T>::publishToSlot(
+                event->typeId, EventSlotKey<T>::eventSender(event), event);
+        }
+        published += events.size();
+        events.clear();
     }
+
+    boost::mutex::scoped_lock lock(m_eventBufferMutex);
+    if (events.capacity() > m_eventBuffer.capacity())
+        events.swap(m_eventBuffer);
     return published;
 }
 
@@ -214,10 +237,8 @@ int QueuedEventPublisherBaseTemplate<T>::waitAndPublishEvents()
 {
     // Wait for events and publish the new event
     EventPtr event = m_eventQueue.popWait();
-    EventPublisherBaseTemplate<T>::publish(event->type,
-                                           event->type,
-                                           event->sender,
-                                           event);
+    EventPublisherBaseTemplate<T>::publishToSlot(
+        event->typeId, EventSlotKey<T>::eventSender(event), event);
     
     return 1 + publishEvents();
 }
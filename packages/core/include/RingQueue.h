@@ -0,0 +1,586 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/include/RingQueue.h
+ */
+
+#ifndef RAM_CORE_RINGQUEUE_H_03_14_2010
+#define RAM_CORE_RINGQUEUE_H_03_14_2010
+
+// STD Includes
+#include <new>
+#include <vector>
+#include <limits>
+#include <iterator>
+#include <string>
+#include <cstddef>
+
+// Library Includes
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/xtime.hpp>
+
+// Project Includes
+#include "core/include/Atomic.h"
+
+// Must Be Included last
+#include "core/include/Export.h"
+
+namespace ram {
+namespace core {
+
+namespace details {
+    boost::xtime add_xtime(const boost::xtime& a, const boost::xtime& b);
+
+    /** Gives to the value of from, from is left in any valid state
+     *
+     *  Plain assignment in general, but shared_ptrs are swapped so taking
+     *  an event off a queue does not touch its reference count.
+     */
+    template <typename T>
+    inline void takeValue(T& to, T& from)
+    {
+        to = from;
+    }
+
+    template <typename U>
+    inline void takeValue(boost::shared_ptr<U>& to, boost::shared_ptr<U>& from)
+    {
+        to.swap(from);
+    }
+
+    /** Appends the value of from to items, in the same way as takeValue */
+    template <typename T>
+    inline void takeBack(std::vector<T>& items, T& from)
+    {
+        items.push_back(from);
+    }
+
+    template <typename U>
+    inline void takeBack(std::vector<boost::shared_ptr<U> >& items,
+                         boost::shared_ptr<U>& from)
+    {
+        items.push_back(boost::shared_ptr<U>());
+        items.back().swap(from);
+    }
+}
+
+/** Non template parts of the RingQueue */
+class RAM_EXPORT RingQueueBase
+{
+public:
+    /** What push does when the queue is full */
+    enum OverflowPolicy {
+        /** Wait until the consumer makes room */
+        BLOCK,
+        /** Throw away the oldest queued item to make room */
+        DROP_OLDEST,
+        /** Throw away the item being pushed */
+        DROP_NEWEST
+    };
+
+    /** Converts "block", "dropOldest" or "dropNewest" to a policy
+     *
+     *  Unknown strings result in BLOCK so nothing is silently lost.
+     */
+    static OverflowPolicy policyFromString(const std::string& policy);
+};
+
+/** A bounded, lock free, multi-producer queue with the ThreadedQueue API
+ *
+ *  Items live in a fixed, power of two sized, ring of cells which each
+ *  carry a sequence number (Dmitry Vyukov's bounded queue).  Pushing and
+ *  popping are a single compare and swap in the common case and never
+ *  allocate.  The mutex and condition are only touched when a thread has to
+ *  sleep, either a consumer waiting on an empty queue or a producer waiting
+ *  on a full one with the BLOCK policy.
+ *
+ *  It is intended for many producers and one consumer, but the algorithm is
+ *  safe for multiple consumers, which is what lets DROP_OLDEST producers
+ *  throw away items themselves.
+ *
+ *  @remarks
+ *  The templated object only needs to be copy constructable.
+ */
+template <typename T>
+class RingQueue : public RingQueueBase, boost::noncopyable
+{
+public:
+    /** Creates a queue which holds at least capacity items
+     *
+     *  @param capacity  Rounded up to the next power of two
+     *  @param policy    What to do when pushing to a full queue
+     */
+    RingQueue(size_t capacity, OverflowPolicy policy = BLOCK);
+
+    ~RingQueue();
+
+    /** Adds an item to the queue, applying the overflow policy if full
+     *
+     *  @return false if the item was dropped (DROP_NEWEST only)
+     */
+    bool push(const T& newData);
+
+    /** @copydoc ThreadedQueue::popNoWait */
+    bool popNoWait(T& data);
+
+    /** @copydoc ThreadedQueue::popWait */
+    T popWait();
+
+    /** @copydoc ThreadedQueue::popTimedWait */
+    bool popTimedWait(const boost::xtime &timeout, T& data);
+
+    /** @copydoc ThreadedQueue::popAll */
+    size_t popAll(std::vector<T>& items);
+
+    /** @copydoc ThreadedQueue::drainInto */
+    template <typename OutputIterator>
+    size_t drainInto(OutputIterator out,
+                     size_t maxItems = std::numeric_limits<size_t>::max());
+
+    /** The maximum number of items the queue can hold */
+    size_t capacity() const;
+
+    /** The number of queued items, only approximate when under contention */
+    size_t size() const;
+
+    /** The largest number of items that has been queued at once */
+    size_t highWaterMark() const;
+
+    /** The number of items thrown away due to the overflow policy */
+    size_t dropped() const;
+
+private:
+    typedef typename boost::aligned_storage<
+        sizeof(T), boost::alignment_of<T>::value>::type Storage;
+
+    struct Cell
+    {
+        Atomic<size_t> sequence;
+        Storage storage;
+    };
+
+    /** Pushes if there is room, never blocks */
+    bool tryPush(const T& newData);
+
+    /** Pops into data if there is an item, if data is 0 the item is dropped
+     *
+     *  @param construct  If true data is uninitialized storage which the
+     *                    item is copy constructed into, otherwise it is
+     *                    given to data with details::takeValue
+     */
+    bool tryPop(T* data, bool construct = false);
+
+    /** Claims the oldest full cell for the caller to take the item from
+     *
+     *  @param pos  Set to the position of the cell, for releaseFull
+     *  @return     The cell, or 0 if the queue is empty
+     */
+    Cell* claimFull(size_t& pos);
+
+    /** Destroys the item left in a claimed cell and frees the cell */
+    void releaseFull(Cell* cell, size_t pos);
+
+    /** Sleeps until another thread pushes or pops, or wakeUp passes
+     *
+     *  @param ready    Tried again after registering as a waiter, if it
+     *                  succeeds we return without sleeping
+     *  @param wakeUp   Absolute time to give up at, or 0 to wait forever
+     *  @return         false if we timed out
+     */
+    template <typename Ready>
+    bool waitFor(Ready ready, const boost::xtime* wakeUp);
+
+    /** Wakes any sleeping threads after the queue has changed */
+    void notifyWaiters();
+
+    /** Records the current size as the high water mark if needed */
+    void updateHighWaterMark(size_t size);
+
+    /** Binds the try functions so they can be passed to waitFor */
+    struct TryPush
+    {
+        TryPush(RingQueue* q, const T& d) : queue(q), data(d) {}
+        bool operator()() { return queue->tryPush(data); }
+        RingQueue* queue;
+        const T& data;
+    };
+
+    struct TryPop
+    {
+        TryPop(RingQueue* q, T* d, bool c = false) :
+            queue(q), data(d), construct(c) {}
+        bool operator()() { return queue->tryPop(data, construct); }
+        RingQueue* queue;
+        T* data;
+        bool construct;
+    };
+
+    /** Keeps the producer and consumer indexes on separate cache lines */
+    typedef char CacheLinePad[64];
+
+    CacheLinePad m_pad0;
+    Cell* m_buffer;
+    size_t m_mask;
+    OverflowPolicy m_policy;
+
+    CacheLinePad m_pad1;
+    Atomic<size_t> m_enqueuePos;
+
+    CacheLinePad m_pad2;
+    Atomic<size_t> m_dequeuePos;
+
+    CacheLinePad m_pad3;
+    Atomic<size_t> m_highWaterMark;
+    Atomic<size_t> m_dropped;
+
+    /** Number of threads sleeping in waitFor */
+    Atomic<int> m_waiters;
+    boost::mutex m_waitMutex;
+    boost::condition m_changed;
+};
+
+// ------------------------------------------------------------------------- //
+//             T E M P L A T E   I M P L E M E N T A T I O N                 //
+// ------------------------------------------------------------------------- //
+
+template <typename T>
+RingQueue<T>::RingQueue(size_t capacity, OverflowPolicy policy) :
+    m_buffer(0),
+    m_mask(0),
+    m_policy(policy),
+    m_enqueuePos(0),
+    m_dequeuePos(0),
+    m_highWaterMark(0),
+    m_dropped(0),
+    m_waiters(0)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+
+    m_mask = size - 1;
+    m_buffer = new Cell[size];
+    for (size_t i = 0; i < size; ++i)
+        m_buffer[i].sequence.store(i, MEMORY_ORDER_RELAXED);
+}
+
+template <typename T>
+RingQueue<T>::~RingQueue()
+{
+    // Destroy anything still queued
+    while (tryPop(0)) {}
+    delete [] m_buffer;
+}
+
+template <typename T>
+bool RingQueue<T>::push(const T& newData)
+{
+    if (!tryPush(newData))
+    {
+        switch (m_policy)
+        {
+            case DROP_NEWEST:
+                m_dropped.fetchAdd(1);
+                return false;
+
+            case DROP_OLDEST:
+                // Throw away items until there is room for ours
+                while (!tryPush(newData))
+                {
+                    if (tryPop(0))
+                        m_dropped.fetchAdd(1);
+                }
+                break;
+
+            case BLOCK:
+                waitFor(TryPush(this, newData), 0);
+                break;
+        }
+    }
+
+    notifyWaiters();
+    return true;
+}
+
+template <typename T>
+bool RingQueue<T>::popNoWait(T& data)
+{
+    if (tryPop(&data))
+    {
+        notifyWaiters();
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+T RingQueue<T>::popWait()
+{
+    // We pop into raw storage because T need not be default constructable
+    Storage storage;
+    T* data = reinterpret_cast<T*>(&storage);
+
+    waitFor(TryPop(this, data, true), 0);
+    notifyWaiters();
+    T temp(*data);
+    data->~T();
+    return temp;
+}
+
+template <typename T>
+bool RingQueue<T>::popTimedWait(const boost::xtime &timeout, T& data)
+{
+    // Boost uses and absolute timeout, so determine when we want to wake
+    // up based on the current time and how long the timeout is
+    boost::xtime now;
+    boost::xtime_get(&now, boost::TIME_UTC);
+    boost::xtime wakeUp = details::add_xtime(now, timeout);
+
+    if (waitFor(TryPop(this, &data), &wakeUp))
+    {
+        notifyWaiters();
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+size_t RingQueue<T>::popAll(std::vector<T>& items)
+{
+    items.reserve(items.size() + size());
+
+    // Take each item straight out of its cell, for shared_ptrs that is a
+    // swap, other types get one copy
+    size_t count = 0;
+    size_t pos = 0;
+    while (Cell* cell = claimFull(pos))
+    {
+        details::takeBack(items, *reinterpret_cast<T*>(&cell->storage));
+        releaseFull(cell, pos);
+        ++count;
+    }
+
+    // Only wake blocked producers once for the whole batch
+    if (count)
+        notifyWaiters();
+    return count;
+}
+
+template <typename T>
+template <typename OutputIterator>
+size_t RingQueue<T>::drainInto(OutputIterator out, size_t maxItems)
+{
+    // Assign straight from the cell, one copy per item
+    size_t count = 0;
+    size_t pos = 0;
+    Cell* cell = 0;
+    while ((count < maxItems) && (cell = claimFull(pos)))
+    {
+        *out++ = *reinterpret_cast<const T*>(&cell->storage);
+        releaseFull(cell, pos);
+        ++count;
+    }
+
+    // Only wake blocked producers once for the whole batch
+    if (count)
+        notifyWaiters();
+    return count;
+}
+
+template <typename T>
+size_t RingQueue<T>::capacity() const
+{
+    return m_mask + 1;
+}
+
+template <typename T>
+size_t RingQueue<T>::size() const
+{
+    size_t dequeuePos = m_dequeuePos.load(MEMORY_ORDER_RELAXED);
+    size_t enqueuePos = m_enqueuePos.load(MEMORY_ORDER_RELAXED);
+    if (enqueuePos < dequeuePos)
+        return 0;
+    return enqueuePos - dequeuePos;
+}
+
+template <typename T>
+size_t RingQueue<T>::highWaterMark() const
+{
+    return m_highWaterMark.load(MEMORY_ORDER_RELAXED);
+}
+
+template <typename T>
+size_t RingQueue<T>::dropped() const
+{
+    return m_dropped.load(MEMORY_ORDER_RELAXED);
+}
+
+template <typename T>
+bool RingQueue<T>::tryPush(const T& newData)
+{
+    Cell* cell = 0;
+    size_t pos = m_enqueuePos.load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        cell = &m_buffer[pos & m_mask];
+        size_t seq = cell->sequence.load(MEMORY_ORDER_ACQUIRE);
+        ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+        if (0 == diff)
+        {
+            // Cell is free, try to claim it
+            if (m_enqueuePos.compareExchange(pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The consumer has not emptied this cell yet, we are full
+            return false;
+        }
+        else
+        {
+            // Another producer beat us, try the new end
+            pos = m_enqueuePos.load(MEMORY_ORDER_RELAXED);
+        }
+    }
+
+    new (&cell->storage) T(newData);
+    cell->sequence.store(pos + 1, MEMORY_ORDER_RELEASE);
+
+    updateHighWaterMark(
+        pos + 1 - m_dequeuePos.load(MEMORY_ORDER_RELAXED));
+    return true;
+}
+
+template <typename T>
+bool RingQueue<T>::tryPop(T* data, bool construct)
+{
+    size_t pos = 0;
+    Cell* cell = claimFull(pos);
+    if (!cell)
+        return false;
+
+    T* item = reinterpret_cast<T*>(&cell->storage);
+    if (data && construct)
+    {
+        new (data) T(*item);
+    }
+    else if (data)
+    {
+        details::takeValue(*data, *item);
+    }
+
+    releaseFull(cell, pos);
+    return true;
+}
+
+template <typename T>
+typename RingQueue<T>::Cell* RingQueue<T>::claimFull(size_t& pos)
+{
+    Cell* cell = 0;
+    pos = m_dequeuePos.load(MEMORY_ORDER_RELAXED);
+    for (;;)
+    {
+        cell = &m_buffer[pos & m_mask];
+        size_t seq = cell->sequence.load(MEMORY_ORDER_ACQUIRE);
+        ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+
+        if (0 == diff)
+        {
+            // Cell is full, try to claim it
+            if (m_dequeuePos.compareExchange(pos, pos + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Nothing has been written here yet, we are empty
+            return 0;
+        }
+        else
+        {
+            // Another consumer beat us (only DROP_OLDEST producers)
+            pos = m_dequeuePos.load(MEMORY_ORDER_RELAXED);
+        }
+    }
+
+    return cell;
+}
+
+template <typename T>
+void RingQueue<T>::releaseFull(Cell* cell, size_t pos)
+{
+    reinterpret_cast<T*>(&cell->storage)->~T();
+
+    // Mark the cell free for the producer one lap around the ring from now
+    cell->sequence.store(pos + m_mask + 1, MEMORY_ORDER_RELEASE);
+}
+
+template <typename T>
+template <typename Ready>
+bool RingQueue<T>::waitFor(Ready ready, const boost::xtime* wakeUp)
+{
+    if (ready())
+        return true;
+
+    boost::mutex::scoped_lock lock(m_waitMutex);
+    m_waiters.fetchAdd(1);
+
+    bool success = true;
+    while (!ready())
+    {
+        if (wakeUp)
+        {
+            if (!m_changed.timed_wait(lock, *wakeUp))
+            {
+                // One last try in case we raced the timeout
+                success = ready();
+                break;
+            }
+        }
+        else
+        {
+            m_changed.wait(lock);
+        }
+    }
+
+    m_waiters.fetchSub(1);
+    return success;
+}
+
+template <typename T>
+void RingQueue<T>::notifyWaiters()
+{
+    // Pairs with the increment in waitFor, so either the waiter sees our
+    // change when it retries, or we see the waiter and wake it up
+    atomicFence();
+    if (m_waiters.load(MEMORY_ORDER_RELAXED) > 0)
+    {
+        boost::mutex::scoped_lock lock(m_waitMutex);
+        m_changed.notify_all();
+    }
+}
+
+template <typename T>
+void RingQueue<T>::updateHighWaterMark(size_t size)
+{
+    size_t current = m_highWaterMark.load(MEMORY_ORDER_RELAXED);
+    while ((size > current) && (size <= capacity()) &&
+           !m_highWaterMark.compareExchange(current, size))
+    {
+    }
+}
+
+} // namespace core
+} // namespace ram
+
+#endif // RAM_CORE_RINGQUEUE_H_03_14_2010
@@ -32,7 +32,15 @@ namespace core {
 class ThreadedAppender : public log4cpp::Appender, public Updatable
 {
 public:
-    ThreadedAppender(log4cpp::Appender* appender);
+    /** Wraps the given appender and starts the background thread
+     *
+     *  @param appender   The appender to write to in the background
+     *  @param queueSize  If non-zero the log queue is a bounded RingQueue
+     *  @param policy     What to do when a bounded queue is full
+     */
+    ThreadedAppender(log4cpp::Appender* appender, int queueSize = 0,
+                     RingQueueBase::OverflowPolicy policy =
+                     RingQueueBase::BLOCK);
     virtual ~ThreadedAppender();
 
     /** Waits for logging events and writes to files as possible*/        
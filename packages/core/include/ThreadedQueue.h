@@ -18,21 +18,24 @@
 #define RAM_CORE_THREADEDQUEUE_H_06_18_2007
 
 // STD Includes
-#include <queue>
+#include <deque>
+#include <vector>
+#include <limits>
 
 // Library Includes
 #include <boost/utility.hpp>
+#include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/xtime.hpp>
 
+// Project Includes
+#include "core/include/RingQueue.h"
+
 namespace ram {
 namespace core {
 
-namespace details {
-    boost::xtime add_xtime(const boost::xtime& a, const boost::xtime& b);
-}
-
 /** A templated queue similar to the std::queue, but thread safe 
 
     @remarks
@@ -68,16 +71,52 @@ namespace details {
         }
     }
     @endcode
+
+    @par
+    By default the queue is unbounded and protected by a mutex.  Calling
+    setBounded switches it over to a fixed size lock free RingQueue, which
+    avoids lock convoys and allocation when many threads push at once.
  */    
 template <typename T>
 class ThreadedQueue : boost::noncopyable
 {
 public:
-    void push(const T& newData)
+    ThreadedQueue() : m_highWaterMark(0) {}
+
+    /** Use a bounded lock free RingQueue instead of a locked std::queue
+
+        This must be called before the queue is shared with other threads.
+
+        @param capacity
+            Max items held, rounded up to a power of two, <= 0 means unbounded
+        @param policy
+            What push does when the queue is full
+     */
+    void setBounded(int capacity,
+                    RingQueueBase::OverflowPolicy policy =
+                    RingQueueBase::BLOCK)
+    {
+        if (capacity > 0)
+            m_ring.reset(new RingQueue<T>(capacity, policy));
+        else
+            m_ring.reset();
+    }
+
+    /** Adds the item to the queue
+
+        @return false if a bounded queue dropped the item
+     */
+    bool push(const T& newData)
     {
+        if (m_ring)
+            return m_ring->push(newData);
+        
         boost::mutex::scoped_lock lock(m_monitorMutex);
-        m_queue.push(newData);
+        m_queue.push_back(newData);
+        if (m_queue.size() > m_highWaterMark)
+            m_highWaterMark = m_queue.size();
         m_itemAvailable.notify_one();
+        return true;
     }
 
     /** Copies data into given parameter if there is data
@@ -90,6 +129,9 @@ public:
     */
     bool popNoWait(T& data)
     {
+        if (m_ring)
+            return m_ring->popNoWait(data);
+        
         boost::mutex::scoped_lock lock(m_monitorMutex);
 
         if(m_queue.empty())
@@ -99,7 +141,7 @@ public:
 
         // Grab the next item off the queue
         data = m_queue.front();
-        m_queue.pop();
+        m_queue.pop_front();
         
         return true;
     }
@@ -107,6 +149,9 @@ public:
     /** Waits until new data is queue and returns that item when its added */
     T popWait()
     {
+        if (m_ring)
+            return m_ring->popWait();
+        
         boost::mutex::scoped_lock lock(m_monitorMutex);
 
         if(m_queue.empty())
@@ -115,7 +160,7 @@ public:
         }
 
         T temp(m_queue.front());
-        m_queue.pop();
+        m_queue.pop_front();
         return temp;
     }
 
@@ -133,6 +178,9 @@ public:
     */
     bool popTimedWait(const boost::xtime &timeout, T& data)
     {
+        if (m_ring)
+            return m_ring->popTimedWait(timeout, data);
+        
         boost::mutex::scoped_lock lock(m_monitorMutex);
         bool success = true;
 
@@ -150,15 +198,90 @@ public:
         if (success)
         {
             data = m_queue.front();
-            m_queue.pop();
+            m_queue.pop_front();
             return true;
         }
         
         return false;
     }
 
+    /** Appends every queued item to the given vector
+
+        The whole pending batch is swapped out under a single lock, so
+        consumers which handle bursts of items only contend with the
+        producers once per batch instead of once per item.  shared_ptr items
+        are swapped into items, without touching their reference counts,
+        other types are copied once.
+
+        @return The number of items added to items
+     */
+    size_t popAll(std::vector<T>& items)
+    {
+        if (m_ring)
+            return m_ring->popAll(items);
+        
+        std::deque<T> batch;
+        {
+            boost::mutex::scoped_lock lock(m_monitorMutex);
+            batch.swap(m_queue);
+        }
+
+        items.reserve(items.size() + batch.size());
+        BOOST_FOREACH(T& item, batch)
+        {
+            details::takeBack(items, item);
+        }
+        return batch.size();
+    }
+
+    /** Copies up to maxItems queued items to out, in queue order
+
+        @return The number of items written to out
+     */
+    template <typename OutputIterator>
+    size_t drainInto(OutputIterator out,
+                     size_t maxItems = std::numeric_limits<size_t>::max())
+    {
+        if (m_ring)
+            return m_ring->drainInto(out, maxItems);
+        
+        boost::mutex::scoped_lock lock(m_monitorMutex);
+        size_t count = 0;
+        while (!m_queue.empty() && (count < maxItems))
+        {
+            *out++ = m_queue.front();
+            m_queue.pop_front();
+            ++count;
+        }
+        return count;
+    }
+    
+    /** The largest number of items that has been queued at once */
+    size_t highWaterMark()
+    {
+        if (m_ring)
+            return m_ring->highWaterMark();
+        
+        boost::mutex::scoped_lock lock(m_monitorMutex);
+        return m_highWaterMark;
+    }
+
+    /** Items dropped because a bounded queue was full, always 0 otherwise */
+    size_t dropped()
+    {
+        if (m_ring)
+            return m_ring->dropped();
+        return 0;
+    }
+
 private:
-    std::queue<T> m_queue;
+    std::deque<T> m_queue;
+
+    /** Largest size of m_queue */
+    size_t m_highWaterMark;
+
+    /** When non-null all operations go here instead of m_queue */
+    boost::scoped_ptr<RingQueue<T> > m_ring;
 
     boost::mutex m_monitorMutex;
     boost::condition m_itemAvailable;
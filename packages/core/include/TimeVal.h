@@ -98,6 +98,18 @@ public:
 
         static TimeVal timeOfDay();
         /// Return the current time of day as timeval
+
+        static TimeVal clockTime();
+        ///< The time subsystems should use for time stamps and time deltas.
+        ///< This is timeOfDay() unless a virtual clock has been set, which
+        ///< the EventPlayer does when playing a log back faster or slower
+        ///< than real time.
+
+        static void setVirtualTime(double seconds);
+        ///< Sets the virtual clock, clockTime() returns it until cleared.
+
+        static void clearVirtualTime();
+        ///< Makes clockTime() return the real time of day again.
     
         void now();
         ///< Sets the time to hold the current time
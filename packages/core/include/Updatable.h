@@ -10,17 +10,26 @@
 #ifndef RAM_CORE_UPDATABLE_06_11_2006
 #define RAM_CORE_UPDATABLE_06_11_2006
 
+// STD Includes
+#include <set>
+#include <string>
+
 // Library Includes
 #include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 // Forward declare boost::thread
 namespace boost { class thread; }
 
+namespace ram { namespace core { class Executor; class LoopStatistics; } }
+
 // Project Includes
 #include "core/include/IUpdatable.h"
 #include "core/include/CountDownLatch.h"
 #include "core/include/EventPublisher.h"
+#include "core/include/ConfigNode.h"
 
 // Must Be Included last
 #include "core/include/Export.h"
@@ -36,6 +45,27 @@ namespace core {
 class RAM_EXPORT Updatable : public IUpdatable, boost::noncopyable
 {
 public:
+    /** What the background loop does when update runs past its deadline */
+    enum OverrunPolicy
+    {
+        /** Drop the missed updates and wait for the next deadline on the
+         *  original schedule */
+        OVERRUN_SKIP,
+        /** Run the missed updates back to back until back on schedule */
+        OVERRUN_CATCH_UP,
+        /** Start a new schedule one full interval from now */
+        OVERRUN_REALIGN
+    };
+
+    /** Kernel scheduling policy used for the RT_* priorities */
+    enum RealTimePolicy
+    {
+        /** SCHED_FIFO, runs until it blocks or a higher priority is ready */
+        RT_FIFO,
+        /** SCHED_RR, like RT_FIFO but time sliced between equal priorities */
+        RT_ROUND_ROBIN
+    };
+    
     Updatable(EventPublisher *publisher = NULL);
     virtual ~Updatable();
 
@@ -45,7 +75,87 @@ public:
 
     virtual void setAffinity(size_t core);
 
+    /** Returns the lowest CPU in the affinity mask, -1 if none is set */
     virtual int getAffinity();
+
+    /** Lets the background thread run on any of the given CPUs
+     *
+     *  An empty set removes any affinity.
+     */
+    void setAffinityMask(const std::set<size_t>& cpus);
+
+    std::set<size_t> getAffinityMask();
+
+    /** Converts a CPU list ("0,2-3") or hex mask ("0xd") to a set of CPUs
+     *
+     * @warning
+     *     This will assert if the string does not parse
+     */
+    static std::set<size_t> stringToCpuSet(std::string str);
+
+    /** Reads a "cpus" setting, missing gives the empty set
+     *
+     *  The config loaders hand an unquoted 0xd to us as the number 13, so a
+     *  bare number is taken as a mask the same way taskset(1) would.
+     */
+    static std::set<size_t> configToCpuSet(ConfigNode config);
+
+    /** The number of CPUs in the machine, including isolated ones */
+    static size_t getCpuCount();
+    
+    /** Sets the policy for the RT_* priorities, the default is RT_FIFO */
+    void setRealTimePolicy(RealTimePolicy policy);
+
+    RealTimePolicy getRealTimePolicy();
+
+    /** Converts "fifo" or "rr" to a RealTimePolicy
+     *
+     * @warning
+     *     This will assert if the string does not match properly
+     */
+    static RealTimePolicy stringToRealTimePolicy(std::string str);
+
+    /** Overrides the kernel priority used for the RT_* priorities
+     *
+     *  @param value
+     *      Clamped to the range of the real time policy, -1 restores the
+     *      default for the current priority.
+     */
+    void setRealTimePriority(int value);
+
+    /** Lock memory and prefault the stack when the thread goes real time
+     *
+     *  Page faults are the largest source of latency for a real time
+     *  thread, mlockall keeps the whole process resident, and touching the
+     *  stack up front keeps it from faulting in during update.
+     *
+     *  @param lock
+     *      Calls mlockall(MCL_CURRENT | MCL_FUTURE), this is process wide
+     *      and is never undone.
+     *  @param prefaultStack
+     *      Bytes of stack to touch, 0 to skip
+     */
+    void setMemoryLocking(bool lock, size_t prefaultStack = 0);
+
+    /** Run on the given Executor's worker pool instead of a dedicated thread
+     *
+     *  Must be called while not backgrounded.  NULL goes back to a dedicated
+     *  thread.  The executor must outlive this object, or be destroyed
+     *  first, in which case this goes back to a dedicated thread.
+     */
+    void setExecutor(Executor* executor);
+
+    Executor* getExecutor();
+
+    /** Current time of the clock used for update deadlines (microseconds)
+     *
+     *  CLOCK_MONOTONIC where available, so it never jumps with the wall
+     *  clock.
+     */
+    static boost::int64_t monotonicTime();
+
+    /** Sleeps until monotonicTime() reaches the given deadline */
+    static void sleepUntil(boost::int64_t deadline);
     
     virtual void update(double timestep) = 0;
 
@@ -55,6 +165,22 @@ public:
 
     virtual bool backgrounded();
 
+    /** Sets how the background loop recovers from an overrun, the default
+     *  is OVERRUN_REALIGN */
+    void setOverrunPolicy(OverrunPolicy policy);
+
+    OverrunPolicy getOverrunPolicy();
+
+    /** Converts "skip", "catch_up" or "realign" to an OverrunPolicy
+     *
+     * @warning
+     *     This will assert if the string does not match properly
+     *
+     * @param str
+     *     Case insensitive.
+     */
+    static OverrunPolicy stringToOverrunPolicy(std::string str);
+    
 protected:
     /** Gets copies of the internal state */
     void getState(bool& backgrounded, int& interval);
@@ -64,8 +190,24 @@ protected:
 
     /** This function executes the wait for next frame */
     virtual void waitForUpdate(long microseconds);
+
+    /** Sleeps until the given monotonic clock time (microseconds)
+     *
+     *  On Linux this is a single absolute clock_nanosleep, so it does not
+     *  drift with the time spent computing how long to sleep.
+     */
+    virtual void waitUntil(boost::int64_t deadline);
+
+    /** The clock the background loop times updates with (microseconds)
+     *
+     *  monotonicTime() by default.  Overriding it along with waitUntil runs
+     *  the loop on another clock, like the TimeVal virtual clock in tests.
+     */
+    virtual boost::int64_t loopTime();
     
 private:
+    friend class Executor;
+    
     /** Simple message to talk to background thread */
     enum StateChange {
         PRIORITY = 1,
@@ -86,6 +228,25 @@ private:
 
     /** Sets the affinity of the running thread */
     void setThreadAffinity();
+
+    /** Starts a new PROFILE and TIMING report window */
+    void resetStatistics();
+
+    /** Records one call to update, publishing the reports once a second
+     *
+     *  Called from whichever thread ran the update, our own or a worker of
+     *  the Executor, so both publish the same events.
+     *
+     *  @param start   Monotonic time the update started
+     *  @param end     Monotonic time the update returned
+     *  @param period  Time since the previous update started, 0 if this is
+     *                 the first
+     */
+    void recordUpdate(boost::int64_t start, boost::int64_t end,
+                      boost::int64_t period);
+
+    /** Records an update which could not start on time */
+    void recordOverrun();
     
     /** Guard the interval and background */
     boost::mutex m_upStateMutex;
@@ -100,8 +261,20 @@ private:
     Priority m_priority;
     int m_priorityValue;
 
-    /** The core which background thread will run on */
-    int m_affinity;
+    /** The cores which background thread can run on, empty for any */
+    std::set<size_t> m_affinity;
+
+    /** Real time scheduling settings */
+    RealTimePolicy m_rtPolicy;
+    int m_rtPriorityValue;
+    bool m_lockMemory;
+    size_t m_prefaultStack;
+
+    /** How the loop handles running past a deadline */
+    OverrunPolicy m_overrunPolicy;
+
+    /** The pool we run on, NULL when we use our own thread */
+    Executor* m_executor;
 
     /** If the above settings have been changed */
     int m_settingChange;
@@ -117,6 +290,12 @@ private:
     /** The publisher to use for profiling updates */
     EventPublisher *m_publisher;
     unsigned int m_profileCount;
+
+    /** Timing of the updates in the current report window */
+    boost::scoped_ptr<LoopStatistics> m_statistics;
+
+    /** When the current report window started, 0 before the first update */
+    boost::int64_t m_reportStart;
 };
 
 } // namespace core
@@ -19,10 +19,17 @@
 #include <map>
 #include <sstream>
 #include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
 
 // Library Includes
 #include <boost/foreach.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <log4cpp/Category.hh>
 
 // Project Includes
 #include "core/include/Application.h"
@@ -31,7 +38,10 @@
 #include "core/include/Logging.h"
 #include "core/include/SubsystemMaker.h"
 #include "core/include/DependencyGraph.h"
+#include "core/include/Updatable.h"
+#include "core/include/Executor.h"
 #include "core/include/Feature.h"
+#include "core/include/TimeVal.h"
 
 #ifdef RAM_WITH_WRAPPERS
 #include <iostream>
@@ -50,8 +60,149 @@
 #define PYTHON_ERROR_CATCH(message)
 #endif
 
+static log4cpp::Category& LOGGER(
+    log4cpp::Category::getInstance("Application"));
+
 namespace ram {
 namespace core {
+
+namespace {
+
+/** A subsystem to build once all of its dependencies are built */
+struct Construction
+{
+    Construction(std::string name_, ConfigNode config_,
+                 SubsystemList deps_) :
+        name(name_),
+        config(config_),
+        deps(deps_),
+        makerFound(true),
+        seconds(0)
+    {
+    }
+
+    std::string name;
+    ConfigNode config;
+    SubsystemList deps;
+
+    /** Results, only touched by the thread building it */
+    SubsystemPtr subsystem;
+    bool makerFound;
+    double seconds;
+    std::string error;
+};
+
+/** Builds a single subsystem, errors other than a missing maker are thrown */
+void construct(Construction* job)
+{
+    TimeVal start(TimeVal::timeOfDay());
+    try {
+        job->subsystem = SubsystemMaker::newObject(
+            std::make_pair(job->config, job->deps));
+    } catch (core::MakerNotFoundException& ex) {
+        std::cout << ex.what() << " - " << job->name << std::endl;
+        job->makerFound = false;
+    }
+    job->seconds = TimeVal::timeOfDay().get_double() - start.get_double();
+}
+
+/** Body of the startup threads, builds jobs until there are none left */
+void constructLoop(std::vector<Construction*>* jobs, size_t* next,
+                   boost::mutex* mutex)
+{
+    while (true)
+    {
+        Construction* job = 0;
+        {
+            boost::mutex::scoped_lock lock(*mutex);
+            if (*next == jobs->size())
+                return;
+            job = (*jobs)[(*next)++];
+        }
+
+        // Errors are reported from the main thread
+        try {
+            construct(job);
+        } catch (std::exception& ex) {
+            job->error = ex.what();
+        } catch (...) {
+            job->error = "unknown error";
+        }
+    }
+}
+
+#ifdef RAM_WITH_WRAPPERS
+/** Lets the startup threads take the GIL while the main thread waits */
+class ScopedGILRelease
+{
+public:
+    ScopedGILRelease() :
+        m_state(0)
+    {
+        if (Py_IsInitialized())
+        {
+            PyEval_InitThreads();
+            m_state = PyEval_SaveThread();
+        }
+    }
+
+    ~ScopedGILRelease()
+    {
+        if (m_state)
+            PyEval_RestoreThread(m_state);
+    }
+
+private:
+    PyThreadState* m_state;
+};
+#else
+struct ScopedGILRelease {};
+#endif
+
+/** Builds all the given subsystems, using up to the given number of threads
+ *
+ *  Without more than one thread they are built in order on this thread,
+ *  exactly like they always were.
+ */
+void constructAll(std::vector<Construction*>& jobs, size_t threads)
+{
+    if ((threads < 2) || (jobs.size() < 2))
+    {
+        BOOST_FOREACH(Construction* job, jobs)
+        {
+            PYTHON_ERROR_TRY {
+                construct(job);
+            } PYTHON_ERROR_CATCH("Subsystem construction");
+        }
+        return;
+    }
+
+    size_t next = 0;
+    boost::mutex mutex;
+    {
+        ScopedGILRelease release;
+        boost::thread_group group;
+        for (size_t i = 0; i < std::min(threads, jobs.size()); ++i)
+        {
+            group.create_thread(
+                boost::bind(constructLoop, &jobs, &next, &mutex));
+        }
+        group.join_all();
+    }
+
+    BOOST_FOREACH(Construction* job, jobs)
+    {
+        if (!job->error.empty())
+        {
+            std::cerr << "ERROR: Subsystem construction of " << job->name
+                      << ": " << job->error << std::endl;
+            throw std::runtime_error("Subsystem construction of " + job->name
+                                     + " failed: " + job->error);
+        }
+    }
+}
+
+} // namespace
     
 Application::Application(std::string configPath) :
     m_running(false)
@@ -74,62 +225,124 @@ Application::Application(std::string configPath) :
         DependencyGraph depGraph(sysConfig);
         m_order = depGraph.getOrder();
 
+        // Subsystems with all their dependencies at a lower depth can be
+        // built at the same time, but only when the config can be read from
+        // several threads at once
+        size_t threads = 1;
+        if (ConfigNode::NATIVE == ConfigNode::defaultBackend())
+        {
+            int startupThreads =
+                rootCfg["SubsystemStartupThreads"].asInt(0);
+            if (startupThreads > 0)
+                threads = startupThreads;
+            else
+                threads = std::max(1u, boost::thread::hardware_concurrency());
+        }
+
         std::vector<std::string> badSubsystemNames;
         std::set<std::string> invalidSystems;
-        
-        // Create all the subsystems
+
+        // Set 'name' properly in the configs, before anything reads them
         BOOST_FOREACH(std::string subsystemName, m_order)
         {
-            // Skip "creationMode"
-            if (subsystemName == "creationMode") {
-                continue;
+            if ((subsystemName != "creationMode") &&
+                sysConfig.exists(subsystemName))
+            {
+                sysConfig[subsystemName].set("name", subsystemName);
             }
+        }
 
-            // If the subsystem has no configuration section, ignore it
-            if (!sysConfig.exists(subsystemName)) {
-                badSubsystemNames.push_back(subsystemName);
-                continue;
+        // Group the subsystems by depth, keeping the dependency order
+        // within each depth
+        std::map<std::string, int> depths;
+        std::vector<NameList> levels;
+        BOOST_FOREACH(std::string subsystemName, m_order)
+        {
+            int depth = 0;
+            BOOST_FOREACH(std::string depName,
+                          depGraph.getDependencies(subsystemName))
+            {
+                if (depths.count(depName))
+                    depth = std::max(depth, depths[depName] + 1);
             }
+            depths[subsystemName] = depth;
 
-            // Set 'name' properly in the config
-            ConfigNode config(sysConfig[subsystemName]);
-            config.set("name", subsystemName);
-        
-            // Build list of dependencies
-            SubsystemList deps;
-            NameList depNames = depGraph.getDependencies(subsystemName);
-            bool abort = false;
-            BOOST_FOREACH(std::string depName, depNames)
+            if ((int)levels.size() <= depth)
+                levels.resize(depth + 1);
+            levels[depth].push_back(subsystemName);
+        }
+
+        // Create all the subsystems, one depth at a time
+        BOOST_FOREACH(NameList& level, levels)
+        {
+            std::vector<Construction*> jobs;
+            BOOST_FOREACH(std::string subsystemName, level)
             {
-                if (!hasSubsystem(depName) ||
-                    invalidSystems.count(depName) == 1) {
-                    // The dependencies have not been satisfied
-                    abort = true;
-                    break;
+                // Skip "creationMode"
+                if (subsystemName == "creationMode") {
+                    continue;
+                }
+
+                // If the subsystem has no configuration section, ignore it
+                if (!sysConfig.exists(subsystemName)) {
+                    badSubsystemNames.push_back(subsystemName);
+                    continue;
+                }
+
+                // Build list of dependencies
+                SubsystemList deps;
+                NameList depNames = depGraph.getDependencies(subsystemName);
+                bool abort = false;
+                BOOST_FOREACH(std::string depName, depNames)
+                {
+                    if (!hasSubsystem(depName) ||
+                        invalidSystems.count(depName) == 1) {
+                        // The dependencies have not been satisfied
+                        abort = true;
+                        break;
+                    }
+                    deps.push_back(getSubsystem(depName));
+                }
+
+                if (abort) {
+                    // The dependencies were not satisfied
+                    // do not make this subsystem
+                    // Remove from the order
+                    badSubsystemNames.push_back(subsystemName);
+                    continue;
                 }
-                deps.push_back(getSubsystem(depName));
+
+                jobs.push_back(new Construction(
+                    subsystemName, sysConfig[subsystemName], deps));
             }
 
-            if (abort) {
-                // The dependencies were not satisfied
-                // do not make this subsystem
-                // Remove from the order
-                badSubsystemNames.push_back(subsystemName);
-                continue;
+            try {
+                constructAll(jobs, threads);
+            } catch (...) {
+                BOOST_FOREACH(Construction* job, jobs)
+                {
+                    delete job;
+                }
+                throw;
             }
 
-            // Create out new subsystem and store it
-            PYTHON_ERROR_TRY {
-                try {
-                    SubsystemPtr subsystem(SubsystemMaker::newObject(
-                                               std::make_pair(config, deps) ));
-                    m_subsystems[subsystemName] = subsystem;
-                } catch (core::MakerNotFoundException& ex) {
-                    std::cout << ex.what() << " - "
-                              << subsystemName << std::endl;
-                    invalidSystems.insert(subsystemName);
+            // Store our new subsystems
+            BOOST_FOREACH(Construction* job, jobs)
+            {
+                if (job->makerFound)
+                {
+                    m_subsystems[job->name] = job->subsystem;
+                    LOGGER.infoStream() << "Constructed " << job->name
+                                        << " in "
+                                        << (int)(job->seconds * 1000)
+                                        << " ms";
                 }
-            } PYTHON_ERROR_CATCH("Subsystem construction");
+                else
+                {
+                    invalidSystems.insert(job->name);
+                }
+                delete job;
+            }
         }
         
         // Add invalid systems to the bad subsystems
@@ -163,6 +376,31 @@ Application::Application(std::string configPath) :
         {
             PYTHON_ERROR_TRY {
                 ConfigNode cfg(sysConfig[name]);
+
+                // Must be set before the subsystem is backgrounded
+                if (cfg.exists("executor"))
+                {
+                    std::string executorName(cfg["executor"].asString());
+                    Updatable* updatable = dynamic_cast<Updatable*>(
+                        m_subsystems[name].get());
+                    Executor* executor = 0;
+                    if (hasSubsystem(executorName))
+                    {
+                        executor = dynamic_cast<Executor*>(
+                            getSubsystem(executorName).get());
+                    }
+
+                    if (updatable && executor)
+                    {
+                        updatable->setExecutor(executor);
+                    }
+                    else
+                    {
+                        std::cout << "WARNING: " << name << " can't run on "
+                                  << "executor " << executorName << std::endl;
+                    }
+                }
+                
                 if (cfg.exists("update_interval"))
                 {
                     int updateInterval = cfg["update_interval"].asInt();
@@ -176,9 +414,50 @@ Application::Application(std::string configPath) :
                         IUpdatable::stringToPriority(priority));
                 }
                 
+                // Settings only a plain Updatable understands
+                Updatable* updatable = dynamic_cast<Updatable*>(
+                    m_subsystems[name].get());
+                
+                // A single core, sets of CPUs go under "cpus"
                 if (cfg.exists("affinity"))
-                {
                     m_subsystems[name]->setAffinity(cfg["affinity"].asInt());
+
+                if (cfg.exists("cpus") && updatable)
+                {
+                    updatable->setAffinityMask(
+                        Updatable::configToCpuSet(cfg["cpus"]));
+                }
+
+                if (updatable)
+                {
+                    if (cfg.exists("overrun_policy"))
+                    {
+                        updatable->setOverrunPolicy(
+                            Updatable::stringToOverrunPolicy(
+                                cfg["overrun_policy"].asString()));
+                    }
+
+                    if (cfg.exists("rt_policy"))
+                    {
+                        updatable->setRealTimePolicy(
+                            Updatable::stringToRealTimePolicy(
+                                cfg["rt_policy"].asString()));
+                    }
+
+                    if (cfg.exists("rt_priority"))
+                    {
+                        updatable->setRealTimePriority(
+                            cfg["rt_priority"].asInt());
+                    }
+
+                    if (cfg.exists("lock_memory") ||
+                        cfg.exists("prefault_stack"))
+                    {
+                        updatable->setMemoryLocking(
+                            cfg["lock_memory"].asInt(0) != 0,
+                            (size_t)std::max(
+                                0, cfg["prefault_stack"].asInt(0)));
+                    }
                 }
             } PYTHON_ERROR_CATCH("Subsystem setup");
         } // foreach name in order
@@ -7,6 +7,10 @@
  * File:  packages/core/src/ConfigNode.cpp
  */
 
+// STD Includes
+#include <cstdlib>
+#include <cstring>
+
 // Library Includes
 #include <boost/filesystem.hpp>
 
@@ -14,6 +18,7 @@
 #include "core/include/ConfigNode.h"
 #include "core/include/ConfigNodeImp.h"
 #include "core/include/PythonConfigNodeImp.h"
+#include "core/include/NativeConfigNodeImp.h"
 
 namespace ram {
 namespace core {
@@ -99,6 +104,13 @@ void ConfigNode::set(std::string key, int value)
     
 ConfigNode ConfigNode::fromString(std::string data)
 {
+    return fromString(data, defaultBackend());
+}
+
+ConfigNode ConfigNode::fromString(std::string data, Backend backend)
+{
+    if (NATIVE == backend)
+        return ConfigNode(NativeConfigNodeImp::fromYamlString(data));
     return ConfigNode(ConfigNodeImpPtr(new PythonConfigNodeImp(data)));
 }
 
@@ -109,14 +121,29 @@ std::string ConfigNode::toString()
 }
 
 ConfigNode ConfigNode::fromFile(std::string configPath)
+{
+    return fromFile(configPath, defaultBackend());
+}
+
+ConfigNode ConfigNode::fromFile(std::string configPath, Backend backend)
 {
     boost::filesystem::path path(configPath);
     if (path.extension() == ".yml" || path.extension() == ".sml") {
+        if (NATIVE == backend)
+            return ConfigNode(NativeConfigNodeImp::fromYamlFile(path.string()));
         return ConfigNode(PythonConfigNodeImp::fromYamlFile(path.string()));
     } else {
         assert(false && "Invalid configuration type!");
     }
 }
+
+ConfigNode::Backend ConfigNode::defaultBackend()
+{
+    const char* backend = getenv("RAM_CONFIG_BACKEND");
+    if (backend && (0 == strcmp(backend, "native")))
+        return NATIVE;
+    return PYTHON;
+}
     
 ConfigNode::ConfigNode(ConfigNodeImpPtr impl) :
     m_impl(impl)
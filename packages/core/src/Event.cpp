@@ -7,16 +7,52 @@
  * File:  packages/core/src/Event.cpp
  */
 
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/unordered_map.hpp>
+
 // Project Includes
 #include "core/include/Event.h"
 #include "core/include/TimeVal.h"
+#include "core/include/ReadWriteMutex.h"
 
 namespace ram {
 namespace core {
 
+const Event::TypeId Event::UNKNOWN_TYPE;
+
+namespace {
+
+/** Holds the EventType <-> TypeId mapping */
+struct TypeRegistry
+{
+    TypeRegistry() : names(1, "") {}
+
+    /** Protects access to both members */
+    ReadWriteMutex mutex;
+
+    /** Maps type strings -> ids */
+    boost::unordered_map<Event::EventType, Event::TypeId> ids;
+
+    /** Maps ids -> type strings, id 0 is UNKNOWN_TYPE */
+    std::vector<Event::EventType> names;
+};
+
+/** Constructed on first use so it is safe to use during static init */
+TypeRegistry& getRegistry()
+{
+    static TypeRegistry registry;
+    return registry;
+}
+
+} // namespace
+
 Event::Event() :
+    typeId(UNKNOWN_TYPE),
     sender(0),
-    timeStamp(TimeVal::timeOfDay().get_double())
+    timeStamp(TimeVal::clockTime().get_double())
 {
 }
 
@@ -27,9 +63,52 @@ EventPtr Event::clone()
     return event;
 }
 
+Event::TypeId Event::registerType(const EventType& type)
+{
+    TypeRegistry& registry = getRegistry();
+
+    // Nearly all lookups are for types which already exist
+    {
+        ReadWriteMutex::ScopedReadLock lock(registry.mutex);
+        boost::unordered_map<EventType, TypeId>::const_iterator iter =
+            registry.ids.find(type);
+        if (registry.ids.end() != iter)
+            return iter->second;
+    }
+
+    // Check again because somebody could have beaten us to the write lock
+    ReadWriteMutex::ScopedWriteLock lock(registry.mutex);
+    boost::unordered_map<EventType, TypeId>::const_iterator iter =
+        registry.ids.find(type);
+    if (registry.ids.end() != iter)
+        return iter->second;
+
+    TypeId id = registry.names.size();
+    registry.names.push_back(type);
+    registry.ids[type] = id;
+    return id;
+}
+
+Event::EventType Event::typeName(TypeId id)
+{
+    TypeRegistry& registry = getRegistry();
+    ReadWriteMutex::ScopedReadLock lock(registry.mutex);
+
+    if (id < registry.names.size())
+        return registry.names[id];
+    return "";
+}
+
+Event::EventType Event::declareType(const EventType& type)
+{
+    registerType(type);
+    return type;
+}
+
 void Event::copyInto(EventPtr inEvent)
 {
     inEvent->type = type;
+    inEvent->typeId = typeId;
     inEvent->sender = sender;
     inEvent->timeStamp = timeStamp;
 }    
@@ -16,6 +16,10 @@
 // Event Types
 RAM_CORE_EVENT_TYPE(ram::core::EventHub, ALL_EVENTS);
 
+// Must come after ALL_EVENTS is defined
+static const ram::core::Event::TypeId ALL_EVENTS_ID =
+    ram::core::Event::registerType(ram::core::EventHub::ALL_EVENTS);
+
 // Register EventHub into the maker subsystem
 RAM_CORE_REGISTER_SUBSYSTEM_MAKER(ram::core::EventHub, EventHub);
 
@@ -91,30 +95,34 @@ EventConnectionPtr EventHub::subscribeToAll(
     
 void EventHub::publish(EventPtr event)
 {
+    // Events from an EventPublisher already have their id, only hand built
+    // ones need the string lookup
+    if (Event::UNKNOWN_TYPE == event->typeId)
+        event->typeId = Event::registerType(event->type);
+    
     // Publish to all subscribers of a specific event type
-    asType<TypeEventPublisherType>(m_impType)->publish(event->type,
-                                                       event->type,
-                                                       event->sender,
-                                                       event);
+    asType<TypeEventPublisherType>(m_impType)->publishToSlot(event->typeId,
+                                                             0, event);
 
     // Publish to all subscribers to specific EventType & EventPublisher pairs
-    asType<TypePublisherEventPublisherType>(m_impTypePublisher)->publish(
-        std::make_pair(event->type, event->sender),
-        event->type,
-        event->sender,
-        event);
+    asType<TypePublisherEventPublisherType>(m_impTypePublisher)->publishToSlot(
+        event->typeId, event->sender, event);
 
     // Publish to subscribers who want all events
-    asType<TypeEventPublisherType>(m_impAll)->publish(
-        EventHub::ALL_EVENTS,
-        event->type,
-        event->sender,
-        event);
+    asType<TypeEventPublisherType>(m_impAll)->publishToSlot(ALL_EVENTS_ID,
+                                                            0, event);
 }
 
 void EventHub::publish(Event::EventType etype, EventPtr event)
+{
+    publish(Event::registerType(etype), etype, event);
+}
+
+void EventHub::publish(Event::TypeId typeId, Event::EventType etype,
+                       EventPtr event)
 {
     event->type = etype;
+    event->typeId = typeId;
     event->sender = this;
     publish(event);
 }
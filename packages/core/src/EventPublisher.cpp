@@ -49,7 +49,13 @@ EventConnectionPtr EventPublisher::subscribe(
 
 void EventPublisher::publish(Event::EventType type, EventPtr event)
 {
-    asType(m_imp)->publish(type, type, this, event);
+    asType(m_imp)->publish(type, this, event);
+}
+
+void EventPublisher::publish(Event::TypeId typeId, Event::EventType type,
+                             EventPtr event)
+{
+    asType(m_imp)->publish(typeId, type, this, event);
 }
 
 std::string EventPublisher::getPublisherName()
@@ -22,6 +22,8 @@ static ram::core::SpecificEventConverter<ram::core::StringEvent>
 RAM_CORE_STRINGEVENT;
 static ram::core::SpecificEventConverter<ram::core::IntEvent>
 RAM_CORE_INTEVENT;
+static ram::core::SpecificEventConverter<ram::core::UpdateTimingEvent>
+RAM_CORE_UPDATETIMINGEVENT;
    
 #endif // RAM_WITH_WRAPPERS
 
@@ -44,5 +46,36 @@ EventPtr IntEvent::clone()
     return event;
 }
 
+UpdateTimingEvent::UpdateTimingEvent() :
+    updates(0),
+    overruns(0),
+    minPeriod(0),
+    meanPeriod(0),
+    maxPeriod(0),
+    p99Period(0),
+    jitter(0),
+    minExecTime(0),
+    meanExecTime(0),
+    maxExecTime(0)
+{
+}
+
+EventPtr UpdateTimingEvent::clone()
+{
+    UpdateTimingEventPtr event = UpdateTimingEventPtr(new UpdateTimingEvent());
+    copyInto(event);
+    event->updates = updates;
+    event->overruns = overruns;
+    event->minPeriod = minPeriod;
+    event->meanPeriod = meanPeriod;
+    event->maxPeriod = maxPeriod;
+    event->p99Period = p99Period;
+    event->jitter = jitter;
+    event->minExecTime = minExecTime;
+    event->meanExecTime = meanExecTime;
+    event->maxExecTime = maxExecTime;
+    return event;
+}
+
 } // namespace core
 } // namespace ram
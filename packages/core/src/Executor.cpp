@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/src/Executor.cpp
+ */
+
+// STD Includes
+#include <stdio.h>
+#include <cassert>
+#include <algorithm>
+
+// Library Includes
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "core/include/Executor.h"
+#include "core/include/Updatable.h"
+#include "core/include/SubsystemMaker.h"
+
+// System Includes
+#ifdef RAM_LINUX
+#include <sched.h>
+#endif
+
+// Register executor in subsystem maker system
+RAM_CORE_REGISTER_SUBSYSTEM_MAKER(ram::core::Executor, Executor);
+
+namespace ram {
+namespace core {
+
+typedef boost::int64_t Usec;
+
+const static Usec USEC_PER_SEC = 1000000;
+const static Usec USEC_PER_MILLISEC = 1000;
+
+/** Longest the timer sleeps at once.  Condition waits are against the wall
+ *  clock, so this bounds how late a step back of the clock can make it. */
+const static Usec MAX_TIMER_WAIT = 50 * USEC_PER_MILLISEC;
+
+/** An Updatable scheduled on the pool */
+struct Executor::Task
+{
+    Task(Updatable* updatable_, int interval_, size_t worker_,
+         Usec deadline_) :
+        updatable(updatable_),
+        interval(interval_),
+        worker(worker_),
+        deadline(deadline_),
+        lastStart(0),
+        queued(false),
+        running(false),
+        cancelled(false)
+    {
+    }
+
+    Updatable* updatable;
+
+    /** Milliseconds between updates, <= 0 runs all out */
+    int interval;
+
+    /** The worker whose queue this task goes on */
+    size_t worker;
+
+    /** When the next update should start */
+    Usec deadline;
+
+    /** When the last update started, 0 before the first one */
+    Usec lastStart;
+
+    /** Whether the task is on a worker queue or in the wheel */
+    bool queued;
+
+    /** Whether a worker is calling update right now */
+    bool running;
+
+    /** Set to drop the task the next time a worker or the timer sees it */
+    bool cancelled;
+
+    /** The worker thread running the task */
+    boost::thread::id runner;
+};
+
+Executor::Executor(std::string name, size_t threads, std::set<size_t> cpus,
+                   int tickUSec, size_t wheelSize) :
+    Subsystem(name)
+{
+    init(threads, cpus, tickUSec, wheelSize);
+}
+
+Executor::Executor(ConfigNode config, SubsystemList deps) :
+    Subsystem(config["name"].asString(), deps)
+{
+    init((size_t)std::max(0, config["threads"].asInt(0)),
+         Updatable::configToCpuSet(config["cpus"]),
+         config["tick"].asInt(1000),
+         (size_t)std::max(1, config["wheelSize"].asInt(512)));
+}
+
+Executor::~Executor()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_shutdown = true;
+        m_workAvailable.notify_all();
+        m_timerWake.notify_all();
+    }
+    m_threads.join_all();
+
+    // Anything still scheduled goes back to a dedicated thread and keeps
+    // running, so losing the pool first does not silently stop a subsystem
+    typedef std::map<Updatable*, TaskPtr>::value_type TaskPair;
+    BOOST_FOREACH(TaskPair& pair, m_tasks)
+    {
+        if (!pair.second->cancelled)
+        {
+            Updatable* updatable = pair.first;
+            {
+                boost::mutex::scoped_lock lock(updatable->m_upStateMutex);
+                updatable->m_executor = 0;
+                updatable->m_backgrounded = false;
+            }
+            updatable->Updatable::background(pair.second->interval);
+        }
+    }
+}
+
+void Executor::init(size_t threads, std::set<size_t> cpus, int tickUSec,
+                    size_t wheelSize)
+{
+    if (0 == threads)
+        threads = std::max(1u, boost::thread::hardware_concurrency());
+
+    m_shutdown = false;
+    m_nextWorker = 0;
+    m_threadCount = threads;
+    m_queues.resize(threads);
+    m_wheel.resize(std::max((size_t)1, wheelSize));
+    m_tick = std::max(1, tickUSec);
+    m_lastTick = Updatable::monotonicTime() / m_tick;
+
+    std::vector<size_t> cpuList(cpus.begin(), cpus.end());
+    for (size_t i = 0; i < threads; ++i)
+    {
+        int cpu = cpuList.empty() ? -1 : (int)cpuList[i % cpuList.size()];
+        m_threads.create_thread(
+            boost::bind(&Executor::workerLoop, this, i, cpu));
+    }
+    m_threads.create_thread(boost::bind(&Executor::timerLoop, this));
+}
+
+void Executor::schedule(Updatable* updatable, int interval)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    std::map<Updatable*, TaskPtr>::iterator iter = m_tasks.find(updatable);
+    if (m_tasks.end() != iter)
+    {
+        // Change the interval, and pick the task back up if it was on its
+        // way out
+        TaskPtr task = iter->second;
+        task->interval = interval;
+        task->cancelled = false;
+        return;
+    }
+
+    // Not running anywhere yet, so safe to touch from here
+    updatable->resetStatistics();
+    
+    TaskPtr task(new Task(updatable, interval, m_nextWorker,
+                          Updatable::monotonicTime()));
+    m_nextWorker = (m_nextWorker + 1) % m_threadCount;
+    m_tasks[updatable] = task;
+    makeReady(task);
+}
+
+void Executor::cancel(Updatable* updatable, bool join)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    std::map<Updatable*, TaskPtr>::iterator iter = m_tasks.find(updatable);
+    if (m_tasks.end() == iter)
+        return;
+
+    // Workers and the timer drop it once they see it
+    TaskPtr task = iter->second;
+    task->cancelled = true;
+    if (!task->queued && !task->running)
+        m_tasks.erase(iter);
+
+    // Can't wait for ourselves to finish
+    if (join && (task->runner != boost::this_thread::get_id()))
+    {
+        while (task->running)
+            m_taskDone.wait(lock);
+    }
+}
+
+size_t Executor::getThreadCount()
+{
+    return m_threadCount;
+}
+
+void Executor::workerLoop(size_t worker, int cpu)
+{
+#ifdef RAM_LINUX
+    if (cpu >= 0)
+    {
+        cpu_set_t cpuMask;
+        CPU_ZERO(&cpuMask);
+        CPU_SET(cpu, &cpuMask);
+        if(sched_setaffinity(0, sizeof(cpuMask), &cpuMask))
+            perror("ERROR sched_setaffinity");
+    }
+#endif
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_shutdown)
+    {
+        TaskPtr task = nextTask(worker);
+        if (!task)
+        {
+            m_workAvailable.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        runTask(worker, task);
+        lock.lock();
+    }
+}
+
+void Executor::timerLoop()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_shutdown)
+    {
+        // Nothing parked, wait for enqueue to hand us something
+        if (m_wheelTicks.empty())
+        {
+            m_timerWake.wait(lock);
+            continue;
+        }
+
+        // Sleep until the earliest deadline, enqueue wakes us early if it
+        // adds an earlier one.  The wait is worked out from the monotonic
+        // clock right before each wait, then retried until it runs out.
+        Usec wait = *m_wheelTicks.begin() * m_tick -
+            Updatable::monotonicTime();
+        if (wait > 0)
+        {
+            wait = std::min(wait, MAX_TIMER_WAIT);
+            boost::xtime wakeUp;
+            boost::xtime_get(&wakeUp, boost::TIME_UTC);
+            wakeUp.sec += wait / USEC_PER_SEC;
+            wakeUp.nsec += (wait % USEC_PER_SEC) * 1000;
+            if (wakeUp.nsec >= 1000000000)
+            {
+                wakeUp.sec += 1;
+                wakeUp.nsec -= 1000000000;
+            }
+            m_timerWake.timed_wait(lock, wakeUp);
+            continue;
+        }
+
+        // Visit every slot we passed, but each one only once if we fell a
+        // whole rotation behind
+        Usec nowTick = Updatable::monotonicTime() / m_tick;
+        Usec slots = std::min(nowTick - m_lastTick, (Usec)m_wheel.size());
+        for (Usec i = 1; i <= slots; ++i)
+        {
+            TaskList& slot = m_wheel[(m_lastTick + i) % m_wheel.size()];
+            TaskList::iterator iter = slot.begin();
+            while (slot.end() != iter)
+            {
+                TaskPtr task = *iter;
+                Usec tick = task->deadline / m_tick;
+                if (task->cancelled)
+                {
+                    task->queued = false;
+                    dropTask(task);
+                    m_wheelTicks.erase(m_wheelTicks.find(tick));
+                    iter = slot.erase(iter);
+                }
+                else if (tick <= nowTick)
+                {
+                    m_wheelTicks.erase(m_wheelTicks.find(tick));
+                    iter = slot.erase(iter);
+                    makeReady(task);
+                }
+                else
+                {
+                    // Comes around on a later rotation
+                    ++iter;
+                }
+            }
+        }
+        m_lastTick = nowTick;
+    }
+}
+
+void Executor::runTask(size_t worker, TaskPtr task)
+{
+    Updatable* updatable = task->updatable;
+    int interval = 0;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        interval = task->interval;
+    }
+
+    // On the first run, use the ideal step like Updatable::loop
+    Usec start = Updatable::monotonicTime();
+    Usec diff = std::max(0, interval) * USEC_PER_MILLISEC;
+    Usec lastPeriod = 0;
+    if (0 != task->lastStart)
+    {
+        diff = start - task->lastStart;
+        lastPeriod = diff;
+    }
+    task->lastStart = start;
+
+    updatable->update(diff / (double)USEC_PER_SEC);
+    updatable->recordUpdate(start, Updatable::monotonicTime(), lastPeriod);
+    Updatable::OverrunPolicy overrunPolicy = updatable->getOverrunPolicy();
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    task->running = false;
+    task->runner = boost::thread::id();
+    m_taskDone.notify_all();
+
+    if (task->cancelled)
+    {
+        dropTask(task);
+        return;
+    }
+
+    // Pick up interval changes made during the update
+    interval = task->interval;
+    Usec now = Updatable::monotonicTime();
+    if (interval <= 0)
+    {
+        // Back of the line, so others on this worker get a turn
+        task->deadline = now;
+        makeReady(task);
+        return;
+    }
+
+    // Same deadline handling as Updatable::loop
+    Usec period = interval * USEC_PER_MILLISEC;
+    task->deadline += period;
+    if (task->deadline < now)
+    {
+        updatable->recordOverrun();
+        switch (overrunPolicy)
+        {
+            case Updatable::OVERRUN_SKIP:
+                task->deadline +=
+                    ((now - task->deadline) / period + 1) * period;
+                break;
+            case Updatable::OVERRUN_CATCH_UP:
+                break;
+            case Updatable::OVERRUN_REALIGN:
+                task->deadline = now + period;
+                break;
+        }
+    }
+    enqueue(task);
+}
+
+Executor::TaskPtr Executor::nextTask(size_t worker)
+{
+    for (size_t i = 0; i < m_threadCount; ++i)
+    {
+        std::deque<TaskPtr>& queue = m_queues[(worker + i) % m_threadCount];
+        while (!queue.empty())
+        {
+            // Our own work from the front, stolen work from the back
+            TaskPtr task;
+            if (0 == i)
+            {
+                task = queue.front();
+                queue.pop_front();
+            }
+            else
+            {
+                task = queue.back();
+                queue.pop_back();
+            }
+            task->queued = false;
+
+            if (task->cancelled)
+            {
+                dropTask(task);
+                continue;
+            }
+
+            task->running = true;
+            task->runner = boost::this_thread::get_id();
+            return task;
+        }
+    }
+
+    return TaskPtr();
+}
+
+void Executor::enqueue(TaskPtr task)
+{
+    Usec tick = task->deadline / m_tick;
+    if (tick <= m_lastTick)
+    {
+        makeReady(task);
+        return;
+    }
+
+    task->queued = true;
+    m_wheel[tick % m_wheel.size()].push_back(task);
+
+    bool earliest = m_wheelTicks.empty() || (tick < *m_wheelTicks.begin());
+    m_wheelTicks.insert(tick);
+    if (earliest)
+        m_timerWake.notify_one();
+}
+
+void Executor::makeReady(TaskPtr task)
+{
+    task->queued = true;
+    m_queues[task->worker].push_back(task);
+    m_workAvailable.notify_one();
+}
+
+void Executor::dropTask(TaskPtr task)
+{
+    std::map<Updatable*, TaskPtr>::iterator iter =
+        m_tasks.find(task->updatable);
+    if ((m_tasks.end() != iter) && (iter->second == task))
+        m_tasks.erase(iter);
+}
+
+void Executor::update(double)
+{
+}
+
+void Executor::setPriority(IUpdatable::Priority)
+{
+}
+
+IUpdatable::Priority Executor::getPriority()
+{
+    return IUpdatable::NORMAL_PRIORITY;
+}
+
+void Executor::setAffinity(size_t)
+{
+}
+
+int Executor::getAffinity()
+{
+    return -1;
+}
+
+void Executor::background(int)
+{
+}
+
+void Executor::unbackground(bool)
+{
+}
+
+bool Executor::backgrounded()
+{
+    return true;
+}
+
+} // namespace core
+} // namespace ram
@@ -18,6 +18,7 @@
 #include "core/include/IUpdatable.h"
 
 RAM_CORE_EVENT_TYPE(ram::core::IUpdatable, PROFILE);
+RAM_CORE_EVENT_TYPE(ram::core::IUpdatable, TIMING);
 
 namespace ram {
 namespace core {
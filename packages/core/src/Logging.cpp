@@ -255,7 +255,10 @@ log4cpp::Appender* Logging::createAppender(
     if (appender)
     {
         // Wrap in a background threaded container
-        appender = new ThreadedAppender(appender);
+        appender = new ThreadedAppender(appender,
+            config["queueSize"].asInt(0),
+            RingQueueBase::policyFromString(
+                config["queueOverflow"].asString("block")));
         
         // Set layout (using default if needed)
         log4cpp::Layout* layout = 0;
@@ -0,0 +1,1311 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/src/NativeConfigNodeImp.cpp
+ */
+
+// STD Includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cctype>
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+// Library Includes
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "core/include/NativeConfigNodeImp.h"
+#include "core/include/Exception.h"
+
+namespace ram {
+namespace core {
+
+typedef NativeConfigNodeImp::ValuePtr ValuePtr;
+
+struct NativeConfigNodeImp::Value
+{
+    enum Type
+    {
+        NONE,
+        SCALAR,
+        SEQUENCE,
+        MAP
+    };
+
+    Value(Type type_ = NONE) : type(type_), quoted(false) {}
+
+    Type type;
+
+    /** Text of a scalar, without quotes */
+    std::string text;
+
+    /** Quoted scalars are always strings */
+    bool quoted;
+
+    std::vector<ValuePtr> items;
+    std::map<std::string, ValuePtr> entries;
+};
+
+typedef NativeConfigNodeImp::Value Value;
+typedef std::map<std::string, ValuePtr>::value_type Entry;
+
+// ------------------------------------------------------------------------- //
+//                           S C A L A R   T Y P E S                         //
+// ------------------------------------------------------------------------- //
+
+/** Removes the YAML digit separators */
+static std::string stripUnderscores(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.size());
+    BOOST_FOREACH(char c, text)
+    {
+        if ('_' != c)
+            result += c;
+    }
+    return result;
+}
+
+static bool isNull(const ValuePtr& value)
+{
+    if (!value || (Value::NONE == value->type))
+        return true;
+    if ((Value::SCALAR != value->type) || value->quoted)
+        return false;
+
+    // Python's None is accepted as well, for strings made by toString
+    const std::string& t = value->text;
+    return (t == "~") || (t == "null") || (t == "Null") || (t == "NULL") ||
+        (t == "None");
+}
+
+/** Parses a YAML 1.1 boolean, like PyYAML does */
+static bool toBool(const ValuePtr& value, bool& result)
+{
+    if ((Value::SCALAR != value->type) || value->quoted)
+        return false;
+
+    const std::string& t = value->text;
+    if ((t == "true") || (t == "True") || (t == "TRUE") || (t == "yes") ||
+        (t == "Yes") || (t == "YES") || (t == "on") || (t == "On") ||
+        (t == "ON"))
+    {
+        result = true;
+        return true;
+    }
+    if ((t == "false") || (t == "False") || (t == "FALSE") || (t == "no") ||
+        (t == "No") || (t == "NO") || (t == "off") || (t == "Off") ||
+        (t == "OFF"))
+    {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+/** Parses a YAML 1.1 integer (decimal, 0x hex, 0b binary or 0 octal) */
+static bool toLong(const ValuePtr& value, long& result)
+{
+    if ((Value::SCALAR != value->type) || value->quoted ||
+        value->text.empty())
+    {
+        return false;
+    }
+
+    std::string text = stripUnderscores(value->text);
+    size_t start = (('-' == text[0]) || ('+' == text[0])) ? 1 : 0;
+    if (start == text.size())
+        return false;
+
+    int base = 10;
+    std::string digits = text.substr(start);
+    if ((digits.size() > 2) && ('0' == digits[0]) &&
+        (('x' == digits[1]) || ('b' == digits[1])))
+    {
+        base = ('x' == digits[1]) ? 16 : 2;
+        digits = digits.substr(2);
+    }
+    else if ((digits.size() > 1) && ('0' == digits[0]))
+    {
+        base = 8;
+    }
+
+    // strtol would also accept white space and signs here
+    for (size_t i = 0; i < digits.size(); ++i)
+    {
+        if (!isxdigit((unsigned char)digits[i]))
+            return false;
+    }
+
+    char* end = 0;
+    errno = 0;
+    result = strtol(digits.c_str(), &end, base);
+    if ((0 != *end) || (0 != errno))
+        return false;
+    if ('-' == text[0])
+        result = -result;
+    return true;
+}
+
+/** Parses a YAML 1.1 float, which unlike C needs a '.' and a signed
+ *  exponent ("1.5e+3", ".5" and "-0.5" but not "-.5" or "1e3")
+ */
+static bool toFloat(const ValuePtr& value, double& result)
+{
+    if ((Value::SCALAR != value->type) || value->quoted ||
+        value->text.empty())
+    {
+        return false;
+    }
+
+    const std::string& t = value->text;
+    if ((t == ".nan") || (t == ".NaN") || (t == ".NAN"))
+    {
+        result = strtod("nan", 0);
+        return true;
+    }
+
+    size_t pos = (('-' == t[0]) || ('+' == t[0])) ? 1 : 0;
+    std::string body = t.substr(pos);
+    if ((body == ".inf") || (body == ".Inf") || (body == ".INF"))
+    {
+        result = ('-' == t[0]) ? -HUGE_VAL : HUGE_VAL;
+        return true;
+    }
+
+    // Digits before the '.' are only optional without a sign
+    size_t start = pos;
+    while ((pos < t.size()) && (isdigit((unsigned char)t[pos]) ||
+                                (('_' == t[pos]) && (pos > start))))
+    {
+        pos++;
+    }
+    if ((pos == t.size()) || ('.' != t[pos]) ||
+        ((pos == start) && (start > 0)))
+    {
+        return false;
+    }
+
+    size_t fraction = ++pos;
+    while ((pos < t.size()) && (isdigit((unsigned char)t[pos]) ||
+                                ('_' == t[pos])))
+    {
+        pos++;
+    }
+    if ((0 == start) && (1 == fraction) && (fraction == pos))
+        return false;
+
+    if ((pos < t.size()) && (('e' == t[pos]) || ('E' == t[pos])))
+    {
+        pos++;
+        if ((pos == t.size()) || (('-' != t[pos]) && ('+' != t[pos])))
+            return false;
+        size_t digits = ++pos;
+        while ((pos < t.size()) && isdigit((unsigned char)t[pos]))
+            pos++;
+        if (digits == pos)
+            return false;
+    }
+    if (pos != t.size())
+        return false;
+
+    result = strtod(stripUnderscores(t).c_str(), 0);
+    return true;
+}
+
+/** Formats a double like Python's str (or repr when precise) */
+static std::string formatFloat(double value, bool precise)
+{
+    char buffer[64];
+    if (!precise)
+    {
+        snprintf(buffer, sizeof(buffer), "%.12g", value);
+        std::string result(buffer);
+        if (std::string::npos == result.find_first_of(".eni"))
+            result += ".0";
+        return result;
+    }
+
+    if ((value != value) || (value == HUGE_VAL) || (value == -HUGE_VAL))
+    {
+        snprintf(buffer, sizeof(buffer), "%g", value);
+        return buffer;
+    }
+
+    // Shortest digits which read back exactly, like Python 2.7 repr
+    int digits = 1;
+    for (; digits < 17; ++digits)
+    {
+        snprintf(buffer, sizeof(buffer), "%.*e", digits - 1, value);
+        if (strtod(buffer, 0) == value)
+            break;
+    }
+    snprintf(buffer, sizeof(buffer), "%.*e", digits - 1, value);
+    int exponent = atoi(strchr(buffer, 'e') + 1);
+
+    std::string result;
+    if ((exponent >= -4) && (exponent < 16))
+    {
+        snprintf(buffer, sizeof(buffer), "%.*f",
+                 std::max(0, digits - 1 - exponent), value);
+        result = buffer;
+        if (std::string::npos == result.find('.'))
+            result += ".0";
+    }
+    else
+    {
+        // Keep the '.' so it still reads back as a float from YAML
+        result = buffer;
+        size_t e = result.find('e');
+        if (std::string::npos == result.find('.'))
+            result.insert(e, ".0");
+    }
+    return result;
+}
+
+/** Quotes a string like Python's repr */
+static std::string pythonQuote(const std::string& text)
+{
+    char quote = '\'';
+    if ((std::string::npos != text.find('\'')) &&
+        (std::string::npos == text.find('"')))
+    {
+        quote = '"';
+    }
+
+    std::string result(1, quote);
+    BOOST_FOREACH(char c, text)
+    {
+        if ((c == quote) || ('\\' == c))
+        {
+            result += '\\';
+            result += c;
+        }
+        else if ('\n' == c)
+        {
+            result += "\\n";
+        }
+        else if ('\t' == c)
+        {
+            result += "\\t";
+        }
+        else if ((unsigned char)c < 32)
+        {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\x%02x", (unsigned char)c);
+            result += buffer;
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    result += quote;
+    return result;
+}
+
+/** Writes the value as a Python literal */
+static void writePython(std::ostream& out, const ValuePtr& value)
+{
+    bool boolean;
+    long integer;
+    double real;
+
+    if (isNull(value))
+    {
+        out << "None";
+    }
+    else if (Value::MAP == value->type)
+    {
+        out << '{';
+        bool first = true;
+        BOOST_FOREACH(const Entry& entry, value->entries)
+        {
+            if (!first)
+                out << ", ";
+            first = false;
+            out << pythonQuote(entry.first) << ": ";
+            writePython(out, entry.second);
+        }
+        out << '}';
+    }
+    else if (Value::SEQUENCE == value->type)
+    {
+        out << '[';
+        for (size_t i = 0; i < value->items.size(); ++i)
+        {
+            if (i > 0)
+                out << ", ";
+            writePython(out, value->items[i]);
+        }
+        out << ']';
+    }
+    else if (toBool(value, boolean))
+    {
+        out << (boolean ? "True" : "False");
+    }
+    else if (toLong(value, integer))
+    {
+        out << integer;
+    }
+    else if (toFloat(value, real))
+    {
+        out << formatFloat(real, true);
+    }
+    else
+    {
+        out << pythonQuote(value->text);
+    }
+}
+
+// ------------------------------------------------------------------------- //
+//                                P A R S E R                                //
+// ------------------------------------------------------------------------- //
+
+/** One line of YAML without its comment, flow collections are joined */
+struct YamlLine
+{
+    int indent;
+    std::string text;
+    int number;
+};
+
+static std::string trim(const std::string& text)
+{
+    size_t start = text.find_first_not_of(" \t");
+    if (std::string::npos == start)
+        return "";
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+/** Whether a quote or bracket at pos starts a new value
+ *
+ *  Elsewhere they are just part of a plain scalar, like the ']' in
+ *  "a: b]" or the quote in "a: it's".
+ */
+static bool startsValue(const std::string& text, size_t pos, bool inFlow)
+{
+    size_t j = pos;
+    while ((j > 0) && ((' ' == text[j - 1]) || ('\t' == text[j - 1])))
+        j--;
+    if (0 == j)
+        return true;
+
+    char before = text[j - 1];
+    if (inFlow)
+        return ('[' == before) || ('{' == before) || (',' == before) ||
+            (':' == before);
+    return ((':' == before) && (j < pos)) ||
+        (('-' == before) && (j < pos) && ((1 == j) || (' ' == text[j - 2])));
+}
+
+/** Parses the subset of YAML described in NativeConfigNodeImp */
+class YamlParser
+{
+public:
+    YamlParser(const std::string& data, const std::string& source) :
+        m_pos(0),
+        m_source(source)
+    {
+        splitLines(data);
+    }
+
+    ValuePtr parse()
+    {
+        ValuePtr root = parseBlock(-1);
+        if (m_pos < m_lines.size())
+            error("Unexpected indentation", m_lines[m_pos].number);
+        return root;
+    }
+
+private:
+    void error(const std::string& message, int line)
+    {
+        std::stringstream ss;
+        ss << "ConfigNode: " << m_source << ":" << line << ": " << message;
+        throw ConfigNodeException(ss.str());
+    }
+
+    /** Scans a line outside of quotes, removing any comment
+     *
+     *  @param depth  Open flow collections, updated
+     *  @return  The line without its comment
+     */
+    std::string scanLine(const std::string& line, int& depth, int number)
+    {
+        char quote = 0;
+
+        // A '#' right after a quoted value or flow indicator is a comment
+        // even without a space in front of it
+        size_t tokenEnd = std::string::npos;
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            char c = line[i];
+            if (quote)
+            {
+                if (('\\' == c) && ('"' == quote))
+                {
+                    ++i;
+                }
+                else if (c == quote)
+                {
+                    quote = 0;
+                    tokenEnd = i;
+                }
+            }
+            else if ((('\'' == c) || ('"' == c)) &&
+                     startsValue(line, i, depth > 0))
+            {
+                quote = c;
+            }
+            else if (('#' == c) && ((0 == i) || (' ' == line[i - 1]) ||
+                                    ('\t' == line[i - 1]) ||
+                                    (tokenEnd + 1 == i)))
+            {
+                return line.substr(0, i);
+            }
+            else if ((('[' == c) || ('{' == c)) &&
+                     ((depth > 0) || startsValue(line, i, false)))
+            {
+                depth++;
+                tokenEnd = i;
+            }
+            else if ((depth > 0) && ((']' == c) || ('}' == c) || (',' == c)))
+            {
+                if (',' != c)
+                    depth--;
+                tokenEnd = i;
+            }
+        }
+
+        if (quote)
+            error("Unterminated quote", number);
+        return line;
+    }
+
+    void splitLines(const std::string& data)
+    {
+        std::istringstream in(data);
+        std::string raw;
+        int number = 0;
+        int depth = 0;
+        while (std::getline(in, raw))
+        {
+            number++;
+            if (!raw.empty() && ('\r' == raw[raw.size() - 1]))
+                raw.erase(raw.size() - 1);
+
+            bool continued = depth > 0;
+            std::string text = trim(scanLine(raw, depth, number));
+            if (text.empty())
+                continue;
+
+            if (continued)
+            {
+                // Part of a flow collection started on an earlier line
+                m_lines.back().text += " " + text;
+                continue;
+            }
+
+            if ((text == "---") || (text == "...") ||
+                (0 == text.find("--- ")))
+            {
+                continue;
+            }
+
+            size_t indent = raw.find_first_not_of(' ');
+            if ('\t' == raw[indent])
+                error("Tabs can not be used for indentation", number);
+
+            YamlLine line = {(int)indent, text, number};
+            m_lines.push_back(line);
+        }
+
+        if (depth > 0)
+            error("Unbalanced brackets", number);
+    }
+
+    static bool isSequenceItem(const std::string& text)
+    {
+        return (text == "-") || (0 == text.find("- "));
+    }
+
+    /** Position of the ':' ending a mapping key, or npos */
+    static size_t findKeyEnd(const std::string& text)
+    {
+        char quote = 0;
+        int depth = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            char c = text[i];
+            if (quote)
+            {
+                if (('\\' == c) && ('"' == quote))
+                    ++i;
+                else if (c == quote)
+                    quote = 0;
+            }
+            else if ((('\'' == c) || ('"' == c)) &&
+                     startsValue(text, i, depth > 0))
+            {
+                quote = c;
+            }
+            else if ((('[' == c) || ('{' == c)) &&
+                     ((depth > 0) || startsValue(text, i, false)))
+            {
+                depth++;
+            }
+            else if ((depth > 0) && ((']' == c) || ('}' == c)))
+            {
+                depth--;
+            }
+            else if ((':' == c) && (0 == depth) &&
+                     ((i + 1 == text.size()) || (' ' == text[i + 1])))
+            {
+                return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    /** Parses the node made of the lines indented past parentIndent */
+    ValuePtr parseBlock(int parentIndent)
+    {
+        if ((m_pos == m_lines.size()) ||
+            (m_lines[m_pos].indent <= parentIndent))
+        {
+            return ValuePtr(new Value(Value::NONE));
+        }
+
+        YamlLine& line = m_lines[m_pos];
+        if (isSequenceItem(line.text))
+            return parseSequence(line.indent);
+        if (std::string::npos != findKeyEnd(line.text))
+            return parseMapping(line.indent);
+
+        // A lone value, like a whole file in flow style
+        m_pos++;
+        return parseInline(line.text, line.number);
+    }
+
+    ValuePtr parseMapping(int indent)
+    {
+        ValuePtr map(new Value(Value::MAP));
+        while ((m_pos < m_lines.size()) && (m_lines[m_pos].indent >= indent))
+        {
+            YamlLine& line = m_lines[m_pos];
+            if (line.indent > indent)
+                error("Unexpected indentation", line.number);
+            if (isSequenceItem(line.text))
+                break;
+
+            size_t keyEnd = findKeyEnd(line.text);
+            if (std::string::npos == keyEnd)
+                error("Expected 'key: value'", line.number);
+
+            std::string key = trim(line.text.substr(0, keyEnd));
+            std::string rest = trim(line.text.substr(keyEnd + 1));
+            int number = line.number;
+            if (key.empty())
+                error("Empty key", number);
+            if (('\'' == key[0]) || ('"' == key[0]))
+                key = parseInline(key, number)->text;
+            m_pos++;
+
+            ValuePtr child;
+            if (!rest.empty())
+            {
+                child = parseInline(rest, number);
+            }
+            else if ((m_pos < m_lines.size()) &&
+                     (m_lines[m_pos].indent == indent) &&
+                     isSequenceItem(m_lines[m_pos].text))
+            {
+                // Sequences may sit at the same indent as their key
+                child = parseSequence(indent);
+            }
+            else
+            {
+                child = parseBlock(indent);
+            }
+
+            // Like a Python dict, the last one wins
+            map->entries[key] = child;
+        }
+        return map;
+    }
+
+    ValuePtr parseSequence(int indent)
+    {
+        ValuePtr sequence(new Value(Value::SEQUENCE));
+        while ((m_pos < m_lines.size()) &&
+               (m_lines[m_pos].indent == indent) &&
+               isSequenceItem(m_lines[m_pos].text))
+        {
+            YamlLine& line = m_lines[m_pos];
+            std::string rest = trim(line.text.substr(1));
+
+            if (rest.empty())
+            {
+                m_pos++;
+                sequence->items.push_back(parseBlock(indent));
+            }
+            else if (isSequenceItem(rest) ||
+                     (std::string::npos != findKeyEnd(rest)))
+            {
+                // A collection starting on the item's line, treat the rest
+                // of the line as if it started the next one
+                line.indent += line.text.size() - rest.size();
+                line.text = rest;
+                sequence->items.push_back(parseBlock(indent));
+            }
+            else
+            {
+                m_pos++;
+                sequence->items.push_back(parseInline(rest, line.number));
+            }
+        }
+        return sequence;
+    }
+
+    /** Parses a value written on one (joined) line */
+    ValuePtr parseInline(const std::string& text, int number)
+    {
+        char first = text[0];
+        if (('|' == first) || ('>' == first))
+            error("Block scalars are not supported", number);
+        if (('&' == first) || ('*' == first) || ('!' == first))
+            error("Anchors, aliases and tags are not supported", number);
+
+        if (('[' == first) || ('{' == first) || ('\'' == first) ||
+            ('"' == first))
+        {
+            size_t pos = 0;
+            ValuePtr value = parseFlow(text, pos, number);
+            skipSpace(text, pos);
+            if (pos != text.size())
+                error("Unexpected text after value", number);
+            return value;
+        }
+
+        ValuePtr value(new Value(Value::SCALAR));
+        value->text = text;
+        return value;
+    }
+
+    static void skipSpace(const std::string& text, size_t& pos)
+    {
+        while ((pos < text.size()) && ((' ' == text[pos]) ||
+                                       ('\t' == text[pos])))
+        {
+            pos++;
+        }
+    }
+
+    ValuePtr parseFlow(const std::string& text, size_t& pos, int number)
+    {
+        skipSpace(text, pos);
+        if (pos == text.size())
+            error("Missing value", number);
+
+        char first = text[pos];
+        if ('[' == first)
+        {
+            pos++;
+            ValuePtr sequence(new Value(Value::SEQUENCE));
+            while (true)
+            {
+                skipSpace(text, pos);
+                if ((pos < text.size()) && (']' == text[pos]))
+                {
+                    pos++;
+                    break;
+                }
+                sequence->items.push_back(parseFlow(text, pos, number));
+                skipSpace(text, pos);
+                if ((pos < text.size()) && (',' == text[pos]))
+                    pos++;
+                else if ((pos < text.size()) && (']' == text[pos]))
+                    continue;
+                else
+                    error("Expected ',' or ']'", number);
+            }
+            return sequence;
+        }
+        else if ('{' == first)
+        {
+            pos++;
+            ValuePtr map(new Value(Value::MAP));
+            while (true)
+            {
+                skipSpace(text, pos);
+                if ((pos < text.size()) && ('}' == text[pos]))
+                {
+                    pos++;
+                    break;
+                }
+
+                ValuePtr key = parseFlowScalar(text, pos, number);
+                skipSpace(text, pos);
+                if ((pos == text.size()) || (':' != text[pos]))
+                    error("Expected ':' after key", number);
+                pos++;
+
+                skipSpace(text, pos);
+                ValuePtr value;
+                if ((pos < text.size()) &&
+                    ((',' == text[pos]) || ('}' == text[pos])))
+                {
+                    value = ValuePtr(new Value(Value::NONE));
+                }
+                else
+                {
+                    value = parseFlow(text, pos, number);
+                }
+                map->entries[key->text] = value;
+
+                skipSpace(text, pos);
+                if ((pos < text.size()) && (',' == text[pos]))
+                    pos++;
+                else if ((pos < text.size()) && ('}' == text[pos]))
+                    continue;
+                else
+                    error("Expected ',' or '}'", number);
+            }
+            return map;
+        }
+
+        return parseFlowScalar(text, pos, number);
+    }
+
+    /** Parses a quoted scalar, or a plain one ending at a flow indicator */
+    ValuePtr parseFlowScalar(const std::string& text, size_t& pos, int number)
+    {
+        ValuePtr value(new Value(Value::SCALAR));
+        char quote = text[pos];
+        if (('\'' == quote) || ('"' == quote))
+        {
+            value->quoted = true;
+            pos++;
+            while (true)
+            {
+                if (pos == text.size())
+                    error("Unterminated quote", number);
+
+                char c = text[pos++];
+                if (c == quote)
+                {
+                    // Two single quotes are an escaped one
+                    if (('\'' == quote) && (pos < text.size()) &&
+                        ('\'' == text[pos]))
+                    {
+                        value->text += '\'';
+                        pos++;
+                        continue;
+                    }
+                    break;
+                }
+
+                if (('\\' == c) && ('"' == quote) && (pos < text.size()))
+                {
+                    char escaped = text[pos++];
+                    switch (escaped)
+                    {
+                        case 'n': value->text += '\n'; break;
+                        case 't': value->text += '\t'; break;
+                        case 'r': value->text += '\r'; break;
+                        case '0': value->text += '\0'; break;
+                        default: value->text += escaped; break;
+                    }
+                    continue;
+                }
+                value->text += c;
+            }
+            return value;
+        }
+
+        size_t start = pos;
+        while (pos < text.size())
+        {
+            char c = text[pos];
+            if ((',' == c) || (']' == c) || ('}' == c))
+                break;
+            if ((':' == c) && ((pos + 1 == text.size()) ||
+                               (' ' == text[pos + 1])))
+            {
+                break;
+            }
+            pos++;
+        }
+
+        value->text = trim(text.substr(start, pos - start));
+        if (value->text.empty())
+            error("Missing value", number);
+        return value;
+    }
+
+    std::vector<YamlLine> m_lines;
+    size_t m_pos;
+    std::string m_source;
+};
+
+// ------------------------------------------------------------------------- //
+//                              I N C L U D E S                              //
+// ------------------------------------------------------------------------- //
+
+static ValuePtr loadFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str());
+    if (!file)
+        throw ConfigNodeException("ConfigNode: Could not open: " + filename);
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return YamlParser(ss.str(), filename).parse();
+}
+
+/** Merges in the files named by INCLUDE keys, the same way the Python
+ *  version does: included keys replace existing ones, and an included file
+ *  may give a new INCLUDE to follow.
+ */
+static void resolveIncludes(const ValuePtr& value)
+{
+    if (!value)
+        return;
+
+    if (Value::SEQUENCE == value->type)
+    {
+        BOOST_FOREACH(ValuePtr item, value->items)
+        {
+            resolveIncludes(item);
+        }
+        return;
+    }
+
+    if (Value::MAP != value->type)
+        return;
+
+    std::string last;
+    int count = 0;
+    std::map<std::string, ValuePtr>::iterator iter;
+    while ((value->entries.end() != (iter = value->entries.find("INCLUDE")))
+           && (Value::SCALAR == iter->second->type) &&
+           (iter->second->text != last))
+    {
+        last = iter->second->text;
+        if (++count > 32)
+            throw ConfigNodeException("ConfigNode: Include loop at: " + last);
+
+        const char* root = getenv("RAM_SVN_DIR");
+        if (!root)
+            throw ConfigNodeException("ConfigNode: RAM_SVN_DIR is not set");
+
+        // All paths are resolved from the root of the SVN dir
+        boost::filesystem::path path(root);
+        path /= last;
+        ValuePtr included = loadFile(path.string());
+        if (Value::MAP != included->type)
+        {
+            throw ConfigNodeException("ConfigNode: Included file is not a "
+                                      "mapping: " + path.string());
+        }
+
+        BOOST_FOREACH(const Entry& entry, included->entries)
+        {
+            value->entries[entry.first] = entry.second;
+        }
+    }
+    value->entries.erase("INCLUDE");
+    value->entries.erase("INCLUDE_LOADED");
+
+    BOOST_FOREACH(const Entry& entry, value->entries)
+    {
+        resolveIncludes(entry.second);
+    }
+}
+
+// ------------------------------------------------------------------------- //
+//                                W R I T E R                                //
+// ------------------------------------------------------------------------- //
+
+/** Whether a string needs quotes to read back as the same string */
+static bool needsQuotes(const std::string& text)
+{
+    if (text.empty() || (text != trim(text)))
+        return true;
+    if (std::string::npos != text.find_first_of("#,[]{}\n\t\"'"))
+        return true;
+    if ((std::string::npos != text.find(": ")) ||
+        (':' == text[text.size() - 1]))
+    {
+        return true;
+    }
+
+    char first = text[0];
+    if (std::string::npos != std::string("-?:|>!&*%@`").find(first))
+        return true;
+
+    // Would read back as some other type
+    ValuePtr plain(new Value(Value::SCALAR));
+    plain->text = text;
+    bool boolean;
+    long integer;
+    double real;
+    return isNull(plain) || toBool(plain, boolean) || toLong(plain, integer)
+        || toFloat(plain, real);
+}
+
+static std::string yamlScalar(const ValuePtr& value)
+{
+    if (!value || (Value::NONE == value->type))
+        return "null";
+    if (value->quoted || needsQuotes(value->text))
+    {
+        if (!value->quoted && !needsQuotes("x" + value->text))
+            return value->text;
+
+        std::string result("'");
+        BOOST_FOREACH(char c, value->text)
+        {
+            if ('\'' == c)
+                result += "''";
+            else
+                result += c;
+        }
+        return result + "'";
+    }
+    return value->text;
+}
+
+static std::string yamlKey(const std::string& key)
+{
+    ValuePtr value(new Value(Value::SCALAR));
+    value->text = key;
+    value->quoted = needsQuotes(key);
+    return yamlScalar(value);
+}
+
+/** True for values written on one line */
+static bool isLeaf(const ValuePtr& value)
+{
+    if (!value)
+        return true;
+    if (Value::MAP == value->type)
+        return value->entries.empty();
+    if (Value::SEQUENCE == value->type)
+    {
+        BOOST_FOREACH(ValuePtr item, value->items)
+        {
+            if (!isLeaf(item))
+                return false;
+        }
+    }
+    return true;
+}
+
+/** Writes a value which fits on one line in flow style */
+static void writeFlow(std::ostream& out, const ValuePtr& value)
+{
+    if (value && (Value::MAP == value->type))
+    {
+        out << "{}";
+    }
+    else if (value && (Value::SEQUENCE == value->type))
+    {
+        out << '[';
+        for (size_t i = 0; i < value->items.size(); ++i)
+        {
+            if (i > 0)
+                out << ", ";
+            writeFlow(out, value->items[i]);
+        }
+        out << ']';
+    }
+    else
+    {
+        out << yamlScalar(value);
+    }
+}
+
+static void writeYaml(std::ostream& out, const ValuePtr& value, int indent)
+{
+    std::string spaces(indent, ' ');
+    if (isLeaf(value))
+    {
+        out << spaces;
+        writeFlow(out, value);
+        out << std::endl;
+    }
+    else if (Value::MAP == value->type)
+    {
+        BOOST_FOREACH(const Entry& entry, value->entries)
+        {
+            out << spaces << yamlKey(entry.first) << ':';
+            if (isLeaf(entry.second))
+            {
+                out << ' ';
+                writeFlow(out, entry.second);
+                out << std::endl;
+            }
+            else
+            {
+                out << std::endl;
+                writeYaml(out, entry.second, indent + 4);
+            }
+        }
+    }
+    else
+    {
+        BOOST_FOREACH(ValuePtr item, value->items)
+        {
+            if (isLeaf(item))
+            {
+                out << spaces << "- ";
+                writeFlow(out, item);
+                out << std::endl;
+            }
+            else
+            {
+                out << spaces << '-' << std::endl;
+                writeYaml(out, item, indent + 4);
+            }
+        }
+    }
+}
+
+// ------------------------------------------------------------------------- //
+//                       N A T I V E   C O N F I G   N O D E                 //
+// ------------------------------------------------------------------------- //
+
+NativeConfigNodeImp::NativeConfigNodeImp(ValuePtr value,
+                                         std::string debugPath) :
+    m_value(value),
+    m_debugPath(debugPath)
+{
+}
+
+ConfigNodeImpPtr NativeConfigNodeImp::fromYamlFile(std::string filename)
+{
+    ValuePtr root = loadFile(filename);
+    resolveIncludes(root);
+    return ConfigNodeImpPtr(new NativeConfigNodeImp(root));
+}
+
+ConfigNodeImpPtr NativeConfigNodeImp::fromYamlString(std::string data)
+{
+    ValuePtr root = YamlParser(data, "<string>").parse();
+    resolveIncludes(root);
+    return ConfigNodeImpPtr(new NativeConfigNodeImp(root));
+}
+
+ConfigNodeImpPtr NativeConfigNodeImp::idx(int index)
+{
+    std::stringstream ss;
+    ss << m_debugPath << "[" << index << "]";
+
+    ValuePtr child;
+    if (m_value && (Value::SEQUENCE == m_value->type))
+    {
+        if ((index < 0) || (index >= (int)m_value->items.size()))
+            error("Index", "Index out of range");
+        child = m_value->items[index];
+    }
+    return ConfigNodeImpPtr(new NativeConfigNodeImp(child, ss.str()));
+}
+
+ConfigNodeImpPtr NativeConfigNodeImp::map(std::string key)
+{
+    ValuePtr child;
+    if (m_value && (Value::MAP == m_value->type))
+    {
+        std::map<std::string, ValuePtr>::const_iterator iter =
+            m_value->entries.find(key);
+        if (m_value->entries.end() != iter)
+            child = iter->second;
+    }
+    return ConfigNodeImpPtr(new NativeConfigNodeImp(child,
+                                                    m_debugPath + "." + key));
+}
+
+std::string NativeConfigNodeImp::asString()
+{
+    bool boolean;
+    long integer;
+    double real;
+
+    if (isNull(m_value))
+        return "None";
+    if (Value::SCALAR != m_value->type)
+        return toString();
+    if (m_value->quoted)
+        return m_value->text;
+    if (toBool(m_value, boolean))
+        return boolean ? "True" : "False";
+    if (toLong(m_value, integer))
+        return boost::lexical_cast<std::string>(integer);
+    if (toFloat(m_value, real))
+        return formatFloat(real, false);
+    return m_value->text;
+}
+
+std::string NativeConfigNodeImp::asString(const std::string& def)
+{
+    if (isNull(m_value))
+        return def;
+    return asString();
+}
+
+double NativeConfigNodeImp::asDouble()
+{
+    bool boolean;
+    long integer;
+    double real;
+
+    if (isNull(m_value))
+        error("asDouble", "No value");
+    if (toFloat(m_value, real))
+        return real;
+    if (toLong(m_value, integer))
+        return integer;
+    if (toBool(m_value, boolean))
+        return boolean ? 1 : 0;
+
+    error("asDouble", "Not a number");
+    return 0;
+}
+
+double NativeConfigNodeImp::asDouble(const double def)
+{
+    try {
+        if (isNull(m_value))
+            return def;
+        return asDouble();
+    } catch (ConfigNodeException&) {
+        return def;
+    }
+}
+
+int NativeConfigNodeImp::asInt()
+{
+    bool boolean;
+    long integer;
+
+    if (isNull(m_value))
+        error("asInt", "No value");
+    if (toLong(m_value, integer))
+    {
+        if ((integer < INT_MIN) || (integer > INT_MAX))
+            error("asInt", "Value too large");
+        return (int)integer;
+    }
+    if (toBool(m_value, boolean))
+        return boolean ? 1 : 0;
+
+    error("asInt", "Not an integer");
+    return 0;
+}
+
+int NativeConfigNodeImp::asInt(const int def)
+{
+    try {
+        if (isNull(m_value))
+            return def;
+        return asInt();
+    } catch (ConfigNodeException&) {
+        return def;
+    }
+}
+
+NodeNameList NativeConfigNodeImp::subNodes()
+{
+    NodeNameList subnodes;
+    if (m_value && (Value::MAP == m_value->type))
+    {
+        BOOST_FOREACH(const Entry& entry, m_value->entries)
+        {
+            subnodes.insert(entry.first);
+        }
+    }
+    return subnodes;
+}
+
+size_t NativeConfigNodeImp::size()
+{
+    if (m_value && (Value::MAP == m_value->type))
+        return m_value->entries.size();
+    if (m_value && (Value::SEQUENCE == m_value->type))
+        return m_value->items.size();
+    if (m_value && (Value::SCALAR == m_value->type))
+        return m_value->text.size();
+
+    error("size", "No value");
+    return 0;
+}
+
+void NativeConfigNodeImp::set(std::string key, std::string str)
+{
+    if (!m_value || (Value::MAP != m_value->type))
+        error("set string", "Not a map, can't set: " + key);
+
+    ValuePtr value(new Value(Value::SCALAR));
+    value->text = str;
+    value->quoted = true;
+    m_value->entries[key] = value;
+}
+
+void NativeConfigNodeImp::set(std::string key, int value)
+{
+    if (!m_value || (Value::MAP != m_value->type))
+        error("set value", "Not a map, can't set: " + key);
+
+    ValuePtr scalar(new Value(Value::SCALAR));
+    scalar->text = boost::lexical_cast<std::string>(value);
+    m_value->entries[key] = scalar;
+}
+
+std::string NativeConfigNodeImp::toString()
+{
+    std::stringstream ss;
+    writePython(ss, m_value);
+    return ss.str();
+}
+
+void NativeConfigNodeImp::writeToFile(std::string fileName, bool silent)
+{
+    std::ofstream out(fileName.c_str());
+    if (!out)
+    {
+        printf("Error during write out\n");
+        if (!silent)
+        {
+            throw ConfigNodeException("ConfigNode: Could not write: " +
+                                      fileName);
+        }
+        return;
+    }
+
+    writeYaml(out, m_value, 0);
+}
+
+void NativeConfigNodeImp::error(const std::string& operation,
+                                const std::string& message)
+{
+    throw ConfigNodeException("ConfigNode \"" + m_debugPath + "\"(" +
+                              operation + ") Error: " + message);
+}
+
+} // namespace core
+} // namespace ram
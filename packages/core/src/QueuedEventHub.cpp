@@ -40,7 +40,9 @@ QueuedEventHub::QueuedEventHub(ram::core::EventHubPtr eventHub,
 QueuedEventHub::QueuedEventHub(ConfigNode config, SubsystemList deps) :
     EventHub(config["name"].asString()),
     m_hub(core::Subsystem::getSubsystemOfType<EventHub>(deps)),
-    m_imp(new QueuedEventHubImp()),
+    m_imp(new QueuedEventHubImp(config["queueSize"].asInt(0),
+              RingQueueBase::policyFromString(
+                  config["queueOverflow"].asString("block")))),
     // Send all incomming events to be queued and store the resulting connection
     m_connection(m_hub->subscribeToAll(
         boost::bind(&QueuedEventHubImp::queueEvent, m_imp, _1))),
@@ -65,8 +67,15 @@ void QueuedEventHub::publish(EventPtr event)
 }
 
 void QueuedEventHub::publish(Event::EventType etype, EventPtr event)
+{
+    publish(Event::registerType(etype), etype, event);
+}
+
+void QueuedEventHub::publish(Event::TypeId typeId, Event::EventType etype,
+                             EventPtr event)
 {
     event->type = etype;
+    event->typeId = typeId;
     event->sender = this;
     publish(event);
 }
@@ -7,14 +7,22 @@
  * File:  packages/core/src/QueuedEventHubImp.cpp
  */
 
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/foreach.hpp>
+
 // Project Includes
 #include "core/include/QueuedEventHubImp.h"
 
 namespace ram {
 namespace core {
 
-QueuedEventHubImp::QueuedEventHubImp()
+QueuedEventHubImp::QueuedEventHubImp(int queueSize,
+                                     RingQueueBase::OverflowPolicy policy)
 {
+    m_eventQueue.setBounded(queueSize, policy);
 }
 
 void QueuedEventHubImp::setPublishFunction(boost::function<void (EventPtr)> publishFunction)
@@ -29,15 +37,30 @@ void QueuedEventHubImp::queueEvent(EventPtr event)
                                    
 int QueuedEventHubImp::publishEvents()
 {
-    EventPtr event;
-    int published = 0;
-    
-    while(m_eventQueue.popNoWait(event))
+    // Take whole batches off the queue, so we only contend with the
+    // publishers once per batch, and loop to catch events queued by handlers.
+    // The buffer is borrowed from the last call, a handler calling us again,
+    // or a second thread, just finds it gone and starts a new one.
+    std::vector<EventPtr> events;
     {
-        m_publishFunction(event);
-        published++;
+        boost::mutex::scoped_lock lock(m_eventBufferMutex);
+        events.swap(m_eventBuffer);
     }
     
+    int published = 0;
+    while(m_eventQueue.popAll(events))
+    {
+        BOOST_FOREACH(EventPtr& event, events)
+            m_publishFunction(event);
+        
+        published += events.size();
+        events.clear();
+    }
+
+    // Keep whichever buffer has grown the most
+    boost::mutex::scoped_lock lock(m_eventBufferMutex);
+    if (events.capacity() > m_eventBuffer.capacity())
+        events.swap(m_eventBuffer);
     return published;    
 }
 
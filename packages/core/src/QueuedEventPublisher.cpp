@@ -41,9 +41,15 @@ EventConnectionPtr QueuedEventPublisher::subscribe(
     
 void QueuedEventPublisher::publish(Event::EventType type, EventPtr event)
 {
-    asType(m_imp)->publish(type, type, this, event);
+    asType(m_imp)->publish(type, this, event);
 };
 
+void QueuedEventPublisher::publish(Event::TypeId typeId,
+                                   Event::EventType type, EventPtr event)
+{
+    asType(m_imp)->publish(typeId, type, this, event);
+}
+
 int QueuedEventPublisher::publishEvents()
 {
     return asType(m_imp)->publishEvents();
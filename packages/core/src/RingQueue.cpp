@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/src/RingQueue.cpp
+ */
+
+// Project Includes
+#include "core/include/RingQueue.h"
+
+namespace ram {
+namespace core {
+
+RingQueueBase::OverflowPolicy
+RingQueueBase::policyFromString(const std::string& policy)
+{
+    if ("dropOldest" == policy)
+        return DROP_OLDEST;
+    else if ("dropNewest" == policy)
+        return DROP_NEWEST;
+    return BLOCK;
+}
+
+} // namespace core
+} // namespace ram
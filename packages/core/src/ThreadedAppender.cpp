@@ -7,16 +7,26 @@
  * File:  packages/core/src/ThreadedAppender.cpp
  */
 
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/foreach.hpp>
+
 // Project Includes
 #include "core/include/ThreadedAppender.h"
 
 namespace ram {
 namespace core {
 
-ThreadedAppender::ThreadedAppender(log4cpp::Appender* appender) :
+ThreadedAppender::ThreadedAppender(log4cpp::Appender* appender,
+                                   int queueSize,
+                                   RingQueueBase::OverflowPolicy policy) :
     Appender(appender->getName()),
     m_appender(appender)
 {
+    m_logEvents.setBounded(queueSize, policy);
+    
     // Start running full out
     background(-1);
 }
@@ -31,10 +41,15 @@ ThreadedAppender::~ThreadedAppender()
 void ThreadedAppender::update(double timestep)
 {
     LoggingEvent event("", "", "", 1);
+    std::vector<LoggingEvent> events;
 
-    // Clear all current events
-    while(m_logEvents.popNoWait(event))
-        m_appender->doAppend(event);
+    // Clear all current events, a batch at a time
+    while(m_logEvents.popAll(events))
+    {
+        BOOST_FOREACH(LoggingEvent& batchEvent, events)
+            m_appender->doAppend(batchEvent);
+        events.clear();
+    }
 
     // Wait for half a second, log event if needed, then reloop
     boost::xtime wait ={0, 500000000}; // 500 milliseconds
@@ -23,8 +23,12 @@
 #include <cassert>
 #include <time.h>
 
+// Library Includes
+#include <boost/thread/mutex.hpp>
+
 // Project Includes
 #include "core/include/TimeVal.h"
+#include "core/include/Atomic.h"
 
 // On windows we need our own gettimeofday
 #ifdef RAM_WINDOWS
@@ -130,6 +134,35 @@ TimeVal TimeVal::timeOfDay()
     current.now();
     return current;
 }
+
+/** Set while the virtual clock is in use, checked without the lock */
+static Atomic<int> virtualClockSet(0);
+static boost::mutex virtualClockMutex;
+static double virtualClockTime = 0;
+
+TimeVal TimeVal::clockTime()
+{
+    if (virtualClockSet.load(MEMORY_ORDER_ACQUIRE))
+    {
+        boost::mutex::scoped_lock lock(virtualClockMutex);
+        if (virtualClockSet.load(MEMORY_ORDER_RELAXED))
+            return TimeVal(virtualClockTime);
+    }
+    return timeOfDay();
+}
+
+void TimeVal::setVirtualTime(double seconds)
+{
+    boost::mutex::scoped_lock lock(virtualClockMutex);
+    virtualClockTime = seconds;
+    virtualClockSet.store(1, MEMORY_ORDER_RELEASE);
+}
+
+void TimeVal::clearVirtualTime()
+{
+    boost::mutex::scoped_lock lock(virtualClockMutex);
+    virtualClockSet.store(0, MEMORY_ORDER_RELEASE);
+}
     
 void TimeVal::now()
 {
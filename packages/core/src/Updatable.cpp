@@ -9,24 +9,37 @@
 
 // STD Includes
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <algorithm>
 
 // Library Includes
 #include <boost/cstdint.hpp>
 #include <boost/thread/xtime.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/algorithm/string.hpp>
 
 // Project Includes
+#include "core/include/ConfigNode.h"
 #include "core/include/Feature.h"
 #include "core/include/TimeVal.h"
 #include "core/include/Events.h"
 #include "core/include/Updatable.h"
+#include "core/include/Executor.h"
 
 // System Includes
 #ifdef RAM_POSIX
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sched.h>
 
 #ifdef RAM_LINUX
     // Only Linux support thread affinity on POSIX platforms
@@ -46,20 +59,34 @@
 
 #include <iostream>
 
+const static long USEC_PER_SEC = 1000000;
 const static long USEC_PER_MILLISEC = 1000;
 const static long NSEC_PER_MILLISEC = 1000000;
 const static long NSEC_PER_USEC = 1000;
 
-// How close do we try to get to actual sleep time (in usec)
+// How close do we try to get to actual sleep time (in usec), only used on
+// platforms without clock_nanosleep
 const static long SLEEP_THRESHOLD = 500;
 
+// How often we publish the PROFILE and TIMING events (in usec)
+const static long REPORT_INTERVAL = 1000000;
+
 static int HIGH_PRIORITY_VALUE = 0;
 static int NORMAL_PRIORITY_VALUE = 0;
 static int LOW_PRIORITY_VALUE = 0;
 static int RT_HIGH_PRIORITY_VALUE = 0;
 static int RT_NORMAL_PRIORITY_VALUE = 0;
 static int RT_LOW_PRIORITY_VALUE = 0;
-static size_t CPU_COUNT = 0;
+static size_t NUM_CPUS = 0;
+
+// Size of each stack chunk touched when prefaulting the stack
+const static size_t PREFAULT_CHUNK = 16 * 1024;
+const static size_t PAGE_SIZE_GUESS = 4096;
+
+#ifdef RAM_LINUX
+// The CPUs the process was allowed to run on at start up
+static cpu_set_t DEFAULT_CPU_SET;
+#endif
 
 namespace ram {
 namespace core {
@@ -67,92 +94,120 @@ namespace core {
 
 typedef boost::int64_t Usec;
 
-// Adapted from the avahi library, under LPGL
-int timeval_compare(const struct timeval *a, const struct timeval *b) {
-    assert(a);
-    assert(b);
-
-    if (a->tv_sec < b->tv_sec)
-        return -1;
-
-    if (a->tv_sec > b->tv_sec)
-        return 1;
-
-    if (a->tv_usec < b->tv_usec)
-        return -1;
-
-    if (a->tv_usec > b->tv_usec)
-        return 1;
-
-    return 0;
-}
-
-Usec timeval_diff(const struct timeval *a, const struct timeval *b) {
-    assert(a);
-    assert(b);
-
-    if (timeval_compare(a, b) < 0)
-        return - timeval_diff(b, a);
-
-    return ((Usec) a->tv_sec - b->tv_sec)*1000000 + a->tv_usec - b->tv_usec;
-}
-
-struct timeval* timeval_add(struct timeval *a, Usec usec) {
-    Usec u;
-    assert(a);
-
-    u = usec + a->tv_usec;
+/** Accumulates the timing of the background loop for one report */
+class LoopStatistics
+{
+public:
+    LoopStatistics() { reset(); }
 
-    if (u < 0) {
-        a->tv_usec = (long) (1000000 + (u % 1000000));
-        a->tv_sec += (long) (-1 + (u / 1000000));
-    } else {
-        a->tv_usec = (long) (u % 1000000);
-        a->tv_sec += (long) (u / 1000000);
+    void reset()
+    {
+        m_periods.clear();
+        m_execCount = 0;
+        m_execSum = 0;
+        m_execMin = 0;
+        m_execMax = 0;
+        m_overruns = 0;
     }
 
-    return a;
-}
+    void addPeriod(Usec period) { m_periods.push_back(period); }
 
-Usec age(const struct timeval *a) {
-    struct timeval now;
-    
-    assert(a);
+    void addExecTime(Usec exec)
+    {
+        if ((0 == m_execCount) || (exec < m_execMin))
+            m_execMin = exec;
+        if (exec > m_execMax)
+            m_execMax = exec;
+        m_execSum += exec;
+        m_execCount++;
+    }
 
-    gettimeofday(&now, NULL);
+    void addOverrun() { m_overruns++; }
 
-    return timeval_diff(&now, a);
-}
+    /** Fills in the event, reorders the recorded periods */
+    void fillEvent(UpdateTimingEventPtr event)
+    {
+        event->updates = m_execCount;
+        event->overruns = m_overruns;
 
-struct timeval *elapse_time(struct timeval *tv, unsigned msec) {
-    assert(tv);
+        if (m_execCount)
+        {
+            event->minExecTime = toSeconds(m_execMin);
+            event->meanExecTime = toSeconds(m_execSum) / m_execCount;
+            event->maxExecTime = toSeconds(m_execMax);
+        }
 
-    gettimeofday(tv, NULL);
+        if (m_periods.empty())
+            return;
 
-    if (msec)
-        timeval_add(tv, (Usec) msec*1000);
+        double sum = 0;
+        double sumSquares = 0;
+        BOOST_FOREACH(Usec period, m_periods)
+        {
+            double seconds = toSeconds(period);
+            sum += seconds;
+            sumSquares += seconds * seconds;
+        }
+        double count = (double)m_periods.size();
+        double mean = sum / count;
+        double variance = sumSquares / count - mean * mean;
+
+        event->meanPeriod = mean;
+        event->jitter = variance > 0 ? std::sqrt(variance) : 0;
+        event->minPeriod =
+            toSeconds(*std::min_element(m_periods.begin(), m_periods.end()));
+        event->maxPeriod =
+            toSeconds(*std::max_element(m_periods.begin(), m_periods.end()));
         
-    return tv;
-}
+        std::vector<Usec>::iterator p99 =
+            m_periods.begin() + (m_periods.size() * 99) / 100;
+        if (p99 == m_periods.end())
+            --p99;
+        std::nth_element(m_periods.begin(), p99, m_periods.end());
+        event->p99Period = toSeconds(*p99);
+    }
 
+private:
+    static double toSeconds(Usec usec) { return usec / (double)USEC_PER_SEC; }
+    
+    std::vector<Usec> m_periods;
+    int m_execCount;
+    Usec m_execSum;
+    Usec m_execMin;
+    Usec m_execMax;
+    int m_overruns;
+};
     
 Updatable::Updatable(EventPublisher *publisher) :
     m_backgrounded(0),
     m_interval(100),
     m_priority(NORMAL_PRIORITY),
     m_priorityValue(NORMAL_PRIORITY_VALUE),
-    m_affinity(-1),
+    m_affinity(),
+    m_rtPolicy(RT_FIFO),
+    m_rtPriorityValue(-1),
+    m_lockMemory(false),
+    m_prefaultStack(0),
+    m_overrunPolicy(OVERRUN_REALIGN),
+    m_executor(0),
     m_settingChange(0),
     m_backgroundThread(0),
     m_threadStopped(1),
     m_publisher(publisher),
-    m_profileCount(0)
+    m_profileCount(0),
+    m_statistics(new LoopStatistics()),
+    m_reportStart(0)
 {
     initThreadingSettings();
 }
 
 Updatable::~Updatable()
 {
+    // Make sure the pool is not running us
+    Executor* executor = getExecutor();
+    if (executor)
+        executor->cancel(this, true);
+    
     // Join and delete background thread if its still running
     cleanUpBackgroundThread();
 }
@@ -230,29 +285,172 @@ Updatable::Priority Updatable::getPriority()
 }
 
 void Updatable::setAffinity(size_t core)
+{
+    std::set<size_t> cpus;
+    cpus.insert(core);
+    setAffinityMask(cpus);
+}
+
+int Updatable::getAffinity()
+{
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    if (m_affinity.empty())
+        return -1;
+    return (int)*m_affinity.begin();
+}
+
+void Updatable::setAffinityMask(const std::set<size_t>& cpus)
 {
     boost::mutex::scoped_lock lock(m_upStateMutex);
-    assert(CPU_COUNT != 1 && "Can't set affinity on single core system");
-    assert(core < CPU_COUNT && "Core too large");
-    m_affinity = (int)core;
+    assert((cpus.empty() || NUM_CPUS != 1) &&
+           "Can't set affinity on single core system");
+    assert((cpus.empty() || *cpus.rbegin() < NUM_CPUS) && "Core too large");
+    m_affinity = cpus;
     m_settingChange |= AFFINITY;
 }
 
-int Updatable::getAffinity()
+std::set<size_t> Updatable::getAffinityMask()
 {
     boost::mutex::scoped_lock lock(m_upStateMutex);
     return m_affinity;
 }
+
+std::set<size_t> Updatable::configToCpuSet(ConfigNode config)
+{
+    std::string cpus(config.asString(""));
+    if (!cpus.empty() &&
+        cpus.find_first_not_of("0123456789") == std::string::npos)
+    {
+        std::stringstream ss;
+        ss << "0x" << std::hex << config.asInt();
+        cpus = ss.str();
+    }
+    return stringToCpuSet(cpus);
+}
+
+std::set<size_t> Updatable::stringToCpuSet(std::string str)
+{
+    boost::algorithm::trim(str);
+    boost::algorithm::to_lower(str);
+    std::set<size_t> cpus;
+
+    // Hex mask, like taskset(1)
+    if (boost::algorithm::starts_with(str, "0x"))
+    {
+        for (size_t i = 2; i < str.size(); ++i)
+        {
+            char c = str[str.size() - 1 - (i - 2)];
+            int nibble = 0;
+            if ('0' <= c && c <= '9')
+                nibble = c - '0';
+            else if ('a' <= c && c <= 'f')
+                nibble = c - 'a' + 10;
+            else
+                assert(false && "Invalid CPU mask");
+
+            for (size_t bit = 0; bit < 4; ++bit)
+            {
+                if (nibble & (1 << bit))
+                    cpus.insert((i - 2) * 4 + bit);
+            }
+        }
+        return cpus;
+    }
+
+    // CPU list, like /sys/devices/system/cpu/isolated: "0,2-3"
+    std::vector<std::string> ranges;
+    boost::algorithm::split(ranges, str, boost::algorithm::is_any_of(","));
+    BOOST_FOREACH(std::string range, ranges)
+    {
+        boost::algorithm::trim(range);
+        if (range.empty())
+            continue;
+        
+        std::string::size_type dash = range.find('-');
+        std::string firstStr(range.substr(0, dash));
+        std::string lastStr(dash == std::string::npos ? firstStr :
+                            range.substr(dash + 1));
+        assert(!firstStr.empty() && !lastStr.empty() &&
+               firstStr.find_first_not_of("0123456789") == std::string::npos &&
+               lastStr.find_first_not_of("0123456789") == std::string::npos &&
+               "Invalid CPU list");
+
+        size_t first = (size_t)atoi(firstStr.c_str());
+        size_t last = (size_t)atoi(lastStr.c_str());
+        assert(first <= last && "Invalid CPU range");
+        for (size_t cpu = first; cpu <= last; ++cpu)
+            cpus.insert(cpu);
+    }
+    
+    return cpus;
+}
+
+size_t Updatable::getCpuCount()
+{
+    return NUM_CPUS;
+}
+
+void Updatable::setRealTimePolicy(RealTimePolicy policy)
+{
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    if (policy != m_rtPolicy)
+    {
+        m_rtPolicy = policy;
+        m_settingChange |= PRIORITY;
+    }
+}
+
+Updatable::RealTimePolicy Updatable::getRealTimePolicy()
+{
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    return m_rtPolicy;
+}
+
+Updatable::RealTimePolicy Updatable::stringToRealTimePolicy(std::string str)
+{
+    boost::algorithm::to_lower(str);
+
+    if ("fifo" == str)
+        return RT_FIFO;
+    else if ("rr" == str)
+        return RT_ROUND_ROBIN;
+
+    assert(false && "Invalid real time policy");
+    return RT_FIFO;
+}
+
+void Updatable::setRealTimePriority(int value)
+{
+    if (value >= 0)
+    {
+        value = std::max(value, RT_LOW_PRIORITY_VALUE);
+        value = std::min(value, RT_HIGH_PRIORITY_VALUE);
+    }
+    
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    m_rtPriorityValue = value;
+    m_settingChange |= PRIORITY;
+}
+
+void Updatable::setMemoryLocking(bool lock, size_t prefaultStack)
+{
+    boost::mutex::scoped_lock stateLock(m_upStateMutex);
+    m_lockMemory = lock;
+    m_prefaultStack = prefaultStack;
+    m_settingChange |= PRIORITY;
+}
      
 void Updatable::background(int interval)
 {
     bool startThread = false;
+    Executor* executor = 0;
 
     {
         boost::mutex::scoped_lock lock(m_upStateMutex);
 
         // Set state
         m_interval = interval;
+        executor = m_executor;
 
         // Only start up the background thread if we aren't already
         // running
@@ -263,6 +461,13 @@ void Updatable::background(int interval)
         }
     }
 
+    // The pool handles both starting and interval changes
+    if (executor)
+    {
+        executor->schedule(this, interval);
+        return;
+    }
+
     if (startThread)
     {
         // Join and delete background thread if it exists, if it does exist
@@ -285,8 +490,11 @@ void Updatable::background(int interval)
 
 void Updatable::unbackground(bool join)
 {
+    Executor* executor = 0;
+    
     {
         boost::mutex::scoped_lock lock(m_upStateMutex);
+        executor = m_executor;
 
         // Leave early if its already backgrounded and we aren't joining
         if (!m_backgrounded && !join)
@@ -297,6 +505,12 @@ void Updatable::unbackground(bool join)
         m_backgrounded = false;
     }
 
+    if (executor)
+    {
+        executor->cancel(this, join);
+        return;
+    }
+    
     // Wait for background thread to stop runnig and the delete it
     if (join)
         cleanUpBackgroundThread();
@@ -315,35 +529,65 @@ void Updatable::getState(bool& backgrounded, int& interval)
     interval = m_interval;
 }
     
-void Updatable::loop()
+void Updatable::setExecutor(Executor* executor)
 {
-    struct timeval last;
-    struct timeval start;
-    struct timeval profile; // last time a profile update happened
-    Usec sleep_time;
-    Usec offset;
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    assert(!m_backgrounded && "Can't change executor while backgrounded");
+    m_executor = executor;
+}
 
-    // This call determines the time it takes for a gettimeofday call
-    // This makes the calls more accurate
-    gettimeofday(&last, NULL);
-    gettimeofday(&start, NULL);
-    offset = timeval_diff(&start, &last);
+Executor* Updatable::getExecutor()
+{
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    return m_executor;
+}
+    
+void Updatable::setOverrunPolicy(OverrunPolicy policy)
+{
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    m_overrunPolicy = policy;
+}
 
-    // Get time of day for profiling
-    gettimeofday(&profile, NULL);
-    m_profileCount = 0;
+Updatable::OverrunPolicy Updatable::getOverrunPolicy()
+{
+    boost::mutex::scoped_lock lock(m_upStateMutex);
+    return m_overrunPolicy;
+}
+
+Updatable::OverrunPolicy Updatable::stringToOverrunPolicy(std::string str)
+{
+    boost::algorithm::to_lower(str);
+
+    if ("skip" == str)
+        return OVERRUN_SKIP;
+    else if ("catch_up" == str)
+        return OVERRUN_CATCH_UP;
+    else if ("realign" == str)
+        return OVERRUN_REALIGN;
+    
+    assert(false && "Invalid overrun policy");
+    return OVERRUN_REALIGN;
+}
+    
+void Updatable::loop()
+{
+    // Zero until we have run once
+    Usec lastStart = 0;
+    
+    // The time the current update was supposed to start
+    Usec deadline = loopTime();
 
-    // Zero last so we can check
-    last.tv_usec = 0;
+    resetStatistics();
     
     while (1)
     {
         // Grab current time
-        gettimeofday(&start, NULL);
+        Usec start = loopTime();
 
         // Grab our running state
         bool in_background = false;
         int interval = 10;
+        OverrunPolicy overrunPolicy = OVERRUN_REALIGN;
         getState(in_background, interval);
 
         // Change thread state if needed
@@ -356,55 +600,60 @@ void Updatable::loop()
                 setThreadAffinity();
 
             m_settingChange = 0;
+            overrunPolicy = m_overrunPolicy;
         }
         
         if (in_background)
         {
             // On the first loop through, set the step to ideal
-            double diff = (double)(interval *(double)1000);
-            if (0 != last.tv_usec)
-                diff = (double)(timeval_diff(&start, &last) + offset);
+            Usec diff = (Usec)interval * USEC_PER_MILLISEC;
+            Usec period = 0;
+            if (0 != lastStart)
+            {
+                diff = start - lastStart;
+                period = diff;
+            }
 
             // Record time for next run 
-            last = start;
+            lastStart = start;
             
             // Call our update function
-            update(diff / (double)1000000);
-            m_profileCount += 1;
-
-            Usec profile_time = timeval_diff(&last, &profile);
-            // If 1 second has passed since the last profile, publish and reset
-            if (profile_time > 1000000)
-            {
-                if (m_publisher) {
-                    IntEventPtr event(new IntEvent());
-                    event->data = m_profileCount;
-                    m_publisher->publish(IUpdatable::PROFILE, event);
-                }
-                profile = last;
-                m_profileCount = 0;
-            }
+            update(diff / (double)USEC_PER_SEC);
+            Usec end = loopTime();
+            recordUpdate(start, end, period);
 
             // Only sleep if we aren't running all out
             if (interval > 0)
             {
-                // Determine next time to awake
-                struct timeval next = start;
-                timeval_add(&next, (Usec)interval * USEC_PER_MILLISEC);
-            
-                // Sleep for the rest for the remainder of our time
-                sleep_time = -age(&next);
+                Usec step = (Usec)interval * USEC_PER_MILLISEC;
+                deadline += step;
 
                 // Handle overrun
-                if (sleep_time < 0)
-                    sleep_time = interval * USEC_PER_MILLISEC;
-
-                // If the wait ends early keep waiting
-                while(sleep_time > SLEEP_THRESHOLD)
+                Usec now = loopTime();
+                if (deadline < now)
                 {
-                    waitForUpdate((long)sleep_time);
-                    sleep_time = -age(&next);
+                    recordOverrun();
+                    
+                    switch (overrunPolicy)
+                    {
+                        case OVERRUN_SKIP:
+                            deadline += ((now - deadline) / step + 1) * step;
+                            break;
+                        case OVERRUN_CATCH_UP:
+                            // Leave it in the past, we won't sleep
+                            break;
+                        case OVERRUN_REALIGN:
+                            deadline = now + step;
+                            break;
+                    }
                 }
+
+                waitUntil(deadline);
+            }
+            else
+            {
+                // Make sure switching to a fixed interval starts from now
+                deadline = end;
             }
         }
         // Time to quit
@@ -418,18 +667,116 @@ void Updatable::loop()
     m_threadStopped.countDown();
 }
 
+void Updatable::resetStatistics()
+{
+    m_statistics->reset();
+    m_reportStart = 0;
+    m_profileCount = 0;
+}
+
+void Updatable::recordUpdate(Usec start, Usec end, Usec period)
+{
+    if (0 == m_reportStart)
+        m_reportStart = start;
+    
+    if (0 != period)
+        m_statistics->addPeriod(period);
+    m_statistics->addExecTime(end - start);
+    m_profileCount += 1;
+
+    // If 1 second has passed since the last profile, publish and reset
+    if ((end - m_reportStart) > REPORT_INTERVAL)
+    {
+        if (m_publisher) {
+            static const Event::TypeId PROFILE_ID =
+                Event::registerType(IUpdatable::PROFILE);
+            static const Event::TypeId TIMING_ID =
+                Event::registerType(IUpdatable::TIMING);
+            
+            IntEventPtr event(new IntEvent());
+            event->data = m_profileCount;
+            m_publisher->publish(PROFILE_ID, IUpdatable::PROFILE, event);
+
+            UpdateTimingEventPtr timing(new UpdateTimingEvent());
+            m_statistics->fillEvent(timing);
+            m_publisher->publish(TIMING_ID, IUpdatable::TIMING, timing);
+        }
+        m_statistics->reset();
+        m_reportStart = end;
+        m_profileCount = 0;
+    }
+}
+
+void Updatable::recordOverrun()
+{
+    m_statistics->addOverrun();
+}
+
 void Updatable::waitForUpdate(long microseconds)
 {
 #ifdef RAM_POSIX
     struct timespec sleep = {0, 0};
     struct timespec act_sleep = {0, 0};
     
-    sleep.tv_nsec = microseconds * NSEC_PER_USEC;        
+    sleep.tv_sec = microseconds / USEC_PER_SEC;
+    sleep.tv_nsec = (microseconds % USEC_PER_SEC) * NSEC_PER_USEC;
     nanosleep(&sleep, &act_sleep);  
 #else
     Sleep(microseconds / USEC_PER_MILLISEC);
 #endif
 }
+
+void Updatable::waitUntil(boost::int64_t deadline)
+{
+    sleepUntil(deadline);
+}
+
+boost::int64_t Updatable::loopTime()
+{
+    return monotonicTime();
+}
+
+boost::int64_t Updatable::monotonicTime()
+{
+#ifdef RAM_LINUX
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((Usec)now.tv_sec) * USEC_PER_SEC + now.tv_nsec / NSEC_PER_USEC;
+#else
+    TimeVal now(TimeVal::timeOfDay());
+    return ((Usec)now.seconds()) * USEC_PER_SEC + now.microseconds();
+#endif
+}
+
+void Updatable::sleepUntil(boost::int64_t deadline)
+{
+#ifdef RAM_LINUX
+    struct timespec wakeUp = {0, 0};
+    wakeUp.tv_sec = (time_t)(deadline / USEC_PER_SEC);
+    wakeUp.tv_nsec = (long)(deadline % USEC_PER_SEC) * NSEC_PER_USEC;
+
+    // Restart if a signal interrupts us, the deadline stays the same
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                    &wakeUp, NULL))
+    {
+    }
+#else
+    // If the wait ends early keep waiting
+    Usec sleep_time = deadline - monotonicTime();
+    while(sleep_time > SLEEP_THRESHOLD)
+    {
+#ifdef RAM_POSIX
+        struct timespec sleep = {0, 0};
+        sleep.tv_sec = (time_t)(sleep_time / USEC_PER_SEC);
+        sleep.tv_nsec = (long)(sleep_time % USEC_PER_SEC) * NSEC_PER_USEC;
+        nanosleep(&sleep, NULL);
+#else
+        Sleep((DWORD)(sleep_time / USEC_PER_MILLISEC));
+#endif
+        sleep_time = deadline - monotonicTime();
+    }
+#endif
+}
     
 void Updatable::cleanUpBackgroundThread()
 {
@@ -462,13 +809,20 @@ void Updatable::initThreadingSettings()
         RT_LOW_PRIORITY_VALUE = sched_get_priority_min(SCHED_FIFO);
 
         // Check default affinity set to determine CPU count
-        cpu_set_t defaultSet;
+        cpu_set_t& defaultSet = DEFAULT_CPU_SET;
         sched_getaffinity(0, sizeof(defaultSet), &defaultSet);
 
-        CPU_COUNT = 0;
-        while (CPU_ISSET((int)CPU_COUNT, &defaultSet))
-            CPU_COUNT++;
-        assert(CPU_COUNT != 0 && "Getting CPU count failed");
+        assert(CPU_COUNT(&defaultSet) != 0 && "Getting CPU count failed");
+
+        // Isolated cores are left out of the default set, but can still be
+        // pinned to, so count everything the kernel knows about
+        long configured = sysconf(_SC_NPROCESSORS_CONF);
+        NUM_CPUS = configured > 0 ? (size_t)configured : 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &defaultSet))
+                NUM_CPUS = std::max(NUM_CPUS, (size_t)cpu + 1);
+        }
 
         // Assume these are standard accross all systems
         HIGH_PRIORITY_VALUE = -20;
@@ -492,8 +846,8 @@ void Updatable::initThreadingSettings()
 	//        RT_HIGH_PRIORITY_VALUE = PTHREAD_MAX_PRIORITY;
 	//        RT_LOW_PRIORITY_VALUE = PTHREAD_MIN_PRIORITY;
 
-        size_t size = sizeof(CPU_COUNT) ;
-        int ret = sysctlbyname("hw.ncpu", &CPU_COUNT, &size, NULL, 0);
+        size_t size = sizeof(NUM_CPUS) ;
+        int ret = sysctlbyname("hw.ncpu", &NUM_CPUS, &size, NULL, 0);
         assert(ret == 0 && "Getting CPU count failed");
 #else
         #error "Unsupported platform"
@@ -508,6 +862,21 @@ void Updatable::initThreadingSettings()
     }
 }
 
+/** Touches the given amount of stack so it is faulted in up front */
+static void prefaultStack(size_t bytes)
+{
+    volatile unsigned char chunk[PREFAULT_CHUNK];
+    for (size_t i = 0; i < PREFAULT_CHUNK; i += PAGE_SIZE_GUESS)
+        chunk[i] = 0;
+    
+    if (bytes > PREFAULT_CHUNK)
+        prefaultStack(bytes - PREFAULT_CHUNK);
+
+    // Keeps the recursive call from becoming a tail call which would reuse
+    // this frame
+    chunk[0] = chunk[PREFAULT_CHUNK - 1];
+}
+
 void Updatable::setThreadPriority()
 {
     switch (m_priority)
@@ -517,6 +886,14 @@ void Updatable::setThreadPriority()
         case LOW_PRIORITY:
         {
 #ifdef RAM_POSIX
+#ifdef RAM_LINUX
+            // Drop out of any real time policy we were in before
+            struct sched_param param;
+            param.sched_priority = 0;
+            if (pthread_setschedparam(pthread_self(), SCHED_OTHER, &param))
+                perror("ERROR pthread_setschedparam");
+#endif
+            
             int which = 0;
             int who = 0;
 #ifdef RAM_DARWIN
@@ -540,19 +917,27 @@ void Updatable::setThreadPriority()
         case RT_LOW_PRIORITY:
         {
 #ifdef RAM_LINUX
-/* Use the following            
-    struct sched_param param;  // scheduling priority
-    int policy = SCHED_RR;     // scheduling policy
-    
-    // Get the current thread id
-    
-    pthread_t thread_id = pthread_self();
-    
-    // To set the scheduling priority of the thread
-    param.sched_priority = 90;
-    pthread_setschedparam(thread_id, policy, &param);
-*/
+            static bool memoryLocked = false;
+            if (m_lockMemory && !memoryLocked)
+            {
+                // Process wide, so only the first thread needs to do it
+                if (mlockall(MCL_CURRENT | MCL_FUTURE))
+                    perror("ERROR mlockall");
+                else
+                    memoryLocked = true;
+            }
+
+            if (m_prefaultStack)
+                prefaultStack(m_prefaultStack);
             
+            struct sched_param param;
+            param.sched_priority = m_rtPriorityValue >= 0 ?
+                m_rtPriorityValue : m_priorityValue;
+            int policy = (RT_ROUND_ROBIN == m_rtPolicy) ? SCHED_RR : SCHED_FIFO;
+            
+            // Needs CAP_SYS_NICE or an rtprio entry in limits.conf
+            if (pthread_setschedparam(pthread_self(), policy, &param))
+                perror("ERROR pthread_setschedparam");
 #else
 	  assert(false && "Unsupported platform");
 #endif
@@ -569,10 +954,15 @@ void Updatable::setThreadPriority()
 void Updatable::setThreadAffinity()
 {
 #ifdef RAM_LINUX
-    // Create a mask which runs us on the proper CPU
-    cpu_set_t cpuMask;
-    CPU_ZERO(&cpuMask);
-    CPU_SET(m_affinity, &cpuMask);
+    // Create a mask which runs us on the proper CPUs, go back to the start up
+    // mask if none were given
+    cpu_set_t cpuMask = DEFAULT_CPU_SET;
+    if (!m_affinity.empty())
+    {
+        CPU_ZERO(&cpuMask);
+        BOOST_FOREACH(size_t cpu, m_affinity)
+            CPU_SET(cpu, &cpuMask);
+    }
     
     if(sched_setaffinity(0, sizeof(cpuMask), &cpuMask))
         perror("ERROR sched_setaffinity");
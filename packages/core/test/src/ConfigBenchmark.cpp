@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/test/src/ConfigBenchmark.cpp
+ */
+
+// STD Includes
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+// Library Includes
+#include <boost/filesystem.hpp>
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "core/include/ConfigNode.h"
+#include "core/include/TimeVal.h"
+
+using namespace ram;
+
+/** Seconds since the given start time */
+static double since(const core::TimeVal& start)
+{
+    return core::TimeVal::timeOfDay().get_double() - start.get_double();
+}
+
+/** Prints the time per iteration in milliseconds */
+static void report(const std::string& name, int iterations, double seconds)
+{
+    std::cout << std::setw(30) << std::left << name
+              << std::setw(12) << std::right << std::fixed
+              << std::setprecision(3) << seconds * 1000 / iterations
+              << " ms" << std::endl;
+}
+
+/** Reads every value in the tree like the subsystem constructors do
+ *
+ *  @return  The number of values read
+ */
+static int walk(core::ConfigNode node)
+{
+    core::NodeNameList names = node.subNodes();
+    if (names.empty())
+    {
+        node.asString("");
+        return 1;
+    }
+
+    int count = 0;
+    BOOST_FOREACH(std::string name, names)
+    {
+        count += walk(node[name]);
+    }
+    return count;
+}
+
+static core::ConfigNode load(const std::string& file,
+                             core::ConfigNode::Backend backend)
+{
+    return core::ConfigNode::fromFile(file, backend);
+}
+
+static void benchmark(const std::string& name, const std::string& file,
+                      core::ConfigNode::Backend backend, int iterations)
+{
+    // The first load also pays for starting the interpreter, so it gets
+    // its own line
+    core::TimeVal start = core::TimeVal::timeOfDay();
+    core::ConfigNode config(load(file, backend));
+    report(name + " first load", 1, since(start));
+
+    start = core::TimeVal::timeOfDay();
+    for (int i = 0; i < iterations; ++i)
+        config = load(file, backend);
+    report(name + " load", iterations, since(start));
+
+    int values = 0;
+    start = core::TimeVal::timeOfDay();
+    for (int i = 0; i < iterations; ++i)
+        values = walk(config);
+    report(name + " read all", iterations, since(start));
+
+    // The kind of lookup done over and over at run time
+    int lookups = iterations * 1000;
+    start = core::TimeVal::timeOfDay();
+    for (int i = 0; i < lookups; ++i)
+    {
+        config["Subsystems"]["Controller"]["update_interval"].asInt(-1);
+    }
+    report(name + " 1000 lookups", iterations, since(start));
+
+    std::cout << std::setw(30) << std::left << (name + " values")
+              << std::setw(12) << std::right << values << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string file;
+    int iterations = 20;
+    const char* root = getenv("RAM_SVN_DIR");
+    if (argc > 1)
+        file = argv[1];
+    else if (root)
+        file = (boost::filesystem::path(root) / "data" / "config" /
+                "transdec2010.yml").string();
+    if (argc > 2)
+        iterations = atoi(argv[2]);
+
+    if (file.empty() || !root || (iterations < 1) ||
+        ((argc > 1) && (0 == strcmp(argv[1], "-h"))))
+    {
+        std::cout << "Usage: ConfigBenchmark [config.yml] [iterations]\n\n"
+            "Times loading and reading the vehicle config with each\n"
+            "ConfigNode backend, $RAM_SVN_DIR must be set for includes"
+                  << std::endl;
+        return 1;
+    }
+
+    std::cout << "Config: " << file << std::endl;
+    benchmark("Native", file, core::ConfigNode::NATIVE, iterations);
+    benchmark("Python", file, core::ConfigNode::PYTHON, iterations);
+    return 0;
+}
@@ -14,6 +14,8 @@
 // STD Includes
 #include <sstream>
 #include <cstdlib>
+#include <map>
+#include <algorithm>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
@@ -21,6 +23,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
 
 // Project Includes
 #include "core/test/include/MockSubsystem.h"
@@ -34,6 +37,37 @@ namespace bf = boost::filesystem;
 const std::string LoopSubsystem::STOP("CORE_TEST_LOOPSUBSYSTEM");
 RAM_CORE_REGISTER_SUBSYSTEM_MAKER(LoopSubsystem, LoopSubsystem);
 
+/** Takes sleepTime milliseconds to construct, and records when it did */
+class SlowSubsystem : public MockSubsystem
+{
+public:
+    SlowSubsystem(ram::core::ConfigNode config_,
+                  ram::core::SubsystemList dependents_) :
+        MockSubsystem(config_, dependents_)
+    {
+        ram::core::TimeVal start(ram::core::TimeVal::timeOfDay());
+        #ifdef RAM_POSIX
+            usleep(USEC_PER_MILLISEC * config_["sleepTime"].asInt());
+        #else
+            Sleep(config_["sleepTime"].asInt());
+        #endif
+        ram::core::TimeVal end(ram::core::TimeVal::timeOfDay());
+
+        boost::mutex::scoped_lock lock(mutex);
+        started[getName()] = start.get_double();
+        finished[getName()] = end.get_double();
+    }
+
+    static boost::mutex mutex;
+    static std::map<std::string, double> started;
+    static std::map<std::string, double> finished;
+};
+
+boost::mutex SlowSubsystem::mutex;
+std::map<std::string, double> SlowSubsystem::started;
+std::map<std::string, double> SlowSubsystem::finished;
+RAM_CORE_REGISTER_SUBSYSTEM_MAKER(SlowSubsystem, SlowSubsystem);
+
 static bf::path getConfigRoot()
 {
     bf::path root(getenv("RAM_SVN_DIR"));
@@ -211,4 +245,58 @@ TEST(setAffinity)
     CHECK_EQUAL(1, subsystem->getAffinity());
 }
 
+#ifdef RAM_POSIX // Needs setenv
+TEST(ParallelStartup)
+{
+    // Only the native config can be read from several threads
+    const char* backend = getenv("RAM_CONFIG_BACKEND");
+    std::string oldBackend(backend ? backend : "");
+    setenv("RAM_CONFIG_BACKEND", "native", 1);
+
+    bf::path path(getConfigRoot() / "parallelSubsystems.yml");
+    ram::core::TimeVal start(ram::core::TimeVal::timeOfDay());
+    {
+        ram::core::Application app(path.string());
+        double elapsed = ram::core::TimeVal::timeOfDay().get_double() -
+            start.get_double();
+
+        // The three servants were built at the same time
+        CHECK(elapsed < 0.55);
+
+        // Everything was built after what it depends on
+        std::vector<std::string> names = app.getSubsystemNames();
+        CHECK_EQUAL(5u, names.size());
+        BOOST_FOREACH(std::string name, names)
+        {
+            MockSubsystem* subsystem = dynamic_cast<MockSubsystem*>(
+                app.getSubsystem(name).get());
+            CHECK(subsystem);
+            BOOST_FOREACH(ram::core::SubsystemPtr dep, subsystem->dependents)
+            {
+                CHECK(SlowSubsystem::finished[dep->getName()] <=
+                      SlowSubsystem::started[name]);
+
+                // And comes before it in the order
+                CHECK(std::find(names.begin(), names.end(), dep->getName()) <
+                      std::find(names.begin(), names.end(), name));
+            }
+        }
+
+        MockSubsystem* subServant = dynamic_cast<MockSubsystem*>(
+            app.getSubsystem("SubServant").get());
+        ram::core::SubsystemList expected =
+            ba::list_of(app.getSubsystem("Servant1"))
+            (app.getSubsystem("Servant3"));
+        CHECK(expected == subServant->dependents);
+        CHECK(subServant->inBackground);
+        CHECK_EQUAL(100, subServant->rate);
+    }
+
+    if (oldBackend.empty())
+        unsetenv("RAM_CONFIG_BACKEND");
+    else
+        setenv("RAM_CONFIG_BACKEND", oldBackend.c_str(), 1);
+}
+#endif
+
 } // SUITE(Application)
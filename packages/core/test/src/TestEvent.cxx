@@ -16,6 +16,7 @@
 // Project Includes
 #include "core/include/Event.h"
 #include "core/include/Events.h"
+#include "core/include/EventHub.h"
 
 using namespace ram;
 
@@ -59,3 +60,31 @@ TEST(Clone)
     CHECK_EQUAL(0, memcmp(original2.get(), cloned2.get(),
                           sizeof(core::StringEvent)));
 }
+
+TEST(RegisterType)
+{
+    core::Event::TypeId idA = core::Event::registerType("TestEvent A");
+    core::Event::TypeId idB = core::Event::registerType("TestEvent B");
+
+    // Ids are stable and unique
+    CHECK(idA != core::Event::UNKNOWN_TYPE);
+    CHECK(idA != idB);
+    CHECK_EQUAL(idA, core::Event::registerType("TestEvent A"));
+
+    // We can get back to the string
+    CHECK_EQUAL("TestEvent A", core::Event::typeName(idA));
+    CHECK_EQUAL("TestEvent B", core::Event::typeName(idB));
+    CHECK_EQUAL("", core::Event::typeName(idB + 1000));
+}
+
+TEST(DeclaredTypesRegistered)
+{
+    // Declared with RAM_CORE_EVENT_TYPE so it has an id before main
+    core::Event::TypeId id =
+        core::Event::registerType(core::EventHub::ALL_EVENTS);
+    CHECK_EQUAL(core::EventHub::ALL_EVENTS, core::Event::typeName(id));
+
+    // Fresh events have no id until they are published
+    core::EventPtr event(new core::Event());
+    CHECK_EQUAL(core::Event::UNKNOWN_TYPE, event->typeId);
+}
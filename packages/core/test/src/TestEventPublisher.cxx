@@ -46,6 +46,27 @@ TEST_FIXTURE(EventPublisherFixture, Publish)
     CHECK_EQUAL(&publisher, recv.events[0]->sender);
 }
 
+TEST_FIXTURE(EventPublisherFixture, PublishTypeId)
+{
+    publisher.subscribe("Type", boost::bind(&Reciever::handler, &recv, _1));
+
+    ram::core::Event::TypeId typeId =
+        ram::core::Event::registerType("Type");
+    ram::core::EventPtr event(new ram::core::Event());
+    publisher.publish(typeId, "Type", event);
+
+    CHECK_EQUAL(1, recv.calls);
+    CHECK_EQUAL(event, recv.events[0]);
+    CHECK_EQUAL("Type", recv.events[0]->type);
+    CHECK_EQUAL(typeId, recv.events[0]->typeId);
+    CHECK_EQUAL(&publisher, recv.events[0]->sender);
+
+    // Other types don't get through
+    publisher.publish(ram::core::Event::registerType("TypeB"), "TypeB",
+                      ram::core::EventPtr(new ram::core::Event()));
+    CHECK_EQUAL(1, recv.calls);
+}
+
 TEST_FIXTURE(EventPublisherFixture, EmptyPublish)
 {
     publisher.publish("Type", ram::core::EventPtr(new ram::core::Event()));
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/test/src/TestExecutor.cxx
+ */
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+// Project Includes
+#include "core/include/Executor.h"
+#include "core/include/Updatable.h"
+#include "core/include/EventPublisher.h"
+#include "core/include/Events.h"
+
+using namespace ram;
+
+class Counter : public core::Updatable
+{
+public:
+    Counter(int stopAt_ = -1, core::EventPublisher* publisher = 0) :
+        core::Updatable(publisher),
+        count(0), total(0), stopAt(stopAt_), thread() {}
+
+    ~Counter()
+        {
+            unbackground(true);
+        }
+
+    virtual void update(double timestep)
+        {
+            count += 1;
+            total += timestep;
+            thread = boost::this_thread::get_id();
+            if (count == stopAt)
+                unbackground(false);
+        }
+
+    int count;
+    double total;
+    int stopAt;
+    boost::thread::id thread;
+};
+
+static void sleepMilliseconds(int milliseconds)
+{
+    boost::xtime wait;
+    boost::xtime_get(&wait, boost::TIME_UTC);
+    wait.nsec += milliseconds * 1000000;
+    while (wait.nsec >= 1000000000)
+    {
+        wait.sec += 1;
+        wait.nsec -= 1000000000;
+    }
+    boost::thread::sleep(wait);
+}
+
+static void waitForStop(core::Updatable& updatable)
+{
+    while (updatable.backgrounded())
+        boost::thread::yield();
+    updatable.unbackground(true);
+}
+
+static void recordEvent(core::EventPtr* result, core::EventPtr event)
+{
+    *result = event;
+}
+
+SUITE(Executor)
+{
+
+TEST(Periodic)
+{
+    core::Executor executor("Executor", 2);
+    CHECK_EQUAL(2u, executor.getThreadCount());
+
+    Counter counter(10);
+    counter.setExecutor(&executor);
+    counter.background(5);
+    waitForStop(counter);
+
+    CHECK_EQUAL(10, counter.count);
+    CHECK_CLOSE(0.005, counter.total / counter.count, 0.002);
+
+    // Ran on the pool, not our thread
+    CHECK(counter.thread != boost::this_thread::get_id());
+    CHECK(counter.thread != boost::thread::id());
+}
+
+TEST(LongerThanWheel)
+{
+    // Both intervals go around the 4 ms wheel more than once
+    core::Executor executor("Executor", 2, std::set<size_t>(), 1000, 4);
+    Counter fast(10);
+    Counter slow(4);
+    fast.setExecutor(&executor);
+    slow.setExecutor(&executor);
+
+    fast.background(5);
+    slow.background(13);
+    waitForStop(fast);
+    waitForStop(slow);
+
+    CHECK_EQUAL(10, fast.count);
+    CHECK_EQUAL(4, slow.count);
+    CHECK_CLOSE(0.005, fast.total / fast.count, 0.002);
+    CHECK_CLOSE(0.013, slow.total / slow.count, 0.002);
+}
+
+TEST(RunAllOut)
+{
+    core::Executor executor("Executor", 1);
+    Counter fast(1000);
+    Counter slow(5);
+    fast.setExecutor(&executor);
+    slow.setExecutor(&executor);
+
+    // The all out task can't starve the periodic one on a single worker
+    fast.background(-1);
+    slow.background(1);
+    waitForStop(slow);
+    waitForStop(fast);
+
+    CHECK_EQUAL(1000, fast.count);
+    CHECK_EQUAL(5, slow.count);
+}
+
+TEST(UnbackgroundJoin)
+{
+    core::Executor executor("Executor", 2);
+    Counter counter;
+    counter.setExecutor(&executor);
+    counter.background(1);
+
+    sleepMilliseconds(10);
+    counter.unbackground(true);
+    CHECK_EQUAL(false, counter.backgrounded());
+    CHECK(counter.count > 0);
+
+    // No more updates after the join
+    int count = counter.count;
+    sleepMilliseconds(20);
+    CHECK_EQUAL(count, counter.count);
+
+    // And it can start back up
+    counter.stopAt = count + 3;
+    counter.background(1);
+    waitForStop(counter);
+    CHECK_EQUAL(count + 3, counter.count);
+}
+
+TEST(ExecutorDestroyedFirst)
+{
+    Counter counter;
+    {
+        core::Executor executor("Executor", 1);
+        counter.setExecutor(&executor);
+        counter.background(1);
+        sleepMilliseconds(5);
+    }
+
+    // Back on a dedicated thread, and still running
+    CHECK(0 == counter.getExecutor());
+    CHECK_EQUAL(true, counter.backgrounded());
+
+    int count = counter.count;
+    sleepMilliseconds(20);
+    counter.unbackground(true);
+    CHECK(counter.count > count);
+}
+
+TEST(PublishesTiming)
+{
+    core::Executor executor("Executor", 1);
+    core::EventPublisher publisher;
+    core::EventPtr timing;
+    publisher.subscribe(core::IUpdatable::TIMING,
+                        boost::bind(recordEvent, &timing, _1));
+
+    Counter counter(-1, &publisher);
+    counter.setExecutor(&executor);
+    counter.background(10);
+
+    // Reports go out once a second, the same as on a dedicated thread
+    sleepMilliseconds(1300);
+    counter.unbackground(true);
+
+    core::UpdateTimingEventPtr event =
+        boost::dynamic_pointer_cast<core::UpdateTimingEvent>(timing);
+    CHECK(event);
+    if (event)
+    {
+        CHECK(event->updates > 0);
+        CHECK_CLOSE(0.01, event->meanPeriod, 0.005);
+    }
+}
+
+} // SUITE(Executor)
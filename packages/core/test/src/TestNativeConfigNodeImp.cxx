@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/test/src/TestNativeConfigNodeImp.cxx
+ */
+
+#ifdef RAM_WINDOWS
+#define _CRT_SECURE_NO_WARNINGS // turn off warning about getenv
+#endif
+
+// STD Includes
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+#include <boost/filesystem.hpp>
+
+// Project Includes
+#include "core/include/ConfigNode.h"
+#include "core/include/Exception.h"
+
+namespace ram {
+namespace core {
+
+static std::string getNativeConfigFile(std::string name)
+{
+    boost::filesystem::path root(getenv("RAM_SVN_DIR"));
+    return (root / "packages" / "core" / "test" / "data" / name).string();
+}
+
+const std::string NATIVE_BASIC_CFG(
+    "{'TestInt': 10, "
+    " 'TestDouble': 23.5,"
+    " 'TestStr' : 'Str',"
+    " 'Array' : [4,5,6],"
+    " 'Map' :"
+    "     {'A' : 'D', 'B' : 'E', 'C' : 'F'} }");
+
+const std::string NATIVE_BLOCK_CFG(
+    "# A comment\n"
+    "Vehicle:\n"
+    "    name: 'Tortuga #4' # Quoted\n"
+    "    depthGain: 1.5e+2\n"
+    "    hex: 0x1F\n"
+    "    enabled: yes\n"
+    "    nothing: ~\n"
+    "    list:\n"
+    "    - 1\n"
+    "    - two\n"
+    "    - [3, 4.0]\n"
+    "    thrusters:\n"
+    "        - name: Port\n"
+    "          address: 1\n"
+    "        - name: Starboard\n"
+    "          address: 2\n"
+    "    flow: {a: 1, b: [x, y],\n"
+    "           c: 'it''s'}\n");
+
+struct TestNativeConfigNode
+{
+    TestNativeConfigNode()
+        : configNode(ConfigNode::fromString(NATIVE_BASIC_CFG,
+                                            ConfigNode::NATIVE))
+    {
+    }
+
+    ConfigNode configNode;
+};
+
+TEST_FIXTURE(TestNativeConfigNode, toString)
+{
+    std::string config("{'Test': 10}");
+    ConfigNode node(ConfigNode::fromString(config, ConfigNode::NATIVE));
+    CHECK_EQUAL(config, node.toString());
+
+    // Reads back its own output
+    ConfigNode copy(ConfigNode::fromString(configNode.toString(),
+                                           ConfigNode::NATIVE));
+    CHECK_EQUAL(configNode.toString(), copy.toString());
+}
+
+TEST_FIXTURE(TestNativeConfigNode, asString)
+{
+    CHECK_EQUAL("Str", configNode["TestStr"].asString());
+    CHECK_EQUAL("Def", configNode["NotThere"].asString("Def"));
+    CHECK_EQUAL("10", configNode["TestInt"].asString());
+    CHECK_EQUAL("23.5", configNode["TestDouble"].asString());
+}
+
+TEST_FIXTURE(TestNativeConfigNode, asInt)
+{
+    CHECK_EQUAL(10, configNode["TestInt"].asInt());
+    CHECK_EQUAL(2, configNode["NotThere"].asInt(2));
+    CHECK_EQUAL(2, configNode["TestStr"].asInt(2));
+    CHECK_THROW(configNode["Bob"].asInt(), ConfigNodeException);
+    CHECK_THROW(configNode["TestStr"].asInt(), ConfigNodeException);
+}
+
+TEST_FIXTURE(TestNativeConfigNode, asDouble)
+{
+    CHECK_EQUAL(23.5, configNode["TestDouble"].asDouble());
+    CHECK_EQUAL(10.0, configNode["TestInt"].asDouble());
+    CHECK_EQUAL(17.6, configNode["NotThere"].asDouble(17.6));
+    CHECK_THROW(configNode["TestStr"].asDouble(), ConfigNodeException);
+}
+
+TEST_FIXTURE(TestNativeConfigNode, subNodes)
+{
+    NodeNameList subnodes = configNode["Map"].subNodes();
+
+    // Ensure we got the right size
+    CHECK_EQUAL(3u, subnodes.size());
+
+    CHECK(subnodes.end() != subnodes.find("A"));
+    CHECK(subnodes.end() != subnodes.find("B"));
+    CHECK(subnodes.end() != subnodes.find("C"));
+}
+
+TEST_FIXTURE(TestNativeConfigNode, size)
+{
+    CHECK_EQUAL(3u, configNode["Array"].size());
+    CHECK_EQUAL(3u, configNode["Map"].size());
+}
+
+TEST_FIXTURE(TestNativeConfigNode, exists)
+{
+    CHECK(false == configNode.exists("Bob"));
+    CHECK(configNode.exists("Map"));
+    CHECK(false == configNode["TestInt"].exists("Map"));
+}
+
+TEST_FIXTURE(TestNativeConfigNode, index)
+{
+    CHECK_EQUAL(4, configNode["Array"][0].asInt());
+    CHECK_EQUAL(5, configNode["Array"][1].asInt());
+    CHECK_EQUAL(6, configNode["Array"][2].asInt());
+    CHECK_THROW(configNode["Array"][3], ConfigNodeException);
+}
+
+TEST_FIXTURE(TestNativeConfigNode, map)
+{
+    CHECK_EQUAL("D", configNode["Map"]["A"].asString());
+    CHECK_EQUAL("E", configNode["Map"]["B"].asString());
+    CHECK_EQUAL("F", configNode["Map"]["C"].asString());
+}
+
+TEST_FIXTURE(TestNativeConfigNode, set)
+{
+    // Ensure value is not there
+    CHECK_EQUAL("NotHere", configNode["Map"]["TestSet"].asString("NotHere"));
+
+    // Set value and make sure it stuck, copies share the tree
+    configNode["Map"].set("TestSet", "MyVal");
+    configNode["Map"].set("TestSetInt", 7);
+    CHECK_EQUAL("MyVal", configNode["Map"]["TestSet"].asString());
+    CHECK_EQUAL(7, configNode["Map"]["TestSetInt"].asInt());
+
+    CHECK_THROW(configNode["TestInt"].set("A", 1), ConfigNodeException);
+}
+
+TEST(NativeConfigNodeBlock)
+{
+    ConfigNode root(ConfigNode::fromString(NATIVE_BLOCK_CFG,
+                                           ConfigNode::NATIVE));
+    ConfigNode node = root["Vehicle"];
+
+    CHECK_EQUAL("Tortuga #4", node["name"].asString());
+    CHECK_EQUAL(150.0, node["depthGain"].asDouble());
+    CHECK_EQUAL(31, node["hex"].asInt());
+    CHECK_EQUAL(1, node["enabled"].asInt());
+    CHECK_EQUAL("True", node["enabled"].asString());
+    CHECK_EQUAL("None", node["nothing"].asString());
+    CHECK_EQUAL(5, node["nothing"].asInt(5));
+
+    CHECK_EQUAL(3u, node["list"].size());
+    CHECK_EQUAL(1, node["list"][0].asInt());
+    CHECK_EQUAL("two", node["list"][1].asString());
+    CHECK_EQUAL(4.0, node["list"][2][1].asDouble());
+
+    CHECK_EQUAL(2u, node["thrusters"].size());
+    CHECK_EQUAL("Port", node["thrusters"][0]["name"].asString());
+    CHECK_EQUAL(2, node["thrusters"][1]["address"].asInt());
+
+    CHECK_EQUAL(1, node["flow"]["a"].asInt());
+    CHECK_EQUAL("y", node["flow"]["b"][1].asString());
+    CHECK_EQUAL("it's", node["flow"]["c"].asString());
+}
+
+TEST(NativeConfigNodeErrors)
+{
+    CHECK_THROW(ConfigNode::fromString("a: [1, 2", ConfigNode::NATIVE),
+                ConfigNodeException);
+    CHECK_THROW(ConfigNode::fromString("a: 'open", ConfigNode::NATIVE),
+                ConfigNodeException);
+    CHECK_THROW(ConfigNode::fromString("a: 1\n  b: 2", ConfigNode::NATIVE),
+                ConfigNodeException);
+    CHECK_THROW(ConfigNode::fromString("a: &anchor 1", ConfigNode::NATIVE),
+                ConfigNodeException);
+}
+
+TEST(NativeConfigNodeInclude)
+{
+    ConfigNode configNode(ConfigNode::fromFile(
+        getNativeConfigFile("testInclude.yml"), ConfigNode::NATIVE));
+
+    // Make sure original values are there
+    CHECK(configNode.exists("Base"));
+    ConfigNode base = configNode["Base"];
+    CHECK(base.exists("Sub"));
+    ConfigNode sub = base["Sub"];
+
+    CHECK_EQUAL(100, sub["count"].asInt());
+    CHECK_EQUAL("Test.Good", sub["type"].asString());
+
+    // Test the base level import
+    CHECK(configNode.exists("Other"));
+    CHECK_EQUAL(1, configNode["Other"]["key"].asInt());
+
+    // Test import of mid-level import
+    CHECK(base.exists("Sys2"));
+    CHECK_EQUAL("Sonar", base["Sys2"]["type"].asString());
+
+    // Test deep import
+    CHECK_EQUAL(57.6, sub["setting"].asDouble());
+    CHECK_EQUAL("Bob", sub["mode"].asString());
+
+    // Test recursive import
+    CHECK_EQUAL(67, configNode["Other"]["recVal"].asInt());
+
+    // The INCLUDE keys themselves are gone
+    NodeNameList subnodes = configNode["Base"].subNodes();
+    CHECK_EQUAL(2u, subnodes.size());
+    CHECK(subnodes.end() != subnodes.find("Sub"));
+    CHECK(subnodes.end() != subnodes.find("Sys2"));
+}
+
+TEST(NativeConfigNodeWriteToFile)
+{
+    ConfigNode node(ConfigNode::fromString(NATIVE_BLOCK_CFG,
+                                           ConfigNode::NATIVE));
+
+    boost::filesystem::path path("NativeConfigNodeTest.yml");
+    if (boost::filesystem::exists(path))
+        boost::filesystem::remove(path);
+
+    node.writeToFile(path.string());
+    CHECK(boost::filesystem::exists(path));
+
+    // Reads back to the same tree
+    ConfigNode copy(ConfigNode::fromFile(path.string(), ConfigNode::NATIVE));
+    CHECK_EQUAL(node.toString(), copy.toString());
+
+    // Cleanup
+    boost::filesystem::remove(path);
+}
+
+TEST(NativeConfigNodeVehicleConfig)
+{
+    // The full vehicle config, with includes several levels deep
+    boost::filesystem::path root(getenv("RAM_SVN_DIR"));
+    ConfigNode config(ConfigNode::fromFile(
+        (root / "data" / "config" / "transdec2010.yml").string(),
+        ConfigNode::NATIVE));
+    ConfigNode subsystems = config["Subsystems"];
+
+    CHECK_EQUAL(11u, subsystems.subNodes().size());
+    CHECK_EQUAL("ram.ai.course.Gate",
+                subsystems["Ai"]["taskOrder"][0].asString());
+    CHECK_EQUAL(10.0, subsystems["Controller"]["depthKp"].asDouble());
+    CHECK_EQUAL(1.288, subsystems["Controller"]["inertia"][2][2].asDouble());
+    CHECK_EQUAL("VisionSystem", subsystems["VisionSystem"]["type"].asString());
+
+    // Mean the same thing again when written out as a Python literal
+    ConfigNode copy(ConfigNode::fromString(config.toString(),
+                                           ConfigNode::NATIVE));
+    CHECK_EQUAL(config.toString(), copy.toString());
+}
+
+} // namespace core
+} // namespace ram
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/core/test/src/TestRingQueue.cxx
+ */
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+
+// Project Includes
+#include "core/include/RingQueue.h"
+#include "core/include/ThreadedQueue.h"
+
+using namespace ram;
+
+/** Not default constructable, like core::LoggingEvent */
+struct Item
+{
+    Item(int v) : value(v) {}
+    int value;
+};
+
+TEST(RingQueueCapacity)
+{
+    core::RingQueue<int> queue(5);
+    CHECK_EQUAL(8u, queue.capacity());
+    CHECK_EQUAL(0u, queue.size());
+}
+
+TEST(RingQueueFIFO)
+{
+    core::RingQueue<Item> queue(4);
+    queue.push(Item(1));
+    queue.push(Item(2));
+    CHECK_EQUAL(2u, queue.size());
+
+    Item item(0);
+    CHECK(queue.popNoWait(item));
+    CHECK_EQUAL(1, item.value);
+    CHECK_EQUAL(2, queue.popWait().value);
+    CHECK_EQUAL(false, queue.popNoWait(item));
+
+    boost::xtime wait = {0, 1000000}; // 1 millisecond
+    CHECK_EQUAL(false, queue.popTimedWait(wait, item));
+    CHECK_EQUAL(1, item.value);
+}
+
+TEST(RingQueueDropNewest)
+{
+    core::RingQueue<Item> queue(2, core::RingQueueBase::DROP_NEWEST);
+    CHECK(queue.push(Item(1)));
+    CHECK(queue.push(Item(2)));
+    CHECK_EQUAL(false, queue.push(Item(3)));
+    CHECK_EQUAL(1u, queue.dropped());
+    CHECK_EQUAL(2u, queue.highWaterMark());
+
+    CHECK_EQUAL(1, queue.popWait().value);
+    CHECK_EQUAL(2, queue.popWait().value);
+}
+
+TEST(RingQueueDropOldest)
+{
+    core::RingQueue<Item> queue(4, core::RingQueueBase::DROP_OLDEST);
+    for (int i = 0; i < 10; ++i)
+        CHECK(queue.push(Item(i)));
+
+    CHECK_EQUAL(6u, queue.dropped());
+    CHECK_EQUAL(4u, queue.highWaterMark());
+    for (int i = 6; i < 10; ++i)
+        CHECK_EQUAL(i, queue.popWait().value);
+}
+
+TEST(RingQueueReleasesItems)
+{
+    boost::shared_ptr<int> value(new int(5));
+    {
+        core::RingQueue<boost::shared_ptr<int> > queue(4);
+        queue.push(value);
+        queue.push(value);
+        CHECK_EQUAL(3, value.use_count());
+
+        boost::shared_ptr<int> popped;
+        queue.popNoWait(popped);
+        popped.reset();
+        CHECK_EQUAL(2, value.use_count());
+    }
+    // Destructor cleans up what is left
+    CHECK_EQUAL(1, value.use_count());
+}
+
+static void pushMany(core::ThreadedQueue<int>* queue, int count)
+{
+    for (int i = 0; i < count; ++i)
+        queue->push(1);
+}
+
+TEST(ThreadedQueueBoundedBlocking)
+{
+    const int COUNT = 10000;
+    core::ThreadedQueue<int> queue;
+    queue.setBounded(16);
+
+    // Three producers against a queue much smaller than what they push
+    boost::thread producerA(boost::bind(pushMany, &queue, COUNT));
+    boost::thread producerB(boost::bind(pushMany, &queue, COUNT));
+    boost::thread producerC(boost::bind(pushMany, &queue, COUNT));
+
+    int total = 0;
+    for (int i = 0; i < COUNT * 3; ++i)
+        total += queue.popWait();
+
+    producerA.join();
+    producerB.join();
+    producerC.join();
+
+    int item = 0;
+    CHECK_EQUAL(COUNT * 3, total);
+    CHECK_EQUAL(false, queue.popNoWait(item));
+    CHECK_EQUAL(0u, queue.dropped());
+    CHECK(queue.highWaterMark() <= 16u);
+}
+
+TEST(ThreadedQueueUnboundedStats)
+{
+    core::ThreadedQueue<int> queue;
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+
+    int item = 0;
+    queue.popNoWait(item);
+    CHECK_EQUAL(3u, queue.highWaterMark());
+    CHECK_EQUAL(0u, queue.dropped());
+}
+
+TEST(ThreadedQueuePopAll)
+{
+    core::ThreadedQueue<int> unbounded;
+    core::ThreadedQueue<int> bounded;
+    bounded.setBounded(8);
+
+    core::ThreadedQueue<int>* queues[] = {&unbounded, &bounded};
+    for (int i = 0; i < 2; ++i)
+    {
+        core::ThreadedQueue<int>& queue = *queues[i];
+        queue.push(1);
+        queue.push(2);
+        queue.push(3);
+
+        // Appends to what is already there
+        std::vector<int> items(1, 0);
+        CHECK_EQUAL(3u, queue.popAll(items));
+        CHECK_EQUAL(4u, items.size());
+        CHECK_EQUAL(0, items[0]);
+        CHECK_EQUAL(1, items[1]);
+        CHECK_EQUAL(3, items[3]);
+
+        // Nothing left
+        CHECK_EQUAL(0u, queue.popAll(items));
+        CHECK_EQUAL(4u, items.size());
+    }
+}
+
+TEST(ThreadedQueueDrainInto)
+{
+    core::ThreadedQueue<int> unbounded;
+    core::ThreadedQueue<int> bounded;
+    bounded.setBounded(8);
+
+    core::ThreadedQueue<int>* queues[] = {&unbounded, &bounded};
+    for (int i = 0; i < 2; ++i)
+    {
+        core::ThreadedQueue<int>& queue = *queues[i];
+        for (int j = 0; j < 5; ++j)
+            queue.push(j);
+
+        int items[5] = {0};
+        CHECK_EQUAL(2u, queue.drainInto(items, 2));
+        CHECK_EQUAL(0, items[0]);
+        CHECK_EQUAL(1, items[1]);
+        CHECK_EQUAL(0, items[2]);
+
+        // The rest in order
+        CHECK_EQUAL(3u, queue.drainInto(items + 2));
+        CHECK_EQUAL(4, items[4]);
+        CHECK_EQUAL(0u, queue.drainInto(items));
+    }
+}
@@ -24,12 +24,15 @@ get the mutex from the lower priority threads.
 
 // STD Includes
 #include <iostream>
+#include <set>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
+#include <boost/thread/thread.hpp>
 
 // Project Includes
 #include "core/include/Updatable.h"
+#include "core/include/TimeVal.h"
 
 #ifdef RAM_LINUX
 // Linux Includes
@@ -80,6 +83,45 @@ public:
     int tid;
 };
 
+class StepRecorder : public ram::core::Updatable
+{
+public:
+    StepRecorder() : count(0), total(0) {}
+
+    ~StepRecorder()
+        {
+            unbackground(true);
+        }
+    
+    virtual void update(double timestep)
+        {
+            total += timestep;
+            count += 1;
+            if (count == 20)
+                unbackground(false);
+        }
+
+    int count;
+    double total;
+};
+
+/** Runs its loop on the TimeVal virtual clock, which only moves when the
+ *  loop waits, so every update sees exactly the interval */
+class VirtualStepRecorder : public StepRecorder
+{
+public:
+    virtual boost::int64_t loopTime()
+        {
+            return (boost::int64_t)
+                (ram::core::TimeVal::clockTime().get_double() * 1000000 + 0.5);
+        }
+
+    virtual void waitUntil(boost::int64_t deadline)
+        {
+            ram::core::TimeVal::setVirtualTime(deadline / 1000000.0);
+        }
+};
+
 SUITE(Updatable)
 {
 
@@ -92,6 +134,110 @@ TEST(setPriority)
     CHECK_EQUAL(test1.getPriority(), ram::core::IUpdatable::LOW_PRIORITY);
 }
 
+TEST(stringToOverrunPolicy)
+{
+    using ram::core::Updatable;
+    CHECK_EQUAL(Updatable::OVERRUN_SKIP,
+                Updatable::stringToOverrunPolicy("skip"));
+    CHECK_EQUAL(Updatable::OVERRUN_CATCH_UP,
+                Updatable::stringToOverrunPolicy("Catch_Up"));
+    CHECK_EQUAL(Updatable::OVERRUN_REALIGN,
+                Updatable::stringToOverrunPolicy("REALIGN"));
+}
+
+TEST(setOverrunPolicy)
+{
+    Spinner test;
+    CHECK_EQUAL(ram::core::Updatable::OVERRUN_REALIGN,
+                test.getOverrunPolicy());
+    test.setOverrunPolicy(ram::core::Updatable::OVERRUN_SKIP);
+    CHECK_EQUAL(ram::core::Updatable::OVERRUN_SKIP, test.getOverrunPolicy());
+}
+
+TEST(measuredTimestep)
+{
+    ram::core::TimeVal::setVirtualTime(1000);
+    VirtualStepRecorder test;
+    test.background(5);
+    while (test.backgrounded())
+        boost::thread::yield();
+    test.unbackground(true);
+    ram::core::TimeVal::clearVirtualTime();
+
+    // The clock only advances to each deadline, so every timestep handed to
+    // update is exactly the interval
+    CHECK_EQUAL(20, test.count);
+    CHECK_CLOSE(0.005 * 20, test.total, 1e-6);
+}
+
+TEST(stringToCpuSet)
+{
+    using ram::core::Updatable;
+    std::set<size_t> cpus(Updatable::stringToCpuSet("0, 2-4,7"));
+    CHECK_EQUAL(5u, cpus.size());
+    CHECK(cpus.count(0));
+    CHECK(cpus.count(3));
+    CHECK(cpus.count(7));
+    CHECK_EQUAL(0u, cpus.count(1));
+
+    cpus = Updatable::stringToCpuSet("0x1A");
+    CHECK_EQUAL(3u, cpus.size());
+    CHECK(cpus.count(1));
+    CHECK(cpus.count(3));
+    CHECK(cpus.count(4));
+
+    CHECK(Updatable::stringToCpuSet("").empty());
+}
+
+TEST(configToCpuSet)
+{
+    using ram::core::Updatable;
+    using ram::core::ConfigNode;
+    ConfigNode config(ConfigNode::fromString(
+        "{ 'list' : '0,2-3', 'mask' : '0xd', 'number' : 13 }"));
+
+    // All three name CPUs 0, 2 and 3, a bare number is a mask
+    std::set<size_t> expected;
+    expected.insert(0);
+    expected.insert(2);
+    expected.insert(3);
+    CHECK(expected == Updatable::configToCpuSet(config["list"]));
+    CHECK(expected == Updatable::configToCpuSet(config["mask"]));
+    CHECK(expected == Updatable::configToCpuSet(config["number"]));
+
+    CHECK(Updatable::configToCpuSet(config["missing"]).empty());
+}
+
+TEST(stringToRealTimePolicy)
+{
+    using ram::core::Updatable;
+    CHECK_EQUAL(Updatable::RT_FIFO, Updatable::stringToRealTimePolicy("FIFO"));
+    CHECK_EQUAL(Updatable::RT_ROUND_ROBIN,
+                Updatable::stringToRealTimePolicy("rr"));
+}
+
+TEST(setAffinityMask)
+{
+    Spinner test;
+    CHECK_EQUAL(-1, test.getAffinity());
+    if (ram::core::Updatable::getCpuCount() < 2)
+        return;
+    
+    std::set<size_t> cpus;
+    cpus.insert(1);
+    cpus.insert(0);
+    test.setAffinityMask(cpus);
+    CHECK_EQUAL(0, test.getAffinity());
+    CHECK(cpus == test.getAffinityMask());
+
+    // Make sure the background thread can apply it
+    test.background(-1);
+    test.unbackground(true);
+
+    test.setAffinityMask(std::set<size_t>());
+    CHECK_EQUAL(-1, test.getAffinity());
+}
+
 #ifdef RAM_LINUX
 TEST(getTID)
 {
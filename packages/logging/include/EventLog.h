@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/logging/include/EventLog.h
+ */
+
+#ifndef RAM_LOGGING_EVENTLOG_10_17_2010
+#define RAM_LOGGING_EVENTLOG_10_17_2010
+
+// STD Includes
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+// Library Includes
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Project Includes
+#include "core/include/Event.h"
+
+// Forward declare boost::interprocess and boost::archive classes
+namespace boost { namespace interprocess {
+class file_mapping;
+class mapped_region;
+} }
+namespace boost { namespace archive {
+class binary_oarchive;
+} }
+
+namespace ram {
+namespace logging {
+
+/** Writes events to the chunked binary event log format
+ *
+ *  The file starts with an 8 byte magic string, followed by chunks.  Each
+ *  chunk is written in one piece when full or flushed, so a crash can only
+ *  cut off the chunk being written:
+ *
+ *    Chunk header: magic, event count, data size, index size, first and last
+ *                  time stamp in the chunk
+ *    Data:         one boost binary archive of all the chunk's EventPtrs,
+ *                  using the serializers in Serialize.h.  Each event's
+ *                  class is only named the first time it shows up, so
+ *                  events are read back a whole chunk at a time
+ *    Index:        per event, (uint32 data offset, uint32 type, double time)
+ *                  followed by the table of type names used in the chunk
+ *
+ *  All values are in host byte order, like the binary archives themselves,
+ *  so logs have to be read back on the same kind of machine.
+ */
+class LogWriter : boost::noncopyable
+{
+public:
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    /** Appends to the given file, writing the file header if it is new
+     *
+     *  @param chunkSize
+     *      Bytes of event data buffered before the chunk is written out
+     */
+    LogWriter(std::string fileName, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    /** Flushes the current chunk */
+    ~LogWriter();
+
+    /** Buffers the event, writing out the chunk if it is full
+     *
+     *  @return  False if the event could not be serialized.
+     */
+    bool write(core::EventPtr event);
+
+    /** Writes the current chunk to disk, does nothing if its empty */
+    void flush();
+
+    /** Whether the file could be opened */
+    bool isOpen();
+
+private:
+    struct IndexEntry
+    {
+        boost::uint32_t offset;
+        boost::uint32_t type;
+        double timeStamp;
+    };
+
+    std::ofstream m_file;
+
+    size_t m_chunkSize;
+
+    /** Serialized records of the current chunk, and the archive writing
+     *  them, which is started by the first event of each chunk */
+    std::ostringstream m_stream;
+    boost::scoped_ptr<boost::archive::binary_oarchive> m_archive;
+
+    /** One entry per event in the current chunk */
+    std::vector<IndexEntry> m_index;
+
+    /** The events written to the current chunk */
+    std::vector<core::EventPtr> m_events;
+
+    /** Event types used in the current chunk, and their index */
+    std::vector<std::string> m_types;
+    std::map<std::string, boost::uint32_t> m_typeIds;
+};
+
+/** Reads back event logs, either the binary format or legacy text archives
+ *
+ *  Binary logs are memory mapped and only the chunk headers and indexes are
+ *  read when opened, events are deserialized a chunk at a time when asked
+ *  for.  Legacy text
+ *  archive logs have to be read in completely when opened.
+ *
+ *  On open a sparse index is built with a keyframe every KEYFRAME_INTERVAL
+ *  events.  Each keyframe holds the largest time stamp seen so far and the
+ *  latest event of every type before it, so time lookups are a binary
+ *  search plus a short scan, and the state of the log at any point can be
+ *  found without going back to the start.
+ *
+ *  Once opened, all methods are safe to call from multiple threads.
+ */
+class LogReader : boost::noncopyable
+{
+public:
+    static const size_t KEYFRAME_INTERVAL = 1024;
+
+    /** Opens the given log, check isOpen() for success */
+    LogReader(std::string fileName);
+
+    ~LogReader();
+
+    /** Whether the file could be opened and read */
+    bool isOpen();
+
+    /** True for the binary format, false for legacy text logs */
+    bool isBinary();
+
+    /** Number of events in the log */
+    size_t size();
+
+    /** Reads the event at the given position in the log
+     *
+     *  @return  The event, or an empty pointer if its part of the log is
+     *           corrupt
+     */
+    core::EventPtr readEvent(size_t index);
+
+    /** Time stamp of the event, without deserializing it */
+    double timeStamp(size_t index);
+
+    /** Type of the event, without deserializing it */
+    core::Event::EventType eventType(size_t index);
+
+    /** Index of the first event at or after the given time stamp
+     *
+     *  @return  size() if all events are before the time
+     */
+    size_t findTime(double timeStamp);
+
+    /** The latest event of each type before the given index
+     *
+     *  Replaying these events gives the state of the system just before the
+     *  event at index, without replaying the whole log up to it.
+     *
+     *  @return  Indexes of the events, in log order
+     */
+    std::vector<size_t> latestEvents(size_t index);
+
+    /** Returns true if the file starts with the binary log magic */
+    static bool isBinaryLog(std::string fileName);
+
+private:
+    typedef std::map<core::Event::EventType, size_t> TypeIndexMap;
+
+    struct Chunk
+    {
+        /** Global index of the first event in the chunk */
+        size_t firstEvent;
+        size_t eventCount;
+        /** Start of the record data in the mapped file */
+        const char* data;
+        /** Start of the index entries in the mapped file */
+        const char* index;
+        /** Event types, by the type ids in the index */
+        std::vector<core::Event::EventType> types;
+    };
+
+    struct Keyframe
+    {
+        /** Largest time stamp up to the end of this keyframe's events */
+        double maxTime;
+        /** The latest event of each type before this keyframe */
+        TypeIndexMap latest;
+    };
+
+    /** Finds the chunk holding the given event */
+    const Chunk& findChunk(size_t index, size_t& offset);
+
+    /** Reads the chunk headers and types from the mapped file */
+    bool openBinary(std::string fileName);
+
+    /** Reads every event from a text archive log */
+    bool openText(std::string fileName);
+
+    /** Deserializes every event of the chunk into m_decoded
+     *
+     *  Must hold m_decodedMutex.
+     */
+    void decodeChunk(const Chunk& chunk);
+
+    /** Builds the keyframes from the opened log */
+    void buildIndex();
+
+    /** Adds the next event in the log to the keyframes */
+    void indexEvent(size_t index, const core::Event::EventType& type,
+                    double timeStamp, TypeIndexMap& latest);
+
+    bool m_open;
+
+    boost::scoped_ptr<boost::interprocess::file_mapping> m_mapping;
+    boost::scoped_ptr<boost::interprocess::mapped_region> m_region;
+
+    /** Binary log chunks, in file order */
+    std::vector<Chunk> m_chunks;
+    size_t m_eventCount;
+
+    /** Events of the last chunk read, taken out as they are handed out */
+    boost::mutex m_decodedMutex;
+    const Chunk* m_decodedChunk;
+    std::vector<core::EventPtr> m_decoded;
+
+    /** Events at the start of the chunk which decoded, the rest are bad */
+    size_t m_decodedCount;
+
+    /** All events of a legacy text log */
+    std::vector<core::EventPtr> m_textEvents;
+
+    /** One keyframe for each KEYFRAME_INTERVAL events */
+    std::vector<Keyframe> m_keyframes;
+};
+
+} // namespace logging
+} // namespace ram
+
+#endif // RAM_LOGGING_EVENTLOG_10_17_2010
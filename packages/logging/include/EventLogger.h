@@ -11,11 +11,10 @@
 #define RAM_LOGGING_EVENTLOGGER_06_06_2009
 
 // STD Includes
-#include <fstream>
 #include <set>
 
 // Library Includes
-#include <boost/archive/text_oarchive.hpp>
+#include <boost/scoped_ptr.hpp>
 
 // Project Includes
 #include "core/include/Subsystem.h"
@@ -23,6 +22,7 @@
 #include "core/include/ConfigNode.h"
 #include "core/include/ThreadedQueue.h"
 #include "logging/include/Common.h"
+#include "logging/include/EventLog.h"
 
 namespace ram {
 namespace logging {
@@ -64,11 +64,14 @@ private:
     /** Holds queued events we are goign to log to the file */
     core::ThreadedQueue<core::EventPtr> m_eventQueue;
 
-    /** The file we are writing the data to */
-    std::ofstream m_logFile;
-    
-    /** The archive we are writing to */
-    boost::archive::text_oarchive* m_archive;
+    /** Writes the binary log file */
+    boost::scoped_ptr<LogWriter> m_writer;
+
+    /** Seconds between forced writes of a partial chunk */
+    double m_flushInterval;
+
+    /** The last time we wrote a chunk to disk */
+    double m_lastFlush;
 
     /** List of all type we cannot convert for some reason */
     std::set<std::string> m_unconvertableTypes;
@@ -11,12 +11,11 @@
 #define RAM_LOGGING_EVENTPLAYER_07_06_2009
 
 // STD Includes
-#include <fstream>
 #include <set>
 #include <vector>
 
 // Library Includes
-#include <boost/archive/text_iarchive.hpp>
+#include <boost/scoped_ptr.hpp>
 
 // Project Includes
 #include "core/include/Forward.h"
@@ -25,13 +24,27 @@
 #include "core/include/ConfigNode.h"
 #include "core/include/ReadWriteMutex.h"
 #include "logging/include/Common.h"
+#include "logging/include/EventLog.h"
 
 namespace ram {
 namespace logging {
 
 class EventPlayer;
 
-/** Plays back events from a log file at the rate the were really played */
+/** Plays back events from a log file at the rate the were really played
+ *
+ *  The playback rate can be scaled, or the player can be told to publish
+ *  events back to back as fast as the listeners can handle them.  In either
+ *  of those modes the published time stamps advance with the log, not the
+ *  wall clock, and the core::TimeVal::clockTime() virtual clock is set to
+ *  each event's time stamp as it is published.
+ *
+ *  Config values:
+ *   - fileName:         the log to play, default "event.log"
+ *   - rate:             playback speed multiplier, 0.1 to 100, default 1
+ *   - asFastAsPossible: 1 to ignore the time between events, default 0
+ *   - republishOnSeek:  see seekToTime, default 1
+ */
 class PlayerThread : public core::Updatable
 {
 public:
@@ -43,12 +56,30 @@ public:
     /** Length of the log file */
     virtual double duration();
 
-    /** Seek to a specific time in the log */
+    /** Seek to a specific time in the log
+     *
+     *  Unless "republishOnSeek" is 0 in the config, the latest event of each
+     *  type before that time is published first, so listeners see the state
+     *  at the new time straight away.
+     */
     virtual void seekToTime(double seconds);
 
     /** Get the current time in the log (in seconds since start) */
     virtual double currentTime();
 
+    /** Sets the playback speed, clamped to between MIN_RATE and MAX_RATE */
+    virtual void setRate(double rate);
+
+    virtual double getRate();
+
+    /** Publish events back to back, ignoring the time between them */
+    virtual void setAsFastAsPossible(bool fast);
+
+    virtual bool getAsFastAsPossible();
+
+    static const double MIN_RATE;
+    static const double MAX_RATE;
+
     /** Stops the current playback */
     virtual void start();
 
@@ -86,11 +117,33 @@ private:
     /** Creates all parts of the underlying logging system */
     void init(core::ConfigNode config, core::SubsystemList deps);
 
-    /** The archive we reading from */
-    boost::archive::text_iarchive* m_archive;
+    /** Republishes the event from its sender, stamped with the given time */
+    void sendEvent(core::EventPtr event, double sendTime);
+
+    /** True when time stamps should follow the wall clock */
+    bool isRealTime();
+
+    /** Seconds into the log playback has reached at the given wall time
+     *
+     *  Must hold m_mutex.
+     */
+    double playbackPosition(double now);
+
+    /** Time stamp to give an event at the given log position
+     *
+     *  Must hold m_mutex.
+     */
+    double eventTime(double position);
+
+    /** Moves the playback reference point to the given wall time, must be
+     *  done before any change to the rate or mode.  Must hold m_mutex. */
+    void rebase(double now);
 
-    /** The file we are writing the data to */
-    std::ifstream m_logFile;
+    /** Sets or clears the virtual clock for the given event time stamp */
+    void updateClock(double timeStamp);
+
+    /** Reads events from the log as they are needed */
+    boost::scoped_ptr<LogReader> m_reader;
 
     /** Protects access to the file */
     core::ReadWriteMutex m_mutex;
@@ -101,27 +154,41 @@ private:
     /** The current time we are at*/
     double m_currentTime;
 
-    /** The time at which the EventPlayer was stopped */
-    double m_stoppedTime;
+    /** Whether playback is stopped, the position does not advance */
+    bool m_stopped;
+
+    /** Playback speed multiplier */
+    double m_rate;
+
+    /** Whether to publish events without waiting between them */
+    bool m_asFastAsPossible;
+
+    /** Wall time of the playback reference point */
+    double m_playStart;
+
+    /** Position in the log (seconds since start) at the reference point */
+    double m_playPosition;
+
+    /** Event time stamp given to the reference point position */
+    double m_timeBase;
 
-    /** How much time the player has been stopped (offsets the start time) */
-    double m_stopageTime;
+    /** Whether we have set the virtual clock */
+    bool m_virtualClock;
 
     /** The duration of a set of events. (The timestamp of the last event) */
     double m_duration;
     
-    /** The length of the file we are reading */
-    int m_fileLength;
-
     /** Our event hub that is usable */
     core::EventHubPtr m_eventHub;
 
-    /** Events that we have already read from the logfile */
-    std::vector<core::EventPtr> m_pastEvents;
+    /** Index in the log of the next event to publish */
+    size_t m_presentEvent;
+
+    /** Whether to publish the latest event of each type after a seek */
+    bool m_republishOnSeek;
 
-    /** Location of the "present event" in the vector/logfile. Starting at the 
-        vector*/
-    unsigned int m_presentEvent;
+    /** Events from the last seek which still need to be published */
+    std::vector<size_t> m_seekEvents;
 
     /** EventPlayer subsystem */
     EventPlayer *m_player;
@@ -162,6 +229,16 @@ public:
     /** Seek to a specific time in the log */
     virtual void seekToTime(double seconds);
 
+    /** Sets the playback speed multiplier, see PlayerThread */
+    virtual void setRate(double rate);
+
+    virtual double getRate();
+
+    /** Publish events without waiting between them, see PlayerThread */
+    virtual void setAsFastAsPossible(bool fast);
+
+    virtual bool getAsFastAsPossible();
+
     virtual void background(int interval);
     
     virtual void unbackground(bool join = false);
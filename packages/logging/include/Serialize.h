@@ -12,9 +12,7 @@
 #define RAM_LOGGING_SERIALIZE_H_03_05_2009
 
 // STD Includes
-#include <set>
 #include <string>
-#include <typeinfo>
 
 // Library Includes
 #include <boost/serialization/serialization.hpp>
@@ -22,10 +20,13 @@
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
 
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/vector.hpp>
-#include <boost/thread/mutex.hpp>
+#include <boost/serialization/extended_type_info.hpp>
+#include <boost/serialization/type_info_implementation.hpp>
 
 // Project Includes
 #include "core/include/Feature.h"
@@ -56,38 +57,101 @@
 namespace ram {
 namespace logging {
 
-static boost::mutex writeMutex;
-static std::set<std::string> unconvertableTypes;
+/** Whether the event's concrete type was registered with BOOST_CLASS_EXPORT
+ *
+ *  This looks the type up in the table the serialization library builds
+ *  from the exports at startup, it never changes after that so no lock is
+ *  needed.
+ */
+inline bool isSerializable(const core::Event& event)
+{
+    const boost::serialization::extended_type_info* typeInfo =
+        boost::serialization::type_info_implementation<core::Event>::type
+        ::get_const_instance().get_derived_extended_type_info(event);
+    return typeInfo && typeInfo->get_key();
+}
 
+/** Prints a warning, only the first time it is called for a type */
+void reportUnserializable(const core::Event& event);
+
+/** How writeEvent handles events of a given concrete type */
+enum SerializeMode
+{
+    /** Not worked out yet */
+    SERIALIZE_UNKNOWN = 0,
+    /** Written in place */
+    SERIALIZE_DIRECT,
+    /** A clone() is written, for the Python wrapper classes which are
+     *  never exported, but clone to the C++ class they wrap */
+    SERIALIZE_CLONE,
+    /** Can't be written at all */
+    SERIALIZE_NEVER
+};
+
+/** The mode remembered for the event's concrete type
+ *
+ *  Lookups take no lock, so they are cheap enough for every event.
+ */
+SerializeMode getSerializeMode(const core::Event& event);
+
+/** Remembers the mode for the event's concrete type */
+void setSerializeMode(const core::Event& event, SerializeMode mode);
+
+/** Writes the event, through a core::EventPtr, to the given archive
+ *
+ *  Safe to call from many threads at once, each with its own archive.  The
+ *  event is written in place when its type is exported, so it must not be
+ *  changed while being written (events are never changed once published).
+ *
+ *  @return  false if the event's type can not be serialized
+ */
 template <class Archive>
 bool writeEvent(core::EventPtr event, Archive& archive)
 {
-    std::string typeName(typeid(*(event.get())).name());
-    boost::mutex::scoped_lock lock(writeMutex);
-    try
+    SerializeMode mode = getSerializeMode(*event);
+    if (SERIALIZE_UNKNOWN == mode)
     {
-        // Only attempt to convert events we now we can convert
-        bool convertable = unconvertableTypes.end() ==
-            unconvertableTypes.find(typeName);
-        if (convertable) {
+        mode = SERIALIZE_NEVER;
+        if (isSerializable(*event))
+        {
+            mode = SERIALIZE_DIRECT;
+        }
+        else
+        {
             core::EventPtr clone = event->clone();
-            archive << clone;
+            if (clone && isSerializable(*clone))
+                mode = SERIALIZE_CLONE;
         }
-        return convertable;
+
+        setSerializeMode(*event, mode);
+        if (SERIALIZE_NEVER == mode)
+            reportUnserializable(*event);
+    }
+
+    if (SERIALIZE_NEVER == mode)
+        return false;
+
+    try
+    {
+        core::EventPtr toWrite(event);
+        if (SERIALIZE_CLONE == mode)
+            toWrite = event->clone();
+
+        const core::EventPtr& constEvent = toWrite;
+        archive << constEvent;
+        return true;
     }
     catch (boost::archive::archive_exception ex)
     {
+        // Exported, but not for this kind of archive, only let this happen
+        // once for each type
         if (ex.code == boost::archive::archive_exception::unregistered_class)
         {
-            std::cerr << "Could not convert: " << typeName << event->type
-                      << std::endl;
-            unconvertableTypes.insert(typeName);
-        }
-        else
-        {
-            throw ex;
+            setSerializeMode(*event, SERIALIZE_NEVER);
+            reportUnserializable(*event);
+            return false;
         }
-        return false;
+        throw ex;
     }
 }
 
@@ -160,6 +224,23 @@ void serialize(Archive &ar, ram::core::IntEvent& t,
     ar & t.data;
 }
 
+template <class Archive>
+void serialize(Archive &ar, ram::core::UpdateTimingEvent& t,
+               const unsigned int file_version)
+{
+    ar & boost::serialization::base_object<ram::core::Event>(t);
+    ar & t.updates;
+    ar & t.overruns;
+    ar & t.minPeriod;
+    ar & t.meanPeriod;
+    ar & t.maxPeriod;
+    ar & t.p99Period;
+    ar & t.jitter;
+    ar & t.minExecTime;
+    ar & t.meanExecTime;
+    ar & t.maxExecTime;
+}
+
 
 // ------------------------------------------------------------------------- //
 //                           M A T H   E V E N T S                           //
@@ -409,6 +490,37 @@ void serialize(Archive &ar, ram::vision::HedgeEvent &t,
     ar & t.haveRight;
 }
 
+template <class Archive>
+void serialize(Archive &ar, ram::vision::DetectorTimingEvent &t,
+               const unsigned int file_version)
+{
+    ar & boost::serialization::base_object<ram::core::Event>(t);
+    ar & t.detector;
+    ar & t.frames;
+    ar & t.droppedFrames;
+    ar & t.minTime;
+    ar & t.meanTime;
+    ar & t.maxTime;
+}
+
+BOOST_SERIALIZATION_SHARED_PTR(ram::vision::DetectorTimingEvent)
+
+template <class Archive>
+void serialize(Archive &ar, ram::vision::RecorderWriteEvent &t,
+               const unsigned int file_version)
+{
+    ar & boost::serialization::base_object<ram::core::Event>(t);
+    ar & t.queueDepth;
+    ar & t.peakQueueDepth;
+    ar & t.bytesPerSecond;
+    ar & t.writesPerSecond;
+    ar & t.writeTime;
+    ar & t.droppedFrames;
+    ar & t.blockedTime;
+}
+
+BOOST_SERIALIZATION_SHARED_PTR(ram::vision::RecorderWriteEvent)
+
 #endif // RAM_WITH_VISION
 
 // ------------------------------------------------------------------------- //
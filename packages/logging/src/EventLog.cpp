@@ -0,0 +1,558 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/logging/src/EventLog.cpp
+ */
+
+// STD Includes
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <algorithm>
+
+// Library Includes
+#include <boost/foreach.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+// Project Includes
+#include "logging/include/EventLog.h"
+#include "logging/include/Serialize.h"
+
+namespace ram {
+namespace logging {
+
+namespace bi = boost::interprocess;
+
+static const char FILE_MAGIC[] = "RAMELOG1";
+static const size_t FILE_MAGIC_SIZE = 8;
+static const char CHUNK_MAGIC[] = "RCHK";
+static const size_t CHUNK_MAGIC_SIZE = 4;
+
+// magic, event count, data size, index size, first time, last time
+static const size_t CHUNK_HEADER_SIZE = CHUNK_MAGIC_SIZE + 3 * 4 + 2 * 8;
+
+// offset, type, time stamp
+static const size_t INDEX_ENTRY_SIZE = 4 + 4 + 8;
+
+static const int ARCHIVE_FLAGS =
+    boost::archive::no_header | boost::archive::no_tracking;
+
+template<typename T>
+static void appendValue(std::string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static T readValue(const char* buffer)
+{
+    T value;
+    std::memcpy(&value, buffer, sizeof(T));
+    return value;
+}
+
+/** Lets a boost archive read straight out of the mapped file */
+class MemoryBuffer : public std::streambuf
+{
+public:
+    MemoryBuffer(const char* data, size_t size)
+    {
+        char* start = const_cast<char*>(data);
+        setg(start, start, start + size);
+    }
+};
+
+static size_t fileSize(std::string fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return 0;
+    file.seekg(0, std::ios::end);
+    return (size_t)file.tellg();
+}
+
+// ------------------------------------------------------------------------- //
+//                            L O G   W R I T E R                            //
+// ------------------------------------------------------------------------- //
+
+LogWriter::LogWriter(std::string fileName, size_t chunkSize) :
+    m_chunkSize(chunkSize)
+{
+    // Never append binary chunks to the end of an old text log
+    if (fileSize(fileName) > 0 && !LogReader::isBinaryLog(fileName))
+    {
+        std::cerr << "WARNING: " << fileName << " is not a binary event log, "
+                  << "writing to " << fileName << ".bin" << std::endl;
+        fileName += ".bin";
+    }
+
+    m_file.open(fileName.c_str(),
+                std::ios::out | std::ios::app | std::ios::binary);
+
+    if (m_file.is_open() && (0 == fileSize(fileName)))
+    {
+        m_file.write(FILE_MAGIC, FILE_MAGIC_SIZE);
+        m_file.flush();
+    }
+
+}
+
+LogWriter::~LogWriter()
+{
+    flush();
+    m_file.close();
+}
+
+bool LogWriter::write(core::EventPtr event)
+{
+    // One archive for the whole chunk, so the class of each event is only
+    // written out the first time it shows up
+    if (!m_archive)
+    {
+        m_archive.reset(
+            new boost::archive::binary_oarchive(m_stream, ARCHIVE_FLAGS));
+    }
+
+    boost::uint32_t offset = (boost::uint32_t)m_stream.tellp();
+    if (!writeEvent(event, *m_archive))
+    {
+        // The archive may have been left part way through the record, so
+        // start the next one fresh
+        flush();
+        return false;
+    }
+
+    // Look up the type
+    std::map<std::string, boost::uint32_t>::iterator iter =
+        m_typeIds.find(event->type);
+    if (m_typeIds.end() == iter)
+    {
+        boost::uint32_t typeId = (boost::uint32_t)m_types.size();
+        m_types.push_back(event->type);
+        iter = m_typeIds.insert(std::make_pair(event->type, typeId)).first;
+    }
+
+    // The archive tracks pointers by address, so keep the event alive until
+    // the chunk is done, or a later event at the same address would be
+    // written as a reference to this one
+    m_events.push_back(event);
+
+    IndexEntry entry;
+    entry.offset = offset;
+    entry.type = iter->second;
+    entry.timeStamp = event->timeStamp;
+    m_index.push_back(entry);
+
+    if ((size_t)m_stream.tellp() >= m_chunkSize)
+        flush();
+    return true;
+}
+
+void LogWriter::flush()
+{
+    std::string data(m_stream.str());
+    m_archive.reset();
+    m_stream.str("");
+
+    if (m_index.empty())
+        return;
+
+    // Build the index, entries first so they can be found by position
+    std::string index;
+    index.reserve(m_index.size() * INDEX_ENTRY_SIZE);
+    double firstTime = m_index.front().timeStamp;
+    double lastTime = firstTime;
+    BOOST_FOREACH(IndexEntry& entry, m_index)
+    {
+        appendValue(index, entry.offset);
+        appendValue(index, entry.type);
+        appendValue(index, entry.timeStamp);
+        firstTime = std::min(firstTime, entry.timeStamp);
+        lastTime = std::max(lastTime, entry.timeStamp);
+    }
+    appendValue(index, (boost::uint32_t)m_types.size());
+    BOOST_FOREACH(std::string& type, m_types)
+    {
+        appendValue(index, (boost::uint32_t)type.size());
+        index.append(type);
+    }
+
+    std::string header(CHUNK_MAGIC, CHUNK_MAGIC_SIZE);
+    appendValue(header, (boost::uint32_t)m_index.size());
+    appendValue(header, (boost::uint32_t)data.size());
+    appendValue(header, (boost::uint32_t)index.size());
+    appendValue(header, firstTime);
+    appendValue(header, lastTime);
+
+    m_file.write(header.data(), header.size());
+    m_file.write(data.data(), data.size());
+    m_file.write(index.data(), index.size());
+    m_file.flush();
+
+    m_index.clear();
+    m_events.clear();
+    m_types.clear();
+    m_typeIds.clear();
+}
+
+bool LogWriter::isOpen()
+{
+    return m_file.is_open();
+}
+
+// ------------------------------------------------------------------------- //
+//                            L O G   R E A D E R                            //
+// ------------------------------------------------------------------------- //
+
+LogReader::LogReader(std::string fileName) :
+    m_open(false),
+    m_eventCount(0),
+    m_decodedChunk(0),
+    m_decodedCount(0)
+{
+    if (isBinaryLog(fileName))
+        m_open = openBinary(fileName);
+    else
+        m_open = openText(fileName);
+
+    if (m_open)
+        buildIndex();
+}
+
+LogReader::~LogReader()
+{
+}
+
+bool LogReader::isOpen()
+{
+    return m_open;
+}
+
+bool LogReader::isBinary()
+{
+    return m_region.get() != 0;
+}
+
+size_t LogReader::size()
+{
+    if (isBinary())
+        return m_eventCount;
+    return m_textEvents.size();
+}
+
+core::EventPtr LogReader::readEvent(size_t index)
+{
+    assert(index < size() && "Event index out of range");
+    if (!isBinary())
+        return m_textEvents[index]->clone();
+
+    size_t offset = 0;
+    const Chunk& chunk = findChunk(index, offset);
+
+    // Each event is only handed out once, so it is never shared between
+    // callers, and the chunk is decoded again if it is asked for twice
+    boost::mutex::scoped_lock lock(m_decodedMutex);
+    if ((m_decodedChunk != &chunk) ||
+        ((offset < m_decodedCount) && !m_decoded[offset]))
+    {
+        decodeChunk(chunk);
+    }
+
+    // Past the point where the chunk is corrupt
+    core::EventPtr event;
+    if (offset >= m_decodedCount)
+        return event;
+    event.swap(m_decoded[offset]);
+
+    // The same event logged twice comes back as one object
+    if (!event.unique())
+        event = event->clone();
+    return event;
+}
+
+double LogReader::timeStamp(size_t index)
+{
+    assert(index < size() && "Event index out of range");
+    if (!isBinary())
+        return m_textEvents[index]->timeStamp;
+
+    size_t offset = 0;
+    const Chunk& chunk = findChunk(index, offset);
+    return readValue<double>(chunk.index + offset * INDEX_ENTRY_SIZE + 8);
+}
+
+core::Event::EventType LogReader::eventType(size_t index)
+{
+    assert(index < size() && "Event index out of range");
+    if (!isBinary())
+        return m_textEvents[index]->type;
+
+    size_t offset = 0;
+    const Chunk& chunk = findChunk(index, offset);
+    boost::uint32_t type = readValue<boost::uint32_t>(
+        chunk.index + offset * INDEX_ENTRY_SIZE + 4);
+    return chunk.types[type];
+}
+
+size_t LogReader::findTime(double time)
+{
+    // Binary search for the first keyframe which reaches the time, the
+    // keyframe times are a running maximum so they are sorted
+    size_t low = 0;
+    size_t high = m_keyframes.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_keyframes[middle].maxTime < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    // Then scan the events of that keyframe
+    size_t end = std::min((low + 1) * KEYFRAME_INTERVAL, size());
+    for (size_t i = low * KEYFRAME_INTERVAL; i < end; ++i)
+    {
+        if (timeStamp(i) >= time)
+            return i;
+    }
+    return size();
+}
+
+std::vector<size_t> LogReader::latestEvents(size_t index)
+{
+    std::vector<size_t> events;
+    index = std::min(index, size());
+    if (0 == index)
+        return events;
+
+    // Start from the keyframe and catch up to the index
+    size_t keyframe = std::min(index / KEYFRAME_INTERVAL,
+                               m_keyframes.size() - 1);
+    TypeIndexMap latest(m_keyframes[keyframe].latest);
+    for (size_t i = keyframe * KEYFRAME_INTERVAL; i < index; ++i)
+        latest[eventType(i)] = i;
+
+    BOOST_FOREACH(TypeIndexMap::value_type& entry, latest)
+        events.push_back(entry.second);
+    std::sort(events.begin(), events.end());
+    return events;
+}
+
+bool LogReader::isBinaryLog(std::string fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    char magic[FILE_MAGIC_SIZE];
+    file.read(magic, FILE_MAGIC_SIZE);
+    return file.good() &&
+        (0 == std::memcmp(magic, FILE_MAGIC, FILE_MAGIC_SIZE));
+}
+
+const LogReader::Chunk& LogReader::findChunk(size_t index, size_t& offset)
+{
+    // Last chunk whose first event is at or before the index
+    size_t low = 0;
+    size_t high = m_chunks.size();
+    while (high - low > 1)
+    {
+        size_t middle = (low + high) / 2;
+        if (m_chunks[middle].firstEvent <= index)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    offset = index - m_chunks[low].firstEvent;
+    return m_chunks[low];
+}
+
+void LogReader::decodeChunk(const Chunk& chunk)
+{
+    m_decodedChunk = &chunk;
+    m_decoded.assign(chunk.eventCount, core::EventPtr());
+    m_decodedCount = 0;
+    try
+    {
+        MemoryBuffer buffer(chunk.data, chunk.index - chunk.data);
+        std::istream stream(&buffer);
+        boost::archive::binary_iarchive archive(stream, ARCHIVE_FLAGS);
+        for (size_t i = 0; i < chunk.eventCount; ++i)
+        {
+            archive >> m_decoded[i];
+            if (!m_decoded[i])
+                break;
+            m_decodedCount++;
+        }
+    }
+    catch (std::exception& ex)
+    {
+        // A corrupt length can also show up as bad_alloc or length_error
+        // Everything before the bad record is still good
+        std::cerr << "ERROR: Could not read the chunk starting at event "
+                  << chunk.firstEvent << ": " << ex.what() << std::endl;
+    }
+}
+
+bool LogReader::openBinary(std::string fileName)
+{
+    try
+    {
+        m_mapping.reset(new bi::file_mapping(fileName.c_str(), bi::read_only));
+        m_region.reset(new bi::mapped_region(*m_mapping, bi::read_only));
+    }
+    catch (bi::interprocess_exception& ex)
+    {
+        std::cerr << "ERROR: Could not map " << fileName << ": " << ex.what()
+                  << std::endl;
+        m_region.reset();
+        m_mapping.reset();
+        return false;
+    }
+
+    const char* start = static_cast<const char*>(m_region->get_address());
+    const char* end = start + m_region->get_size();
+    const char* pos = start + FILE_MAGIC_SIZE;
+
+    while (pos + CHUNK_HEADER_SIZE <= end)
+    {
+        if (0 != std::memcmp(pos, CHUNK_MAGIC, CHUNK_MAGIC_SIZE))
+        {
+            std::cerr << "ERROR: Corrupt chunk at " << (pos - start)
+                      << " in " << fileName << std::endl;
+            break;
+        }
+
+        const char* field = pos + CHUNK_MAGIC_SIZE;
+        boost::uint32_t eventCount = readValue<boost::uint32_t>(field);
+        boost::uint32_t dataSize = readValue<boost::uint32_t>(field + 4);
+        boost::uint32_t indexSize = readValue<boost::uint32_t>(field + 8);
+
+        // The last chunk may have been cut off by a crash
+        const char* data = pos + CHUNK_HEADER_SIZE;
+        const char* index = data + dataSize;
+        const char* next = index + indexSize;
+        if ((next > end) || (next < data) ||
+            ((size_t)eventCount * INDEX_ENTRY_SIZE + 4 > indexSize))
+        {
+            std::cerr << "WARNING: Truncated chunk at " << (pos - start)
+                      << " in " << fileName << std::endl;
+            break;
+        }
+
+        Chunk chunk;
+        chunk.firstEvent = m_eventCount;
+        chunk.eventCount = eventCount;
+        chunk.data = data;
+        chunk.index = index;
+
+        // Read in the type table
+        const char* types = index + eventCount * INDEX_ENTRY_SIZE;
+        boost::uint32_t typeCount = readValue<boost::uint32_t>(types);
+        types += 4;
+        for (boost::uint32_t i = 0; (i < typeCount) && (types + 4 <= next);
+             ++i)
+        {
+            boost::uint32_t length = readValue<boost::uint32_t>(types);
+            types += 4;
+            chunk.types.push_back(
+                std::string(types, std::min(types + length, next)));
+            types += length;
+        }
+
+        if (eventCount)
+        {
+            m_chunks.push_back(chunk);
+            m_eventCount += eventCount;
+        }
+        pos = next;
+    }
+
+    return true;
+}
+
+bool LogReader::openText(std::string fileName)
+{
+    std::ifstream file(fileName.c_str());
+    if (!file.is_open())
+        return false;
+
+    // Get length of file
+    file.seekg(0, std::ios::end);
+    std::streamoff fileLength = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (0 == fileLength)
+        return true;
+
+    try
+    {
+        boost::archive::text_iarchive archive(file);
+        // The archive ends with a newline, so skip it before checking for
+        // the end of the file
+        while (!(file >> std::ws).eof())
+        {
+            core::EventPtr event;
+            archive >> event;
+            m_textEvents.push_back(event);
+        }
+    }
+    catch (boost::archive::archive_exception& ex)
+    {
+        std::cerr << "ERROR: Could not read " << fileName << ": "
+                  << ex.what() << std::endl;
+    }
+
+    return true;
+}
+
+void LogReader::buildIndex()
+{
+    TypeIndexMap latest;
+    if (isBinary())
+    {
+        // Walk the chunk indexes directly instead of a lookup per event
+        BOOST_FOREACH(const Chunk& chunk, m_chunks)
+        {
+            for (size_t i = 0; i < chunk.eventCount; ++i)
+            {
+                const char* entry = chunk.index + i * INDEX_ENTRY_SIZE;
+                boost::uint32_t type = readValue<boost::uint32_t>(entry + 4);
+                indexEvent(chunk.firstEvent + i, chunk.types[type],
+                           readValue<double>(entry + 8), latest);
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < m_textEvents.size(); ++i)
+        {
+            indexEvent(i, m_textEvents[i]->type, m_textEvents[i]->timeStamp,
+                       latest);
+        }
+    }
+}
+
+void LogReader::indexEvent(size_t index, const core::Event::EventType& type,
+                           double timeStamp, TypeIndexMap& latest)
+{
+    if (0 == (index % KEYFRAME_INTERVAL))
+    {
+        Keyframe keyframe;
+        keyframe.maxTime = m_keyframes.empty() ? timeStamp :
+            m_keyframes.back().maxTime;
+        keyframe.latest = latest;
+        m_keyframes.push_back(keyframe);
+    }
+
+    Keyframe& keyframe = m_keyframes.back();
+    keyframe.maxTime = std::max(keyframe.maxTime, timeStamp);
+    latest[type] = index;
+}
+
+} // namespace logging
+} // namespace ram
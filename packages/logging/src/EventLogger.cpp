@@ -13,9 +13,12 @@
 
 // STD Includes
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 // Library Includes
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 
 // Project Includes
 #include "logging/include/EventLogger.h"
@@ -26,6 +29,7 @@
 #include "core/include/Logging.h"
 #include "core/include/EventHub.h"
 #include "core/include/Events.h"
+#include "core/include/TimeVal.h"
 
 // Register controller in subsystem maker system
 RAM_CORE_REGISTER_SUBSYSTEM_MAKER(ram::logging::EventLogger, EventLogger);
@@ -35,14 +39,16 @@ namespace logging {
 
 EventLogger::EventLogger(core::ConfigNode config) :
     Subsystem(config["name"].asString("EventLogger")),
-    m_archive(0)//m_logFile)
+    m_flushInterval(1.0),
+    m_lastFlush(0)
 {
     init(config, core::SubsystemList());
 }
     
 EventLogger::EventLogger(core::ConfigNode config, core::SubsystemList deps) :
     Subsystem(config["name"].asString("EventLogger"), deps),
-    m_archive(0)//m_logFile)
+    m_flushInterval(1.0),
+    m_lastFlush(0)
 {
     init(config, deps);
 }
@@ -53,22 +59,32 @@ EventLogger::~EventLogger()
     m_connection->disconnect();
 
     // Flush the log to disk
-    core::EventPtr event;
-    while(m_eventQueue.popNoWait(event))
-        writeEvent(event, *m_archive);
+    update(0);
 
-    // Close the log file
-    m_logFile.close();
-    delete m_archive;
+    // Writes the last partial chunk and closes the file
+    m_writer.reset();
 }
 
 void EventLogger::update(double)
 {
-    // Read off events and write them to disk
-    core::EventPtr event;
+    // Read off events in batches and write them to disk
+    std::vector<core::EventPtr> events;
     
-    while(m_eventQueue.popNoWait(event))
-        writeEvent(event, *m_archive);
+    while(m_eventQueue.popAll(events))
+    {
+        BOOST_FOREACH(core::EventPtr& event, events)
+            m_writer->write(event);
+        events.clear();
+    }
+
+    // Full chunks are written as they fill, make sure slow trickles of
+    // events still reach the disk
+    double now = core::TimeVal::timeOfDay().get_double();
+    if ((now - m_lastFlush) >= m_flushInterval)
+    {
+        m_writer->flush();
+        m_lastFlush = now;
+    }
 }
 
 void EventLogger::setPriority(core::IUpdatable::Priority priority)
@@ -111,13 +127,14 @@ void EventLogger::init(core::ConfigNode config, core::SubsystemList deps)
     // Open our log file
     std::string fileName = config["fileName"].asString("event.log");
     std::string filePath = (core::Logging::getLogDir() / fileName).string();
-    m_logFile.open(filePath.c_str(), 
-                   std::ios::out | std::ios::app | std::ios::binary);
-
-
-    // Create our archive
-    m_archive = new boost::archive::text_oarchive(m_logFile,
-                                                  boost::archive::no_tracking);
+    m_writer.reset(new LogWriter(filePath, (size_t)std::max(1,
+        config["chunkSize"].asInt((int)LogWriter::DEFAULT_CHUNK_SIZE))));
+    m_flushInterval = config["flushInterval"].asDouble(1.0);
+
+    // Optionally use a bounded lock free queue, must be before we subscribe
+    m_eventQueue.setBounded(config["queueSize"].asInt(0),
+        core::RingQueueBase::policyFromString(
+            config["queueOverflow"].asString("block")));
 
     // Get our subsystem
     core::EventHubPtr eventHub =
@@ -15,9 +15,11 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 
 // Library Includes
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 
 // Project Includes
 #include "logging/include/EventPlayer.h"
@@ -83,6 +85,26 @@ void EventPlayer::seekToTime(double seconds)
     m_playerThread->seekToTime(seconds);
 }
 
+void EventPlayer::setRate(double rate)
+{
+    m_playerThread->setRate(rate);
+}
+
+double EventPlayer::getRate()
+{
+    return m_playerThread->getRate();
+}
+
+void EventPlayer::setAsFastAsPossible(bool fast)
+{
+    m_playerThread->setAsFastAsPossible(fast);
+}
+
+bool EventPlayer::getAsFastAsPossible()
+{
+    return m_playerThread->getAsFastAsPossible();
+}
+
 void EventPlayer::background(int interval)
 {
 
@@ -143,15 +165,22 @@ void EventPlayer::publishUpdate()
 }
     
 
+const double PlayerThread::MIN_RATE = 0.1;
+const double PlayerThread::MAX_RATE = 100;
+
 PlayerThread::PlayerThread(core::ConfigNode config, EventPlayer *player) :
     m_startTime(core::TimeVal::timeOfDay().get_double()),
-    m_archive(0), //m_logFile)
     m_firstEventTime(-1),
     m_currentTime(-1),
-    m_stoppedTime(-1),
-    m_stopageTime(0),
-    m_fileLength(-1),
-    m_presentEvent(0)
+    m_stopped(false),
+    m_rate(1),
+    m_asFastAsPossible(false),
+    m_playStart(m_startTime),
+    m_playPosition(0),
+    m_timeBase(m_startTime),
+    m_virtualClock(false),
+    m_presentEvent(0),
+    m_republishOnSeek(true)
 {
     m_player = player;
     init(config, core::SubsystemList());
@@ -159,13 +188,17 @@ PlayerThread::PlayerThread(core::ConfigNode config, EventPlayer *player) :
     
 PlayerThread::PlayerThread(core::ConfigNode config, core::SubsystemList deps, EventPlayer *player) :
     m_startTime(core::TimeVal::timeOfDay().get_double()),
-    m_archive(0), //m_logFile)
     m_firstEventTime(-1),
     m_currentTime(-1),
-    m_stoppedTime(-1),
-    m_stopageTime(0),
-    m_fileLength(-1),
-    m_presentEvent(0)
+    m_stopped(false),
+    m_rate(1),
+    m_asFastAsPossible(false),
+    m_playStart(m_startTime),
+    m_playPosition(0),
+    m_timeBase(m_startTime),
+    m_virtualClock(false),
+    m_presentEvent(0),
+    m_republishOnSeek(true)
 {
     m_player = player;
     init(config, deps);
@@ -173,8 +206,8 @@ PlayerThread::PlayerThread(core::ConfigNode config, core::SubsystemList deps, Ev
 
 PlayerThread::~PlayerThread()
 {
-    // Close the log file
-    m_logFile.close();
+    if (m_virtualClock)
+        core::TimeVal::clearVirtualTime();
 }
 
 double PlayerThread::duration()
@@ -184,16 +217,19 @@ double PlayerThread::duration()
 
 void PlayerThread::seekToTime(double seconds)
 {
+    // The reader is thread safe, so do the lookups before taking the lock
+    size_t presentEvent = m_reader->findTime(m_firstEventTime + seconds);
+    std::vector<size_t> seekEvents;
+    if (m_republishOnSeek)
+        seekEvents = m_reader->latestEvents(presentEvent);
+
     {
         core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
-        m_stopageTime += m_currentTime - seconds;
+        rebase(getTimeOfDay());
+        m_playPosition = seconds;
         m_currentTime = seconds;
-        for(int i=0; i < (int) m_pastEvents.size(); i++){
-            if((m_pastEvents.at(i)->timeStamp) >= seconds){
-                m_presentEvent = i;
-                return;
-            }
-        }
+        m_presentEvent = presentEvent;
+        m_seekEvents.swap(seekEvents);
     }
 }
 
@@ -203,34 +239,70 @@ double PlayerThread::currentTime()
     return m_currentTime;
 }
 
+void PlayerThread::setRate(double rate)
+{
+    core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+    double now = getTimeOfDay();
+    rebase(now);
+    m_rate = std::min(MAX_RATE, std::max(MIN_RATE, rate));
+
+    // Back to wall clock time stamps
+    if (isRealTime())
+        m_timeBase = now;
+}
+
+double PlayerThread::getRate()
+{
+    core::ReadWriteMutex::ScopedReadLock lock(m_mutex);
+    return m_rate;
+}
+
+void PlayerThread::setAsFastAsPossible(bool fast)
+{
+    core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+    double now = getTimeOfDay();
+    rebase(now);
+    m_asFastAsPossible = fast;
+
+    // Back to wall clock time stamps
+    if (isRealTime())
+        m_timeBase = now;
+}
+
+bool PlayerThread::getAsFastAsPossible()
+{
+    core::ReadWriteMutex::ScopedReadLock lock(m_mutex);
+    return m_asFastAsPossible;
+}
+
 void PlayerThread::start()
 {
     {
-        // Determine how much time we have been stopped
-        core::ReadWriteMutex::ScopedReadLock lock(m_mutex);
-        if(m_stoppedTime != -1) {
-            double timeStopped = getTimeOfDay() - m_stoppedTime;
-        
-            // Add that to our stopage time so playback still works
-            m_stopageTime += timeStopped;
+        // Pick up playback from where we stopped
+        core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+        if (m_stopped)
+        {
+            rebase(getTimeOfDay());
+            m_stopped = false;
         }
-
-        // Now start backup the background thread
-        background(-1);
     }
 
+    // Now start backup the background thread
+    background(-1);
+
     m_player->publishStart();
 }
 
 void PlayerThread::stop()
 {
     // Stop the background thread
-    unbackground(true);;
+    unbackground(true);
 
-    // Record when stopped playback
+    // Freeze playback where it is
     {
-        core::ReadWriteMutex::ScopedReadLock lock(m_mutex);
-        m_stoppedTime = getTimeOfDay();
+        core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+        rebase(getTimeOfDay());
+        m_stopped = true;
     }
 
     m_player->publishStop();
@@ -239,44 +311,89 @@ void PlayerThread::stop()
     
 void PlayerThread::update(double)
 {
-    // If the "current event" is in the pastEvents vector
-    if(m_pastEvents.size() > m_presentEvent){
+    size_t presentEvent = 0;
+    double seekTime = 0;
+    std::vector<size_t> seekEvents;
+    {
+        core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+        presentEvent = m_presentEvent;
+        seekEvents.swap(m_seekEvents);
+        seekTime = eventTime(playbackPosition(getTimeOfDay()));
+    }
 
-        ram::core::EventPtr event = m_pastEvents.at(m_presentEvent);
+    // Catch up on the state at the point we just seeked to
+    if (!seekEvents.empty())
+    {
+        updateClock(seekTime);
+        BOOST_FOREACH(size_t index, seekEvents)
+        {
+            core::EventPtr event = m_reader->readEvent(index);
+            if (event)
+                sendEvent(event, seekTime);
+        }
+        m_player->publishUpdate();
+        return;
+    }
+
+    // If there are events left in the log
+    if(m_reader->size() > presentEvent){
+
+        ram::core::EventPtr event = m_reader->readEvent(presentEvent);
+        if (!event)
+        {
+            // Skip events we can't read
+            core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+            if (m_presentEvent == presentEvent)
+                m_presentEvent++;
+            return;
+        }
 
         // Grab essentially the place we are in the log file
-        double delta = event->timeStamp;
-        m_currentTime = delta;
-        double sendTime = m_startTime + delta + m_stopageTime;
+        double delta = event->timeStamp - m_firstEventTime;
 
         // If in the "past" send the event, other wise sleep until it must
-        // be sent out
-        double now = getTimeOfDay();
-        now -= m_stopageTime;
-        while (now < (m_currentTime + m_startTime))
+        // be sent out.  Sleep in short steps so rate changes take effect.
+        while (true)
         {
-            // Compute the time needed to sleep in seconds
-            double sleepTime = m_currentTime + m_startTime - now;
+            double sleepTime = 0;
+            {
+                core::ReadWriteMutex::ScopedReadLock lock(m_mutex);
+                if ((m_presentEvent != presentEvent) || m_stopped)
+                    return;
+                if (m_asFastAsPossible)
+                    break;
+
+                double now = getTimeOfDay();
+                double sendAt = m_playStart + (delta - m_playPosition) / m_rate;
+                if (now >= sendAt)
+                    break;
+                sleepTime = std::min(sendAt - now, 0.1);
+            }
             eventSleep(sleepTime);
-            now = getTimeOfDay() - m_stopageTime;
-        }
-        
-        // Clone the event to send
-        core::EventPtr eventToSend(event->clone());
-        eventToSend->timeStamp = sendTime;
-            
-        if (eventToSend->sender)
-        {
-            // Republish the event with the events sender
-            eventToSend->sender->publish(eventToSend->type, eventToSend);
         }
-        else
+
+        double sendTime = 0;
         {
-            // Republish just to the event hub
-            m_eventHub->publish(eventToSend);
+            // Drop the event if we were seeked while waiting for it
+            core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
+            if (m_presentEvent != presentEvent)
+                return;
+            m_presentEvent++;
+            m_currentTime = delta;
+            sendTime = eventTime(delta);
+
+            // Playback only moves as fast as we publish
+            if (m_asFastAsPossible)
+            {
+                m_playStart = getTimeOfDay();
+                m_playPosition = delta;
+                m_timeBase = sendTime;
+            }
         }
+
+        updateClock(sendTime);
+        sendEvent(event, sendTime);
         m_player->publishUpdate();
-        m_presentEvent++;
     }
 }
 
@@ -327,53 +444,93 @@ void PlayerThread::eventSleep(double seconds)
 }
 
 
+void PlayerThread::sendEvent(core::EventPtr event, double sendTime)
+{
+    // The reader gives us a fresh event, so we can send it as is
+    event->timeStamp = sendTime;
+
+    if (event->sender)
+    {
+        // Republish the event with the events sender
+        event->sender->publish(event->type, event);
+    }
+    else
+    {
+        // Republish just to the event hub
+        m_eventHub->publish(event);
+    }
+}
+
+bool PlayerThread::isRealTime()
+{
+    return (1.0 == m_rate) && !m_asFastAsPossible;
+}
+
+double PlayerThread::playbackPosition(double now)
+{
+    if (m_stopped || m_asFastAsPossible)
+        return m_playPosition;
+    return m_playPosition + (now - m_playStart) * m_rate;
+}
+
+double PlayerThread::eventTime(double position)
+{
+    return m_timeBase + (position - m_playPosition);
+}
+
+void PlayerThread::rebase(double now)
+{
+    double position = playbackPosition(now);
+    if (isRealTime())
+        m_timeBase = now;
+    else
+        m_timeBase = eventTime(position);
+    m_playPosition = position;
+    m_playStart = now;
+}
+
+void PlayerThread::updateClock(double timeStamp)
+{
+    bool realTime = false;
+    {
+        core::ReadWriteMutex::ScopedReadLock lock(m_mutex);
+        realTime = isRealTime();
+    }
+
+    if (!realTime)
+    {
+        core::TimeVal::setVirtualTime(timeStamp);
+        m_virtualClock = true;
+    }
+    else if (m_virtualClock)
+    {
+        core::TimeVal::clearVirtualTime();
+        m_virtualClock = false;
+    }
+}
+
 void PlayerThread::init(core::ConfigNode config, core::SubsystemList deps)
 {
-    // Open our log file
+    // Open our log file, only the index is read in now
     std::string fileName = config["fileName"].asString("event.log");
-    m_logFile.open(fileName.c_str());
-
-    assert(m_logFile.is_open() && "Could not open log file");
-    
-    // Get length of file:  
-    m_logFile.seekg (0, std::ios::end);
-    m_fileLength = m_logFile.tellg();
-    m_logFile.seekg (0, std::ios::beg);
+    m_reader.reset(new LogReader(fileName));
+    m_republishOnSeek = config["republishOnSeek"].asInt(1) != 0;
+    m_rate = std::min(MAX_RATE, std::max(MIN_RATE,
+                                         config["rate"].asDouble(1.0)));
+    m_asFastAsPossible = config["asFastAsPossible"].asInt(0) != 0;
 
-    // Create our archive
-    m_archive = new boost::archive::text_iarchive(m_logFile);
+    assert(m_reader->isOpen() && "Could not open log file");
     
     // Get our subsystem
     m_eventHub = core::Subsystem::getSubsystemOfType<core::EventHub>(deps);
 
-    // Add all of the events in the file to a Vector
-    while(m_logFile.tellg() < m_fileLength) {
-        ram::core::EventPtr event = ram::core::EventPtr();
-        double sendTime = 0;
-        {
-            core::ReadWriteMutex::ScopedWriteLock lock(m_mutex);
-            
-            // Grab event from the log
-            (*m_archive) >> event;
-
-            // Grab our first event time if needed
-            if (-1 == m_firstEventTime)
-            {
-                m_firstEventTime = event->timeStamp;
-            }
-            // Grab essentially the place we are in the log file
-            double delta = event->timeStamp - m_firstEventTime;
-            //sendTime = m_startTime + delta;
-            sendTime = delta;
-        }
-        core::EventPtr eventToAdd(event->clone());
-        eventToAdd->timeStamp = sendTime;
-        m_pastEvents.push_back(eventToAdd);
-    }
-    // If there are events in the file, duration is last timstamp
+    // Times are relative to the first event, duration is the last one
     m_duration = 0;
-    if(m_pastEvents.size()){
-        m_duration = m_pastEvents.at(m_pastEvents.size() - 1)->timeStamp;
+    size_t eventCount = m_reader->size();
+    if (eventCount)
+    {
+        m_firstEventTime = m_reader->timeStamp(0);
+        m_duration = m_reader->timeStamp(eventCount - 1) - m_firstEventTime;
     }
     m_player->publishSetup();
 }
@@ -1,14 +1,25 @@
 
+// STD Includes
+#include <iostream>
+#include <set>
+#include <typeinfo>
+
 // Library Includes
+#include <boost/thread/mutex.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 
 // Project Includes
 #include "logging/include/Serialize.h"
 
+#include "core/include/Atomic.h"
+
 #include <boost/serialization/export.hpp>
 BOOST_CLASS_EXPORT(ram::core::Event)
 BOOST_CLASS_EXPORT(ram::core::StringEvent)
+BOOST_CLASS_EXPORT(ram::core::UpdateTimingEvent)
 
 #ifdef RAM_WITH_MATH
 BOOST_CLASS_EXPORT(ram::math::OrientationEvent)
@@ -26,6 +37,8 @@ BOOST_CLASS_EXPORT(ram::vision::DuctEvent)
 BOOST_CLASS_EXPORT(ram::vision::SafeEvent)
 BOOST_CLASS_EXPORT(ram::vision::TargetEvent)
 BOOST_CLASS_EXPORT(ram::vision::BarbedWireEvent)
+BOOST_CLASS_EXPORT(ram::vision::DetectorTimingEvent)
+BOOST_CLASS_EXPORT(ram::vision::RecorderWriteEvent)
 #endif // RAM_WITH_VISION
 
 #ifdef RAM_WITH_VEHICLE
@@ -45,3 +58,75 @@ BOOST_CLASS_EXPORT(ram::vehicle::DepthSensorInitEvent)
 BOOST_CLASS_EXPORT(ram::control::ParamSetupEvent)
 BOOST_CLASS_EXPORT(ram::control::ParamUpdateEvent)
 #endif // RAM_WITH_CONTROL
+
+namespace ram {
+namespace logging {
+
+// The SerializeMode of each type, by the address of its type_info.  Slots
+// are claimed with a compare and swap and never given back, so finding a
+// type needs no lock.  If it ever fills up types just aren't remembered.
+static const size_t TYPE_SLOTS = 512;
+static core::Atomic<size_t> slotTypes[TYPE_SLOTS];
+static core::Atomic<int> slotModes[TYPE_SLOTS];
+
+/** Finds the slot of the type, TYPE_SLOTS if it doesn't have one */
+static size_t findSlot(const std::type_info& type, bool claim)
+{
+    size_t key = (size_t)&type;
+    size_t start = (key >> 4) % TYPE_SLOTS;
+    for (size_t i = 0; i < TYPE_SLOTS; ++i)
+    {
+        size_t slot = (start + i) % TYPE_SLOTS;
+        size_t current = slotTypes[slot].load(core::MEMORY_ORDER_ACQUIRE);
+        if (key == current)
+            return slot;
+
+        if (0 == current)
+        {
+            if (!claim)
+                return TYPE_SLOTS;
+
+            // Lost the race unless it was for the same type
+            if (slotTypes[slot].compareExchange(current, key) ||
+                (key == current))
+            {
+                return slot;
+            }
+        }
+    }
+    return TYPE_SLOTS;
+}
+
+SerializeMode getSerializeMode(const core::Event& event)
+{
+    size_t slot = findSlot(typeid(event), false);
+    if (TYPE_SLOTS == slot)
+        return SERIALIZE_UNKNOWN;
+    return (SerializeMode)slotModes[slot].load(core::MEMORY_ORDER_ACQUIRE);
+}
+
+void setSerializeMode(const core::Event& event, SerializeMode mode)
+{
+    size_t slot = findSlot(typeid(event), true);
+    if (TYPE_SLOTS != slot)
+        slotModes[slot].store((int)mode, core::MEMORY_ORDER_RELEASE);
+}
+
+// Only used for types which can't be written, so this lock is never on the
+// normal path
+static boost::mutex reportedMutex;
+static std::set<std::string> reportedTypes;
+
+void reportUnserializable(const core::Event& event)
+{
+    std::string typeName(typeid(event).name());
+    boost::mutex::scoped_lock lock(reportedMutex);
+    if (reportedTypes.insert(typeName).second)
+    {
+        std::cerr << "Could not convert: " << typeName << event.type
+                  << std::endl;
+    }
+}
+
+} // namespace logging
+} // namespace ram
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/logging/test/src/SerializeBenchmark.cpp
+ */
+
+// STD Includes
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Library Includes
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Project Includes
+#include "logging/include/Serialize.h"
+#include "core/include/TimeVal.h"
+
+using namespace ram;
+
+/** The same flags the binary event log uses */
+static const int ARCHIVE_FLAGS =
+    boost::archive::no_header | boost::archive::no_tracking;
+
+/** The old way, one lock for everyone and a copy of each event */
+static boost::mutex oldMutex;
+
+/** Keeps the copies alive until the run is over, the archive tracks pointers
+ *  by address so a later copy at a freed address would only be written as a
+ *  reference (guarded by oldMutex)
+ */
+static std::vector<core::EventPtr> oldClones;
+
+template <class Archive>
+static bool writeEventLocked(core::EventPtr event, Archive& archive)
+{
+    boost::mutex::scoped_lock lock(oldMutex);
+    core::EventPtr clone = event->clone();
+    oldClones.push_back(clone);
+    archive << clone;
+    return true;
+}
+
+typedef boost::archive::binary_oarchive BinaryArchive;
+typedef bool (*WriteFunction)(core::EventPtr, BinaryArchive&);
+
+typedef std::vector<core::EventPtr> EventList;
+
+/** Writes every event into one archive, like the log does for each chunk */
+static void writeLoop(WriteFunction write, const EventList* events)
+{
+    std::ostringstream stream(std::ios::out | std::ios::binary);
+    BinaryArchive archive(stream, ARCHIVE_FLAGS);
+    for (size_t i = 0; i < events->size(); ++i)
+        write((*events)[i], archive);
+}
+
+/** Seconds since the given start time */
+static double since(const core::TimeVal& start)
+{
+    return core::TimeVal::timeOfDay().get_double() - start.get_double();
+}
+
+static void benchmark(const std::string& name, WriteFunction write,
+                      core::EventPtr event, int threads, int count)
+{
+    // Separate events, writing the same one again would only write a
+    // reference to it
+    std::vector<EventList> events(threads);
+    for (int i = 0; i < threads; ++i)
+    {
+        for (int j = 0; j < count; ++j)
+            events[i].push_back(event->clone());
+    }
+    oldClones.reserve(threads * count);
+
+    core::TimeVal start = core::TimeVal::timeOfDay();
+    boost::thread_group group;
+    for (int i = 0; i < threads; ++i)
+        group.create_thread(boost::bind(writeLoop, write, &events[i]));
+    group.join_all();
+    double seconds = since(start);
+    oldClones.clear();
+
+    std::stringstream label;
+    label << name << " (" << threads << " thread"
+          << ((threads > 1) ? "s)" : ")");
+    std::cout << std::setw(30) << std::left << label.str()
+              << std::setw(12) << std::right << std::fixed
+              << std::setprecision(0) << threads * count / seconds
+              << " events/s" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int count = 100000;
+    if (argc > 1)
+        count = atoi(argv[1]);
+
+    if (count < 1)
+    {
+        std::cout << "Usage: SerializeBenchmark [events per thread]\n\n"
+            "Times logging::writeEvent from 1, 2 and 4 threads at once"
+                  << std::endl;
+        return 1;
+    }
+
+    core::StringEventPtr event(new core::StringEvent());
+    event->type = "ram::core::SerializeBenchmark";
+    event->string = "A string about as long as a typical message";
+
+    int threadCounts[] = {1, 2, 4};
+    for (int i = 0; i < 3; ++i)
+    {
+        benchmark("writeEvent", &logging::writeEvent<BinaryArchive>, event,
+                  threadCounts[i], count);
+        benchmark("Locked with clone", &writeEventLocked<BinaryArchive>,
+                  event, threadCounts[i], count);
+    }
+    return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/logging/test/src/TestEventLog.cxx
+ */
+
+// STD Includes
+#include <sstream>
+#include <fstream>
+#include <unistd.h>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+#include <boost/filesystem.hpp>
+#include <boost/archive/text_oarchive.hpp>
+
+// Project Includes
+#include "logging/include/EventLog.h"
+#include "logging/include/Serialize.h"
+
+#include "core/include/Events.h"
+
+using namespace ram;
+
+SUITE(EventLog) {
+
+struct Fixture
+{
+    Fixture()
+    {
+        std::stringstream ss;
+        ss << "EventLogTest_" << getpid() << ".log";
+        fileName = ss.str();
+    }
+
+    ~Fixture()
+    {
+        boost::filesystem::path logFile(fileName);
+        if (boost::filesystem::exists(logFile))
+            boost::filesystem::remove(logFile);
+    }
+
+    core::EventPtr makeEvent(core::Event::EventType type, double timeStamp,
+                             std::string value)
+    {
+        core::StringEventPtr event(new core::StringEvent());
+        event->type = type;
+        event->timeStamp = timeStamp;
+        event->string = value;
+        return event;
+    }
+
+    std::string fileName;
+};
+
+TEST_FIXTURE(Fixture, RoundTrip)
+{
+    {
+        // Tiny chunks so we get lots of them
+        logging::LogWriter writer(fileName, 64);
+        CHECK(writer.isOpen());
+        for (int i = 0; i < 100; ++i)
+        {
+            std::stringstream ss;
+            ss << "Value" << i;
+            CHECK(writer.write(makeEvent(i % 2 ? "ODD" : "EVEN", i * 0.1,
+                                         ss.str())));
+        }
+    }
+
+    CHECK(logging::LogReader::isBinaryLog(fileName));
+    logging::LogReader reader(fileName);
+    CHECK(reader.isOpen());
+    CHECK(reader.isBinary());
+    CHECK_EQUAL(100u, reader.size());
+
+    // Read out of order
+    core::StringEventPtr event = boost::dynamic_pointer_cast<core::StringEvent>(
+        reader.readEvent(57));
+    CHECK(event);
+    CHECK_EQUAL("Value57", event->string);
+    CHECK_EQUAL("ODD", event->type);
+    CHECK_CLOSE(5.7, event->timeStamp, 0.0001);
+
+    // The index agrees with the events
+    CHECK_EQUAL("EVEN", reader.eventType(0));
+    CHECK_EQUAL("ODD", reader.eventType(99));
+    CHECK_CLOSE(9.9, reader.timeStamp(99), 0.0001);
+}
+
+TEST_FIXTURE(Fixture, MixedTypesInChunk)
+{
+    {
+        logging::LogWriter writer(fileName);
+        for (int i = 0; i < 10; ++i)
+        {
+            if (i % 2)
+            {
+                core::UpdateTimingEventPtr event(new core::UpdateTimingEvent());
+                event->type = "TIMING";
+                event->timeStamp = i;
+                event->updates = i;
+                CHECK(writer.write(event));
+            }
+            else
+            {
+                CHECK(writer.write(makeEvent("STRING", i, "Value")));
+            }
+
+            // Events we can't write don't spoil the rest of the chunk
+            if (5 == i)
+                CHECK(!writer.write(core::EventPtr(new core::IntEvent(i))));
+        }
+    }
+
+    logging::LogReader reader(fileName);
+    CHECK_EQUAL(10u, reader.size());
+    for (size_t i = 0; i < reader.size(); ++i)
+    {
+        core::EventPtr event = reader.readEvent(i);
+        CHECK(event);
+        if (i % 2)
+        {
+            core::UpdateTimingEventPtr timing =
+                boost::dynamic_pointer_cast<core::UpdateTimingEvent>(event);
+            CHECK(timing);
+            if (timing)
+                CHECK_EQUAL((int)i, timing->updates);
+        }
+        else
+        {
+            CHECK(boost::dynamic_pointer_cast<core::StringEvent>(event));
+        }
+    }
+
+    // Reading an event again gives a new copy
+    core::EventPtr first = reader.readEvent(3);
+    core::EventPtr second = reader.readEvent(3);
+    CHECK(first && second);
+    CHECK(first != second);
+    CHECK_EQUAL("TIMING", second->type);
+}
+
+TEST_FIXTURE(Fixture, FindTime)
+{
+    {
+        logging::LogWriter writer(fileName, 64);
+        for (int i = 0; i < 50; ++i)
+            writer.write(makeEvent("A", 10 + i, "a"));
+    }
+
+    logging::LogReader reader(fileName);
+    CHECK_EQUAL(0u, reader.findTime(0));
+    CHECK_EQUAL(0u, reader.findTime(10));
+    CHECK_EQUAL(21u, reader.findTime(30.5));
+    CHECK_EQUAL(49u, reader.findTime(59));
+    CHECK_EQUAL(50u, reader.findTime(100));
+}
+
+TEST_FIXTURE(Fixture, FindTimeKeyframes)
+{
+    // Enough events for several keyframes, with one out of order time stamp
+    size_t count = logging::LogReader::KEYFRAME_INTERVAL * 3 + 10;
+    {
+        logging::LogWriter writer(fileName);
+        for (size_t i = 0; i < count; ++i)
+        {
+            double timeStamp = (i == 1500) ? 2000.5 : i;
+            writer.write(makeEvent("A", timeStamp, "a"));
+        }
+    }
+
+    logging::LogReader reader(fileName);
+    CHECK_EQUAL(count, reader.size());
+    CHECK_EQUAL(1025u, reader.findTime(1025));
+    CHECK_EQUAL(1500u, reader.findTime(1499.5));
+    CHECK_EQUAL(1500u, reader.findTime(2000.1));
+    CHECK_EQUAL(count - 1, reader.findTime(count - 1));
+    CHECK_EQUAL(count, reader.findTime(count));
+}
+
+TEST_FIXTURE(Fixture, LatestEvents)
+{
+    size_t count = logging::LogReader::KEYFRAME_INTERVAL * 2 + 100;
+    {
+        logging::LogWriter writer(fileName, 1024);
+        writer.write(makeEvent("ONCE", 0, "once"));
+        for (size_t i = 1; i < count; ++i)
+            writer.write(makeEvent(i % 3 ? "OFTEN" : "SOMETIMES", i, "a"));
+    }
+
+    logging::LogReader reader(fileName);
+    CHECK_EQUAL(0u, reader.latestEvents(0).size());
+
+    std::vector<size_t> latest = reader.latestEvents(1);
+    CHECK_EQUAL(1u, latest.size());
+    CHECK_EQUAL(0u, latest[0]);
+
+    // Crosses a keyframe, the first event is still remembered
+    latest = reader.latestEvents(2100);
+    CHECK_EQUAL(3u, latest.size());
+    CHECK_EQUAL(0u, latest[0]);
+    CHECK_EQUAL(2097u, latest[1]);
+    CHECK_EQUAL(2099u, latest[2]);
+    CHECK_EQUAL("SOMETIMES", reader.eventType(latest[1]));
+    CHECK_EQUAL("OFTEN", reader.eventType(latest[2]));
+
+    // Right on a keyframe
+    latest = reader.latestEvents(logging::LogReader::KEYFRAME_INTERVAL);
+    CHECK_EQUAL(3u, latest.size());
+    CHECK_EQUAL(1023u, latest[2]);
+}
+
+TEST_FIXTURE(Fixture, AppendAndTruncate)
+{
+    {
+        logging::LogWriter writer(fileName);
+        writer.write(makeEvent("A", 1, "first"));
+    }
+    {
+        logging::LogWriter writer(fileName);
+        writer.write(makeEvent("B", 2, "second"));
+    }
+
+    // Simulate a crash part way through writing a chunk
+    {
+        std::ofstream file(fileName.c_str(),
+                           std::ios::out | std::ios::app | std::ios::binary);
+        file.write("RCHK\x05\x00", 6);
+    }
+
+    logging::LogReader reader(fileName);
+    CHECK_EQUAL(2u, reader.size());
+    CHECK_EQUAL("B", reader.eventType(1));
+}
+
+TEST_FIXTURE(Fixture, CorruptChunk)
+{
+    {
+        logging::LogWriter writer(fileName);
+        writer.write(makeEvent("A", 1, "ValueOne"));
+        writer.write(makeEvent("B", 2, "ValueTwo"));
+        writer.write(makeEvent("C", 3, "ValueThree"));
+    }
+
+    // Garble the length in front of the second string, leaving the chunk
+    // header and index alone
+    std::string contents;
+    {
+        std::ifstream file(fileName.c_str(), std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        contents = ss.str();
+    }
+    std::string::size_type pos = contents.find("ValueTwo");
+    CHECK(pos != std::string::npos && pos >= 8);
+    if (pos == std::string::npos || pos < 8)
+        return;
+    contents.replace(pos - 8, 8, 8, '\xff');
+    {
+        std::ofstream file(fileName.c_str(),
+                           std::ios::out | std::ios::trunc | std::ios::binary);
+        file.write(contents.data(), contents.size());
+    }
+
+    // Events before the damage still read, the rest come back empty
+    logging::LogReader reader(fileName);
+    CHECK_EQUAL(3u, reader.size());
+    core::StringEventPtr first =
+        boost::dynamic_pointer_cast<core::StringEvent>(reader.readEvent(0));
+    CHECK(first);
+    if (first)
+        CHECK_EQUAL("ValueOne", first->string);
+    CHECK(!reader.readEvent(1));
+    CHECK(!reader.readEvent(2));
+    CHECK(!reader.readEvent(1));
+
+    // The index is separate, so it is still right
+    CHECK_EQUAL("C", reader.eventType(2));
+}
+
+TEST_FIXTURE(Fixture, LegacyText)
+{
+    {
+        std::ofstream file(fileName.c_str(),
+                           std::ios::out | std::ios::binary);
+        boost::archive::text_oarchive archive(file,
+                                              boost::archive::no_tracking);
+        core::EventPtr first = makeEvent("A", 1, "one");
+        core::EventPtr second = makeEvent("B", 2, "two");
+        archive << first;
+        archive << second;
+    }
+
+    CHECK_EQUAL(false, logging::LogReader::isBinaryLog(fileName));
+    logging::LogReader reader(fileName);
+    CHECK(reader.isOpen());
+    CHECK_EQUAL(false, reader.isBinary());
+    CHECK_EQUAL(2u, reader.size());
+    CHECK_EQUAL("B", reader.eventType(1));
+    CHECK_EQUAL(1u, reader.findTime(1.5));
+
+    core::StringEventPtr event = boost::dynamic_pointer_cast<core::StringEvent>(
+        reader.readEvent(0));
+    CHECK(event);
+    CHECK_EQUAL("one", event->string);
+}
+
+} // SUITE(EventLog)
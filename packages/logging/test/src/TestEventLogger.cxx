@@ -18,6 +18,7 @@
 
 // Project Includes
 #include "logging/include/EventLogger.h"
+#include "logging/include/EventLog.h"
 #include "logging/include/Serialize.h"
 
 #include "core/include/Events.h"
@@ -47,26 +48,12 @@ struct Fixture
     {
         std::string fileName = "event.log";
         std::string filePath = (core::Logging::getLogDir() / fileName).string();
-        std::ifstream ifs;
-        ifs.open(filePath.c_str());
-
-        // get length of file:
-        ifs.seekg (0, std::ios::end);
-        int fileLength = ifs.tellg();
-        ifs.seekg (0, std::ios::beg);
-        
-        // Create the archive
-        boost::archive::text_iarchive iar(ifs);
+        logging::LogReader reader(filePath);
 
         // Read in all the events
         EventList events;
-        while (ifs.tellg() < fileLength)
-        {
-            // Read in the event
-            ram::core::EventPtr event;
-            iar >> event;
-            events.push_back(event);
-        }
+        for (size_t i = 0; i < reader.size(); ++i)
+            events.push_back(reader.readEvent(i));
 
         return events;
     }
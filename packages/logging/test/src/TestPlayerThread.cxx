@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/logging/test/src/TestPlayerThread.cxx
+ */
+
+// STD Includes
+#include <sstream>
+#include <unistd.h>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+#include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/bind.hpp>
+
+// Project Includes
+#include "logging/include/EventPlayer.h"
+#include "logging/include/EventLog.h"
+
+#include "core/include/Events.h"
+#include "core/include/EventHub.h"
+#include "core/include/TimeVal.h"
+
+using namespace ram;
+
+/** Runs off a fake clock so we can check the timing */
+class TestPlayerThread : public logging::PlayerThread
+{
+public:
+    TestPlayerThread(core::ConfigNode config, core::SubsystemList deps,
+                     logging::EventPlayer* player) :
+        logging::PlayerThread(config, deps, player),
+        timeOfDay(m_startTime),
+        sleptTime(0)
+    {
+    }
+
+    double timeOfDay;
+    double sleptTime;
+
+protected:
+    virtual double getTimeOfDay()
+    {
+        return timeOfDay;
+    }
+
+    virtual void eventSleep(double seconds)
+    {
+        seconds += 0.00001; // To avoid floating point errors
+        sleptTime += seconds;
+        timeOfDay += seconds;
+    }
+};
+
+SUITE(PlayerThread) {
+
+struct Fixture
+{
+    Fixture() :
+        eventHub(new core::EventHub())
+    {
+        std::stringstream ss;
+        ss << "PlayerThreadTestLog_" << getpid() << ".log";
+        fileName = ss.str();
+
+        // Events at 0, 0.5, 1 and 3 seconds into the log
+        logging::LogWriter writer(fileName);
+        double times[] = {10, 10.5, 11, 13};
+        for (int i = 0; i < 4; ++i)
+        {
+            core::EventPtr event(new core::StringEvent());
+            event->type = "TEST";
+            event->timeStamp = times[i];
+            writer.write(event);
+        }
+
+        eventHub->subscribeToType("TEST",
+            boost::bind(&Fixture::handleEvent, this, _1));
+    }
+
+    ~Fixture()
+    {
+        boost::filesystem::path logFile(fileName);
+        if (boost::filesystem::exists(logFile))
+            boost::filesystem::remove(logFile);
+    }
+
+    void handleEvent(core::EventPtr event)
+    {
+        publishedEvents.push_back(event);
+        clockTimes.push_back(core::TimeVal::clockTime().get_double());
+    }
+
+    core::ConfigNode config(std::string extra)
+    {
+        return core::ConfigNode::fromString(
+            "{ 'fileName' : '" + fileName + "', " + extra + " }");
+    }
+
+    core::EventHubPtr eventHub;
+    std::string fileName;
+    std::vector<core::EventPtr> publishedEvents;
+    std::vector<double> clockTimes;
+};
+
+TEST_FIXTURE(Fixture, Rate)
+{
+    core::ConfigNode cfg = config("'rate' : 2");
+    logging::EventPlayer player(cfg, boost::assign::list_of(eventHub));
+    TestPlayerThread thread(cfg, boost::assign::list_of(eventHub), &player);
+    CHECK_EQUAL(2.0, thread.getRate());
+    double start = thread.timeOfDay;
+
+    thread.update(0);
+    CHECK_CLOSE(0, thread.sleptTime, 0.0001);
+
+    // Half a second of log in a quarter second
+    thread.update(0);
+    CHECK_CLOSE(0.25, thread.sleptTime, 0.001);
+    thread.update(0);
+    CHECK_CLOSE(0.5, thread.sleptTime, 0.001);
+    CHECK_CLOSE(1.0, thread.currentTime(), 0.0001);
+
+    // Time stamps and the clock follow the log, not the wall clock
+    CHECK_EQUAL(3u, publishedEvents.size());
+    for (size_t i = 0; i < publishedEvents.size(); ++i)
+    {
+        CHECK_CLOSE(start + i * 0.5, publishedEvents[i]->timeStamp, 0.001);
+        CHECK_CLOSE(publishedEvents[i]->timeStamp, clockTimes[i], 0.001);
+    }
+
+    // Clamped to the supported range
+    thread.setRate(1000);
+    CHECK_EQUAL(logging::PlayerThread::MAX_RATE, thread.getRate());
+    thread.setRate(0);
+    CHECK_EQUAL(logging::PlayerThread::MIN_RATE, thread.getRate());
+}
+
+TEST_FIXTURE(Fixture, AsFastAsPossible)
+{
+    core::ConfigNode cfg = config("'asFastAsPossible' : 1");
+    logging::EventPlayer player(cfg, boost::assign::list_of(eventHub));
+    TestPlayerThread thread(cfg, boost::assign::list_of(eventHub), &player);
+    CHECK(thread.getAsFastAsPossible());
+    double start = thread.timeOfDay;
+
+    // No waiting at all
+    for (int i = 0; i < 3; ++i)
+        thread.update(0);
+    CHECK_EQUAL(0, thread.sleptTime);
+    CHECK_EQUAL(3u, publishedEvents.size());
+    CHECK_CLOSE(start + 1, publishedEvents[2]->timeStamp, 0.0001);
+    CHECK_CLOSE(start + 1, clockTimes[2], 0.001);
+
+    // Back to real time, the last event waits the full two seconds and the
+    // virtual clock is dropped
+    thread.setAsFastAsPossible(false);
+    thread.update(0);
+    CHECK_CLOSE(2, thread.sleptTime, 0.001);
+    CHECK_EQUAL(4u, publishedEvents.size());
+    CHECK_CLOSE(thread.timeOfDay, publishedEvents[3]->timeStamp, 0.001);
+    CHECK_CLOSE(core::TimeVal::timeOfDay().get_double(), clockTimes[3], 1);
+}
+
+} // SUITE(PlayerThread)
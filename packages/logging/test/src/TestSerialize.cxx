@@ -13,6 +13,8 @@
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 // Project Includes
 #include "core/include/Feature.h"
@@ -131,4 +133,121 @@ TEST_FIXTURE(Fixture, RedLightEvent)
 }
 #endif // RAM_WITH_VISION
 
+/** Never registered with BOOST_CLASS_EXPORT, and neither are its clones */
+struct UnexportedEvent : public ram::core::Event
+{
+    virtual ram::core::EventPtr clone()
+    {
+        return ram::core::EventPtr(new UnexportedEvent());
+    }
+};
+
+/** Like the Python wrappers, not exported but clones to a class which is */
+struct WrappedStringEvent : public ram::core::StringEvent
+{
+    virtual ram::core::EventPtr clone()
+    {
+        ram::core::StringEventPtr event(new ram::core::StringEvent());
+        event->type = type;
+        event->string = string;
+        return event;
+    }
+};
+
+TEST(writeEventUnexported)
+{
+    std::ostringstream ofs;
+    boost::archive::text_oarchive oa(ofs);
+    ram::core::EventPtr event(new UnexportedEvent());
+    CHECK(!ram::logging::isSerializable(*event));
+    CHECK(!ram::logging::writeEvent(event, oa));
+
+    // Again, now that it is known
+    CHECK(!ram::logging::writeEvent(event, oa));
+}
+
+TEST(writeEventClone)
+{
+    ram::core::StringEventPtr event(new WrappedStringEvent());
+    event->type = "Wrapped";
+    event->string = "Cloned";
+    CHECK(!ram::logging::isSerializable(*event));
+
+    // Twice, the second time the type is already known
+    for (int i = 0; i < 2; ++i)
+    {
+        std::ostringstream ofs;
+        {
+            boost::archive::binary_oarchive oa(ofs);
+            CHECK(ram::logging::writeEvent(event, oa));
+        }
+
+        std::istringstream ifs(ofs.str());
+        boost::archive::binary_iarchive iar(ifs);
+        ram::core::EventPtr readEvent;
+        iar >> readEvent;
+        ram::core::StringEventPtr result =
+            boost::dynamic_pointer_cast<ram::core::StringEvent>(readEvent);
+        CHECK(result);
+        if (result)
+        {
+            CHECK_EQUAL("Wrapped", result->type);
+            CHECK_EQUAL("Cloned", result->string);
+        }
+    }
+    CHECK_EQUAL(ram::logging::SERIALIZE_CLONE,
+                ram::logging::getSerializeMode(*event));
+}
+
+/** Writes the same event many times, each time into a new archive */
+static void writeMany(ram::core::EventPtr event, std::string* result)
+{
+    for (int i = 0; i < 200; ++i)
+    {
+        std::ostringstream ofs;
+        {
+            boost::archive::binary_oarchive oa(ofs);
+            if (!ram::logging::writeEvent(event, oa))
+                return;
+        }
+        if ((0 == i) || (*result == ofs.str()))
+            *result = ofs.str();
+        else
+            *result = "MISMATCH";
+    }
+}
+
+TEST(writeEventThreads)
+{
+    ram::core::StringEventPtr event(new ram::core::StringEvent());
+    event->type = "Threads";
+    event->string = "Shared";
+
+    // All threads write the one event in place
+    std::string results[4];
+    boost::thread_group threads;
+    for (int i = 0; i < 4; ++i)
+        threads.create_thread(boost::bind(writeMany, event, &results[i]));
+    threads.join_all();
+
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK(!results[i].empty());
+        CHECK_EQUAL(results[0], results[i]);
+    }
+
+    std::istringstream ifs(results[3]);
+    boost::archive::binary_iarchive iar(ifs);
+    ram::core::EventPtr readEvent;
+    iar >> readEvent;
+    ram::core::StringEventPtr result =
+        boost::dynamic_pointer_cast<ram::core::StringEvent>(readEvent);
+    CHECK(result);
+    if (result)
+    {
+        CHECK_EQUAL("Threads", result->type);
+        CHECK_EQUAL("Shared", result->string);
+    }
+}
+
 } // SUITE(Serialization)
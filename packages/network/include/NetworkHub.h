@@ -10,6 +10,9 @@
 #ifndef RAM_NETWORK_NETWORKHUB_11_15_2010
 #define RAM_NETWORK_NETWORKHUB_11_15_2010
 
+// STD Includes
+#include <vector>
+
 // Library Includes
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
@@ -17,6 +20,7 @@
 // Project Includes
 #include "core/include/EventHub.h"
 #include "network/include/NetworkPublisher.h"
+#include "network/include/Protocol.h"
 
 // Must be included last
 #include "network/include/Export.h"
@@ -24,14 +28,27 @@
 namespace ram {
 namespace network {
 
+/**
+ * Republishes the events sent by a remote NetworkPublisher
+ *
+ * By default events arrive in the text format.  Given a Subscription, or
+ * "protocol: binary" in its config, the hub asks for the binary batched
+ * format instead, and only for the types and rates in the subscription.
+ * The config takes the same "types", "maxRates" and "coalesce" as
+ * Subscription::fromConfig.
+ */
 class RAM_EXPORT NetworkHub : public core::EventHub
 {
 public:
-    /** Normal constructor */
+    /** Normal constructor, uses the text format */
     NetworkHub(std::string name = "NetworkHub",
                std::string host = "localhost",
                uint16_t port = NetworkPublisher::PORT);
 
+    /** Uses the binary format, with the given filters and rate limits */
+    NetworkHub(std::string name, std::string host, uint16_t port,
+               const Subscription& subscription);
+
     /** Standard subsystem constructor */
     NetworkHub(core::ConfigNode config,
                core::SubsystemList deps = core::SubsystemList());
@@ -42,9 +59,22 @@ private:
     void sendRequest();
     void daemon();
 
+    /** Deserializes and publishes every event in a binary batch */
+    void publishBatch(const char* data, size_t size);
+
+    /** Deserializes and publishes a text format event */
+    void publishText(const char* data, size_t size);
+
     std::string m_host;
     uint16_t m_port;
 
+    /** True if we asked for the binary format */
+    bool m_binary;
+    Subscription m_subscription;
+    boost::asio::ip::udp::endpoint m_publisher;
+
+    std::vector<char> m_buffer;
+
     boost::asio::io_service io_service;
     boost::asio::ip::udp::socket socket_;
     boost::thread *m_bthread;
@@ -12,10 +12,13 @@
 
 // STD Includes
 #include <stdint.h>
-#include <set>
+#include <map>
+#include <string>
+#include <vector>
 
 // Library Includes
 #include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
 //#include <boost/thread.hpp>
 
 // Project Includes
@@ -25,12 +28,31 @@
 #include "core/include/Subsystem.h"
 #include "core/include/Updatable.h"
 #include "network/include/Common.h"
+#include "network/include/Protocol.h"
 
 namespace boost { class thread; }
 
 namespace ram {
 namespace network {
 
+/**
+ * Sends the events of an EventHub to network clients over UDP
+ *
+ * A client which sends an empty datagram gets events in the text format, one
+ * per datagram, filtered by the Subscription in the "textClients" section of
+ * the config (every event if there is none).  A client which sends a
+ * Subscription gets only the event types it asked for, at no more than the
+ * rates it asked for, in the binary format of Protocol.h.  Binary events are
+ * packed into batches of at most "batchSize" bytes (default 1400), and
+ * everything published while the last batch was going out is sent together
+ * in the next one.
+ *
+ * Filters and rate limits are checked before anything is serialized, so
+ * events no client wants cost nothing.  Rate limited events that come too
+ * soon are dropped, unless their type is coalesced, then the latest one is
+ * held and sent as soon as the rate allows.  Each event is serialized at most
+ * once per format.
+ */
 class RAM_EXPORT NetworkPublisher :
         public core::Subsystem,
         public core::Updatable
@@ -72,7 +94,54 @@ public:
     static const uint16_t PORT;
 
   private:
-    void init();
+    typedef boost::asio::ip::udp::endpoint Endpoint;
+    typedef boost::shared_ptr<std::string> BufferPtr;
+
+    /** The state kept for each client */
+    struct Subscriber
+    {
+        /** What to do with an event */
+        enum Decision {
+            SEND,
+            DROP,
+            /** Coalesced, held until release says it is due */
+            HOLD
+        };
+
+        Subscriber(bool binary, const Subscription& subscription,
+                   size_t batchSize);
+
+        /** Checks the filters and rate limits for the event
+         *
+         *  SEND starts the rate limit over right away, before the event is
+         *  serialized.
+         */
+        Decision accept(core::EventPtr event, double now);
+
+        /** Moves the held events which are due by now into ready */
+        void release(double now, std::vector<core::EventPtr>& ready);
+
+        /** When the next held event is due, or 0 if nothing is held */
+        double nextRelease() const;
+
+        /** False for the text format */
+        bool binary;
+
+        Subscription subscription;
+
+        /** When each rate limited type was last sent */
+        std::map<core::Event::EventType, double> lastSent;
+
+        /** The latest event of each coalesced type waiting for its turn */
+        std::map<core::Event::EventType, core::EventPtr> held;
+
+        /** Binary events waiting for the next flush */
+        EventBatch batch;
+    };
+
+    typedef std::map<Endpoint, Subscriber> SubscriberMap;
+
+    void init(core::ConfigNode config);
 
     void startReceive();
 
@@ -80,23 +149,71 @@ public:
                            size_t bytes_recvd);
 
     void handleSend(const boost::system::error_code& err,
-                    size_t bytes_sent);
+                    size_t bytes_sent, BufferPtr data);
 
     void serviceRequests();
 
     void handleEvent(core::EventPtr event);
 
+    /** Serializes the event for the given clients and queues it to send */
+    void deliver(core::EventPtr event,
+                 const std::vector<Endpoint>& textRecipients,
+                 const std::vector<Endpoint>& binaryRecipients);
+
+    /** Makes sure held events are released by the given time
+     *
+     *  m_mutex must be held.
+     */
+    void scheduleRelease(double due);
+
+    /** Starts the release timer, runs on the io_service
+     *
+     *  Does nothing if m_releaseAt has since moved earlier than due.
+     */
+    void armRelease(double due);
+
+    /** Sends the held events which are now due, runs on the io_service */
+    void releaseHeld(const boost::system::error_code& err);
+
+    /** Adds the event to the batch of each binary recipient
+     *
+     *  Full batches are moved to m_outgoing, m_mutex must be held.
+     */
+    void batchEvent(const std::vector<Endpoint>& recipients,
+                    BufferPtr record);
+
+    /** Sends all queued datagrams and batches, runs on the io_service */
+    void flush();
+
     core::EventHubPtr m_eventHub;
+    core::EventConnectionPtr m_connection;
 
     boost::asio::io_service io_service;
     boost::asio::ip::udp::socket socket_;
     boost::thread *m_bthread;
+    boost::asio::deadline_timer m_releaseTimer;
 
     boost::asio::ip::udp::endpoint sender_endpoint;
-    std::set<boost::asio::ip::udp::endpoint> m_endpoints;
+    std::vector<char> m_receiveBuffer;
+
+    /** Guards everything below */
     boost::mutex m_mutex;
+    SubscriberMap m_subscribers;
+
+    /** Datagrams ready to send at the next flush */
+    std::vector<std::pair<Endpoint, BufferPtr> > m_outgoing;
+
+    /** True when a flush has been posted but not yet run */
+    bool m_flushPending;
+
+    /** True when the release timer is set, for m_releaseAt */
+    bool m_releaseScheduled;
+    double m_releaseAt;
+
+    size_t m_batchSize;
 
-    std::set<std::string> m_unconvertableTypes;
+    /** What text clients get, since they can't ask for anything */
+    Subscription m_textSubscription;
 };
 
 } // namespace network
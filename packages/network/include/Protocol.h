@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/network/include/Protocol.h
+ */
+
+#ifndef RAM_NETWORK_PROTOCOL_11_20_2010
+#define RAM_NETWORK_PROTOCOL_11_20_2010
+
+// STD Includes
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Project Includes
+#include "core/include/Event.h"
+#include "core/include/ConfigNode.h"
+
+// Must be included last
+#include "network/include/Export.h"
+
+namespace ram {
+namespace network {
+
+/**
+ * The binary protocol spoken between the NetworkPublisher and NetworkHub
+ *
+ * A client subscribes by sending a request datagram to the publisher.  An
+ * empty datagram asks for the original text format, one serialized event per
+ * datagram.  A request starting with "RAMS", the version and SUBSCRIBE,
+ * followed by an encoded Subscription, asks for the binary format.  There
+ * each datagram is a batch:
+ *
+ *   magic "RAMB", version (1 byte), reserved (1 byte), record count (2 bytes)
+ *   then for each record: length (4 bytes), binary archive of the event
+ *
+ * Integers, and the doubles of a Subscription, are sent in network (big
+ * endian) byte order, the same as the vision ImageStream.  The events
+ * themselves are written with the same binary archive flags as the event log,
+ * so both ends must still share the same architecture to read them.
+ */
+namespace protocol {
+
+/** Starts every subscribe or unsubscribe request, "RAMS" */
+extern RAM_EXPORT const char REQUEST_MAGIC[];
+
+/** Starts every binary datagram of events, "RAMB" */
+extern RAM_EXPORT const char BATCH_MAGIC[];
+
+/** Length of both magic strings */
+static const size_t MAGIC_SIZE = 4;
+
+/** Bumped whenever the layout of requests or batches changes */
+static const uint8_t VERSION = 3;
+
+/** Magic, version, reserved and record count */
+static const size_t BATCH_HEADER_SIZE = MAGIC_SIZE + 4;
+
+/** The length in front of each record in a batch */
+static const size_t RECORD_HEADER_SIZE = 4;
+
+/** Default limit on a batch, keeps datagrams inside an ethernet MTU */
+static const size_t DEFAULT_BATCH_SIZE = 1400;
+
+/** The largest payload UDP can carry */
+static const size_t MAX_DATAGRAM_SIZE = 65507;
+
+/** Kinds of request a client can send */
+enum RequestType {
+    SUBSCRIBE = 1,
+    UNSUBSCRIBE = 2
+};
+
+/** Returns the RequestType of a request datagram, or 0 if it is not one */
+RAM_EXPORT int requestType(const char* data, size_t size);
+
+/** Builds the request which ends a subscription */
+RAM_EXPORT std::string unsubscribeRequest();
+
+} // namespace protocol
+
+/**
+ * What a client wants from the NetworkPublisher
+ *
+ * Binary clients send theirs once when they subscribe, text clients all get
+ * the one in the "textClients" section of the publisher's config.  The
+ * publisher checks it for every event before serializing anything.
+ */
+struct RAM_EXPORT Subscription
+{
+    /** Event types to send, an empty set means every type */
+    std::set<core::Event::EventType> types;
+
+    /** Most events per second sent of each type, missing means unlimited */
+    std::map<core::Event::EventType, double> maxRates;
+
+    /** Rate limited types which send their latest value at the max rate
+     *
+     *  Events of other rate limited types which come too soon are dropped.
+     *  Events of these types are held instead, and the newest one held is
+     *  sent as soon as the rate allows.  Good for state updates, where only
+     *  the latest value matters, but it should never be stale.
+     */
+    std::set<core::Event::EventType> coalesced;
+
+    /** True if events of this type should be sent at all */
+    bool wants(const core::Event::EventType& type) const;
+
+    /** Returns the maximum rate for the type in Hz, or 0 if unlimited */
+    double maxRate(const core::Event::EventType& type) const;
+
+    /** True if the type keeps its latest value instead of dropping events */
+    bool isCoalesced(const core::Event::EventType& type) const;
+
+    /** Builds the subscribe request datagram */
+    std::string encode() const;
+
+    /**
+     * Reads a subscribe request made by encode
+     *
+     * @return  false if the data is not a valid subscribe request
+     */
+    static bool decode(const char* data, size_t size, Subscription& result);
+
+    /**
+     * Reads the "types" list, "maxRates" map and "coalesce" list of a config
+     * node
+     *
+     * An example, which sends A at 10 Hz and the latest B at 5 Hz:
+     *   { 'types' : ['A', 'B', 'C'], 'maxRates' : { 'A' : 10, 'B' : 5 },
+     *     'coalesce' : ['B'] }
+     */
+    static Subscription fromConfig(core::ConfigNode config);
+};
+
+/**
+ * Packs serialized events into one binary datagram
+ *
+ * Records are added until the next one would make the datagram bigger than
+ * the batch size.  A record bigger than the batch size on its own still gets
+ * a datagram to itself, as long as UDP can carry it.
+ */
+class RAM_EXPORT EventBatch
+{
+public:
+    EventBatch(size_t maxSize = protocol::DEFAULT_BATCH_SIZE);
+
+    /**
+     * Adds the serialized event to the batch
+     *
+     * @return  false if the batch is too full to hold it, or the record can
+     *          never fit in a datagram
+     */
+    bool add(const std::string& record);
+
+    /** True if the record is too large for any datagram */
+    static bool tooLarge(const std::string& record);
+
+    /** The number of records in the batch */
+    size_t size() const { return m_count; }
+
+    bool empty() const { return 0 == m_count; }
+
+    /** The datagram to send, with a valid header */
+    const std::string& data() const { return m_data; }
+
+    /** Hands over the datagram and starts a new empty batch */
+    void swap(std::string& data);
+
+    /**
+     * Splits a received datagram back into its records
+     *
+     * @param records  Filled with pointers to the start and length of each
+     *                 record, they point into data
+     * @return  false if the datagram is not a valid batch
+     */
+    static bool parse(const char* data, size_t size,
+                      std::vector<std::pair<const char*, size_t> >& records);
+
+    /** True if the datagram starts like a binary batch */
+    static bool isBatch(const char* data, size_t size);
+
+private:
+    void reset();
+
+    size_t m_maxSize;
+    size_t m_count;
+    std::string m_data;
+};
+
+} // namespace network
+} // namespace ram
+
+#endif // RAM_NETWORK_PROTOCOL_11_20_2010
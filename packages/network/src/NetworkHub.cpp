@@ -8,9 +8,13 @@
  */
 
 // STD Includes
+#include <iostream>
 #include <sstream>
+#include <streambuf>
 
 // Library Includes
+#include <boost/foreach.hpp>
+#include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -20,8 +24,6 @@
 #include "network/include/NetworkHub.h"
 #include "logging/include/Serialize.h"
 
-#define MAX_LENGTH 512
-
 RAM_CORE_REGISTER_SUBSYSTEM_MAKER(ram::network::NetworkHub,
                                   NetworkHub);
 
@@ -30,10 +32,43 @@ using namespace boost::asio::ip;
 namespace ram {
 namespace network {
 
+/** The same flags the binary event log uses */
+static const int BINARY_ARCHIVE_FLAGS =
+    boost::archive::no_header | boost::archive::no_tracking;
+
+/** Lets a boost archive read straight out of the received datagram */
+class MemoryBuffer : public std::streambuf
+{
+public:
+    MemoryBuffer(const char* data, size_t size)
+    {
+        char* start = const_cast<char*>(data);
+        setg(start, start, start + size);
+    }
+};
+
 NetworkHub::NetworkHub(std::string name, std::string host, uint16_t port)
     : core::EventHub(name),
       m_host(host),
       m_port(port),
+      m_binary(false),
+      m_buffer(protocol::MAX_DATAGRAM_SIZE),
+      socket_(io_service, udp::endpoint(udp::v4(), 0)),
+      m_bthread(0),
+      m_active(true)
+{
+    sendRequest();
+    m_bthread = new boost::thread(boost::bind(&NetworkHub::daemon, this));
+}
+
+NetworkHub::NetworkHub(std::string name, std::string host, uint16_t port,
+                       const Subscription& subscription)
+    : core::EventHub(name),
+      m_host(host),
+      m_port(port),
+      m_binary(true),
+      m_subscription(subscription),
+      m_buffer(protocol::MAX_DATAGRAM_SIZE),
       socket_(io_service, udp::endpoint(udp::v4(), 0)),
       m_bthread(0),
       m_active(true)
@@ -47,6 +82,9 @@ NetworkHub::NetworkHub(core::ConfigNode config,
     : core::EventHub(config, deps),
       m_host(config["host"].asString("localhost")),
       m_port(config["port"].asInt(NetworkPublisher::PORT)),
+      m_binary("binary" == config["protocol"].asString("text")),
+      m_subscription(Subscription::fromConfig(config)),
+      m_buffer(protocol::MAX_DATAGRAM_SIZE),
       socket_(io_service, udp::endpoint(udp::v4(), 0)),
       m_bthread(0),
       m_active(true)
@@ -60,6 +98,14 @@ NetworkHub::~NetworkHub()
     // Stop background processing thread
     m_active = false;
 
+    // Tell the publisher to stop sending to us
+    if (m_binary)
+    {
+        boost::system::error_code err;
+        socket_.send_to(boost::asio::buffer(protocol::unsubscribeRequest()),
+                        m_publisher, 0, err);
+    }
+
     // Shutdown socket
     boost::system::error_code err;
     // This always seems to receive a transport endpoint is not connected error
@@ -76,9 +122,19 @@ void NetworkHub::sendRequest()
     udp::resolver::query query(udp::v4(), m_host,
                                boost::lexical_cast<std::string>(m_port));
     udp::resolver::iterator iterator = resolver.resolve(query);
+    m_publisher = *iterator;
 
-    // Send empty signal to NetworkPublisher to establish connection
-    socket_.send_to(boost::asio::buffer((char *) NULL, 0), *iterator);
+    if (m_binary)
+    {
+        // Ask for the binary format with our filters
+        socket_.send_to(boost::asio::buffer(m_subscription.encode()),
+                        m_publisher);
+    }
+    else
+    {
+        // Send empty signal to NetworkPublisher to establish connection
+        socket_.send_to(boost::asio::buffer((char *) NULL, 0), m_publisher);
+    }
 }
 
 void NetworkHub::daemon()
@@ -86,37 +142,75 @@ void NetworkHub::daemon()
     while (m_active)
     {
         // Block for message
-        char reply[MAX_LENGTH];
         udp::endpoint sender_endpoint;
+        boost::system::error_code err;
         size_t reply_length = socket_.receive_from(
-            boost::asio::buffer(reply, MAX_LENGTH), sender_endpoint);
+            boost::asio::buffer(m_buffer), sender_endpoint, 0, err);
 
         // Check if any data was received
-        if (reply_length > 0)
+        if (err || 0 == reply_length)
+            continue;
+
+        const char* reply = &m_buffer[0];
+        if (EventBatch::isBatch(reply, reply_length))
+            publishBatch(reply, reply_length);
+        else
+            publishText(reply, reply_length);
+    }
+}
+
+void NetworkHub::publishBatch(const char* data, size_t size)
+{
+    std::vector<std::pair<const char*, size_t> > records;
+    if (!EventBatch::parse(data, size, records))
+    {
+        std::cerr << "NetworkHub: discarding bad batch of " << size
+                  << " bytes" << std::endl;
+    }
+
+    // Publish whatever records were intact
+    typedef std::pair<const char*, size_t> Record;
+    BOOST_FOREACH(const Record& record, records)
+    {
+        core::EventPtr event;
+        try {
+            MemoryBuffer buffer(record.first, record.second);
+            std::istream stream(&buffer);
+            boost::archive::binary_iarchive archive(stream,
+                                                    BINARY_ARCHIVE_FLAGS);
+            archive >> event;
+        } catch (boost::archive::archive_exception& ex) {
+            std::cerr << "NetworkHub: could not read event: " << ex.what()
+                      << std::endl;
+            continue;
+        }
+
+        publish(event);
+    }
+}
+
+void NetworkHub::publishText(const char* data, size_t size)
+{
+    // Write message received to archive
+    std::stringstream sstream;
+    sstream.write(data, size);
+
+    using namespace boost::archive;
+    try {
+        // Deserialize the received event
+        text_iarchive archive(sstream, no_tracking);
+        core::EventPtr event = core::EventPtr();
+        archive >> event;
+
+        // Publish the deserialized event
+        publish(event);
+    } catch (archive_exception& ex) {
+        // Ignore stream errors and discard the event
+        if (ex.code == archive_exception::input_stream_error)
         {
-            // Write message received to archive
-            std::stringstream sstream;
-            sstream.write(reply, reply_length);
-
-            using namespace boost::archive;
-            try {
-                // Deserialize the received event
-                text_iarchive archive(sstream, no_tracking);
-                core::EventPtr event = core::EventPtr();
-                archive >> event;
-                
-                // Publish the deserialized event
-                publish(event);
-            } catch (archive_exception& ex) {
-                // Ignore stream errors and discard the event
-                if (ex.code == archive_exception::input_stream_error)
-                {
-                    std::cout << "input stream error: "
-                              << reply_length << std::endl;
-                } else {
-                    throw ex;
-                }
-            }
+            std::cout << "input stream error: " << size << std::endl;
+        } else {
+            throw ex;
         }
     }
 }
@@ -8,16 +8,22 @@
  */
 
 // STD Includes
+#include <algorithm>
+#include <iostream>
 #include <sstream>
 
 // Library Includes
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
+#include <boost/foreach.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
 
 // Project Includes
 #include "network/include/NetworkPublisher.h"
 #include "core/include/EventHub.h"
+#include "core/include/EventConnection.h"
+#include "core/include/TimeVal.h"
 #include "core/include/SubsystemMaker.h"
 #include "logging/include/Serialize.h"
 
@@ -34,15 +40,119 @@ namespace network {
 
 const uint16_t NetworkPublisher::PORT = 51346;
 
+/** The same flags the binary event log uses */
+static const int BINARY_ARCHIVE_FLAGS =
+    boost::archive::no_header | boost::archive::no_tracking;
+
+/** How early, in seconds, a held event may be released */
+static const double RELEASE_SLACK = 0.001;
+
+/** Serializes the event once, returns an empty pointer if it can't be */
+template <class Archive>
+static boost::shared_ptr<std::string> serialize(core::EventPtr event,
+                                                int flags)
+{
+    std::ostringstream stream(std::ios::out | std::ios::binary);
+    {
+        Archive archive(stream, flags);
+        if (!logging::writeEvent(event, archive))
+            return boost::shared_ptr<std::string>();
+    }
+    return boost::shared_ptr<std::string>(new std::string(stream.str()));
+}
+
+NetworkPublisher::Subscriber::Subscriber(bool isBinary,
+                                         const Subscription& wanted,
+                                         size_t batchSize) :
+    binary(isBinary),
+    subscription(wanted),
+    batch(batchSize)
+{
+}
+
+NetworkPublisher::Subscriber::Decision
+NetworkPublisher::Subscriber::accept(core::EventPtr event, double now)
+{
+    const core::Event::EventType& type = event->type;
+    if (!subscription.wants(type))
+        return DROP;
+
+    double maxRate = subscription.maxRate(type);
+    if (maxRate <= 0)
+        return SEND;
+
+    std::map<core::Event::EventType, double>::iterator iter =
+        lastSent.find(type);
+    if (lastSent.end() != iter && (now - iter->second) < 1.0 / maxRate)
+    {
+        if (!subscription.isCoalesced(type))
+            return DROP;
+
+        // Replaces any older event still waiting
+        held[type] = event;
+        return HOLD;
+    }
+
+    // Claimed here, under the publisher's lock, so an event from another
+    // thread can't pass the rate limit before this one is queued
+    lastSent[type] = now;
+    held.erase(type);
+    return SEND;
+}
+
+void NetworkPublisher::Subscriber::release(double now,
+                                           std::vector<core::EventPtr>& ready)
+{
+    std::map<core::Event::EventType, core::EventPtr>::iterator iter =
+        held.begin();
+    while (held.end() != iter)
+    {
+        const core::Event::EventType& type = iter->first;
+        double due = lastSent[type] + 1.0 / subscription.maxRate(type);
+
+        // Timers are not exact, so let events out a little early
+        if (due - RELEASE_SLACK <= now)
+        {
+            ready.push_back(iter->second);
+            lastSent[type] = now;
+            held.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+double NetworkPublisher::Subscriber::nextRelease() const
+{
+    double next = 0;
+    typedef std::pair<core::Event::EventType, core::EventPtr> HeldPair;
+    BOOST_FOREACH(const HeldPair& entry, held)
+    {
+        double due = lastSent.find(entry.first)->second +
+            1.0 / subscription.maxRate(entry.first);
+        if (0 == next || due < next)
+            next = due;
+    }
+    return next;
+}
+
 NetworkPublisher::NetworkPublisher(core::ConfigNode config,
                                    core::SubsystemList deps) :
     core::Subsystem(config["name"].asString("NetworkPublisher"),
                     core::Subsystem::getSubsystemOfType<core::EventHub>(deps)),
     m_eventHub(core::Subsystem::getSubsystemOfType<core::EventHub>(deps)),
     socket_(io_service, udp::endpoint(udp::v4(), config["port"].asInt(PORT))),
-    m_bthread(0)
+    m_bthread(0),
+    m_releaseTimer(io_service),
+    m_receiveBuffer(protocol::MAX_DATAGRAM_SIZE),
+    m_flushPending(false),
+    m_releaseScheduled(false),
+    m_releaseAt(0),
+    m_batchSize(protocol::DEFAULT_BATCH_SIZE)
 {
-    init();
+    init(config);
 }
 
 NetworkPublisher::NetworkPublisher(core::ConfigNode config,
@@ -50,13 +160,22 @@ NetworkPublisher::NetworkPublisher(core::ConfigNode config,
     core::Subsystem(config["name"].asString("NetworkPublisher"), eventHub),
     m_eventHub(eventHub),
     socket_(io_service, udp::endpoint(udp::v4(), config["port"].asInt(PORT))),
-    m_bthread(0)
+    m_bthread(0),
+    m_releaseTimer(io_service),
+    m_receiveBuffer(protocol::MAX_DATAGRAM_SIZE),
+    m_flushPending(false),
+    m_releaseScheduled(false),
+    m_releaseAt(0),
+    m_batchSize(protocol::DEFAULT_BATCH_SIZE)
 {
-    init();
+    init(config);
 }
 
 NetworkPublisher::~NetworkPublisher()
 {
+    if (m_connection)
+        m_connection->disconnect();
+
     io_service.stop();
     if (m_bthread) {
         m_bthread->join();
@@ -66,10 +185,27 @@ NetworkPublisher::~NetworkPublisher()
     }
 }
 
-void NetworkPublisher::init()
+void NetworkPublisher::init(core::ConfigNode config)
 {
     assert(m_eventHub && "Need an EventHub");
-    m_eventHub->subscribeToAll(boost::bind(&NetworkPublisher::handleEvent, this, _1));
+    // Read signed so a negative value can't wrap around to a huge size
+    int batchSize = config["batchSize"].asInt(protocol::DEFAULT_BATCH_SIZE);
+    const int minBatchSize = (int)(protocol::BATCH_HEADER_SIZE +
+                                   protocol::RECORD_HEADER_SIZE + 1);
+    const int maxBatchSize = (int)protocol::MAX_DATAGRAM_SIZE;
+    if (batchSize < minBatchSize || batchSize > maxBatchSize)
+    {
+        int clamped = std::max(minBatchSize,
+                               std::min(batchSize, maxBatchSize));
+        std::cerr << "NetworkPublisher: batchSize " << batchSize
+                  << " out of range, using " << clamped << std::endl;
+        batchSize = clamped;
+    }
+    m_batchSize = (size_t)batchSize;
+    if (config.exists("textClients"))
+        m_textSubscription = Subscription::fromConfig(config["textClients"]);
+    m_connection = m_eventHub->subscribeToAll(
+        boost::bind(&NetworkPublisher::handleEvent, this, _1));
 
     startReceive();
     m_bthread = new boost::thread(
@@ -96,7 +232,7 @@ bool NetworkPublisher::backgrounded()
 void NetworkPublisher::startReceive()
 {
     socket_.async_receive_from(
-        boost::asio::buffer((char *) NULL, 0), sender_endpoint,
+        boost::asio::buffer(m_receiveBuffer), sender_endpoint,
         boost::bind(&NetworkPublisher::handleReceiveFrom, this,
                     boost::asio::placeholders::error,
                     boost::asio::placeholders::bytes_transferred));
@@ -106,9 +242,31 @@ void NetworkPublisher::handleReceiveFrom(const boost::system::error_code& err,
                                    size_t bytes_recvd)
 {
     if (!err) {
-        // Add the sender's endpoint to the list of endpoints if no error
+        const char* request = &m_receiveBuffer[0];
+        Subscription subscription;
+
         boost::mutex::scoped_lock lock(m_mutex);
-        m_endpoints.insert(sender_endpoint);
+        if (0 == bytes_recvd)
+        {
+            // An empty request is an old style text client
+            m_subscribers.erase(sender_endpoint);
+            m_subscribers.insert(std::make_pair(
+                sender_endpoint,
+                Subscriber(false, m_textSubscription, m_batchSize)));
+        }
+        else if (Subscription::decode(request, bytes_recvd, subscription))
+        {
+            // Replaces any earlier subscription from the same client
+            m_subscribers.erase(sender_endpoint);
+            m_subscribers.insert(std::make_pair(
+                sender_endpoint,
+                Subscriber(true, subscription, m_batchSize)));
+        }
+        else if (protocol::UNSUBSCRIBE ==
+                 protocol::requestType(request, bytes_recvd))
+        {
+            m_subscribers.erase(sender_endpoint);
+        }
     }
 
     // Receive a new connection
@@ -116,8 +274,9 @@ void NetworkPublisher::handleReceiveFrom(const boost::system::error_code& err,
 }
 
 void NetworkPublisher::handleSend(const boost::system::error_code& err,
-                            size_t bytes_sent)
+                                  size_t bytes_sent, BufferPtr data)
 {
+    // The bound data is released here, once the send is done with it
 }
 
 void NetworkPublisher::serviceRequests()
@@ -127,30 +286,236 @@ void NetworkPublisher::serviceRequests()
 
 void NetworkPublisher::handleEvent(core::EventPtr event)
 {
-    // Serialize event to archive
-    std::stringstream sstream;
-    bool writeSuccessful = false;
+    double now = core::TimeVal::timeOfDay().get_double();
+    std::vector<Endpoint> textRecipients;
+    std::vector<Endpoint> binaryRecipients;
+
+    // Check the filters first, so unwanted events are never serialized
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        BOOST_FOREACH(SubscriberMap::value_type& entry, m_subscribers)
+        {
+            Subscriber& subscriber = entry.second;
+            switch (subscriber.accept(event, now))
+            {
+                case Subscriber::SEND:
+                    if (subscriber.binary)
+                        binaryRecipients.push_back(entry.first);
+                    else
+                        textRecipients.push_back(entry.first);
+                    break;
+
+                case Subscriber::HOLD:
+                    scheduleRelease(subscriber.nextRelease());
+                    break;
+
+                case Subscriber::DROP:
+                    break;
+            }
+        }
+    }
+
+    deliver(event, textRecipients, binaryRecipients);
+}
+
+void NetworkPublisher::deliver(core::EventPtr event,
+                               const std::vector<Endpoint>& textRecipients,
+                               const std::vector<Endpoint>& binaryRecipients)
+{
+    if (textRecipients.empty() && binaryRecipients.empty())
+        return;
+
+    // Serialize once per format, outside the lock
+    BufferPtr text;
+    if (!textRecipients.empty())
+    {
+        text = serialize<boost::archive::text_oarchive>(
+            event, boost::archive::no_tracking);
+        // Text clients expect the string terminator on the end
+        if (text)
+            text->push_back('\0');
+    }
+
+    BufferPtr record;
+    if (!binaryRecipients.empty())
+    {
+        record = serialize<boost::archive::binary_oarchive>(
+            event, BINARY_ARCHIVE_FLAGS);
+    }
+
+    if (!text && !record)
+        return;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (text)
+    {
+        BOOST_FOREACH(const Endpoint& recipient, textRecipients)
+        {
+            // The client may have unsubscribed while we serialized
+            SubscriberMap::iterator iter = m_subscribers.find(recipient);
+            if (m_subscribers.end() == iter)
+                continue;
+
+            m_outgoing.push_back(std::make_pair(recipient, text));
+        }
+    }
+
+    if (record)
+        batchEvent(binaryRecipients, record);
+
+    // Everything published before the flush runs goes out with it
+    if (!m_flushPending)
+    {
+        m_flushPending = true;
+        io_service.post(boost::bind(&NetworkPublisher::flush, this));
+    }
+}
+
+void NetworkPublisher::scheduleRelease(double due)
+{
+    if (m_releaseScheduled && m_releaseAt <= due)
+        return;
 
+    m_releaseScheduled = true;
+    m_releaseAt = due;
+    io_service.post(boost::bind(&NetworkPublisher::armRelease, this, due));
+}
+
+void NetworkPublisher::armRelease(double due)
+{
     {
-        boost::archive::text_oarchive archive(sstream,
-                                              boost::archive::no_tracking);
-        writeSuccessful = logging::writeEvent(event, archive);
+        // A later time posted before an earlier one must not replace it
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (!m_releaseScheduled || due > m_releaseAt)
+            return;
     }
 
-    // Send serialized data to all registered endpoints
-    if ( writeSuccessful )
+    double wait = due - core::TimeVal::timeOfDay().get_double();
+    long microseconds = (wait > 0) ? (long)(wait * 1e6) : 0;
+
+    // Setting the time cancels any earlier wait
+    m_releaseTimer.expires_from_now(
+        boost::posix_time::microseconds(microseconds));
+    m_releaseTimer.async_wait(
+        boost::bind(&NetworkPublisher::releaseHeld, this,
+                    boost::asio::placeholders::error));
+}
+
+void NetworkPublisher::releaseHeld(const boost::system::error_code& err)
+{
+    // Replaced by an earlier release time
+    if (boost::asio::error::operation_aborted == err)
+        return;
+
+    double now = core::TimeVal::timeOfDay().get_double();
+
+    // Text and binary recipients of each event, so it is serialized once
+    typedef std::pair<std::vector<Endpoint>, std::vector<Endpoint> >
+        Recipients;
+    typedef std::map<core::EventPtr, Recipients> ReleaseMap;
+    ReleaseMap releases;
+    double next = 0;
+
     {
         boost::mutex::scoped_lock lock(m_mutex);
-        BOOST_FOREACH(udp::endpoint recipient, m_endpoints)
+        m_releaseScheduled = false;
+
+        BOOST_FOREACH(SubscriberMap::value_type& entry, m_subscribers)
+        {
+            std::vector<core::EventPtr> ready;
+            entry.second.release(now, ready);
+            BOOST_FOREACH(core::EventPtr event, ready)
+            {
+                Recipients& recipients = releases[event];
+                if (entry.second.binary)
+                    recipients.second.push_back(entry.first);
+                else
+                    recipients.first.push_back(entry.first);
+            }
+
+            double due = entry.second.nextRelease();
+            if (due > 0 && (0 == next || due < next))
+                next = due;
+        }
+
+        if (next > 0)
         {
-            socket_.async_send_to(
-                boost::asio::buffer(sstream.str(), sstream.str().size() + 1),
-                recipient,
-                boost::bind(&NetworkPublisher::handleSend, this,
-                            boost::asio::placeholders::error,
-                            boost::asio::placeholders::bytes_transferred));
+            m_releaseScheduled = true;
+            m_releaseAt = next;
         }
     }
+
+    // Already on the io_service thread, so set the timer right away
+    if (next > 0)
+        armRelease(next);
+
+    BOOST_FOREACH(const ReleaseMap::value_type& release, releases)
+    {
+        deliver(release.first, release.second.first, release.second.second);
+    }
+}
+
+void NetworkPublisher::batchEvent(const std::vector<Endpoint>& recipients,
+                                  BufferPtr record)
+{
+    if (EventBatch::tooLarge(*record))
+    {
+        std::cerr << "NetworkPublisher: dropping " << record->size()
+                  << " byte event, too large for a datagram" << std::endl;
+        return;
+    }
+
+    BOOST_FOREACH(const Endpoint& recipient, recipients)
+    {
+        // The client may have unsubscribed while we serialized
+        SubscriberMap::iterator iter = m_subscribers.find(recipient);
+        if (m_subscribers.end() == iter)
+            continue;
+
+        EventBatch& batch = iter->second.batch;
+        if (!batch.add(*record))
+        {
+            // Full, queue it up and start the next one
+            BufferPtr data(new std::string());
+            batch.swap(*data);
+            m_outgoing.push_back(std::make_pair(recipient, data));
+            batch.add(*record);
+        }
+    }
+}
+
+void NetworkPublisher::flush()
+{
+    std::vector<std::pair<Endpoint, BufferPtr> > outgoing;
+
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_flushPending = false;
+
+        BOOST_FOREACH(SubscriberMap::value_type& entry, m_subscribers)
+        {
+            if (entry.second.batch.empty())
+                continue;
+
+            BufferPtr data(new std::string());
+            entry.second.batch.swap(*data);
+            m_outgoing.push_back(std::make_pair(entry.first, data));
+        }
+
+        outgoing.swap(m_outgoing);
+    }
+
+    // The socket is only ever used from the io_service thread
+    typedef std::pair<Endpoint, BufferPtr> Datagram;
+    BOOST_FOREACH(const Datagram& datagram, outgoing)
+    {
+        socket_.async_send_to(
+            boost::asio::buffer(*datagram.second), datagram.first,
+            boost::bind(&NetworkPublisher::handleSend, this,
+                        boost::asio::placeholders::error,
+                        boost::asio::placeholders::bytes_transferred,
+                        datagram.second));
+    }
 }
 
 } // namespace network
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/network/src/Protocol.cpp
+ */
+
+// STD Includes
+#include <cstring>
+
+// Library Includes
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "network/include/Protocol.h"
+
+namespace ram {
+namespace network {
+
+namespace protocol {
+
+const char REQUEST_MAGIC[] = "RAMS";
+const char BATCH_MAGIC[] = "RAMB";
+
+} // namespace protocol
+
+// magic, version, request type
+static const size_t REQUEST_HEADER_SIZE = protocol::MAGIC_SIZE + 2;
+
+/** Writes an unsigned integer most significant byte first */
+template<typename T>
+static void appendValue(std::string& buffer, T value)
+{
+    for (int shift = 8 * (sizeof(T) - 1); shift >= 0; shift -= 8)
+        buffer.push_back((char)(unsigned char)(value >> shift));
+}
+
+/** Reads an unsigned integer written by appendValue */
+template<typename T>
+static T readValue(const char* buffer)
+{
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        value = (T)((value << 8) | (unsigned char)buffer[i]);
+    return value;
+}
+
+/** Doubles go as the network order bits of their IEEE 754 form */
+static void appendDouble(std::string& buffer, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendValue(buffer, bits);
+}
+
+static double readDouble(const char* buffer)
+{
+    uint64_t bits = readValue<uint64_t>(buffer);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void appendString(std::string& buffer, const std::string& str)
+{
+    appendValue(buffer, (uint16_t)str.size());
+    buffer.append(str);
+}
+
+/** Reads a length prefixed string, advancing pos, false if it runs past end */
+static bool readString(const char*& pos, const char* end, std::string& str)
+{
+    if (end - pos < (ptrdiff_t)sizeof(uint16_t))
+        return false;
+    uint16_t length = readValue<uint16_t>(pos);
+    pos += sizeof(uint16_t);
+
+    if (end - pos < (ptrdiff_t)length)
+        return false;
+    str.assign(pos, length);
+    pos += length;
+    return true;
+}
+
+static std::string requestHeader(protocol::RequestType type)
+{
+    std::string header(protocol::REQUEST_MAGIC, protocol::MAGIC_SIZE);
+    appendValue(header, protocol::VERSION);
+    appendValue(header, (uint8_t)type);
+    return header;
+}
+
+int protocol::requestType(const char* data, size_t size)
+{
+    if (size < REQUEST_HEADER_SIZE ||
+        0 != std::memcmp(data, REQUEST_MAGIC, MAGIC_SIZE) ||
+        VERSION != readValue<uint8_t>(data + MAGIC_SIZE))
+    {
+        return 0;
+    }
+
+    int type = readValue<uint8_t>(data + MAGIC_SIZE + 1);
+    if (SUBSCRIBE != type && UNSUBSCRIBE != type)
+        return 0;
+    return type;
+}
+
+std::string protocol::unsubscribeRequest()
+{
+    return requestHeader(UNSUBSCRIBE);
+}
+
+// ------------------------------------------------------------------------- //
+//                        S U B S C R I P T I O N                            //
+// ------------------------------------------------------------------------- //
+
+bool Subscription::wants(const core::Event::EventType& type) const
+{
+    return types.empty() || (types.end() != types.find(type));
+}
+
+double Subscription::maxRate(const core::Event::EventType& type) const
+{
+    std::map<core::Event::EventType, double>::const_iterator iter =
+        maxRates.find(type);
+    if (maxRates.end() == iter || iter->second <= 0)
+        return 0;
+    return iter->second;
+}
+
+bool Subscription::isCoalesced(const core::Event::EventType& type) const
+{
+    return coalesced.end() != coalesced.find(type);
+}
+
+std::string Subscription::encode() const
+{
+    std::string request(requestHeader(protocol::SUBSCRIBE));
+
+    appendValue(request, (uint16_t)types.size());
+    BOOST_FOREACH(const core::Event::EventType& type, types)
+    {
+        appendString(request, type);
+    }
+
+    appendValue(request, (uint16_t)maxRates.size());
+    typedef std::pair<core::Event::EventType, double> RatePair;
+    BOOST_FOREACH(const RatePair& rate, maxRates)
+    {
+        appendString(request, rate.first);
+        appendDouble(request, rate.second);
+    }
+
+    appendValue(request, (uint16_t)coalesced.size());
+    BOOST_FOREACH(const core::Event::EventType& type, coalesced)
+    {
+        appendString(request, type);
+    }
+
+    return request;
+}
+
+bool Subscription::decode(const char* data, size_t size, Subscription& result)
+{
+    if (protocol::SUBSCRIBE != protocol::requestType(data, size))
+        return false;
+
+    Subscription subscription;
+    const char* pos = data + REQUEST_HEADER_SIZE;
+    const char* end = data + size;
+
+    if (end - pos < (ptrdiff_t)sizeof(uint16_t))
+        return false;
+    uint16_t typeCount = readValue<uint16_t>(pos);
+    pos += sizeof(uint16_t);
+    for (uint16_t i = 0; i < typeCount; ++i)
+    {
+        std::string type;
+        if (!readString(pos, end, type))
+            return false;
+        subscription.types.insert(type);
+    }
+
+    if (end - pos < (ptrdiff_t)sizeof(uint16_t))
+        return false;
+    uint16_t rateCount = readValue<uint16_t>(pos);
+    pos += sizeof(uint16_t);
+    for (uint16_t i = 0; i < rateCount; ++i)
+    {
+        std::string type;
+        if (!readString(pos, end, type) ||
+            end - pos < (ptrdiff_t)sizeof(double))
+        {
+            return false;
+        }
+        subscription.maxRates[type] = readDouble(pos);
+        pos += sizeof(double);
+    }
+
+    if (end - pos < (ptrdiff_t)sizeof(uint16_t))
+        return false;
+    uint16_t coalescedCount = readValue<uint16_t>(pos);
+    pos += sizeof(uint16_t);
+    for (uint16_t i = 0; i < coalescedCount; ++i)
+    {
+        std::string type;
+        if (!readString(pos, end, type))
+            return false;
+        subscription.coalesced.insert(type);
+    }
+
+    result = subscription;
+    return true;
+}
+
+Subscription Subscription::fromConfig(core::ConfigNode config)
+{
+    Subscription subscription;
+
+    if (config.exists("types"))
+    {
+        core::ConfigNode types(config["types"]);
+        for (int i = 0; i < (int)types.size(); ++i)
+            subscription.types.insert(types[i].asString());
+    }
+
+    if (config.exists("maxRates"))
+    {
+        core::ConfigNode rates(config["maxRates"]);
+        BOOST_FOREACH(std::string type, rates.subNodes())
+        {
+            subscription.maxRates[type] = rates[type].asDouble();
+        }
+    }
+
+    if (config.exists("coalesce"))
+    {
+        core::ConfigNode coalesce(config["coalesce"]);
+        for (int i = 0; i < (int)coalesce.size(); ++i)
+            subscription.coalesced.insert(coalesce[i].asString());
+    }
+
+    return subscription;
+}
+
+// ------------------------------------------------------------------------- //
+//                          E V E N T   B A T C H                            //
+// ------------------------------------------------------------------------- //
+
+EventBatch::EventBatch(size_t maxSize) :
+    m_maxSize(maxSize),
+    m_count(0)
+{
+    reset();
+}
+
+bool EventBatch::add(const std::string& record)
+{
+    if (tooLarge(record))
+        return false;
+
+    // Only a lone record may go past the batch size
+    size_t needed = protocol::RECORD_HEADER_SIZE + record.size();
+    if (!empty() && (m_data.size() + needed > m_maxSize ||
+                     m_count == 0xFFFF))
+    {
+        return false;
+    }
+
+    appendValue(m_data, (uint32_t)record.size());
+    m_data.append(record);
+    ++m_count;
+
+    m_data[protocol::MAGIC_SIZE + 2] = (char)(unsigned char)(m_count >> 8);
+    m_data[protocol::MAGIC_SIZE + 3] = (char)(unsigned char)m_count;
+    return true;
+}
+
+bool EventBatch::tooLarge(const std::string& record)
+{
+    return protocol::BATCH_HEADER_SIZE + protocol::RECORD_HEADER_SIZE +
+        record.size() > protocol::MAX_DATAGRAM_SIZE;
+}
+
+void EventBatch::swap(std::string& data)
+{
+    m_data.swap(data);
+    reset();
+}
+
+bool EventBatch::isBatch(const char* data, size_t size)
+{
+    return size >= protocol::BATCH_HEADER_SIZE &&
+        0 == std::memcmp(data, protocol::BATCH_MAGIC, protocol::MAGIC_SIZE);
+}
+
+bool EventBatch::parse(const char* data, size_t size,
+                       std::vector<std::pair<const char*, size_t> >& records)
+{
+    records.clear();
+    if (!isBatch(data, size) ||
+        protocol::VERSION != readValue<uint8_t>(data + protocol::MAGIC_SIZE))
+    {
+        return false;
+    }
+
+    uint16_t count = readValue<uint16_t>(data + protocol::MAGIC_SIZE + 2);
+    const char* pos = data + protocol::BATCH_HEADER_SIZE;
+    const char* end = data + size;
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        if (end - pos < (ptrdiff_t)protocol::RECORD_HEADER_SIZE)
+            return false;
+        uint32_t length = readValue<uint32_t>(pos);
+        pos += protocol::RECORD_HEADER_SIZE;
+
+        if ((size_t)(end - pos) < length)
+            return false;
+        records.push_back(std::make_pair(pos, (size_t)length));
+        pos += length;
+    }
+
+    return true;
+}
+
+void EventBatch::reset()
+{
+    m_count = 0;
+    m_data.clear();
+    m_data.reserve(m_maxSize);
+    m_data.append(protocol::BATCH_MAGIC, protocol::MAGIC_SIZE);
+    appendValue(m_data, protocol::VERSION);
+    appendValue(m_data, (uint8_t)0);
+    appendValue(m_data, (uint16_t)0);
+}
+
+} // namespace network
+} // namespace ram
@@ -11,10 +11,14 @@
 
 // STD Includes
 #include <time.h>
+#include <vector>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 // Project Includes
 #include "core/include/EventHub.h"
@@ -22,6 +26,7 @@
 #include "core/include/EventConnection.h"
 #include "network/include/NetworkPublisher.h"
 #include "network/include/NetworkHub.h"
+#include "network/include/Protocol.h"
 
 using namespace ram;
 
@@ -76,3 +81,239 @@ TEST_FIXTURE(NetworkFixture, publishEvent)
     CHECK_EQUAL(expected->timeStamp, actual->timeStamp);
     CHECK_EQUAL(expected->string, actual->string);
 }
+
+struct BinaryNetworkFixture
+{
+    BinaryNetworkFixture()
+        : eventHub(new core::EventHub())
+        , publisher(core::ConfigNode::fromString(PUBLISHER_CFG), eventHub)
+        , networkHub(0)
+    {
+        // Wait for the publisher to start up
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    }
+
+    ~BinaryNetworkFixture()
+    {
+        if (conn)
+            conn->disconnect();
+        delete networkHub;
+    }
+
+    void subscribe(const network::Subscription& subscription)
+    {
+        networkHub = new network::NetworkHub("NetworkHub", "localhost", 48123,
+                                             subscription);
+        conn = networkHub->subscribeToAll(
+            boost::bind(&BinaryNetworkFixture::handler, this, _1));
+
+        // Wait for the subscription to arrive
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    }
+
+    void handler(core::EventPtr event)
+    {
+        events.push_back(event);
+    }
+
+    void publish(std::string type, std::string str)
+    {
+        core::StringEventPtr event(new core::StringEvent());
+        event->string = str;
+        eventHub->publish(type, event);
+    }
+
+    core::EventHubPtr eventHub;
+    network::NetworkPublisher publisher;
+    network::NetworkHub *networkHub;
+
+    core::EventConnectionPtr conn;
+    std::vector<core::EventPtr> events;
+};
+
+TEST_FIXTURE(BinaryNetworkFixture, binaryPublishEvent)
+{
+    subscribe(network::Subscription());
+
+    core::StringEventPtr expected(new core::StringEvent());
+    expected->string = "hello, world";
+    eventHub->publish("UPDATE", expected);
+
+    // Wait for the network event to get sent (asynchronous operation)
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    CHECK_EQUAL(1u, events.size());
+    if (events.size() < 1)
+        return;
+
+    core::StringEventPtr actual =
+        boost::dynamic_pointer_cast<core::StringEvent>(events[0]);
+    CHECK(actual);
+    CHECK_EQUAL(expected->type, actual->type);
+    CHECK_EQUAL(expected->timeStamp, actual->timeStamp);
+    CHECK_EQUAL(expected->string, actual->string);
+}
+
+TEST_FIXTURE(BinaryNetworkFixture, binaryManyEvents)
+{
+    subscribe(network::Subscription());
+
+    // Enough to need several batches, plus one larger than any batch
+    for (int i = 0; i < 100; ++i)
+        publish("UPDATE", boost::lexical_cast<std::string>(i));
+    publish("LARGE", std::string(10000, 'x'));
+
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    CHECK_EQUAL(101u, events.size());
+    if (events.size() < 101)
+        return;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        core::StringEventPtr event =
+            boost::dynamic_pointer_cast<core::StringEvent>(events[i]);
+        CHECK_EQUAL(boost::lexical_cast<std::string>(i), event->string);
+    }
+
+    core::StringEventPtr large =
+        boost::dynamic_pointer_cast<core::StringEvent>(events[100]);
+    CHECK_EQUAL("LARGE", large->type);
+    CHECK_EQUAL(10000u, large->string.size());
+}
+
+TEST_FIXTURE(BinaryNetworkFixture, binaryTypeFilter)
+{
+    network::Subscription subscription;
+    subscription.types.insert("WANTED");
+    subscribe(subscription);
+
+    publish("UNWANTED", "a");
+    publish("WANTED", "b");
+    publish("UNWANTED", "c");
+
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    CHECK_EQUAL(1u, events.size());
+    if (events.size() < 1)
+        return;
+    CHECK_EQUAL("WANTED", events[0]->type);
+}
+
+TEST_FIXTURE(BinaryNetworkFixture, binaryRateLimit)
+{
+    network::Subscription subscription;
+    subscription.maxRates["LIMITED"] = 0.5;
+    subscribe(subscription);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        publish("LIMITED", "a");
+        publish("FREE", "b");
+    }
+
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    // Only the first limited event fits in two seconds
+    int limited = 0;
+    int free = 0;
+    BOOST_FOREACH(core::EventPtr event, events)
+    {
+        if ("LIMITED" == event->type)
+            limited++;
+        else if ("FREE" == event->type)
+            free++;
+    }
+    CHECK_EQUAL(1, limited);
+    CHECK_EQUAL(10, free);
+}
+
+TEST_FIXTURE(BinaryNetworkFixture, binaryCoalesce)
+{
+    network::Subscription subscription;
+    subscription.maxRates["STATE"] = 5;
+    subscription.coalesced.insert("STATE");
+    subscribe(subscription);
+
+    for (int i = 0; i < 10; ++i)
+        publish("STATE", boost::lexical_cast<std::string>(i));
+
+    // The first goes right away, the latest 200ms later, the rest never
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+    CHECK_EQUAL(1u, events.size());
+    boost::this_thread::sleep(boost::posix_time::milliseconds(400));
+    CHECK_EQUAL(2u, events.size());
+    if (events.size() < 2)
+        return;
+
+    core::StringEventPtr first =
+        boost::dynamic_pointer_cast<core::StringEvent>(events[0]);
+    core::StringEventPtr latest =
+        boost::dynamic_pointer_cast<core::StringEvent>(events[1]);
+    CHECK_EQUAL("0", first->string);
+    CHECK_EQUAL("9", latest->string);
+}
+
+static void collect(std::vector<core::EventPtr>* events,
+                    core::EventPtr event)
+{
+    events->push_back(event);
+}
+
+TEST(textAndBinaryTogether)
+{
+    core::EventHubPtr eventHub(new core::EventHub());
+    network::NetworkPublisher publisher(
+        core::ConfigNode::fromString(PUBLISHER_CFG), eventHub);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+    network::NetworkHub textHub("TextHub", "localhost", 48123);
+    network::NetworkHub binaryHub("BinaryHub", "localhost", 48123,
+                                  network::Subscription());
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+    std::vector<core::EventPtr> textEvents;
+    std::vector<core::EventPtr> binaryEvents;
+    core::EventConnectionPtr textConn = textHub.subscribeToType(
+        "UPDATE", boost::bind(collect, &textEvents, _1));
+    core::EventConnectionPtr binaryConn = binaryHub.subscribeToType(
+        "UPDATE", boost::bind(collect, &binaryEvents, _1));
+
+    core::StringEventPtr event(new core::StringEvent());
+    event->string = "both";
+    eventHub->publish("UPDATE", event);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    CHECK_EQUAL(1u, textEvents.size());
+    CHECK_EQUAL(1u, binaryEvents.size());
+
+    textConn->disconnect();
+    binaryConn->disconnect();
+}
+
+TEST(textClientFilter)
+{
+    core::EventHubPtr eventHub(new core::EventHub());
+    network::NetworkPublisher publisher(
+        core::ConfigNode::fromString(
+            "{ 'port' : 48123, 'textClients' : { 'types' : ['UPDATE'] } }"),
+        eventHub);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+    network::NetworkHub textHub("TextHub", "localhost", 48123);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+    std::vector<core::EventPtr> events;
+    core::EventConnectionPtr conn = textHub.subscribeToAll(
+        boost::bind(collect, &events, _1));
+
+    eventHub->publish("OTHER", core::EventPtr(new core::StringEvent()));
+    eventHub->publish("UPDATE", core::EventPtr(new core::StringEvent()));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    CHECK_EQUAL(1u, events.size());
+    if (events.size() == 1)
+        CHECK_EQUAL("UPDATE", events[0]->type);
+
+    conn->disconnect();
+}
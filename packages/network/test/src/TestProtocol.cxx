@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/network/test/src/TestProtocol.cxx
+ */
+
+// STD Includes
+#include <string>
+#include <vector>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "network/include/Protocol.h"
+
+using namespace ram;
+
+typedef std::vector<std::pair<const char*, size_t> > RecordList;
+
+TEST(SubscriptionRoundTrip)
+{
+    network::Subscription subscription;
+    subscription.types.insert("A");
+    subscription.types.insert("B");
+    subscription.maxRates["A"] = 10;
+    subscription.coalesced.insert("A");
+
+    std::string request(subscription.encode());
+    CHECK_EQUAL(network::protocol::SUBSCRIBE,
+                network::protocol::requestType(request.data(),
+                                               request.size()));
+
+    network::Subscription result;
+    CHECK(network::Subscription::decode(request.data(), request.size(),
+                                        result));
+    CHECK(subscription.types == result.types);
+    CHECK_EQUAL(10.0, result.maxRate("A"));
+    CHECK_EQUAL(0.0, result.maxRate("B"));
+    CHECK(result.isCoalesced("A"));
+    CHECK(!result.isCoalesced("B"));
+    CHECK(result.wants("B"));
+    CHECK(!result.wants("C"));
+
+    // Everything is wanted when no types are given
+    CHECK(network::Subscription().wants("C"));
+}
+
+TEST(SubscriptionBadRequests)
+{
+    network::Subscription result;
+    std::string request(network::Subscription().encode());
+
+    // Cut short
+    CHECK(!network::Subscription::decode(request.data(), request.size() - 1,
+                                         result));
+    // Not a request at all
+    CHECK(!network::Subscription::decode("hello", 5, result));
+    CHECK_EQUAL(0, network::protocol::requestType("hello", 5));
+
+    std::string unsubscribe(network::protocol::unsubscribeRequest());
+    CHECK_EQUAL(network::protocol::UNSUBSCRIBE,
+                network::protocol::requestType(unsubscribe.data(),
+                                               unsubscribe.size()));
+    CHECK(!network::Subscription::decode(unsubscribe.data(),
+                                         unsubscribe.size(), result));
+}
+
+TEST(SubscriptionFromConfig)
+{
+    network::Subscription subscription(network::Subscription::fromConfig(
+        core::ConfigNode::fromString(
+            "{ 'types' : ['A', 'B'], 'maxRates' : { 'A' : 2.5 },"
+            "  'coalesce' : ['A'] }")));
+
+    CHECK_EQUAL(2u, subscription.types.size());
+    CHECK(subscription.wants("A"));
+    CHECK(!subscription.wants("C"));
+    CHECK_EQUAL(2.5, subscription.maxRate("A"));
+    CHECK(subscription.isCoalesced("A"));
+}
+
+TEST(EventBatchPacking)
+{
+    network::EventBatch batch(100);
+    CHECK(batch.empty());
+
+    // 8 byte header, each record is 4 + 40 bytes, so only two fit
+    std::string record(40, 'a');
+    CHECK(batch.add(record));
+    CHECK(batch.add(std::string(40, 'b')));
+    CHECK(!batch.add(record));
+    CHECK_EQUAL(2u, batch.size());
+    CHECK_EQUAL(96u, batch.data().size());
+
+    std::string data;
+    batch.swap(data);
+    CHECK(batch.empty());
+
+    // Count and lengths in network byte order
+    CHECK_EQUAL(0, data[6]);
+    CHECK_EQUAL(2, data[7]);
+    CHECK_EQUAL(0, data[8]);
+    CHECK_EQUAL(40, data[11]);
+
+    RecordList records;
+    CHECK(network::EventBatch::parse(data.data(), data.size(), records));
+    CHECK_EQUAL(2u, records.size());
+    CHECK_EQUAL(std::string(40, 'a'),
+                std::string(records[0].first, records[0].second));
+    CHECK_EQUAL(std::string(40, 'b'),
+                std::string(records[1].first, records[1].second));
+
+    // Truncated datagrams are caught
+    CHECK(!network::EventBatch::parse(data.data(), data.size() - 1,
+                                      records));
+    CHECK(!network::EventBatch::isBatch("RAMS", 4));
+}
+
+TEST(EventBatchLargeRecord)
+{
+    network::EventBatch batch(100);
+
+    // A record over the batch size gets a batch to itself
+    CHECK(batch.add(std::string(1000, 'a')));
+    CHECK(!batch.add(std::string(1, 'b')));
+    CHECK_EQUAL(1u, batch.size());
+
+    // But nothing can go past what UDP carries
+    std::string huge(network::protocol::MAX_DATAGRAM_SIZE, 'c');
+    CHECK(network::EventBatch::tooLarge(huge));
+    network::EventBatch empty;
+    CHECK(!empty.add(huge));
+    CHECK(empty.empty());
+}
@@ -5,7 +5,7 @@
  * @author Copyright 2007 Robotics@Maryland. All rights reserved.
  *
  * Calculate time delay on arrival using a number of different techniques.
- * 
+ *
  */
 
 
@@ -15,14 +15,121 @@
 
 #include "SonarChunk.h"
 
+#ifndef __BFIN
+    #include <fftw3.h>
+#endif
+
 
 namespace ram {
 namespace sonar {
 
 
+/**
+ * Delay of b relative to a, in samples, at the peak of their cross-correlation.
+ *
+ * Uses one TDOAxcorr shared by all calls, except on the Blackfin where there
+ * is no FFTW.  Not thread safe, threads correlating at the same time should
+ * each keep their own TDOAxcorr instead.
+ */
 adcsampleindex_t tdoa_xcorr(const SonarChunk &a, const SonarChunk &b);
 
 
+/**
+ * The same as tdoa_xcorr, computed directly in O(N*M).
+ *
+ * Kept as the reference the FFT version is tested against.
+ */
+adcsampleindex_t tdoa_xcorr_direct(const SonarChunk &a, const SonarChunk &b);
+
+
+#ifndef __BFIN
+
+/**
+ * Cross-correlates SonarChunks with FFTs, O((N+M) log(N+M)) per pair.
+ *
+ * The FFTW plans are made once, sized for chunks up to maxLength samples, and
+ * reused for every ping after.  Longer chunks make new, larger plans.
+ *
+ * The sums are exact integers, so as long as the rounding error of the FFT
+ * stays under half a count, which it does by a wide margin for 16 bit samples
+ * and chunks of SonarChunk::capacity, delay gives exactly the same answer as
+ * tdoa_xcorr_direct, ties included.
+ *
+ * Not thread safe, FFTW planning must not happen in two threads at once.
+ */
+class TDOAxcorr {
+public:
+	TDOAxcorr(adcsampleindex_t maxLength = SonarChunk::capacity);
+	~TDOAxcorr();
+
+	/** Delay of b relative to a in samples, the same as tdoa_xcorr */
+	adcsampleindex_t delay(const SonarChunk &a, const SonarChunk &b);
+
+	/**
+	 * Delay of b relative to a with sub-sample resolution.
+	 *
+	 * Fits a parabola through the correlation peak and its two neighbors.
+	 */
+	double fractionalDelay(const SonarChunk &a, const SonarChunk &b);
+
+	/**
+	 * Fractional delays between every pair of chunks.
+	 *
+	 * Each chunk is transformed only once, then each pair costs one inverse
+	 * transform.
+	 *
+	 * @param chunks  The chunk of each channel
+	 * @param count   Number of channels
+	 * @param delays  count * count results, delays[i * count + j] is the delay
+	 *                of chunk j relative to chunk i
+	 */
+	void allPairs(const SonarChunk * const chunks[], int count,
+	              double delays[]);
+
+private:
+	/** Makes plans and buffers for chunks up to maxLength samples */
+	void plan(adcsampleindex_t maxLength);
+	void destroy();
+
+	/** Grows the plans if needed and the spectra to count channels */
+	void reserve(adcsampleindex_t maxLength, int count);
+
+	/** Transforms the chunk into spectra[channel] */
+	void transform(const SonarChunk &chunk, int channel);
+
+	/**
+	 * Correlates the transformed channels into correlation, returns the lag
+	 * of its peak, in [-a.size(), b.size())
+	 */
+	adcsampleindex_t correlate(int a, adcsampleindex_t aSize,
+	                           int b, adcsampleindex_t bSize);
+
+	/** Sub-sample offset of the peak at lag, from the neighboring lags */
+	double interpolate(adcsampleindex_t lag, adcsampleindex_t aSize,
+	                   adcsampleindex_t bSize) const;
+
+	/** Correlation at the given lag, which must be in range */
+	double at(adcsampleindex_t lag) const;
+
+	/** FFT length, a power of two at least twice the longest chunk */
+	int fftLength;
+
+	/** Spectrum length of the real transform, fftLength / 2 + 1 */
+	int spectrumLength;
+
+	double *signal;
+	double *correlation;
+	fftw_complex *product;
+	fftw_complex **spectra;
+	int nspectra;
+
+	fftw_plan forward;
+	fftw_plan inverse;
+};
+
+#endif
+
+
 } // namespace sonar
 } // namespace ram
 
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <math.h>
 #include <limits.h>
+#include <string.h>
 #include <assert.h>
 
 
@@ -21,28 +22,37 @@ namespace sonar {
 
 
 adcsampleindex_t tdoa_xcorr(const SonarChunk &f, const SonarChunk &g)
+{
+#ifdef __BFIN
+	return tdoa_xcorr_direct(f, g);
+#else
+	// Planned once with FFTW_MEASURE and reused, it grows on longer chunks.
+	// Shared by every caller, so this is not thread safe either.
+	static TDOAxcorr xcorr;
+	return xcorr.delay(f, g);
+#endif
+}
+
+
+adcsampleindex_t tdoa_xcorr_direct(const SonarChunk &f, const SonarChunk &g)
 {
 	long int max = LONG_MIN;
 	adcsampleindex_t maxindex = 0;
-	
+
 	for (int k = -f.size() ; k < g.size() ; k ++)
 	{
 		long int accum = 0;
-		
+
+		// The bounds keep both i and i - k inside their chunks
 		int gMinIndex = std::max(0, k);
-		
+
 		int gMaxIndex = g.size();
 		if (gMaxIndex > k + f.size())
 			gMaxIndex = k + f.size();
-		
+
 		for (int i = gMinIndex ; i < gMaxIndex ; i ++)
-		{
-			assert(i >= 0);
-			assert(i - k >= 0);
-			assert(i < g.size());
-			assert(i - k < f.size());
 			accum += f[i - k] * g[i];
-		}
+
 		if (accum > max)
 		{
 			max = accum;
@@ -53,5 +63,211 @@ adcsampleindex_t tdoa_xcorr(const SonarChunk &f, const SonarChunk &g)
 }
 
 
+#ifndef __BFIN
+
+
+TDOAxcorr::TDOAxcorr(adcsampleindex_t maxLength)
+	: fftLength(0), spectrumLength(0), signal(NULL), correlation(NULL),
+	  product(NULL), spectra(NULL), nspectra(0), forward(NULL), inverse(NULL)
+{
+	plan(maxLength);
+}
+
+
+TDOAxcorr::~TDOAxcorr()
+{
+	destroy();
+}
+
+
+adcsampleindex_t TDOAxcorr::delay(const SonarChunk &a, const SonarChunk &b)
+{
+	reserve(std::max(a.size(), b.size()), 2);
+	transform(a, 0);
+	transform(b, 1);
+	adcsampleindex_t lag = correlate(0, a.size(), 1, b.size());
+	return lag - a.startIndex + b.startIndex;
+}
+
+
+double TDOAxcorr::fractionalDelay(const SonarChunk &a, const SonarChunk &b)
+{
+	reserve(std::max(a.size(), b.size()), 2);
+	transform(a, 0);
+	transform(b, 1);
+	adcsampleindex_t lag = correlate(0, a.size(), 1, b.size());
+	return lag + interpolate(lag, a.size(), b.size())
+		- a.startIndex + b.startIndex;
+}
+
+
+void TDOAxcorr::allPairs(const SonarChunk * const chunks[], int count,
+                         double delays[])
+{
+	adcsampleindex_t maxLength = 0;
+	for (int i = 0 ; i < count ; i ++)
+		maxLength = std::max(maxLength, chunks[i]->size());
+
+	reserve(maxLength, count);
+	for (int i = 0 ; i < count ; i ++)
+		transform(*chunks[i], i);
+
+	for (int i = 0 ; i < count ; i ++)
+	{
+		delays[i * count + i] = 0;
+		for (int j = i + 1 ; j < count ; j ++)
+		{
+			const SonarChunk &a = *chunks[i];
+			const SonarChunk &b = *chunks[j];
+			adcsampleindex_t lag = correlate(i, a.size(), j, b.size());
+			double delay = lag + interpolate(lag, a.size(), b.size())
+				- a.startIndex + b.startIndex;
+			delays[i * count + j] = delay;
+			delays[j * count + i] = -delay;
+		}
+	}
+}
+
+
+void TDOAxcorr::plan(adcsampleindex_t maxLength)
+{
+	// Room for every lag from -maxLength to maxLength - 1 without wrapping
+	fftLength = 2;
+	while (fftLength < 2 * maxLength)
+		fftLength *= 2;
+	spectrumLength = fftLength / 2 + 1;
+
+	signal = (double*) fftw_malloc(sizeof(double) * fftLength);
+	correlation = (double*) fftw_malloc(sizeof(double) * fftLength);
+	product = (fftw_complex*)
+		fftw_malloc(sizeof(fftw_complex) * spectrumLength);
+
+	// Each channel's spectrum is allocated the same way, so the forward plan
+	// can be executed into any of them
+	forward = fftw_plan_dft_r2c_1d(fftLength, signal, product,
+	                               FFTW_MEASURE);
+	inverse = fftw_plan_dft_c2r_1d(fftLength, product, correlation,
+	                               FFTW_MEASURE);
+}
+
+
+void TDOAxcorr::destroy()
+{
+	if (forward)
+		fftw_destroy_plan(forward);
+	if (inverse)
+		fftw_destroy_plan(inverse);
+	forward = inverse = NULL;
+
+	for (int i = 0 ; i < nspectra ; i ++)
+		fftw_free(spectra[i]);
+	delete [] spectra;
+	spectra = NULL;
+	nspectra = 0;
+
+	fftw_free(signal);
+	fftw_free(correlation);
+	fftw_free(product);
+	signal = correlation = NULL;
+	product = NULL;
+}
+
+
+void TDOAxcorr::reserve(adcsampleindex_t maxLength, int count)
+{
+	if (2 * maxLength > fftLength)
+	{
+		destroy();
+		plan(maxLength);
+	}
+
+	if (count > nspectra)
+	{
+		fftw_complex **grown = new fftw_complex*[count];
+		for (int i = 0 ; i < nspectra ; i ++)
+			grown[i] = spectra[i];
+		for (int i = nspectra ; i < count ; i ++)
+			grown[i] = (fftw_complex*)
+				fftw_malloc(sizeof(fftw_complex) * spectrumLength);
+		delete [] spectra;
+		spectra = grown;
+		nspectra = count;
+	}
+}
+
+
+void TDOAxcorr::transform(const SonarChunk &chunk, int channel)
+{
+	assert(channel < nspectra);
+	assert(2 * chunk.size() <= fftLength);
+
+	adcsampleindex_t size = chunk.size();
+	for (adcsampleindex_t i = 0 ; i < size ; i ++)
+		signal[i] = chunk[i];
+	memset(signal + size, 0, sizeof(double) * (fftLength - size));
+
+	fftw_execute_dft_r2c(forward, signal, spectra[channel]);
+}
+
+
+adcsampleindex_t TDOAxcorr::correlate(int a, adcsampleindex_t aSize,
+                                      int b, adcsampleindex_t bSize)
+{
+	// correlation[k] = sum over i of a[i - k] * b[i], so conj(A) * B
+	const fftw_complex *fa = spectra[a];
+	const fftw_complex *fb = spectra[b];
+	for (int i = 0 ; i < spectrumLength ; i ++)
+	{
+		product[i][0] = fa[i][0] * fb[i][0] + fa[i][1] * fb[i][1];
+		product[i][1] = fa[i][0] * fb[i][1] - fa[i][1] * fb[i][0];
+	}
+	fftw_execute(inverse);
+
+	// Round to the exact integer sums and search in the same order as
+	// tdoa_xcorr_direct, so ties go the same way
+	double max = -HUGE_VAL;
+	adcsampleindex_t maxLag = 0;
+	for (adcsampleindex_t k = -aSize ; k < bSize ; k ++)
+	{
+		double value = floor(at(k) + 0.5);
+		if (value > max)
+		{
+			max = value;
+			maxLag = k;
+		}
+	}
+	return maxLag;
+}
+
+
+double TDOAxcorr::interpolate(adcsampleindex_t lag, adcsampleindex_t aSize,
+                              adcsampleindex_t bSize) const
+{
+	if (lag - 1 < -aSize || lag + 1 >= bSize)
+		return 0;
+
+	double before = at(lag - 1);
+	double peak = at(lag);
+	double after = at(lag + 1);
+
+	// Only a peak that curves down has a vertex to move to
+	double curvature = before - 2 * peak + after;
+	if (curvature >= 0)
+		return 0;
+	return 0.5 * (before - after) / curvature;
+}
+
+
+double TDOAxcorr::at(adcsampleindex_t lag) const
+{
+	// Negative lags wrap around to the end of the circular correlation
+	int index = (lag < 0) ? lag + fftLength : lag;
+	return correlation[index] / fftLength;
+}
+
+
+#endif
+
+
 } // namespace sonar
 } // namespace ram
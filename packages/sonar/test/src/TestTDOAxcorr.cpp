@@ -289,3 +289,112 @@ TEST_FIXTURE(TDOAxcorrTestFixture, NoDelayNegativeOffsetFirstLonger)
 	b->recycle();
 	SonarChunk::emptyPool();
 }
+
+
+/*********************************************/
+/** FFT version against the direct version  **/
+/*********************************************/
+
+
+static SonarChunk *makeNoise(adcsampleindex_t size, adcsampleindex_t startIndex, int amplitude)
+{
+	SonarChunk *sc = SonarChunk::newInstance();
+	sc->startIndex = startIndex;
+	for (adcsampleindex_t i = 0 ; i < size ; i ++)
+		sc->append((adcdata_t) (rand() % (2 * amplitude + 1) - amplitude));
+	return sc;
+}
+
+
+static SonarChunk *makeGaussianPulse(double center, adcsampleindex_t size, adcsampleindex_t startIndex)
+{
+	SonarChunk *sc = SonarChunk::newInstance();
+	sc->startIndex = startIndex;
+	for (adcsampleindex_t i = 0 ; i < size ; i ++)
+	{
+		double x = (i - center) / 20.0;
+		sc->append((adcdata_t) (10000 * exp(-x * x / 2)));
+	}
+	return sc;
+}
+
+
+TEST_FIXTURE(TDOAxcorrTestFixture, FFTMatchesDirectOnNoise)
+{
+	srand(42);
+	TDOAxcorr xcorr(512);
+	adcsampleindex_t sizes[][2] = {{400, 400}, {100, 700}, {900, 30},
+	                               {1, 50}, {0, 10}, {2048, 2048}};
+	for (int i = 0 ; i < 6 ; i ++)
+	{
+		SonarChunk *a = makeNoise(sizes[i][0], 500, 30000);
+		SonarChunk *b = makeNoise(sizes[i][1], 600 + i, 30000);
+		adcsampleindex_t expected = tdoa_xcorr_direct(*a, *b);
+		CHECK_EQUAL(expected, xcorr.delay(*a, *b));
+		CHECK_EQUAL(expected, tdoa_xcorr(*a, *b));
+		a->recycle();
+		b->recycle();
+	}
+	SonarChunk::emptyPool();
+}
+
+
+TEST_FIXTURE(TDOAxcorrTestFixture, FFTMatchesDirectOnPulses)
+{
+	// The same plans reused for every ping, like the sonar loop does
+	TDOAxcorr xcorr;
+	for (adcsampleindex_t shift = -150 ; shift <= 150 ; shift += 25)
+	{
+		SonarChunk *a = makeGaussianPulse(200, 400, 1000);
+		SonarChunk *b = makeGaussianPulse(200 + shift, 400, 1000);
+		CHECK_EQUAL(tdoa_xcorr_direct(*a, *b), xcorr.delay(*a, *b));
+		CHECK_EQUAL(shift, xcorr.delay(*a, *b));
+		a->recycle();
+		b->recycle();
+	}
+	SonarChunk::emptyPool();
+}
+
+
+TEST_FIXTURE(TDOAxcorrTestFixture, FractionalDelay)
+{
+	TDOAxcorr xcorr;
+	SonarChunk *a = makeGaussianPulse(200, 400, 500);
+	SonarChunk *b = makeGaussianPulse(210.5, 400, 500);
+	CHECK_CLOSE(10.5, xcorr.fractionalDelay(*a, *b), 0.05);
+	CHECK_CLOSE(-10.5, xcorr.fractionalDelay(*b, *a), 0.05);
+	a->recycle();
+	b->recycle();
+	SonarChunk::emptyPool();
+}
+
+
+TEST_FIXTURE(TDOAxcorrTestFixture, AllPairs)
+{
+	const int count = 4;
+	double centers[count] = {200, 210.25, 195, 230.5};
+	adcsampleindex_t offsets[count] = {500, 500, 600, 400};
+	SonarChunk *chunks[count];
+	for (int i = 0 ; i < count ; i ++)
+		chunks[i] = makeGaussianPulse(centers[i], 400, offsets[i]);
+
+	TDOAxcorr xcorr(256);
+	double delays[count * count];
+	xcorr.allPairs(chunks, count, delays);
+
+	for (int i = 0 ; i < count ; i ++)
+	{
+		for (int j = 0 ; j < count ; j ++)
+		{
+			double expected = centers[j] + offsets[j]
+				- centers[i] - offsets[i];
+			CHECK_CLOSE(expected, delays[i * count + j], 0.05);
+			CHECK_CLOSE(xcorr.fractionalDelay(*chunks[i], *chunks[j]),
+			            delays[i * count + j], 1e-9);
+		}
+	}
+
+	for (int i = 0 ; i < count ; i ++)
+		chunks[i]->recycle();
+	SonarChunk::emptyPool();
+}
@@ -21,6 +21,7 @@
 #include "core/include/EventPublisher.h"
 #include "core/include/ReadWriteMutex.h"
 #include "core/include/Updatable.h"
+#include "core/include/Executor.h"
 
 #include "vehicle/include/Common.h"
 #include "vehicle/include/IVehicle.h"
@@ -205,6 +206,9 @@ private:
 
     math::MatrixN m_controlSignalToThrusterForces;
     bool m_controlSignalToThrusterForcesCreated;
+
+    /** Pool for devices configured with "executor", if we depend on one */
+    core::ExecutorPtr m_executor;
     
     enum thrusters {STAR = 0, PORT, BOT, TOP, FORE, AFT};
 };
@@ -40,29 +40,39 @@ IVehicle::~IVehicle()
 
 void IVehicle::handleReturn(int flags)
 {
+    // Looked up once, these go out on every update
+    static const core::Event::TypeId POSITION_UPDATE_ID =
+        core::Event::registerType(IVehicle::POSITION_UPDATE);
+    static const core::Event::TypeId VELOCITY_UPDATE_ID =
+        core::Event::registerType(IVehicle::VELOCITY_UPDATE);
+    static const core::Event::TypeId DEPTH_UPDATE_ID =
+        core::Event::registerType(IVehicle::DEPTH_UPDATE);
+    static const core::Event::TypeId ORIENTATION_UPDATE_ID =
+        core::Event::registerType(IVehicle::ORIENTATION_UPDATE);
+
     // Sends events to values that have been flagged
     if (flags & device::StateFlag::POS) {
 	math::Vector2EventPtr event(new math::Vector2Event());
 	event->vector2 = getPosition();
-	publish(IVehicle::POSITION_UPDATE, event);
+	publish(POSITION_UPDATE_ID, IVehicle::POSITION_UPDATE, event);
     }
 
     if (flags & device::StateFlag::VEL) {
 	math::Vector2EventPtr event(new math::Vector2Event());
 	event->vector2 = getVelocity();
-	publish(IVehicle::VELOCITY_UPDATE, event);
+	publish(VELOCITY_UPDATE_ID, IVehicle::VELOCITY_UPDATE, event);
     }
 
     if (flags & device::StateFlag::DEPTH) {
 	math::NumericEventPtr event(new math::NumericEvent());
 	event->number = getDepth();
-	publish(IVehicle::DEPTH_UPDATE, event);
+	publish(DEPTH_UPDATE_ID, IVehicle::DEPTH_UPDATE, event);
     }
 
     if (flags & device::StateFlag::ORIENTATION) {
 	math::OrientationEventPtr event(new math::OrientationEvent());
 	event->orientation = getOrientation();
-	publish(IVehicle::ORIENTATION_UPDATE, event);
+	publish(ORIENTATION_UPDATE_ID, IVehicle::ORIENTATION_UPDATE, event);
     }
 }
 
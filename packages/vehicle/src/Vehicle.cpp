@@ -112,7 +112,8 @@ Vehicle::Vehicle(core::ConfigNode config, core::SubsystemList deps) :
     m_grabber(device::IPayloadSetPtr()),
     stateEstimator(estimator::IStateEstimatorPtr()),
     m_controlSignalToThrusterForces(0.0, 6, 6),
-    m_controlSignalToThrusterForcesCreated(false)
+    m_controlSignalToThrusterForcesCreated(false),
+    m_executor(core::Subsystem::getSubsystemOfType<core::Executor>(deps))
 {
 
     /* Make the new state estimator.  This needs to be changed to replace the old one 
@@ -178,7 +179,7 @@ Vehicle::Vehicle(core::ConfigNode config, core::SubsystemList deps) :
 
     // Now set the initial values of the estimator
     LOGGER.info("Setting initial state estimator values.");
-    double timeStamp = core::TimeVal::timeOfDay().get_double();
+    double timeStamp = core::TimeVal::clockTime().get_double();
     if (m_depthSensor)
         m_stateEstimator->depthUpdate(getRawDepth(), timeStamp);
     if (m_imu)
@@ -577,6 +578,40 @@ void Vehicle::background(int interval)
         if (deviceConfig.exists(device->getName()))
         {
             core::ConfigNode devCfg(deviceConfig[device->getName()]);
+
+            // Run on the vehicle's executor instead of a dedicated thread
+            if (devCfg.exists("executor"))
+            {
+                std::string executorName(devCfg["executor"].asString());
+                core::Updatable* updatable =
+                    dynamic_cast<core::Updatable*>(device.get());
+                if (updatable && m_executor &&
+                    (m_executor->getName() == executorName))
+                {
+                    // We can be backgrounded more than once, and a running
+                    // device can't change executors
+                    bool onExecutor =
+                        updatable->getExecutor() == m_executor.get();
+                    if (!onExecutor && updatable->backgrounded())
+                    {
+                        std::cout << "WARNING: Device " << device->getName()
+                                  << " is already running, it stays off "
+                                  << "executor " << executorName << std::endl;
+                    }
+                    else if (!onExecutor)
+                    {
+                        updatable->setExecutor(m_executor.get());
+                    }
+                }
+                else
+                {
+                    std::cout << "WARNING: Device " << device->getName()
+                              << " can't run on executor " << executorName
+                              << ", the Vehicle must depend on it"
+                              << std::endl;
+                }
+            }
+            
             if (devCfg.exists("update_interval"))
                 device->background(devCfg["update_interval"].asInt());
 
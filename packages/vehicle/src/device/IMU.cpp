@@ -159,7 +159,9 @@ void IMU::update(double timestep)
                 new RawIMUDataEvent());
             rawIMUDataEvent->rawIMUData = newState;
             rawIMUDataEvent->name = getName();
-            publish(IIMU::RAW_UPDATE,rawIMUDataEvent);
+            static const core::Event::TypeId RAW_UPDATE_ID =
+                core::Event::registerType(IIMU::RAW_UPDATE);
+            publish(RAW_UPDATE_ID, IIMU::RAW_UPDATE, rawIMUDataEvent);
             
             
             
@@ -248,7 +250,9 @@ void IMU::update(double timestep)
             // Send Event
             math::OrientationEventPtr oevent(new math::OrientationEvent());
             oevent->orientation = updateQuat;
-            publish(IIMU::UPDATE, oevent);
+            static const core::Event::TypeId UPDATE_ID =
+                core::Event::registerType(IIMU::UPDATE);
+            publish(UPDATE_ID, IIMU::UPDATE, oevent);
 
             // Log data directly
             LOGGER.infoStream() << m_imuNum << " "
@@ -36,7 +36,7 @@ SonarStateEstimator::SonarStateEstimator(core::ConfigNode config,
     m_estimatedDepth(0),
     m_currentOrientation(math::Quaternion::IDENTITY),
     m_currentVelocity(math::Vector2::ZERO),
-    m_lastUpdateTime(core::TimeVal::timeOfDay().get_double()),
+    m_lastUpdateTime(core::TimeVal::clockTime().get_double()),
     m_stateHat(0.0 , 8), // 8 elements long, all start out 0
     m_A(0.0,8,8)//8x8 matrix, all values initialized to 0
 {
@@ -242,7 +242,7 @@ math::Vector2 SonarStateEstimator::getRightPingerEstimatedPosition()
 
 double SonarStateEstimator::getDeltaT()
 {
-    return m_lastUpdateTime - core::TimeVal::timeOfDay().get_double();
+    return m_lastUpdateTime - core::TimeVal::clockTime().get_double();
 }
 
 void SonarStateEstimator::onSonarEvent(core::EventPtr event)
@@ -267,7 +267,7 @@ void SonarStateEstimator::onSonarEvent(core::EventPtr event)
 
     // Mark the time this update was finished so we can calculate the dt
     // next frame
-    m_lastUpdateTime = core::TimeVal::timeOfDay().get_double();
+    m_lastUpdateTime = core::TimeVal::clockTime().get_double();
 }
 
 void SonarStateEstimator::pingerLeftFilterUpdate(math::Degree angle, double dt)
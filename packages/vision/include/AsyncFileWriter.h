@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/include/AsyncFileWriter.h
+ */
+
+#ifndef RAM_VISION_ASYNCFILEWRITER_H_11_04_2010
+#define RAM_VISION_ASYNCFILEWRITER_H_11_04_2010
+
+// STD Includes
+#include <string>
+#include <vector>
+#include <deque>
+
+// Library Includes
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+// Must be included last
+#include "vision/include/Export.h"
+
+namespace ram {
+namespace vision {
+
+/** Writes a file from a background thread so the caller never waits on disk
+ *
+ *  Data is copied into a fixed ring of preallocated buffers, and the writer
+ *  thread writes out whole buffers at a time, so many small records become
+ *  a few large writes.  When the writer is idle a partly filled buffer is
+ *  handed over right away, so data does not sit in memory when the disk is
+ *  keeping up.
+ *
+ *  Data is written in records (beginRecord, write..., endRecord).  A record
+ *  is either written completely or, when the ring is full because the disk
+ *  can't keep up, dropped completely by the DROP_NEWEST policy.
+ *
+ *  Only one thread may write records.
+ */
+class RAM_EXPORT AsyncFileWriter : boost::noncopyable
+{
+public:
+    /** What to do with a record when all the buffers are full */
+    enum DropPolicy
+    {
+        DROP_NEWEST, /** Drop the new record, the caller keeps going */
+        BLOCK        /** Wait for the disk, the caller stalls */
+    };
+
+    struct Options
+    {
+        Options();
+
+        /** Size of each buffer in bytes, rounded up to a multiple of 4096 */
+        size_t bufferSize;
+
+        /** Number of buffers in the ring */
+        size_t bufferCount;
+
+        /** Bypass the OS cache (O_DIRECT), ignored where not supported */
+        bool direct;
+
+        /** Bytes of disk to reserve up front, 0 for none */
+        boost::uint64_t preallocate;
+
+        DropPolicy dropPolicy;
+    };
+
+    /** Totals since the writer was created */
+    struct Stats
+    {
+        Stats();
+
+        /** Buffers waiting to be written right now */
+        size_t queueDepth;
+
+        /** Most buffers waiting at once since resetPeakQueueDepth */
+        size_t peakQueueDepth;
+
+        boost::uint64_t bytesWritten;
+
+        /** Number of write calls made to the OS */
+        boost::uint64_t writes;
+
+        /** Seconds spent in those write calls */
+        double writeTime;
+
+        /** Records dropped because the buffers were full */
+        boost::uint64_t droppedRecords;
+
+        /** Seconds the caller spent waiting for room with BLOCK */
+        double blockedTime;
+
+        /** Buffers thrown away because the OS failed to write them */
+        boost::uint64_t writeErrors;
+    };
+
+    /** Creates (or truncates) the file and starts the writer thread */
+    AsyncFileWriter(const std::string& filename,
+                    const Options& options = Options());
+
+    /** Writes out everything left and closes the file */
+    ~AsyncFileWriter();
+
+    /** Starts a record of the given total size
+     *
+     *  @param wait  Wait for room even with DROP_NEWEST, for records which
+     *               must not be lost
+     *
+     *  @return  false if the record was dropped, then write and endRecord
+     *           must not be called for it
+     */
+    bool beginRecord(size_t size, bool wait = false);
+
+    /** Copies part of the current record into the buffers */
+    void write(const void* data, size_t size);
+
+    /** Ends the current record */
+    void endRecord();
+
+    /** Waits until everything written so far has been given to the OS */
+    void flush();
+
+    /** Current statistics */
+    Stats getStats();
+
+    /** Starts peakQueueDepth over from the current queue depth */
+    void resetPeakQueueDepth();
+
+    /** True if the file is really being written with O_DIRECT */
+    bool isDirect() const;
+
+private:
+    /** A buffer waiting for the writer thread */
+    struct Pending
+    {
+        size_t buffer;
+        size_t length;
+
+        /** False when only writing out a tail which will be written again */
+        bool release;
+    };
+
+    /** Gives the current buffer's first length bytes to the writer thread
+     *
+     *  Must hold m_mutex.
+     */
+    void handOff(size_t length, bool release);
+
+    /** Hands off as much of the current buffer as can be written now */
+    void handOffPartial();
+
+    /** Body of the writer thread */
+    void writerLoop();
+
+    /** Writes out all of the given data at the given file offset
+     *
+     *  @return  false if the OS failed to write all of it
+     */
+    bool writeAt(const unsigned char* data, size_t length,
+                 boost::uint64_t offset);
+
+    int m_fd;
+    bool m_direct;
+    size_t m_bufferSize;
+    DropPolicy m_dropPolicy;
+
+    /** All buffers, aligned for O_DIRECT */
+    std::vector<unsigned char*> m_buffers;
+
+    /** Buffer the caller is filling, or -1 for none (caller's thread only) */
+    int m_current;
+
+    /** Bytes used in the current buffer (caller's thread only) */
+    size_t m_fill;
+
+    /** Protects everything below */
+    boost::mutex m_mutex;
+
+    /** Signaled when there is something for the writer thread */
+    boost::condition m_workReady;
+
+    /** Signaled when the writer thread finishes a buffer */
+    boost::condition m_workDone;
+
+    std::deque<size_t> m_free;
+    std::deque<Pending> m_queue;
+
+    /** True while the writer thread is writing a buffer */
+    bool m_writing;
+
+    /** Where the next released buffer goes in the file */
+    boost::uint64_t m_offset;
+
+    bool m_shutdown;
+    Stats m_stats;
+
+    boost::thread* m_thread;
+};
+
+} // namespace vision
+} // namespace ram
+
+#endif // RAM_VISION_ASYNCFILEWRITER_H_11_04_2010
@@ -249,6 +249,9 @@ class RAM_EXPORT BinDetector : public Detector
      *  @note Its always just a bit bigger then the raw image
      */
     unsigned char* m_scratchBuffer2;
+
+    /** Holds the lines found when calculating the bin angle */
+    CvMemStorage* m_lineStorage;
     
     /** Minimum percent for the white mask */
     int m_whiteMaskMinimumPercent;
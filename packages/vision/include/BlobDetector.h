@@ -13,9 +13,13 @@
 // STD Includes
 #include <vector>
 
+// Library Includes
+#include <boost/cstdint.hpp>
+
 // Project Includes
 #include "vision/include/Common.h"
 #include "vision/include/Detector.h"
+#include "vision/include/RegionOfInterest.h"
 
 #include "core/include/ConfigNode.h"
 
@@ -172,6 +176,15 @@ class RAM_EXPORT BlobDetector  : public Detector
     ~BlobDetector();
     
     void processImage(Image* input, Image* output= 0);
+
+    /** Only finds the blobs inside the region
+     *
+     *  Pixels outside the region are treated as background, blob
+     *  coordinates are still relative to the whole image.  The region is
+     *  clipped to the image.
+     */
+    void processImage(Image* input, const RegionOfInterest& roi,
+                      Image* output = 0);
     
     bool found();
 
@@ -189,11 +202,24 @@ class RAM_EXPORT BlobDetector  : public Detector
     /** Initializes the class */
     void init(core::ConfigNode config);
 
-    /** Build the blobs */
-    int buildBlobs(IplImage* img);
+    /** Build the blobs from the foreground pixels inside the given bounds
+     *
+     *  A pixel is foreground when its first channel is non-zero.  The image
+     *  is only read, max values are exclusive.
+     */
+    void buildBlobs(IplImage* img, int minX, int minY, int maxX, int maxY);
+
+    /** Finds the foreground runs of each row, joining touching ones */
+    void labelRuns(IplImage* img, int minX, int minY, int maxX, int maxY);
+
+    /** Returns the run which labels the set the given run is in
+     *
+     *  Every run passed on the way gets pointed closer to it.
+     */
+    int findRoot(int run);
 
-    /** Ensures that data array is large enough to hold desired pixel count */
-    void ensureDataSize(int pixels);
+    /** Merges the sets of the two runs, the earlier root wins */
+    void joinRuns(int first, int second);
     
     std::vector<Blob> m_blobs;
 
@@ -201,24 +227,36 @@ class RAM_EXPORT BlobDetector  : public Detector
     int m_minBlobSize;
     
     
-    // Data used by internal blob algorithm
-    std::vector<int> m_pixelCounts;
-    std::vector<int> m_blobTotalX;
-    std::vector<int> m_blobTotalY;
-    std::vector<int> m_blobMaxX;
-    std::vector<int> m_blobMaxY;
-    std::vector<int> m_blobMinX;
-    std::vector<int> m_blobMinY;
-
-    // For each initial blob that is created, store the index of the blob that the initial
-    // blob was merged into.
-    std::vector<unsigned int> m_joinedBlobIndex;
-
-    /** "Image" used during internal processing */
-    unsigned int* m_pixelBlobIndex;
-    
-    /** Number of pixels represetned in the data array */
-    size_t m_imageSize;
+    // Scratch space used by the labeling, kept between frames so no
+    // allocation is done once it has grown to fit the images seen
+
+    /** X of the first pixel in each run, runs are stored in raster order */
+    std::vector<int> m_runStart;
+
+    /** X of the last pixel in each run */
+    std::vector<int> m_runEnd;
+
+    /** Row of each run */
+    std::vector<int> m_runY;
+
+    /** The run each run is joined to, roots are joined to themselves */
+    std::vector<int> m_runParent;
+
+    /** Statistics for each set of runs, indexed by the root run */
+    struct BlobStats
+    {
+        void reset(size_t count);
+        
+        std::vector<int> pixels;
+        std::vector<boost::int64_t> totalX;
+        std::vector<boost::int64_t> totalY;
+        std::vector<int> minX;
+        std::vector<int> maxX;
+        std::vector<int> minY;
+        std::vector<int> maxY;
+    };
+
+    BlobStats m_stats;
 };
     
 } // namespace vision
@@ -22,6 +22,7 @@
 #include "vision/include/Color.h"
 #include "vision/include/Detector.h"
 #include "vision/include/BlobDetector.h"
+#include "vision/include/TrackingWindow.h"
 
 #include "core/include/ConfigNode.h"
 
@@ -47,8 +48,14 @@ class RAM_EXPORT BuoyDetector : public Detector
   private:
     void init(core::ConfigNode config);
 
-    /* Normal processing to find one blob/color */
+    /* Normal processing to find one blob/color, input must be BGR
+     *
+     * Only the window's region is searched when it is tracking the buoy.
+     * The filtered image is left in output when debug is set or the whole
+     * frame was searched.
+     */
     bool processColor(Image* input, Image* output, ColorFilter& filter,
+                      TrackingWindow& window, bool debug,
                       BlobDetector::Blob& outBlob);
     
     void drawBuoyDebug(Image* debugImage, BlobDetector::Blob &blob,
@@ -74,6 +81,11 @@ class RAM_EXPORT BuoyDetector : public Detector
 
     /** Blob Detector */
     BlobDetector m_blobDetector;
+
+    /** Where to search for each buoy, the red one holds the settings */
+    TrackingWindow m_redWindow;
+    TrackingWindow m_greenWindow;
+    TrackingWindow m_yellowWindow;
     
     /** Threshold for almost hitting the red light */
     double m_almostHitPercentage;
@@ -10,6 +10,9 @@
 #ifndef RAM_VISION_CAMERA_H_05_23_2007
 #define RAM_VISION_CAMERA_H_05_23_2007
 
+// Library Includes
+#include <boost/cstdint.hpp>
+
 // Project Includes
 #include "pattern/include/Subject.h"
 
@@ -38,14 +41,21 @@ public:
     /** The image available through getImage
      *
      *  <b>DO NOT</b> do a lot of work in these event handlers.  It will block
-     *  the camera capture thread.  The best usage is just to copy the given
-     *  image to an internal buffer or queue.
+     *  the camera capture thread.  The best usage is to keep the event's
+     *  FramePtr and process it later, the image must not be changed.
      */
     static const core::Event::EventType IMAGE_CAPTURED;
     
     virtual ~Camera();
+
+    /** Returns the latest frame from the camera without copying it
+     *
+     *  The frame's image is shared with every other reader so it must not
+     *  be changed.  Returns a null pointer if nothing was captured yet.
+     */
+    FramePtr getFrame();
     
-    /** Retrieves the latest image from the camera.
+    /** Retrieves a copy of the latest image from the camera.
      *
      *  @param current
      *      The current image is copied into the given image and that pointer
@@ -142,14 +152,15 @@ protected:
      */
     void cleanup();
     
-    /** Copies image to the public images release those waiting on the image
+    /** Makes a new frame from the image and releases those waiting on it
      *
-     *  This use the virtual copyToPublicImage function to perform the copy. If
-     *  you wish to optimize the copy or perform some kind of processing, that
-     *  is the function you should overload.
+     *  The image is copied once into a pooled Frame with the virtual
+     *  copyToPublic function. If you wish to optimize the copy or perform
+     *  some kind of processing, that is the function you should overload.
+     *  The frame is then shared with all readers without further copies.
      *
-     * @param newImage  This image is copied to the public image in a thread
-     *                  safe manner. The public image is accessed by getImage.
+     * @param newImage  This image is copied into the new frame, which is then
+     *                  returned by getFrame and published.
      */
     void capturedImage(Image* newImage);
 
@@ -161,11 +172,17 @@ protected:
     virtual void copyToPublic(Image* newImage, Image* publicImage);
     
 private:
-    /** Protects access to the public image */
+    /** Protects access to the latest frame */
     core::ReadWriteMutex m_imageMutex;
 
-    /** Image returned from get image*/
-    Image* m_publicImage;
+    /** Frame returned from getFrame */
+    FramePtr m_latestFrame;
+
+    /** Recycles the images of frames nobody uses anymore */
+    FramePoolPtr m_framePool;
+
+    /** Sequence number of the last captured frame */
+    boost::uint64_t m_frameSequence;
     
     /** Latch to release threads waiting on a new image */
     core::CountDownLatch m_imageLatch;
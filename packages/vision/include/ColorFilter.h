@@ -33,6 +33,26 @@ public:
 
     virtual ~ColorFilter();
 
+    /** The ways the filter can work through the pixels */
+    enum Kernel
+    {
+        /** One pixel at a time, with the range lookup tables */
+        KERNEL_SCALAR,
+        /** 16 pixels at a time, when built with SSE2 */
+        KERNEL_SSE2,
+        /** 32 pixels at a time, when built for it and the CPU has AVX2 */
+        KERNEL_AVX2
+    };
+
+    /** The fastest kernel this build can run here, the CPU is checked once */
+    static Kernel bestKernel();
+
+    /** Whether this build can run the kernel on this CPU */
+    static bool kernelSupported(Kernel kernel);
+
+    /** Uses the given kernel instead of bestKernel, it must be supported */
+    void setKernel(Kernel kernel);
+
     /** Run the Filter on the input image, debug results to output Image
      *
      *  @param input   The image to run the detector on
@@ -80,6 +100,27 @@ private:
     /** Sets the up range lookup tables based on the current highs and lows */
     void setupRanges();
 
+    /** Turns the range lookup tables into intervals for filterBlocks */
+    void setupBlockRanges();
+
+    /** Does the work of filterImage and inverseFilterImage */
+    void filter(Image* input, Image* output, bool inverse);
+    
+    /** Filters pixel by pixel, with the range lookup tables */
+    void filterPixels(unsigned char* inputData, unsigned char* outputData,
+                      int numPixels, int nChannels, bool inverse);
+
+    /** Filters 16 pixels at a time with SSE2, into 3 channel output
+     *
+     *  @return  The number of pixels filtered, the rest are left for
+     *           filterPixels.  This is 0 when built without SSE2.
+     */
+    int filterBlocks(const unsigned char* inputData, unsigned char* outputData,
+                     int numPixels, bool inverse);
+
+    /** Works out bestKernel, for use with boost::call_once */
+    static void findBestKernel();
+
     /** Gets the short name for a channel based on the name */
     std::string getShortChannelName(std::string shortName, bool isMin);
 
@@ -96,6 +137,19 @@ private:
     unsigned char m_channel1Range[256];
     unsigned char m_channel2Range[256];
     unsigned char m_channel3Range[256];
+
+    /** Whether the ranges could be turned into the intervals below */
+    bool m_blockRanges;
+
+    /** Up to two intervals per channel, repeated for 32 pixels of data
+     *
+     *  A byte passes if (value - start) <= width for either interval.
+     */
+    unsigned char m_blockStart[2][96];
+    unsigned char m_blockWidth[2][96];
+
+    /** Which kernel filter uses */
+    Kernel m_kernel;
 };
     
 } // namespace vision
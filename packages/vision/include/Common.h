@@ -22,6 +22,16 @@ typedef boost::shared_ptr<Camera> CameraPtr;
     
 class Image;
 class OpenCVImage;
+
+class Frame;
+typedef boost::shared_ptr<Frame> FramePtr;
+
+class FramePool;
+typedef boost::shared_ptr<FramePool> FramePoolPtr;
+
+class ImageCache;
+class ImagePool;
+
 class OpenCVCamera;
 class Calibration;
 class Recorder;
@@ -47,4 +57,7 @@ typedef struct _IplImage IplImage;
 struct CvVideoWriter;
 typedef struct CvVideoWriter CvVideoWriter;
 
+struct CvMemStorage;
+typedef struct CvMemStorage CvMemStorage;
+
 #endif // RAM_VISION_COMMON_H_05_29_2007
@@ -14,6 +14,7 @@
 #include "core/include/Forward.h"
 #include "core/include/EventPublisher.h"
 #include "vision/include/Common.h"
+#include "vision/include/ImageCache.h"
 
 // Must be incldued last
 #include "vision/include/Export.h"
@@ -33,11 +34,22 @@ class RAM_EXPORT Detector : public core::EventPublisher
 public:
     /** Run the detector on the input image, debug results to output Image
      *
-     *  @param input   The image to run the detector on
+     *  @param input   The image to run the detector on, this is usually the
+     *                 camera's shared Frame so it must not be modified
+     *                 (copy it to a working image first)
      *  @param output  Debug image will be copied to this image
      */
     virtual void processImage(Image* input, Image* output = 0) = 0;
 
+    /** Lets processImage share derived images of its input with others
+     *
+     *  Set by the VisionRunner around each processImage call, with the
+     *  cache for the frame it is passing in.
+     *
+     *  @param cache  Cache whose source is the next input, null for none
+     */
+    void setImageCache(ImageCache* cache);
+
     /** Get the set of properties for this object */
     virtual core::PropertySetPtr getPropertySet();
 
@@ -62,12 +74,28 @@ public:
 				     const int& imageX, const int& imageY,
 				     double& outX, double& outY);
     
+    virtual ~Detector();
+
 protected:
     Detector(core::EventHubPtr eventHub = core::EventHubPtr());
 
+    /** Returns the input converted to the given color space or size
+     *
+     *  When the input is the frame of the current image cache this is
+     *  computed only once for all detectors, otherwise it is computed on
+     *  every call.  The result is read only, copy it before changing it.
+     */
+    Image* getDerivedImage(Image* input, ImageCache::Derivation which);
+
 private:
     /** Holds all the properties for this detector */
     core::PropertySetPtr m_propertySet;
+
+    /** Set by setImageCache, null when there is none */
+    ImageCache* m_imageCache;
+
+    /** Used when the input is not from m_imageCache, created on demand */
+    ImageCache* m_localCache;
 };
     
 } // namespace vision
@@ -10,6 +10,9 @@
 #ifndef RAM_VISION_EVENTS_01_08_2008
 #define RAM_VISION_EVENTS_01_08_2008
 
+// STD Includes
+#include <string>
+
 // Project Includes
 #include "vision/include/Common.h"
 #include "vision/include/Symbol.h"
@@ -89,10 +92,17 @@ public:
     ImageEvent(Image* image_)
         {image = image_;}
 
+    /** Shares the frame, image points at the frame's image */
+    ImageEvent(FramePtr frame_);
+
     ImageEvent() : image(0) {}
 
+    /** Read only, it is shared with everyone else listening */
     Image* image;
 
+    /** The frame holding image, null if the event was not from a Camera */
+    FramePtr frame;
+
     virtual core::EventPtr clone();
 };
 
@@ -368,6 +378,81 @@ class RAM_EXPORT HedgeEvent : public core::Event
 
 typedef boost::shared_ptr<HedgeEvent> HedgeEventPtr;
 
+/** Processing time of one detector in a VisionRunner over the last second
+ *
+ *  All times are in seconds.
+ */
+class RAM_EXPORT DetectorTimingEvent : public core::Event
+{
+  public:
+    DetectorTimingEvent() :
+        frames(0),
+        droppedFrames(0),
+        minTime(0),
+        meanTime(0),
+        maxTime(0)
+    {
+    }
+
+    /** Class name of the detector */
+    std::string detector;
+
+    /** Number of frames the detector processed */
+    int frames;
+
+    /** Camera frames the runner skipped because it was still busy */
+    int droppedFrames;
+
+    double minTime;
+    double meanTime;
+    double maxTime;
+
+    virtual core::EventPtr clone();
+};
+
+typedef boost::shared_ptr<DetectorTimingEvent> DetectorTimingEventPtr;
+
+/** How well a RawFileRecorder's disk writes kept up over the last second
+ *
+ *  Rates are per second, times are in seconds.
+ */
+class RAM_EXPORT RecorderWriteEvent : public core::Event
+{
+  public:
+    RecorderWriteEvent() :
+        queueDepth(0),
+        peakQueueDepth(0),
+        bytesPerSecond(0),
+        writesPerSecond(0),
+        writeTime(0),
+        droppedFrames(0),
+        blockedTime(0)
+    {
+    }
+
+    /** Buffers waiting to be written when the event was sent */
+    int queueDepth;
+
+    /** Most buffers waiting at once */
+    int peakQueueDepth;
+
+    double bytesPerSecond;
+    double writesPerSecond;
+
+    /** Time the writer thread spent in the OS write calls */
+    double writeTime;
+
+    /** Frames dropped because the write buffers were full */
+    int droppedFrames;
+
+    /** Time the recorder waited for buffers to free up */
+    double blockedTime;
+
+    virtual core::EventPtr clone();
+};
+
+typedef boost::shared_ptr<RecorderWriteEvent> RecorderWriteEventPtr;
+
 
 } // namespace vision
 } // namespace ram
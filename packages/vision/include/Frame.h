@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/include/Frame.h
+ */
+
+#ifndef RAM_VISION_FRAME_H_10_17_2010
+#define RAM_VISION_FRAME_H_10_17_2010
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/utility.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Project Includes
+#include "vision/include/Common.h"
+
+// Must Be Included last
+#include "vision/include/Export.h"
+
+namespace ram {
+namespace vision {
+
+/** A captured camera image, shared by everyone who reads it
+ *
+ *  Cameras hand out the same Frame to every reader through a FramePtr, once
+ *  the last reader lets go of it the image goes back to the FramePool it
+ *  came from to be reused.  The image of a published frame must be treated
+ *  as read only, copy it first if you need to change it.
+ */
+class RAM_EXPORT Frame : boost::noncopyable
+{
+public:
+    /** The image data of the frame */
+    Image* getImage() const;
+
+    /** Increases by one for each frame captured by a camera, starting at 1
+     *
+     *  A jump of more than one means frames were dropped, the same number
+     *  twice means the same frame was seen twice.
+     */
+    boost::uint64_t getSequence() const;
+
+    /** The core::TimeVal::clockTime() when the frame was captured */
+    double getTimeStamp() const;
+
+    /** Sets the sequence number and time stamp, before the frame is shared */
+    void setCaptureInfo(boost::uint64_t sequence, double timeStamp);
+
+private:
+    friend class FramePool;
+
+    /** Takes ownership of the image */
+    Frame(Image* image);
+    ~Frame();
+
+    Image* m_image;
+    boost::uint64_t m_sequence;
+    double m_timeStamp;
+};
+
+/** Recycles the image buffers of Frames
+ *
+ *  Frames released by their last reader are kept for the next acquire,
+ *  instead of allocating a new image for every capture.  The pool stays
+ *  alive until every frame it handed out is released.
+ */
+class RAM_EXPORT FramePool : public boost::enable_shared_from_this<FramePool>,
+                             boost::noncopyable
+{
+public:
+    static const size_t DEFAULT_MAX_FREE = 8;
+
+    /** Creates a pool, which keeps at most maxFree unused frames */
+    static FramePoolPtr create(size_t maxFree = DEFAULT_MAX_FREE);
+
+    ~FramePool();
+
+    /** Returns an unused frame, reusing a released one when possible
+     *
+     *  The image is width by height, so copying a camera image of that size
+     *  into it with copyFrom does not reallocate.  Released frames of
+     *  another size are freed instead of reused.
+     */
+    FramePtr acquire(size_t width, size_t height);
+
+    /** Number of frames created by the pool still in existence */
+    size_t getFrameCount();
+
+    /** Number of released frames waiting to be reused */
+    size_t getFreeCount();
+
+private:
+    FramePool(size_t maxFree);
+
+    /** Called when the last reference to a frame goes away */
+    void release(Frame* frame);
+
+    /** Deleter for FramePtr which returns the frame to the pool */
+    struct Releaser
+    {
+        Releaser(FramePoolPtr pool_) : pool(pool_) {}
+        void operator()(Frame* frame) { pool->release(frame); }
+        FramePoolPtr pool;
+    };
+
+    /** Protects all members below */
+    boost::mutex m_mutex;
+
+    /** Released frames ready for reuse */
+    std::vector<Frame*> m_free;
+
+    size_t m_maxFree;
+
+    size_t m_frameCount;
+};
+
+} // namespace vision
+} // namespace ram
+
+#endif // RAM_VISION_FRAME_H_10_17_2010
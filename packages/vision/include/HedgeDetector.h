@@ -50,7 +50,7 @@ class RAM_EXPORT HedgeDetector : public Detector
   private:
     void init(core::ConfigNode config);
 
-    /* Normal processing to find one blob/color */
+    /* Normal processing to find one blob/color, input must be LCh */
     bool processColor(Image* input, Image* output,
                       ColorFilter& filter,
                       BlobDetector::Blob& leftBlob,
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/include/ImageCache.h
+ */
+
+#ifndef RAM_VISION_IMAGECACHE_H_10_17_2010
+#define RAM_VISION_IMAGECACHE_H_10_17_2010
+
+// Library Includes
+#include <boost/utility.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Project Includes
+#include "vision/include/Common.h"
+#include "vision/include/Image.h"
+
+// Must Be Included last
+#include "vision/include/Export.h"
+
+namespace ram {
+namespace vision {
+
+/** Images derived from a single source image, each computed only once
+ *
+ *  The VisionRunner keeps one of these for the frame it is processing, so
+ *  when several detectors want the frame in the same color space it is only
+ *  converted by the first one to ask.  Derived images are computed on first
+ *  request and may be requested from several threads at once.  They are
+ *  shared, so they must be treated as read only.
+ */
+class RAM_EXPORT ImageCache : boost::noncopyable
+{
+public:
+    enum Derivation
+    {
+        GRAY,    /** PF_GRAY_8 */
+        LUV,     /** PF_LUV_8 */
+        LCHUV,   /** PF_LCHUV_8 */
+        HSV,     /** PF_HSV_8 */
+        HALF,    /** Source format, half the width and height */
+        QUARTER, /** Source format, a quarter of the width and height */
+        DERIVATION_COUNT /** Sentinal Value */
+    };
+
+    ImageCache();
+    ~ImageCache();
+
+    /** Start deriving from a new source image, which must be BGR
+     *
+     *  This forgets every derived image, but keeps their buffers for reuse.
+     *  It must not be called while another thread is in get().
+     */
+    void setSource(Image* source);
+
+    /** The image everything is derived from, null if none */
+    Image* getSource() const;
+
+    /** Returns the derived image, computing it if this is the first request
+     *
+     *  The returned image stays valid until the next setSource.
+     */
+    Image* get(Derivation which);
+
+    /** Number of derived images computed since creation */
+    size_t getComputeCount();
+
+private:
+    /** Computes the given derived image from the source into m_images */
+    void derive(Derivation which);
+
+    /** Makes sure the buffer for which has the given size and format */
+    Image* buffer(Derivation which, size_t width, size_t height,
+                  Image::PixelFormat format);
+
+    Image* m_source;
+
+    /** Guards the computation of each derived image */
+    boost::mutex m_mutexes[DERIVATION_COUNT];
+
+    /** Buffers for the derived images, null until first needed */
+    Image* m_images[DERIVATION_COUNT];
+
+    /** Whether the derived image is computed for the current source */
+    bool m_valid[DERIVATION_COUNT];
+
+    /** Protects m_computeCount */
+    boost::mutex m_countMutex;
+
+    size_t m_computeCount;
+};
+
+} // namespace vision
+} // namespace ram
+
+#endif // RAM_VISION_IMAGECACHE_H_10_17_2010
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/include/ImagePool.h
+ */
+
+#ifndef RAM_VISION_IMAGEPOOL_H_10_24_2010
+#define RAM_VISION_IMAGEPOOL_H_10_24_2010
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/utility.hpp>
+#include <boost/thread/mutex.hpp>
+
+// Project Includes
+#include "vision/include/Common.h"
+#include "vision/include/Image.h"
+
+// Must Be Included last
+#include "vision/include/Export.h"
+
+namespace ram {
+namespace vision {
+
+/** Recycles scratch images between frames
+ *
+ *  Code which needs a working image only while it handles one frame
+ *  acquires it here and releases it when done, released images are handed
+ *  out again for the next acquire with the same width, height and pixel
+ *  format.  Once every size in use has been seen no more images are
+ *  allocated.  All methods are thread safe.
+ *
+ *  Images kept from frame to frame stay members of their detector, and
+ *  cameras recycle whole frames through FramePool instead.
+ */
+class RAM_EXPORT ImagePool : boost::noncopyable
+{
+public:
+    static const size_t DEFAULT_MAX_FREE = 32;
+
+    /** Allocation statistics of a pool */
+    struct Stats
+    {
+        /** Calls to acquire */
+        size_t acquires;
+        
+        /** Images created because no free one matched */
+        size_t allocations;
+
+        /** Images deleted because too many were free */
+        size_t discards;
+
+        /** Images acquired but not yet released */
+        size_t outstanding;
+
+        /** Released images waiting to be reused */
+        size_t free;
+    };
+
+    /** Holds an image from the pool until the end of the scope */
+    class RAM_EXPORT Scoped : boost::noncopyable
+    {
+    public:
+        Scoped(ImagePool* pool, size_t width, size_t height,
+               Image::PixelFormat fmt = Image::PF_BGR_8);
+        ~Scoped();
+
+        Image* get() const { return m_image; }
+        Image* operator->() const { return m_image; }
+
+    private:
+        ImagePool* m_pool;
+        Image* m_image;
+    };
+    
+    /** Creates a pool which keeps at most maxFree unused images */
+    ImagePool(size_t maxFree = DEFAULT_MAX_FREE);
+
+    /** All acquired images must be released first */
+    ~ImagePool();
+
+    /** The pool shared by all cameras and detectors */
+    static ImagePool* getDefault();
+
+    /** Returns an image of the given size and format
+     *
+     *  The contents are left over from its last user.  The image must be
+     *  given back with release, and must not be resized while held.
+     */
+    Image* acquire(size_t width, size_t height,
+                   Image::PixelFormat fmt = Image::PF_BGR_8);
+
+    /** Gives an image from acquire back to the pool */
+    void release(Image* image);
+
+    /** Deletes all of the free images */
+    void clear();
+    
+    Stats getStats();
+
+private:
+    /** Protects all members below */
+    boost::mutex m_mutex;
+
+    /** Released images, the most recently released last */
+    std::vector<Image*> m_free;
+
+    size_t m_maxFree;
+
+    Stats m_stats;
+};
+
+} // namespace vision
+} // namespace ram
+
+#endif // RAM_VISION_IMAGEPOOL_H_10_24_2010
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/include/ImageStream.h
+ */
+
+#ifndef RAM_VISION_IMAGESTREAM_H_11_02_2010
+#define RAM_VISION_IMAGESTREAM_H_11_02_2010
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp>
+
+// Project Includes
+#include "vision/include/Common.h"
+
+// Must be included last
+#include "vision/include/Export.h"
+
+namespace ram {
+namespace vision {
+
+/** The wire format used between NetworkRecorder and NetworkCamera
+ *
+ *  A client connects once and sends a Request with the size and codec it
+ *  wants.  From then on the recorder sends every new frame it has, each
+ *  a FrameHeader followed by header.size bytes of image data.  All the
+ *  fields are fixed size and sent in network (big endian) byte order.
+ *
+ *  Request (REQUEST_SIZE bytes):
+ *    uint32 magic "RAMS", uint8 version, uint8 codec, uint8 quality,
+ *    uint8 reserved, uint16 width, uint16 height
+ *
+ *  FrameHeader (HEADER_SIZE bytes):
+ *    uint32 magic "RAMF", uint32 sequence, uint16 width, uint16 height,
+ *    uint8 codec, 3 reserved bytes, uint32 size
+ *
+ *  An instance holds the buffers used to encode or decode, so each
+ *  connection should have its own.  RawFileRecorder and RawFileCamera use
+ *  encode and decode to compress .rmv frames as well.
+ */
+class RAM_EXPORT ImageStream : boost::noncopyable
+{
+public:
+    enum Codec
+    {
+        RAW = 0,     /** Uncompressed BGR rows */
+        JPEG = 1,    /** Lossy, the smallest, uses Request::quality */
+        QUICKLZ = 2, /** Lossless and fast, works well on simple scenes */
+        CODEC_END    /** Sentinal Value */
+    };
+
+    static const boost::uint8_t VERSION = 1;
+    static const size_t REQUEST_SIZE = 12;
+    static const size_t HEADER_SIZE = 20;
+
+    /** Sent once by the client to start the stream */
+    struct Request
+    {
+        Request();
+
+        /** Wanted size, 0 for the size the recorder records at
+         *
+         *  The recorder only scales down, it closes the connection on a
+         *  request bigger than what it records.
+         */
+        boost::uint16_t width;
+        boost::uint16_t height;
+
+        Codec codec;
+
+        /** JPEG quality from 1 to 100, 0 for the default */
+        int quality;
+    };
+
+    /** Sent before each frame */
+    struct FrameHeader
+    {
+        FrameHeader();
+
+        /** Counts up by one for each frame the recorder records */
+        boost::uint32_t sequence;
+        boost::uint16_t width;
+        boost::uint16_t height;
+        Codec codec;
+
+        /** Bytes of image data after the header */
+        boost::uint32_t size;
+    };
+
+    ImageStream();
+    ~ImageStream();
+
+    static void packRequest(const Request& request, unsigned char* buffer);
+
+    /** Returns false if the buffer does not hold a valid request */
+    static bool unpackRequest(const unsigned char* buffer, Request& request);
+
+    static void packHeader(const FrameHeader& header, unsigned char* buffer);
+
+    /** Returns false if the buffer does not hold a valid header */
+    static bool unpackHeader(const unsigned char* buffer, FrameHeader& header);
+
+    /** Encodes a BGR image
+     *
+     *  @return  The data to send, valid until the next encode
+     */
+    const std::vector<unsigned char>& encode(Image* image, Codec codec,
+                                             int quality = 0);
+
+    /** Decodes the data sent after the given header
+     *
+     *  @return  A BGR image valid until the next decode, or null if the data
+     *           was bad
+     */
+    Image* decode(const FrameHeader& header,
+                  const std::vector<unsigned char>& data);
+
+private:
+    /** Returns m_image at the given size, reusing it when it fits */
+    Image* decodeImage(int width, int height);
+
+    std::vector<unsigned char> m_data;
+    std::vector<unsigned char> m_raw;
+    std::vector<char> m_scratch;
+    Image* m_image;
+};
+
+} // namespace vision
+} // namespace ram
+
+#endif // RAM_VISION_IMAGESTREAM_H_11_02_2010
@@ -7,6 +7,9 @@
  * File:  packages/vision/include/Convert.h
  */
 
+// Library Includes
+#include <boost/thread/once.hpp>
+
 // Project Includes
 #include "math/include/Matrix3.h"
 #include "vision/include/Image.h"
@@ -25,10 +28,18 @@ public:
                              unsigned char &g,
                              unsigned char &b);
 
+    // The exact full size lookup table, only used by the LCHLookupTable tool
     static void createLookupTable(bool verbose = false);
     static void saveLookupTable(const char *);
     static bool loadLookupTable();
 
+    // Converts count packed RGB pixels in place, exactly like convertPixel.
+    // Takes the gamma curve from a 256 entry table and works on blocks of
+    // pixels a step at a time, so everything but pow and atan2 vectorizes.
+    static void convertPixels(unsigned char* data, size_t count);
+
+    // Converts an RGB image in place, exactly like convertPixel.  Uses the
+    // full lookup table when it can be loaded, otherwise convertPixels.
     static void convert(vision::Image* image);
 
 private:
@@ -63,10 +74,26 @@ private:
     static void lab2lch_ab(double *l2l, double *a2c, double *b2h);
     static void luv2lch_uv(double *l2l, double *a2c, double *b2h);
 
+    // Tries loadLookupTable, for use with boost::call_once
+    static void loadLookupTableOnce();
+
+    // Fills in gammaTable, for use with boost::call_once
+    static void createGammaTable();
+
+    // Pixels convertPixels takes through each step at once
+    static const size_t BLOCK_SIZE = 64;
+
+    // invGammaCorrection of each channel value, scaled to [0, 1]
+    static double gammaTable[256];
+
+    static boost::once_flag gammaInit;
+
     static unsigned char rgb2lchLookup[256][256][256][3];
 
     static bool lookupInit;
 
+    static boost::once_flag lookupLoad;
+
     LCHConverter() {};
 
     LCHConverter(const LCHConverter& c) {};
@@ -12,6 +12,7 @@
 
 // STD Includes
 #include <string>
+#include <vector>
 
 // Library Includes
 #include <boost/asio.hpp>
@@ -19,22 +20,35 @@
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 
-// Compression
-#include "quicklz.h"
-
 // Project Includes
 #include "vision/include/Common.h"
 #include "vision/include/Camera.h"
+#include "vision/include/ImageStream.h"
 #include "vision/include/Export.h"
 
 namespace ram {
 namespace vision {
     
+/** Receives the images streamed by a NetworkRecorder
+ *
+ *  The connection is made on the first update and kept open, each update
+ *  then waits for the next image the recorder sends.  If the connection
+ *  drops it is remade on the following update.
+ */
 class RAM_EXPORT NetworkCamera : public Camera
 {
 public:
-    /** Creates a camera which read dad from the given host the given port */
-    NetworkCamera(std::string hostname, boost::uint16_t port);
+    /** Creates a camera which read dad from the given host the given port
+     *
+     *  @param width    Width to ask the recorder for, 0 for its own
+     *  @param height   Height to ask the recorder for, 0 for its own
+     *  @param codec    How the recorder should compress the images
+     *  @param quality  JPEG quality from 1 to 100, 0 for the default
+     */
+    NetworkCamera(std::string hostname, boost::uint16_t port,
+                  int width = 160, int height = 120,
+                  ImageStream::Codec codec = ImageStream::JPEG,
+                  int quality = 0);
     
     virtual ~NetworkCamera();
 
@@ -53,16 +67,36 @@ public:
 
     virtual double currentTime();
 
+    /** Frames the recorder skipped because this camera fell behind */
+    boost::uint32_t droppedFrames();
+
 private:
+    /** Connects and sends the request, returns false on failure */
+    bool connect();
+
+    /** Closes the connection so the next update reconnects */
+    void disconnect();
+
     boost::asio::io_service io_service;
 
     std::string m_hostname;
     std::string m_port;
     boost::asio::ip::tcp::endpoint m_endpoint;
 
+    boost::asio::ip::tcp::socket m_socket;
+    bool m_connected;
+
+    ImageStream::Request m_request;
+    ImageStream m_stream;
+    std::vector<unsigned char> m_data;
+
+    /** Sequence number of the last frame received, 0 for none */
+    boost::uint32_t m_lastSequence;
+
     boost::mutex m_diagLock;
     size_t m_width;
     size_t m_height;
+    boost::uint32_t m_droppedFrames;
 };
 
 } // namespace vision
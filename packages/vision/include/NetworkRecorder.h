@@ -10,6 +10,9 @@
 #ifndef RAM_NETWORKRECORDER_H_02_25_2008
 #define RAM_NETWORKRECORDER_H_02_25_2008
 
+// STD Includes
+#include <set>
+
 // Library Includes
 #include <boost/asio.hpp>
 #include <boost/cstdint.hpp>
@@ -19,6 +22,7 @@
 
 // Project Includes
 #include "vision/include/Recorder.h"
+#include "vision/include/ImageStream.h"
 
 // Must be included last
 #include "vision/include/Export.h"
@@ -26,7 +30,14 @@
 namespace ram {
 namespace vision {
     
-/** Sends data from the given camera over the network */
+/** Streams images from the given camera to NetworkCameras over TCP
+ *
+ *  Clients connect once and say what size and codec they want (see
+ *  ImageStream), then get every frame recorded after that over the same
+ *  connection.  Each client has at most one frame being sent at a time, if
+ *  a client falls behind it skips to the newest frame instead of queueing
+ *  up old ones.
+ */
 class RAM_EXPORT NetworkRecorder : public Recorder
 {
   public:
@@ -36,6 +47,9 @@ class RAM_EXPORT NetworkRecorder : public Recorder
                     int recordWidth = 640, int recordHeight = 480);
 
     virtual ~NetworkRecorder();
+
+    /** Number of clients currently receiving images */
+    size_t getClientCount();
     
   protected:
     /** Called whenever there is a frame to record, sends data over network */
@@ -47,16 +61,44 @@ class RAM_EXPORT NetworkRecorder : public Recorder
     public:
         typedef boost::shared_ptr<Connection> pointer;
 
-        static pointer create(boost::asio::io_service& io);
+        static pointer create(boost::asio::io_service& io,
+                              NetworkRecorder* recorder);
+
+        ~Connection();
 
-        void sendImage(Image *img);
+        /** Waits for the client's request */
+        void start();
+
+        /** Sends the newest frame, unless one is still being sent */
+        void sendLatest();
 
         boost::asio::ip::tcp::socket& socket();
 
     private:
-        Connection(boost::asio::io_service& io);
+        Connection(boost::asio::io_service& io, NetworkRecorder* recorder);
+
+        void handleRequest(const boost::system::error_code& error);
+        void handleWrite(const boost::system::error_code& error);
+
+        /** Stops sending to this client */
+        void close();
 
         boost::asio::ip::tcp::socket m_socket;
+        NetworkRecorder* m_recorder;
+
+        unsigned char m_requestBuffer[ImageStream::REQUEST_SIZE];
+        ImageStream::Request m_request;
+
+        /** True from the start of a frame's write until it completes */
+        bool m_writing;
+
+        /** Sequence number of the last frame sent, 0 for none */
+        boost::uint32_t m_lastSequence;
+
+        unsigned char m_headerBuffer[ImageStream::HEADER_SIZE];
+        ImageStream m_stream;
+        Image* m_frame;
+        Image* m_scaled;
     };
 
     void run_service()
@@ -68,14 +110,35 @@ class RAM_EXPORT NetworkRecorder : public Recorder
     void handle_accept(Connection::pointer new_connection,
                        const boost::system::error_code& error);
 
+    /** Copies the newest frame if it is newer than the given sequence
+     *
+     *  @return  false when there is no newer frame
+     */
+    bool latestFrame(boost::uint32_t& sequence, Image* image);
+
+    /** Called on the network thread after each recorded frame */
+    void sendToClients();
+
+    void addClient(Connection::pointer client);
+    void removeClient(Connection::pointer client);
+
     boost::asio::io_service io_service;
 
     boost::asio::ip::tcp::acceptor m_acceptor;
     
-    /** Holds the width, height, and data size of the last image sent */
+    /** Protects m_buffer and m_sequence */
     boost::mutex m_lock;
+
+    /** The last image recorded */
     Image *m_buffer;
 
+    /** Sequence number of m_buffer, 0 before the first frame */
+    boost::uint32_t m_sequence;
+
+    /** Protects m_clients, which is only changed on the network thread */
+    boost::mutex m_clientLock;
+    std::set<Connection::pointer> m_clients;
+
     boost::thread *m_bthread;
 };
     
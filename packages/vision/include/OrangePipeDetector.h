@@ -93,6 +93,9 @@ class RAM_EXPORT OrangePipeDetector  : public PipeDetector
 
     /** The set of IDs of the pipes that were present in the last frame */
     std::set<int> m_lastPipeIds;
+
+    /** Working copy of the input image, the input is shared read only */
+    Image* m_working;
 };
     
 } // namespace vision
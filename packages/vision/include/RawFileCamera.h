@@ -10,8 +10,18 @@
 #ifndef RAM_VISION_RAWFILECAMERA_H_06_11_2009
 #define RAM_VISION_RAWFILECAMERA_H_06_11_2009
 
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
 // Project Includes
 #include "vision/include/Camera.h"
+#include "vision/include/RawFileRecorder.h"
+#include "vision/include/ImageStream.h"
 
 // Must be included last
 #include "vision/include/Export.h"
@@ -19,7 +29,13 @@
 namespace ram {
 namespace vision {
 
-/** Captures images from firewire cameras using the libdc1394 library */
+/** Plays back .rmv files made by RawFileRecorder
+ *
+ *  Compressed files are read through their frame index, which is mapped
+ *  into memory, so seeking is a search of the index instead of the file.
+ *  A background thread reads and decodes the next frame while the current
+ *  one is used.
+ */
 class RAM_EXPORT RawFileCamera : public Camera
 {
 public:
@@ -49,8 +65,31 @@ public:
      * @param frame The frame to jump to.
      */
     void seekTo(int frame);
+
+    /** Number of frames in the file, only known for compressed files */
+    size_t frameCount();
+
+    /** Frames of a compressed file skipped because they were corrupt */
+    size_t corruptFrames();
     
 private:
+    /** Maps the trailing index of a compressed file, or scans the packets
+     *  when it is missing because the recording was cut short
+     */
+    void loadIndex(const RawFileRecorder::Header& header);
+
+    /** Body of the thread decoding compressed frames ahead */
+    void decodeLoop();
+
+    /** Reads and decodes one frame of a compressed file into m_backImage
+     *
+     *  @return  False if the frame could not be read or decoded
+     */
+    bool decodeFrame(size_t frame);
+
+    /** Hands out the next decoded frame of a compressed file */
+    void updateIndexed();
+
     /** Read the next frame from the video file
      *
      *  @param hurryUp
@@ -82,11 +121,63 @@ private:
     /** Size of the raw data buffer */
     size_t m_dataBufferSize;
 
+    /** Wraps m_dataBuffer, made on first use after the buffer changes */
+    Image* m_image;
+
     int m_file;
 
     /** The size of the underlying file */
     int m_fileSize;
     //FILE* m_file;
+
+    /** True for compressed files with an index */
+    bool m_indexed;
+
+    /** Codec of the frames in a compressed file */
+    ImageStream::Codec m_codec;
+
+    /** Index of every frame, points into m_map or m_scannedIndex */
+    const RawFileRecorder::IndexEntry* m_index;
+
+    size_t m_frameCount;
+
+    /** Memory mapped part of the file holding the index */
+    void* m_map;
+    size_t m_mapSize;
+
+    /** Index built by scanning a file without one */
+    std::vector<RawFileRecorder::IndexEntry> m_scannedIndex;
+
+    /** Decoder thread only, reads and decodes the frames */
+    ImageStream m_stream;
+    std::vector<unsigned char> m_packetData;
+
+    /** The next frame the decoder produces, swapped with m_image */
+    Image* m_backImage;
+
+    boost::thread* m_decoder;
+
+    /** Protects the members below */
+    boost::mutex m_decodeMutex;
+
+    /** Signaled when m_readyFrame is set */
+    boost::condition m_decodeReady;
+
+    /** Signaled when the decoder should start on m_nextFrame */
+    boost::condition m_decodeWanted;
+
+    /** Frame the next update hands out */
+    size_t m_nextFrame;
+
+    /** Frame decoded into m_backImage, -1 when none */
+    int m_readyFrame;
+
+    /** False when m_readyFrame was corrupt and m_backImage is unchanged */
+    bool m_readyGood;
+
+    size_t m_corruptFrames;
+
+    bool m_shutdown;
 };
 
 } // namespace vision
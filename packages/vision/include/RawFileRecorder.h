@@ -10,8 +10,15 @@
 #ifndef RAM_RAWFILERECORDER_H_06_11_2009
 #define RAM_RAWFILERECORDER_H_06_11_2009
 
+// STD Includes
+#include <vector>
+
 // Project Includes
 #include "vision/include/Recorder.h"
+#include "vision/include/AsyncFileWriter.h"
+#include "vision/include/ImageStream.h"
+
+#include "core/include/EventPublisher.h"
 
 // Boost Includes
 #include <boost/cstdint.hpp>
@@ -22,12 +29,30 @@
 namespace ram {
 namespace vision {
 
-class RAM_EXPORT RawFileRecorder : public Recorder
+/** Records frames to an .rmv file
+ *
+ *  The file is a Header followed by a Packet and its data for each frame.
+ *  Uncompressed files (RMV_VERSION) have fixed size packets.  Compressed
+ *  files (RMV_INDEXED_VERSION) give the codec in the header, each frame is
+ *  compressed with ImageStream, and the file ends with an IndexEntry for
+ *  every frame followed by a Trailer, so readers can seek without scanning.
+ *
+ *  The frames are handed to an AsyncFileWriter, so the recorder thread only
+ *  copies them and never waits on the disk.  If the disk falls far enough
+ *  behind to fill all the write buffers, whole frames are dropped (or the
+ *  recorder waits, depending on the writer options).
+ */
+class RAM_EXPORT RawFileRecorder : public Recorder, public core::EventPublisher
 {
  
   public:
+    /** Published about once a second with a RecorderWriteEvent */
+    static const core::Event::EventType WRITE_STATS;
+
     static const boost::uint32_t MAGIC_NUMBER;
     static const boost::uint32_t RMV_VERSION;
+    static const boost::uint32_t RMV_INDEXED_VERSION;
+    static const boost::uint32_t INDEX_MAGIC_NUMBER;
     
     struct Header
     {
@@ -48,7 +73,8 @@ class RAM_EXPORT RawFileRecorder : public Recorder
         
         // Here to allow room for expansion
         double unusedDouble;
-        boost::uint32_t unusedInt1;
+        /** ImageStream::Codec of the packet data (RMV_INDEXED_VERSION) */
+        boost::uint32_t codec;
         boost::uint32_t unusedInt2;
     };
 
@@ -62,33 +88,95 @@ class RAM_EXPORT RawFileRecorder : public Recorder
         boost::uint32_t framenum;
         /** The size of the frame data coming next */
         boost::uint32_t dataSize;
+        /** Seconds since the first frame was recorded */
+        double timestamp;
 
         // Here to allow room for expansion
-        double unusedDouble;
         boost::uint32_t unusedInt1;
         boost::uint32_t unusedInt2;
     };
 
+    /** Where to find one frame of a RMV_INDEXED_VERSION file */
+    struct IndexEntry
+    {
+        /** File offset of the frame's Packet */
+        boost::uint64_t offset;
+        /** Same as the Packet's */
+        double timestamp;
+        boost::uint32_t framenum;
+        boost::uint32_t dataSize;
+    };
+
+    /** The very end of a RMV_INDEXED_VERSION file */
+    struct Trailer
+    {
+        boost::uint32_t magicNumber;
+        /** Number of IndexEntry's */
+        boost::uint32_t frameCount;
+        /** File offset of the first IndexEntry */
+        boost::uint64_t indexOffset;
+    };
+
     
     RawFileRecorder(Camera* camera, Recorder::RecordingPolicy policy,
                     std::string rawfilename, int policyArg = 0,
-                    int recordWidth = 640, int recordHeight = 480);
+                    int recordWidth = 640, int recordHeight = 480,
+                    ImageStream::Codec codec = ImageStream::RAW,
+                    AsyncFileWriter::Options options =
+                    AsyncFileWriter::Options(),
+                    core::EventHubPtr eventHub = core::EventHubPtr());
 
     virtual ~RawFileRecorder();
 
+    /** Waits until every frame recorded so far is written to the file */
+    void flush();
+
+    /** Statistics of the background writer */
+    AsyncFileWriter::Stats getWriterStats();
+
   protected:
     /** Called whenever there is a frame to record, records to disk */
     virtual void recordFrame(Image* image);
     
   private:
-    /** File we are writing our data to */
-    FILE* m_file;
+    /** Publishes the write statistics once a second */
+    void publishStats();
+
+    /** Writes a record which must not be dropped */
+    void writeRecord(const void* data, size_t size);
+
+    /** Writes the index and trailer of a compressed file */
+    void writeIndex();
+
+    /** Writes our data to the file in the background */
+    AsyncFileWriter* m_writer;
 
     /** Current frame we are writing to disk */
     boost::uint32_t m_framenum;
 
     /** The total size of the last packet written (header and data) */
     boost::uint32_t m_lastPacketSizeWritten;
+
+    /** When the last statistics were published */
+    boost::int64_t m_reportStart;
+
+    /** Writer statistics as of the last report */
+    AsyncFileWriter::Stats m_reportStats;
+
+    /** How frames are stored, RAW means the uncompressed format */
+    ImageStream::Codec m_codec;
+
+    /** Compresses the frames */
+    ImageStream m_stream;
+
+    /** When the first frame was recorded, -1 before then */
+    boost::int64_t m_startTime;
+
+    /** File offset of the next record written */
+    boost::uint64_t m_position;
+
+    /** Every frame written to a compressed file */
+    std::vector<IndexEntry> m_index;
 };
     
 } // namespace vision
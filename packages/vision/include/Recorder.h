@@ -17,6 +17,7 @@
 
 // Library Includes
 #include <boost/thread/mutex.hpp>
+#include <boost/cstdint.hpp>
 
 // Project Includes
 #include "vision/include/Common.h"
@@ -63,7 +64,7 @@ class RAM_EXPORT Recorder : public core::Updatable
 
     virtual void update(double timestep);
 
-    /** Starts the background process thread, clear m_newFrame flag */
+    /** Starts the background process thread, drops any pending frame */
     virtual void background(int interval = -1);
 
     /** Width of image we are recording in pixels */
@@ -72,16 +73,37 @@ class RAM_EXPORT Recorder : public core::Updatable
     /** Height of image we are recording in pixels */
     size_t getRecordingHeight() const;
 
+    /** Number of camera frames which were never recorded
+     *
+     *  Found from gaps in the frame sequence numbers, so frames skipped on
+     *  purpose by the MAX_RATE policy count as well.
+     */
+    boost::uint64_t getDroppedFrames();
+
     /** Creates a recorder from string the string
      *
-     *  This can be a network recorder, file system recorder etc.
+     *  This can be a network recorder, file system recorder etc.  The string
+     *  is a port or file name, optionally followed by arguments in
+     *  parentheses: the recording width and height, then options for the
+     *  .rmv and .rmvz file writers, like "run.rmvz(640,480,direct)":
+     *   - direct:             write around the OS cache with O_DIRECT
+     *   - preallocate=<MB>:   reserve that much disk up front
+     *   - drop=newest|block:  when the disk falls behind, drop frames or
+     *                         make the recorder wait
+     *
+     *  @param eventHub
+     *      Where .rmv and .rmvz recorders publish their WRITE_STATS
+     *
+     *  @return  0 if the string is invalid
      */
     static Recorder* createRecorderFromString(const std::string& str,
                                               Camera* camera,
                                               std::string& message,
                                               Recorder::RecordingPolicy policy,
                                               int policyArg,
-                                              std::string recorderDir = ".");
+                                              std::string recorderDir = ".",
+                                              core::EventHubPtr eventHub =
+                                              core::EventHubPtr());
     
   protected:
     /** This must be the first thing called in by a subclasses destructor */
@@ -89,7 +111,8 @@ class RAM_EXPORT Recorder : public core::Updatable
 
     /** Waits for the next image, only run when the recorder is backgronuded
      *
-     *  By default it will block until a new image is recieved by the camera.
+     *  By default it will block until a new image is recieved by the camera,
+     *  or about a frame has passed.
      */
     virtual void waitForImage(Camera* camera);
     
@@ -114,18 +137,21 @@ class RAM_EXPORT Recorder : public core::Updatable
     /** The height of the image we are recording in pixels */
     size_t m_height;
     
-    /** Protects access to m_nextFrame and m_newFrame */
+    /** Protects access to m_pendingFrame and m_droppedFrames */
     boost::mutex m_mutex;
 
-    /** Weather or not we have a new frame */
-    bool m_newFrame;
+    /** The newest frame from the camera not yet recorded, null if none */
+    FramePtr m_pendingFrame;
+
+    /** Sequence number of the last frame recorded */
+    boost::uint64_t m_lastSequence;
+
+    /** Frames from the camera which were never recorded */
+    boost::uint64_t m_droppedFrames;
     
     /** The camera we are recording from */
     Camera* m_camera;
 
-    /** The frame we get from the camera */
-    Image* m_frameFromCamera;
-
     /** The current frame we are recording */
     Image* m_frameResized;
 
@@ -12,6 +12,8 @@
 
 // STD Includes
 #include <math.h>
+#include <cassert>
+#include <algorithm>
 
 // Library Includes
 
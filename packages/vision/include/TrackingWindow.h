@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/include/TrackingWindow.h
+ */
+
+#ifndef RAM_VISION_TRACKINGWINDOW_H_10_31_2010
+#define RAM_VISION_TRACKINGWINDOW_H_10_31_2010
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <boost/utility.hpp>
+
+// Project Includes
+#include "vision/include/Common.h"
+#include "vision/include/Image.h"
+#include "vision/include/BlobDetector.h"
+#include "vision/include/RegionOfInterest.h"
+
+#include "core/include/ConfigNode.h"
+#include "core/include/Forward.h"
+
+// Must be included last
+#include "vision/include/Export.h"
+
+namespace ram {
+namespace vision {
+
+/** Limits the search for a tracked target to where it should be next
+ *
+ *  Once a detector has found its target it only needs to look near where
+ *  the target will be in the next frame.  Each frame the detector calls
+ *  beginFrame, and if that returns true it only processes the image from
+ *  extract (the predicted window, possibly at a lower resolution), maps the
+ *  blobs it finds back with toFrame, and reports the result with found or
+ *  lost.  The whole frame is searched until the target is found, after it
+ *  is lost, and every so often in case something better showed up.
+ *
+ *  Settings (properties added by addPropertiesToSet):
+ *    roiEnabled - Use windows at all, off by default
+ *    roiMargin - Fraction of the target size added on each side
+ *    roiMinMargin - Smallest margin on each side in pixels
+ *    roiFullSearchInterval - Frames between full searches
+ *    roiMaxLevel - Most times the window may be halved in size
+ *    roiMinLevelSize - Smallest target side length after halving
+ */
+class RAM_EXPORT TrackingWindow : boost::noncopyable
+{
+public:
+    TrackingWindow();
+    ~TrackingWindow();
+
+    /** Adds the settings to the detector's properties, loading the config */
+    void addPropertiesToSet(core::PropertySetPtr propSet,
+                            core::ConfigNode* config);
+
+    /** Uses the same settings as other, for detectors with several targets */
+    void copySettings(const TrackingWindow& other);
+
+    /** Turns the windowing on or off, off always searches the whole frame */
+    void setEnabled(bool enabled);
+
+    /** Sets how many times the window image may be halved */
+    void setMaxLevel(int level);
+
+    /** Decides what part of the frame to search
+     *
+     *  @param width   Width of the frame in pixels
+     *  @param height  Height of the frame in pixels
+     *
+     *  @return  true to only search the window, false for the whole frame
+     */
+    bool beginFrame(int width, int height);
+
+    /** The region of the frame to search, the whole frame if not windowed */
+    RegionOfInterest getRegion() const;
+
+    /** Times the window image is halved in size, 0 for full resolution */
+    int getLevel() const;
+
+    /** Copies the window out of the frame, scaled down to the level
+     *
+     *  The returned image belongs to this object and stays valid until the
+     *  next extract.  It can be changed freely.
+     *
+     *  @param frame   The BGR frame given to beginFrame
+     *  @param format  PF_BGR_8, PF_RGB_8 or PF_LCHUV_8
+     */
+    Image* extract(Image* frame, Image::PixelFormat format = Image::PF_BGR_8);
+
+    /** Draws a processed window image back into a frame sized image
+     *
+     *  Everything outside the window is cleared, only meant for debugging.
+     */
+    void paste(Image* window, Image* frame);
+
+    /** Converts an area in frame pixels, like a minimum blob size, to the
+     *  same area in the extract image */
+    int toWindowArea(int framePixels) const;
+
+    /** Maps a blob found in the extract image into frame coordinates */
+    BlobDetector::Blob toFrame(const BlobDetector::Blob& blob) const;
+
+    /** Maps a list of blobs found in the extract image */
+    BlobDetector::BlobList toFrame(const BlobDetector::BlobList& blobs) const;
+
+    /** Reports where the target was found in this frame (frame coordinates) */
+    void found(const BlobDetector::Blob& target);
+
+    /** Reports that the target was not found in this frame */
+    void lost();
+
+    /** True when the target was found in the last frame */
+    bool isTracking() const;
+
+    /** Frames searched with a window since creation */
+    size_t getWindowedFrames() const;
+
+    /** Frames where the whole frame was searched since creation */
+    size_t getFullFrames() const;
+
+private:
+    /** Returns a window image of the given size, reusing the buffer */
+    Image* windowImage(int width, int height, Image::PixelFormat format);
+
+    /** The formats extract can give back, each has its own wrapper */
+    enum WindowFormat
+    {
+        WINDOW_BGR,
+        WINDOW_RGB,
+        WINDOW_LCHUV,
+        WINDOW_FORMAT_COUNT
+    };
+
+    // Configuration
+    bool m_enabled;
+    double m_margin;
+    int m_minMargin;
+    int m_fullSearchInterval;
+    int m_maxLevel;
+    int m_minLevelSize;
+
+    // Target state, in frame coordinates
+    bool m_tracking;
+    BlobDetector::Blob m_target;
+    double m_velocityX;
+    double m_velocityY;
+    int m_framesSinceFullSearch;
+
+    // Current frame
+    bool m_windowed;
+    int m_frameWidth;
+    int m_frameHeight;
+    RegionOfInterest m_region;
+    int m_level;
+
+    /** Backing memory of m_window, only ever grows */
+    std::vector<unsigned char> m_buffer;
+
+    /** Wrap m_buffer at the current window size, one per WindowFormat so
+     *  converting the window does not remake them.  Null until needed. */
+    Image* m_windows[WINDOW_FORMAT_COUNT];
+
+    size_t m_windowedFrames;
+    size_t m_fullFrames;
+};
+
+} // namespace vision
+} // namespace ram
+
+#endif // RAM_VISION_TRACKINGWINDOW_H_10_31_2010
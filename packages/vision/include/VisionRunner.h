@@ -12,14 +12,24 @@
 
 // STD Includes
 #include <set>
+#include <map>
+#include <vector>
 //#include <utility>
 
+// Library Includes
+#include <boost/cstdint.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
 // Project Includes
 #include "vision/include/Events.h"
 #include "vision/include/Common.h"
 #include "vision/include/Recorder.h"
+#include "vision/include/ImageCache.h"
 
 #include "core/include/Event.h"
+#include "core/include/EventPublisher.h"
 #include "core/include/ThreadedQueue.h"
 
 // Must be included last
@@ -31,21 +41,36 @@ namespace vision {
 /** Runs a set of detectors on a specific camera
  *
  *  If the runner has detecctors, and the given camera is caputring images the
- *  detectors will be running.
+ *  detectors will be running.  Each frame is handed to all the detectors at
+ *  once on a fixed set of threads, which all finish before the next frame is
+ *  taken.  The frame is shared between them, so detectors must not change
+ *  their input image.  Color conversions and downsampled copies of the
+ *  frame are shared the same way through an ImageCache, see
+ *  Detector::getDerivedImage.
  */
-class RAM_EXPORT VisionRunner : public Recorder
+class RAM_EXPORT VisionRunner : public Recorder, public core::EventPublisher
 {
 public:
+    /** Published once a second for each detector with a DetectorTimingEvent
+     */
+    static const core::Event::EventType DETECTOR_TIMING;
+
     /** Constructor
      *
      *  @param camera  The camera to record images from
      *  @param policy  Determines how often images from the camera are recorded
      *  @param policyArg  An argument for use by the given recording policy.
-     *
+     *  @param threads  Number of threads to run detectors on, counting the
+     *                  runner's own.  0 means one per CPU.
+     *  @param eventHub  Where to also publish the timing events
      */
     VisionRunner(Camera* camera, Recorder::RecordingPolicy policy,
-                 int policyArg = 0);
+                 int policyArg = 0, size_t threads = 0,
+                 core::EventHubPtr eventHub = core::EventHubPtr());
     ~VisionRunner();
+
+    /** Number of threads detectors are run on, counting the runner's own */
+    size_t getThreadCount();
     
     /** Process detector changes, then goes into the normal Recorder update */
     virtual void update(double timestep);
@@ -86,8 +111,80 @@ private:
     /** Detectors to be added or removed */
     core::ThreadedQueue<DetectorChange> m_detectorChanges;
 
+    /** Body of the extra detector threads */
+    void workerLoop();
+
+    /** Runs every detector on the image, returns once all are done */
+    void runDetectors(Image* image);
+
+    /** Runs the next detector of the current frame, if there is one left
+     *
+     *  Must hold m_workMutex, which is released while the detector runs.
+     *
+     *  @return  False if all detectors of the frame were already started
+     */
+    bool runNextDetector(boost::mutex::scoped_lock& lock);
+
+    /** Adds the times of the last frame, publishes them once a second */
+    void updateTiming();
+
     /** Current list of dectors being added */
     std::set<DetectorPtr> m_detectors;
+
+    /** Number of threads detectors run on, counting the runner's own */
+    size_t m_threadCount;
+
+    /** Extra threads which help run the detectors */
+    boost::thread_group m_workers;
+
+    /** Protects all the members below used by the workers */
+    boost::mutex m_workMutex;
+
+    /** Signaled when there is a new frame to process, or on shutdown */
+    boost::condition m_workReady;
+
+    /** Signaled when the last detector of a frame finishes */
+    boost::condition m_workDone;
+
+    /** Set when the workers should exit */
+    bool m_shutdown;
+
+    /** Detectors to run on the current frame */
+    std::vector<DetectorPtr> m_work;
+
+    /** Seconds each detector in m_work took */
+    std::vector<double> m_workTimes;
+
+    /** The current frame */
+    Image* m_workImage;
+
+    /** Derived images of the current frame, shared by all detectors */
+    ImageCache m_imageCache;
+
+    /** Index in m_work of the next detector to start */
+    size_t m_nextWork;
+
+    /** Number of detectors in m_work which have not finished */
+    size_t m_pendingWork;
+
+    /** Processing times of one detector since the last report */
+    struct DetectorTiming
+    {
+        DetectorTiming() : frames(0), minTime(0), sumTime(0), maxTime(0) {}
+        int frames;
+        double minTime;
+        double sumTime;
+        double maxTime;
+    };
+
+    /** Only touched by the thread calling update */
+    std::map<DetectorPtr, DetectorTiming> m_timing;
+
+    /** monotonicTime() of the last timing report */
+    boost::int64_t m_reportStart;
+
+    /** Recorder::getDroppedFrames() at the last timing report */
+    boost::uint64_t m_reportDropped;
 };
         
 } // namespace vision
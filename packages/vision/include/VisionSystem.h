@@ -204,6 +204,9 @@ private:
     typedef std::map<std::string, Recorder*> StrRecorderMap;
     typedef StrRecorderMap::value_type StrRecorderMapPair;
     StrRecorderMap m_recorders;
+
+    /** Where recorders publish their statistics */
+    core::EventHubPtr m_eventHub;
     
     VisionRunner* m_forward;
     VisionRunner* m_downward;
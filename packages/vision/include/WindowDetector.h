@@ -48,7 +48,7 @@ class RAM_EXPORT WindowDetector : public Detector
   private:
     void init(core::ConfigNode config);
 
-    /* Normal processing to find one blob/color */
+    /* Normal processing to find one blob/color, input must be LCh */
     bool processColor(Image* input, Image* output,
                       ColorFilter& filter,
                       BlobDetector::Blob& outerBlob,
@@ -81,7 +81,6 @@ class RAM_EXPORT WindowDetector : public Detector
     BlobDetector m_blobDetector;
 
     Image *frame;
-    Image *tempFrame;
     Image *redFrame;
     Image *greenFrame;
     Image *yellowFrame;
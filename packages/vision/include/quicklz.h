@@ -18,7 +18,8 @@
 //#define QLZ_STREAMING_BUFFER 100000
 //#define QLZ_STREAMING_BUFFER 1000000
 
-//#define QLZ_MEMORY_SAFE
+// Frames come off the network, so corrupt data must not overrun buffers
+#define QLZ_MEMORY_SAFE
 
 // Version 1.40 beta 6. Negative revision means beta.
 #define QLZ_VERSION_MAJOR 1
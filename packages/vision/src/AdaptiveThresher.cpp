@@ -11,6 +11,7 @@
 #include "cv.h"
 #include "highgui.h"
 #include "vision/include/Image.h"
+#include "vision/include/ImagePool.h"
 #include "vision/include/AdaptiveThresher.h"
 #include "core/include/ConfigNode.h"
 #include "vision/include/Events.h"
@@ -291,7 +292,9 @@ void AdaptiveThresher::segmentImage(Image* in, Image* out)
 
 void AdaptiveThresher::findCircle()
 {
-    IplImage* img = cvCreateImage(cvSize(m_working.getWidth(), m_working.getHeight()), 8, 1);
+    ImagePool::Scoped gray(ImagePool::getDefault(), m_working.getWidth(),
+                           m_working.getHeight(), Image::PF_GRAY_8);
+    IplImage* img = gray->asIplImage();
     CvMemStorage* storage = cvCreateMemStorage(0);
     unsigned char * data = (unsigned char *)m_working.getData();
     unsigned char * data2 = (unsigned char *)img->imageData;
@@ -312,7 +315,7 @@ void AdaptiveThresher::findCircle()
                  CV_RGB(255,0,0), 3, 8, 0);
     }
 
-    cvReleaseImage(&img);
+    cvReleaseMemStorage(&storage);
 }
 
 }//vision
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/AsyncFileWriter.cpp
+ */
+
+// STD Includes
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Library Includes
+#include <boost/bind.hpp>
+
+// Project Includes
+#include "vision/include/AsyncFileWriter.h"
+
+#include "core/include/Updatable.h"
+
+namespace ram {
+namespace vision {
+
+/** O_DIRECT needs buffers, sizes and offsets aligned to the disk blocks */
+static const size_t ALIGN = 4096;
+
+static double secondsSince(boost::int64_t start)
+{
+    return (core::Updatable::monotonicTime() - start) / 1000000.0;
+}
+
+AsyncFileWriter::Options::Options() :
+    bufferSize(4 * 1024 * 1024),
+    bufferCount(8),
+    direct(false),
+    preallocate(0),
+    dropPolicy(DROP_NEWEST)
+{
+}
+
+AsyncFileWriter::Stats::Stats() :
+    queueDepth(0),
+    peakQueueDepth(0),
+    bytesWritten(0),
+    writes(0),
+    writeTime(0),
+    droppedRecords(0),
+    blockedTime(0),
+    writeErrors(0)
+{
+}
+
+AsyncFileWriter::AsyncFileWriter(const std::string& filename,
+                                 const Options& options) :
+    m_fd(-1),
+    m_direct(false),
+    m_bufferSize((options.bufferSize + ALIGN - 1) / ALIGN * ALIGN),
+    m_dropPolicy(options.dropPolicy),
+    m_current(-1),
+    m_fill(0),
+    m_writing(false),
+    m_offset(0),
+    m_shutdown(false),
+    m_thread(0)
+{
+    assert(m_bufferSize > 0 && options.bufferCount > 0 &&
+           "Writer needs buffers");
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef RAM_LINUX
+    if (options.direct)
+    {
+        // Not every file system supports it, fall back to normal writes
+        m_fd = open(filename.c_str(), flags | O_DIRECT, 0644);
+        m_direct = (m_fd >= 0);
+    }
+#endif
+    if (m_fd < 0)
+        m_fd = open(filename.c_str(), flags, 0644);
+    assert(m_fd >= 0 && "Error opening file");
+
+#ifdef RAM_LINUX
+    // Reserve the space without changing the file size, readers use the
+    // size to tell how much was recorded
+    if ((options.preallocate > 0) &&
+        (0 != fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, options.preallocate)))
+    {
+        // Only saves the file system work later, so carry on without it.
+        // posix_fallocate would fake it by changing the file size.
+        if (EOPNOTSUPP == errno)
+        {
+            fprintf(stderr, "WARNING: Can't preallocate %s on this file "
+                    "system\n", filename.c_str());
+        }
+        else
+        {
+            perror("WARNING fallocate");
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < options.bufferCount; ++i)
+    {
+        void* buffer = 0;
+        int ret = posix_memalign(&buffer, ALIGN, m_bufferSize);
+        assert(0 == ret && "Could not allocate write buffer");
+        m_buffers.push_back((unsigned char*)buffer);
+        m_free.push_back(i);
+    }
+
+    m_thread = new boost::thread(
+        boost::bind(&AsyncFileWriter::writerLoop, this));
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if ((m_current >= 0) && (m_fill > 0))
+            handOff(m_fill, true);
+        m_shutdown = true;
+        m_workReady.notify_all();
+    }
+    m_thread->join();
+    delete m_thread;
+
+    close(m_fd);
+    for (size_t i = 0; i < m_buffers.size(); ++i)
+        free(m_buffers[i]);
+}
+
+bool AsyncFileWriter::beginRecord(size_t size, bool wait)
+{
+    assert(size <= m_bufferSize * (m_buffers.size() - 1) &&
+           "Record bigger than the buffers can hold");
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (true)
+    {
+        size_t available = m_free.size() * m_bufferSize;
+        if (m_current >= 0)
+            available += m_bufferSize - m_fill;
+        if (available >= size)
+            return true;
+
+        if ((DROP_NEWEST == m_dropPolicy) && !wait)
+        {
+            m_stats.droppedRecords++;
+            return false;
+        }
+
+        boost::int64_t start = core::Updatable::monotonicTime();
+        m_workDone.wait(lock);
+        m_stats.blockedTime += secondsSince(start);
+    }
+}
+
+void AsyncFileWriter::write(const void* data, size_t size)
+{
+    const unsigned char* source = (const unsigned char*)data;
+    while (size > 0)
+    {
+        if (m_current < 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            assert(!m_free.empty() && "Wrote more than beginRecord allowed");
+            m_current = (int)m_free.front();
+            m_free.pop_front();
+            m_fill = 0;
+        }
+
+        size_t count = std::min(size, m_bufferSize - m_fill);
+        memcpy(m_buffers[m_current] + m_fill, source, count);
+        m_fill += count;
+        source += count;
+        size -= count;
+
+        if (m_bufferSize == m_fill)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            handOff(m_fill, true);
+        }
+    }
+}
+
+void AsyncFileWriter::endRecord()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    // Only wait to fill the buffer when the disk is busy anyway
+    if (m_queue.empty() && !m_writing)
+        handOffPartial();
+}
+
+void AsyncFileWriter::flush()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    if ((m_current >= 0) && (m_fill > 0))
+    {
+        if (m_direct)
+        {
+            // Write out what we have but keep the buffer, it gets written
+            // again once full so the file stays aligned
+            handOff(m_fill, false);
+        }
+        else
+        {
+            handOff(m_fill, true);
+        }
+    }
+
+    while (!m_queue.empty() || m_writing)
+        m_workDone.wait(lock);
+}
+
+AsyncFileWriter::Stats AsyncFileWriter::getStats()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    Stats stats = m_stats;
+    stats.queueDepth = m_queue.size();
+    return stats;
+}
+
+void AsyncFileWriter::resetPeakQueueDepth()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stats.peakQueueDepth = m_queue.size();
+}
+
+bool AsyncFileWriter::isDirect() const
+{
+    return m_direct;
+}
+
+void AsyncFileWriter::handOff(size_t length, bool release)
+{
+    Pending pending = {(size_t)m_current, length, release};
+    m_queue.push_back(pending);
+    m_stats.peakQueueDepth = std::max(m_stats.peakQueueDepth, m_queue.size());
+
+    if (release)
+    {
+        m_current = -1;
+        m_fill = 0;
+    }
+    m_workReady.notify_one();
+}
+
+void AsyncFileWriter::handOffPartial()
+{
+    if ((m_current < 0) || (0 == m_fill))
+        return;
+
+    if (!m_direct)
+    {
+        handOff(m_fill, true);
+        return;
+    }
+
+    // Only whole blocks can be written directly, the rest moves to the
+    // start of the next buffer
+    size_t aligned = m_fill - m_fill % ALIGN;
+    if ((0 == aligned) || m_free.empty())
+        return;
+
+    size_t next = m_free.front();
+    m_free.pop_front();
+    size_t tail = m_fill - aligned;
+    memcpy(m_buffers[next], m_buffers[m_current] + aligned, tail);
+
+    handOff(aligned, true);
+    m_current = (int)next;
+    m_fill = tail;
+}
+
+void AsyncFileWriter::writerLoop()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (true)
+    {
+        while (m_queue.empty() && !m_shutdown)
+            m_workReady.wait(lock);
+
+        // Only stop once everything is written
+        if (m_queue.empty())
+            break;
+
+        Pending pending = m_queue.front();
+        m_queue.pop_front();
+        m_writing = true;
+
+        boost::uint64_t offset = m_offset;
+        if (pending.release)
+            m_offset += pending.length;
+
+        lock.unlock();
+        boost::int64_t start = core::Updatable::monotonicTime();
+        bool written =
+            writeAt(m_buffers[pending.buffer], pending.length, offset);
+        double writeTime = secondsSince(start);
+        lock.lock();
+
+        // A failed buffer is dropped, so the caller never waits on a disk
+        // that can't take any more
+        if (written)
+            m_stats.bytesWritten += pending.length;
+        else
+            m_stats.writeErrors++;
+        m_stats.writes++;
+        m_stats.writeTime += writeTime;
+        if (pending.release)
+            m_free.push_back(pending.buffer);
+        m_writing = false;
+        m_workDone.notify_all();
+    }
+}
+
+bool AsyncFileWriter::writeAt(const unsigned char* data, size_t length,
+                              boost::uint64_t offset)
+{
+#ifdef RAM_LINUX
+    // The end of the file is not a whole block, write it through the cache
+    bool unaligned = m_direct && (0 != length % ALIGN);
+    if (unaligned)
+        fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+#endif
+
+    while (length > 0)
+    {
+        ssize_t written = pwrite(m_fd, data, length, (off_t)offset);
+        if ((written < 0) && (EINTR == errno))
+            continue;
+
+        // Out of space or an I/O error, retrying would never end
+        if (written < 0)
+        {
+            perror("Error writing to disk");
+            break;
+        }
+        if (0 == written)
+        {
+            fprintf(stderr, "Error writing to disk: nothing written\n");
+            break;
+        }
+
+        data += written;
+        length -= written;
+        offset += written;
+    }
+
+#ifdef RAM_LINUX
+    if (unaligned)
+        fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_DIRECT);
+#endif
+
+    return 0 == length;
+}
+
+} // namespace vision
+} // namespace ram
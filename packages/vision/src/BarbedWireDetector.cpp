@@ -111,15 +111,8 @@ void BarbedWireDetector::setBottomRemovePercentage(double percent)
     
 void BarbedWireDetector::processImage(Image* input, Image* output)
 {
-    // Ensure our working image is the same size
-    if ((m_image->getWidth() != input->getWidth()) || 
-        (m_image->getHeight() != input->getHeight()))
-    {
-        m_image->copyFrom(input);
-    }
-
-    // Copy to our working image and convert to YUV
-    cvCvtColor(input->asIplImage(), m_image->asIplImage(), CV_BGR2Luv);
+    // Copy the LUV version of the input to our working image
+    m_image->copyFrom(getDerivedImage(input, ImageCache::LUV));
 
     // Filter for green
     filterForGreen(m_image);
@@ -113,6 +113,7 @@ BinDetector::BinDetector(core::ConfigNode config,
     m_extractBuffer(0),
     m_scratchBuffer1(0),
     m_scratchBuffer2(0),
+    m_lineStorage(0),
     m_whiteMaskMinimumPercent(0),
     m_whiteMaskMinimumIntensity(0),
     m_blackMaskMinimumPercent(0),
@@ -174,9 +175,8 @@ void BinDetector::processImage(Image* input, Image* out)
     if (out)
         out->copyFrom(m_frame);
     
-    // Convert the image to LCh
-    m_frame->setPixelFormat(Image::PF_RGB_8);
-    m_frame->setPixelFormat(Image::PF_LCHUV_8);
+    // Switch to the LCh version of the image
+    m_frame->copyFrom(getDerivedImage(input, ImageCache::LCHUV));
     
     // Filter for white, black, and red
     filterForWhite(m_frame, m_whiteMaskedFrame);
@@ -532,6 +532,7 @@ void BinDetector::allocateImages(int width, int height)
     m_extractBuffer = new unsigned char[size];
     m_scratchBuffer1 = new unsigned char[size];
     m_scratchBuffer2 = new unsigned char[size];
+    m_lineStorage = cvCreateMemStorage(0);
 }
 
 void BinDetector::deleteImages()
@@ -543,6 +544,7 @@ void BinDetector::deleteImages()
     delete [] m_extractBuffer;
     delete [] m_scratchBuffer1;
     delete [] m_scratchBuffer2;
+    cvReleaseMemStorage(&m_lineStorage);
 }
     
 void BinDetector::filterForWhite(Image* input, Image* output)
@@ -1036,21 +1038,24 @@ bool BinDetector::calculateAngleOfBin(BlobDetector::Blob bin, Image* input,
                                       math::Degree& foundAngle, Image* output)
 {
     // Grab a gray scale version of the input image
+    // (the headers live on the stack so nothing is allocated per bin)
     CvSize size = cvGetSize(input->asIplImage());
-    IplImage* grayScale = cvCreateImageHeader(size, IPL_DEPTH_8U, 1);
-    cvSetData(grayScale, m_scratchBuffer1, input->getWidth());
-    cvCvtColor(input->asIplImage(), grayScale, CV_BGR2GRAY);
+    IplImage grayScale;
+    cvInitImageHeader(&grayScale, size, IPL_DEPTH_8U, 1);
+    cvSetData(&grayScale, m_scratchBuffer1, input->getWidth());
+    cvCvtColor(input->asIplImage(), &grayScale, CV_BGR2GRAY);
 
     // Grab a cannied version of our image
-    IplImage* cannied = cvCreateImageHeader(size, IPL_DEPTH_8U, 1);
-    cvSetData(cannied, m_scratchBuffer2, input->getWidth());
-    cvCanny(grayScale, cannied, 50, 200, 3 );
+    IplImage cannied;
+    cvInitImageHeader(&cannied, size, IPL_DEPTH_8U, 1);
+    cvSetData(&cannied, m_scratchBuffer2, input->getWidth());
+    cvCanny(&grayScale, &cannied, 50, 200, 3 );
 
     // Run the hough transform on the cannied image
-    CvMemStorage* storage = cvCreateMemStorage(0);
+    cvClearMemStorage(m_lineStorage);
     CvSeq* lines = 0;
     
-    lines = cvHoughLines2( cannied, storage, CV_HOUGH_PROBABILISTIC,
+    lines = cvHoughLines2( &cannied, m_lineStorage, CV_HOUGH_PROBABILISTIC,
                            m_binHoughPixelRes,
                            CV_PI/180, m_binHoughThreshold,
                            m_binHoughMinLineLength, m_binHoughMaxLineGap);
@@ -1103,10 +1108,6 @@ bool BinDetector::calculateAngleOfBin(BlobDetector::Blob bin, Image* input,
         success = true;
     }
     
-    cvReleaseImageHeader(&cannied);
-    cvReleaseMemStorage(&storage);
-    cvReleaseImageHeader(&grayScale);
-    
     return success;
 }
 
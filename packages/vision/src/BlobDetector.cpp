@@ -97,30 +97,36 @@ void BlobDetector::Blob::drawTextUR(Image* output, std::string text,
 BlobDetector::BlobDetector(core::ConfigNode config,
                            core::EventHubPtr eventHub) :
     Detector(eventHub),
-    m_minBlobSize(0),
-    m_pixelBlobIndex(0),
-    m_imageSize(0)
+    m_minBlobSize(0)
 {
     init(config);
 }
 
 BlobDetector::BlobDetector(int minimumBlobSize) :
     Detector(core::EventHubPtr()),
-    m_minBlobSize(minimumBlobSize),
-    m_pixelBlobIndex(0),
-    m_imageSize(0)
+    m_minBlobSize(minimumBlobSize)
 {
 }
     
 BlobDetector::~BlobDetector()
 {
-    free(m_pixelBlobIndex);
 }
     
 void BlobDetector::processImage(Image* input, Image* output)
 {
+    processImage(input, RegionOfInterest(0, input->getWidth(),
+                                         0, input->getHeight()), output);
+}
+
+void BlobDetector::processImage(Image* input, const RegionOfInterest& roi,
+                                Image* output)
+{
+    IplImage* img = input->asIplImage();
+    
     m_blobs.clear();
-    buildBlobs(input->asIplImage());
+    buildBlobs(img, std::max(roi.minX(), 0), std::max(roi.minY(), 0),
+               std::min(roi.maxX(), img->width),
+               std::min(roi.maxY(), img->height));
 
     // Do debug stuff soon
     if (0 != output)
@@ -167,209 +173,152 @@ int BlobDetector::getMinimumBlobSize()
 void BlobDetector::init(core::ConfigNode config)
 {
     // Pre-allocate memory
-    m_joinedBlobIndex.reserve(1024);
-    m_pixelCounts.reserve(1024);
-    m_blobTotalX.reserve(1024);
-    m_blobTotalY.reserve(1024);
-    m_blobMinX.reserve(1024);
-    m_blobMaxX.reserve(1024);
-    m_blobMinY.reserve(1024);
-    m_blobMaxY.reserve(1024);
-
-    ensureDataSize(640 * 480);
+    m_runStart.reserve(4096);
+    m_runEnd.reserve(4096);
+    m_runY.reserve(4096);
+    m_runParent.reserve(4096);
 
     m_minBlobSize = config["minBlobSize"].asInt(0);
 }
     
-int BlobDetector::buildBlobs(IplImage* img)
+void BlobDetector::buildBlobs(IplImage* img, int minX, int minY,
+                              int maxX, int maxY)
 {
-    int width=img->width;
-    int height=img->height;
-    unsigned char* imgData=(unsigned char*)img->imageData;
-    // Make sure the data array is large enough
-    ensureDataSize(width * height);
+    labelRuns(img, minX, minY, maxX, maxY);
     
-    m_joinedBlobIndex.resize(1, UINT_MAX);
-    m_pixelCounts.resize(1, 0);
-    m_blobTotalX.resize(1, 0);
-    m_blobTotalY.resize(1, 0);
-    m_blobMinX.resize(1, 0);
-    m_blobMaxX.resize(1, 0);
-    m_blobMinY.resize(1, 0);
-    m_blobMaxY.resize(1, 0);
-        
-    unsigned int initialBlobIndex = 1;
-    // Black out the top row, front edge so the above and left algos
-    // work properly
-    int imgCount=0;
-    int count = 0;
-
-    // Top row
-    memset(imgData, 0, width * 3);
-    memset(m_pixelBlobIndex, 0, sizeof(*m_pixelBlobIndex) * width);
-
-    // Front edge
-    for (int y=0;y<height;y++)
+    // Gather the runs up into their sets, each run adds a whole span of
+    // pixels at once
+    int runCount = (int)m_runStart.size();
+    m_stats.reset(runCount);
+    for (int run = 0; run < runCount; ++run)
     {
-        imgData[imgCount]=imgData[imgCount+1]=imgData[imgCount+2]=0;
-        m_pixelBlobIndex[count]=0;
-        imgCount+=3*width;
-        count += width;
+        int root = findRoot(run);
+        int start = m_runStart[run];
+        int end = m_runEnd[run];
+        int y = m_runY[run];
+        int length = end - start + 1;
+
+        m_stats.pixels[root] += length;
+        m_stats.totalX[root] += (boost::int64_t)(start + end) * length / 2;
+        m_stats.totalY[root] += (boost::int64_t)y * length;
+        
+        if (start < m_stats.minX[root])
+            m_stats.minX[root] = start;
+        if (end > m_stats.maxX[root])
+            m_stats.maxX[root] = end;
+        if (y < m_stats.minY[root])
+            m_stats.minY[root] = y;
+        if (y > m_stats.maxY[root])
+            m_stats.maxY[root] = y;
     }
-    imgCount=0;
-    count = 0;
 
-
-    // Loop over every pixel
-    for (int y=0; y<height;y++)
+    // Each root is a finished blob
+    for (int run = 0; run < runCount; ++run)
     {
-        for (int x=0; x<width;x++)
+        int pixels = m_stats.pixels[run];
+        if ((m_runParent[run] == run) && (pixels >= m_minBlobSize))
         {
-            // Check for a marked (ie. white) pixel
-            if (imgData[imgCount]>0)
-            {
-                // Found a valid pixel, check the value above and below it
-                unsigned int aboveBlobIndex = m_pixelBlobIndex[count-width];
-                unsigned int leftBlobIndex = m_pixelBlobIndex[count-1];
-                if (aboveBlobIndex == 0 && leftBlobIndex == 0)
-                {
-                    // Start of a new blob
-                    m_pixelCounts.push_back(1);
-                    m_blobTotalX.push_back(x);
-                    m_blobTotalY.push_back(y);
-                    m_blobMinX.push_back(x);
-                    m_blobMaxX.push_back(x);
-                    m_blobMinY.push_back(y);
-                    m_blobMaxY.push_back(y);
-
-                    // add a new blob index and set the current pixel to belong to that blob
-                    m_joinedBlobIndex.push_back(initialBlobIndex);
-                    m_pixelBlobIndex[count]= (initialBlobIndex++);
-                }
-                else 
-                {
-                    // Continuation of an existing blob
-                    unsigned int aboveJoinedBlobIndex = aboveBlobIndex;
-                    unsigned int leftJoinedBlobIndex = leftBlobIndex;
-                    if (aboveJoinedBlobIndex == 0)
-                        aboveJoinedBlobIndex = UINT_MAX;
-                    else
-                    {
-                        while (aboveJoinedBlobIndex != m_joinedBlobIndex[aboveJoinedBlobIndex])
-                            aboveJoinedBlobIndex = m_joinedBlobIndex[aboveJoinedBlobIndex];
-                    }
-                    if (leftJoinedBlobIndex == 0)
-                        leftJoinedBlobIndex = UINT_MAX;
-                    else
-                    {
-                        while (leftJoinedBlobIndex != m_joinedBlobIndex[leftJoinedBlobIndex])
-                            leftJoinedBlobIndex = m_joinedBlobIndex[leftJoinedBlobIndex];
-                    }
-
-                    unsigned int finalBlobIndex = 
-                        std::min(leftJoinedBlobIndex, aboveJoinedBlobIndex);
-
-                    // modify the joined blob indices to be the lowest index that this pixel
-                    // connects to
-                    m_joinedBlobIndex[aboveBlobIndex] = finalBlobIndex;
-                    m_joinedBlobIndex[leftBlobIndex] = finalBlobIndex;
-                    m_pixelBlobIndex[count]= finalBlobIndex;
-
-                    m_blobTotalX[finalBlobIndex]+=x;
-                    m_blobTotalY[finalBlobIndex]+=y;
-                    ++m_pixelCounts[finalBlobIndex];
-                                        
-                    // Min/Max
-                    if (x < m_blobMinX[finalBlobIndex])
-                        m_blobMinX[finalBlobIndex] = x;
-                    else if (x > m_blobMaxX[finalBlobIndex])
-                        m_blobMaxX[finalBlobIndex] = x;
-                    if (y < m_blobMinY[finalBlobIndex])
-                        m_blobMinY[finalBlobIndex] = y;
-                    else if (y > m_blobMaxY[finalBlobIndex])
-                        m_blobMaxY[finalBlobIndex] = y;
-                }
-            }
-            else
-            {
-                // We need to zero the data as we go
-                m_pixelBlobIndex[count] = 0;
-            }
-            count++;
-            imgCount += 3;
+            m_blobs.push_back(
+                BlobDetector::Blob(pixels,
+                                   (int)(m_stats.totalX[run] / pixels),
+                                   (int)(m_stats.totalY[run] / pixels),
+                                   m_stats.maxX[run], m_stats.minX[run],
+                                   m_stats.maxY[run], m_stats.minY[run]));
         }
     }
 
-    int maxCount=0;
-
-    // Work from the top to bottom, collapsing the pixel clusters together
-    for (unsigned int i=initialBlobIndex-1;i>0;i--)
+    // Put largest blob first, equal blobs stay top to bottom
+    if (m_blobs.size() > 0)
     {
-        unsigned int join = m_joinedBlobIndex[i];
+        std::stable_sort(m_blobs.begin(), m_blobs.end(),
+                         BlobDetector::BlobComparer::compare);
+    }
+}
 
-        // Catch sentinal to make the first join, point to the last
-        if (join == UINT_MAX)
-            join = m_joinedBlobIndex.size() - 1;
+void BlobDetector::labelRuns(IplImage* img, int minX, int minY,
+                             int maxX, int maxY)
+{
+    m_runStart.clear();
+    m_runEnd.clear();
+    m_runY.clear();
+    m_runParent.clear();
+
+    int channels = img->nChannels;
+    // Runs of the row above are [prevBegin, prevEnd)
+    int prevBegin = 0;
+    int prevEnd = 0;
+    
+    for (int y = minY; y < maxY; ++y)
+    {
+        const unsigned char* row = (const unsigned char*)
+            (img->imageData + y * img->widthStep);
+        int rowBegin = (int)m_runStart.size();
+        int above = prevBegin;
         
-        //assert(join <= initialBlobIndex);
-        if (join!=i)
-        {
-            // "Unfinished" cluster of pixels, ie part of bigger cluster
-            // So add all of its information to the parents information
-            m_blobTotalX[join]+=m_blobTotalX[i];
-            m_blobTotalY[join]+=m_blobTotalY[i];
-
-            // Mins
-            if (m_blobMinX[i] < m_blobMinX[join])
-                m_blobMinX[join] = m_blobMinX[i];
-            if (m_blobMinY[i] < m_blobMinY[join])
-                m_blobMinY[join] = m_blobMinY[i];
-
-            // Maxs
-            if (m_blobMaxX[i] > m_blobMaxX[join])
-                m_blobMaxX[join] = m_blobMaxX[i];
-            if (m_blobMaxY[i] > m_blobMaxY[join])
-                m_blobMaxY[join] = m_blobMaxY[i];
-
-            m_pixelCounts[join]+=m_pixelCounts[i];
-            m_pixelCounts[i]=0;
-        }
-        else
+        int x = minX;
+        while (x < maxX)
         {
-            maxCount=m_pixelCounts[i];
-            if (maxCount >= m_minBlobSize)
-            {
-                // Found a final cluster
-                m_blobs.push_back(
-                    BlobDetector::Blob(m_pixelCounts[i], m_blobTotalX[i]/maxCount,
-                                       m_blobTotalY[i]/maxCount, m_blobMaxX[i],
-                                       m_blobMinX[i], m_blobMaxY[i], m_blobMinY[i])
-                                  );
-            }
+            // Skip background
+            while ((x < maxX) && (0 == row[x * channels]))
+                ++x;
+            if (x == maxX)
+                break;
+
+            int start = x;
+            while ((x < maxX) && (0 != row[x * channels]))
+                ++x;
+            int end = x - 1;
+
+            int run = (int)m_runStart.size();
+            m_runStart.push_back(start);
+            m_runEnd.push_back(end);
+            m_runY.push_back(y);
+            m_runParent.push_back(run);
+
+            // Join every run above which shares a column with this one,
+            // both rows are in order so we only ever walk forward
+            while ((above < prevEnd) && (m_runEnd[above] < start))
+                ++above;
+            for (int i = above; (i < prevEnd) && (m_runStart[i] <= end); ++i)
+                joinRuns(i, run);
         }
+
+        prevBegin = rowBegin;
+        prevEnd = (int)m_runStart.size();
     }
+}
 
-    // Put largest blob first
-    if (m_blobs.size() > 0)
+int BlobDetector::findRoot(int run)
+{
+    while (m_runParent[run] != run)
     {
-        std::sort(m_blobs.begin(), m_blobs.end(),
-                  BlobDetector::BlobComparer::compare);
+        // Path halving, skip every other step for the next search
+        m_runParent[run] = m_runParent[m_runParent[run]];
+        run = m_runParent[run];
     }
+    return run;
+}
 
-    return maxCount;
+void BlobDetector::joinRuns(int first, int second)
+{
+    int firstRoot = findRoot(first);
+    int secondRoot = findRoot(second);
+    
+    if (firstRoot < secondRoot)
+        m_runParent[secondRoot] = firstRoot;
+    else if (secondRoot < firstRoot)
+        m_runParent[firstRoot] = secondRoot;
 }
 
-void BlobDetector::ensureDataSize(int pixels)
+void BlobDetector::BlobStats::reset(size_t count)
 {
-    size_t bytes = (size_t)pixels * sizeof(*m_pixelBlobIndex);
-    if (m_imageSize < (size_t)pixels)
-    {
-        m_imageSize = (int)pixels;
-        if (m_pixelBlobIndex)
-            m_pixelBlobIndex = (unsigned int*)realloc(m_pixelBlobIndex, bytes);
-        else
-            m_pixelBlobIndex = (unsigned int*)malloc(bytes);
-    }
+    pixels.assign(count, 0);
+    totalX.assign(count, 0);
+    totalY.assign(count, 0);
+    minX.assign(count, INT_MAX);
+    maxX.assign(count, INT_MIN);
+    minY.assign(count, INT_MAX);
+    maxY.assign(count, INT_MIN);
 }
     
 } // namespace vision
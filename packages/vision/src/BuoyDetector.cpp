@@ -169,7 +169,8 @@ void BuoyDetector::init(core::ConfigNode config)
                                       "BlackH", "Black Hue",
                                       0, 255, 0, 255, 0, 255);
 
-
+    // The green and yellow windows copy these each frame
+    m_redWindow.addPropertiesToSet(propSet, &config);
 
     // Make sure the configuration is valid
     propSet->verifyConfig(config, true);
@@ -201,21 +202,41 @@ void BuoyDetector::update()
 }
 
 bool BuoyDetector::processColor(Image* input, Image* output,
-                                ColorFilter& filter,
-                                BlobDetector::Blob& outBlob)
+                                ColorFilter& filter, TrackingWindow& window,
+                                bool debug, BlobDetector::Blob& outBlob)
 {
     const int imgWidth = input->getWidth();
     const int imgHeight = input->getHeight();
     const int imgPixels = imgWidth * imgHeight;
 
-    output->copyFrom(input);
-    output->setPixelFormat(Image::PF_RGB_8);
-    output->setPixelFormat(Image::PF_LCHUV_8);
-
-    filter.filterImage(output);
+    BlobDetector::BlobList blobs;
+    if (window.beginFrame(imgWidth, imgHeight))
+    {
+        // Only convert and filter the part of the frame near the buoy
+        Image* lch = window.extract(input, Image::PF_LCHUV_8);
+        filter.filterImage(lch);
+
+        // The minimum size is in frame pixels, a lower level holds fewer
+        int minBlobSize = m_blobDetector.getMinimumBlobSize();
+        m_blobDetector.setMinimumBlobSize(window.toWindowArea(minBlobSize));
+        m_blobDetector.processImage(lch);
+        m_blobDetector.setMinimumBlobSize(minBlobSize);
+        blobs = window.toFrame(m_blobDetector.getBlobs());
+
+        if (debug)
+        {
+            output->copyFrom(input);
+            window.paste(lch, output);
+        }
+    }
+    else
+    {
+        output->copyFrom(getDerivedImage(input, ImageCache::LCHUV));
+        filter.filterImage(output);
 
-    m_blobDetector.processImage(output);
-    BlobDetector::BlobList blobs = m_blobDetector.getBlobs();
+        m_blobDetector.processImage(output);
+        blobs = m_blobDetector.getBlobs();
+    }
 
     bool foundBlob = false;
     
@@ -262,7 +283,10 @@ bool BuoyDetector::processColor(Image* input, Image* output,
         }
     }
 
- 
+    if (foundBlob)
+        window.found(outBlob);
+    else
+        window.lost();
 
     return foundBlob;
 }
@@ -271,6 +295,11 @@ void BuoyDetector::processImage(Image* input, Image* output)
 {
     frame->copyFrom(input);
 
+    // All windows use the settings loaded into the red one
+    m_greenWindow.copySettings(m_redWindow);
+    m_yellowWindow.copySettings(m_redWindow);
+    bool debug = output && (m_debug >= 1);
+
     int topRowsToIgnore = (int)(m_topIgnorePercentage * frame->getHeight());
     int bottomRowsToIgnore = (int)(m_bottomIgnorePercentage * frame->getHeight());
     int leftColsToIgnore = (int)(m_leftIgnorePercentage * frame->getWidth());
@@ -289,15 +318,15 @@ void BuoyDetector::processImage(Image* input, Image* output)
     // Filter for black if needed
     if (m_checkBlack)
     {
-        blackFrame->copyFrom(frame);
-        blackFrame->setPixelFormat(Image::PF_RGB_8);
-        blackFrame->setPixelFormat(Image::PF_LCHUV_8);
+        // Always searched over the whole frame, the buoys can be anywhere
+        blackFrame->copyFrom(getDerivedImage(input, ImageCache::LCHUV));
 
         m_blackFilter->filterImage(blackFrame);
     }
 
     BlobDetector::Blob redBlob;
-    bool redFound = processColor(frame, redFrame, *m_redFilter, redBlob);
+    bool redFound = processColor(input, redFrame, *m_redFilter,
+                                 m_redWindow, debug, redBlob);
     if (redFound)
     {
         publishFoundEvent(redBlob, Color::RED);
@@ -315,7 +344,8 @@ void BuoyDetector::processImage(Image* input, Image* output)
     m_redFound = redFound;
 
     BlobDetector::Blob greenBlob;
-    bool greenFound = processColor(frame, greenFrame, *m_greenFilter, greenBlob);
+    bool greenFound = processColor(input, greenFrame, *m_greenFilter,
+                                   m_greenWindow, debug, greenBlob);
     if (greenFound)
     {
         publishFoundEvent(greenBlob, Color::GREEN);
@@ -333,7 +363,8 @@ void BuoyDetector::processImage(Image* input, Image* output)
     m_greenFound = greenFound;
 
     BlobDetector::Blob yellowBlob;
-    bool yellowFound = processColor(frame, yellowFrame, *m_yellowFilter, yellowBlob);
+    bool yellowFound = processColor(input, yellowFrame, *m_yellowFilter,
+                                    m_yellowWindow, debug, yellowBlob);
     if (yellowFound)
     {
         publishFoundEvent(yellowBlob, Color::YELLOW);
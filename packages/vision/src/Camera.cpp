@@ -16,12 +16,15 @@
 
 // Project Includes
 #include "vision/include/Camera.h"
+#include "vision/include/Frame.h"
 #include "vision/include/Image.h"
 #include "vision/include/OpenCVImage.h"
 #include "vision/include/Events.h"
 #include "vision/include/CameraMaker.h"
 #include "vision/include/VisionSystem.h"
 
+#include "core/include/TimeVal.h"
+
 RAM_CORE_EVENT_TYPE(ram::vision::Camera, IMAGE_CAPTURED);
 
 namespace ram {
@@ -30,11 +33,10 @@ namespace vision {
 Camera::Camera() :
     Updatable(this),
     EventPublisher(core::EventHubPtr()),
-    m_publicImage(0),
+    m_framePool(FramePool::create()),
+    m_frameSequence(0),
     m_imageLatch(1)
 {
-    /// TODO: Make me a basic image, and check that copying work properly
-    m_publicImage = new OpenCVImage(640, 480);
 }
 
 Camera::~Camera()
@@ -43,17 +45,22 @@ Camera::~Camera()
            "anything");
     assert(!backgrounded() &&
            "Camera must not be backgrounded for destruction");
-    delete m_publicImage;
+}
+
+FramePtr Camera::getFrame()
+{
+    core::ReadWriteMutex::ScopedReadLock lock(m_imageMutex);
+    return m_latestFrame;
 }
 
 void Camera::getImage(Image* current)
 {
     assert(current && "Can't copy into a null image");
-    
-    core::ReadWriteMutex::ScopedReadLock lock(m_imageMutex);
 
-    // Copy over the image (uses copy assignment operator)
-    current->copyFrom(m_publicImage);
+    // Frames never change once shared, so copy without holding the lock
+    FramePtr frame = getFrame();
+    if (frame)
+        current->copyFrom(frame->getImage());
 }
 
 bool Camera::waitForImage(Image* current)
@@ -173,29 +180,26 @@ void Camera::cleanup()
 void Camera::capturedImage(Image* newImage)
 {
     assert(newImage && "Can't copy null image");
-    
-    {    
-        core::ReadWriteMutex::ScopedWriteLock lock(m_imageMutex);
 
-        // Copy over the image data to the public image
-        // (Silently ignore a new image if the new image is null.)
-        if (newImage)
-        {
-            copyToPublic(newImage, m_publicImage);
-        }
+    // Silently ignore a new image if the new image is null
+    if (!newImage)
+        return;
+
+    // Nobody else can see this frame yet, so copy into it without the lock
+    FramePtr frame = m_framePool->acquire(newImage->getWidth(),
+                                          newImage->getHeight());
+    copyToPublic(newImage, frame->getImage());
+    frame->setCaptureInfo(++m_frameSequence,
+                          core::TimeVal::clockTime().get_double());
+
+    {
+        // Only swap the pointer under the lock, the old frame is recycled
+        // once its last reader lets go of it
+        core::ReadWriteMutex::ScopedWriteLock lock(m_imageMutex);
+        m_latestFrame = frame;
     }
 
-    // no need to hold the mutex after the image is copied
-    // it would be nice if we could publish this somewhere else
-    // after the image is copied because this blocks the capture loop
-    // alternatively, we could require everyone to use waitForImage
-    // in order to get images upon copy or getImage if dropped or
-    // duplicate frames are not problematic
-    // we could add a timestamp or index for the image in order to
-    // let other modules figure out if they are getting duplicate
-    // frames or dropping frames
-    publish(Camera::IMAGE_CAPTURED,
-            ImageEventPtr(new ImageEvent(m_publicImage)));
+    publish(Camera::IMAGE_CAPTURED, ImageEventPtr(new ImageEvent(frame)));
     
     // Now release all waiting threads
     m_imageLatch.countDown();
@@ -13,8 +13,18 @@
 
 // Library Includes
 #include "boost/bind.hpp"
+#include "boost/thread/once.hpp"
 #include "cxtypes.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <cpuid.h>
+#define RAM_VISION_HAVE_CPUID
+#endif
+
 // Project Includes
 #include "vision/include/ColorFilter.h"
 #include "vision/include/Image.h"
@@ -25,6 +35,46 @@
 namespace ram {
 namespace vision {
 
+namespace detail {
+
+// In ColorFilterAVX2.cpp, which is the only file built with AVX2 enabled
+int colorFilterAVX2(const unsigned char* inputData, unsigned char* outputData,
+                    int numPixels, const unsigned char starts[2][96],
+                    const unsigned char widths[2][96], bool inverse);
+bool colorFilterAVX2Built();
+
+} // namespace detail
+
+static ColorFilter::Kernel s_bestKernel = ColorFilter::KERNEL_SCALAR;
+static boost::once_flag s_bestKernelOnce = BOOST_ONCE_INIT;
+
+/** Whether the CPU and the OS both support AVX2 */
+static bool cpuHasAVX2()
+{
+#ifdef RAM_VISION_HAVE_CPUID
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+
+    // AVX (bit 28), and OSXSAVE (bit 27) so we can ask the OS below
+    if (!(ecx & (1 << 28)) || !(ecx & (1 << 27)))
+        return false;
+
+    // The OS must save the SSE and AVX registers on a context switch
+    unsigned int xcr0, xcr0High;
+    __asm__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0High) : "c" (0));
+    if ((xcr0 & 0x6) != 0x6)
+        return false;
+
+    if (__get_cpuid_max(0, 0) < 7)
+        return false;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
 ColorFilter::ColorFilter(
     unsigned char channel1Low, unsigned char channel1High,
     unsigned char channel2Low, unsigned char channel2High,
@@ -35,7 +85,8 @@ ColorFilter::ColorFilter(
     m_channel2Low(channel2Low),
     m_channel2High(channel2High),
     m_channel3Low(channel3Low),
-    m_channel3High(channel3High)
+    m_channel3High(channel3High),
+    m_kernel(bestKernel())
 {
     setupRanges();
 }
@@ -44,6 +95,48 @@ ColorFilter::~ColorFilter()
 {
 }
 
+ColorFilter::Kernel ColorFilter::bestKernel()
+{
+    boost::call_once(&ColorFilter::findBestKernel, s_bestKernelOnce);
+    return s_bestKernel;
+}
+
+void ColorFilter::findBestKernel()
+{
+    if (kernelSupported(KERNEL_AVX2))
+        s_bestKernel = KERNEL_AVX2;
+    else if (kernelSupported(KERNEL_SSE2))
+        s_bestKernel = KERNEL_SSE2;
+    else
+        s_bestKernel = KERNEL_SCALAR;
+}
+
+bool ColorFilter::kernelSupported(Kernel kernel)
+{
+    switch (kernel)
+    {
+        case KERNEL_SCALAR:
+            return true;
+
+        case KERNEL_SSE2:
+#ifdef __SSE2__
+            return true;
+#else
+            return false;
+#endif
+
+        case KERNEL_AVX2:
+            return detail::colorFilterAVX2Built() && cpuHasAVX2();
+    }
+    return false;
+}
+
+void ColorFilter::setKernel(Kernel kernel)
+{
+    assert(kernelSupported(kernel) && "Kernel not supported");
+    m_kernel = kernel;
+}
+
 void ColorFilter::setupRanges()
 {
     // Zero the ranges
@@ -91,38 +184,73 @@ void ColorFilter::setupRanges()
         }
     }
 
+    setupBlockRanges();
 }
 
-void ColorFilter::filterImage(Image* input, Image* output)
+void ColorFilter::setupBlockRanges()
 {
-    int numPixels = input->getWidth() * input->getHeight();
-    int nChannels;
-    unsigned char* inputData = input->getData();
-    unsigned char* outputData = 0;
-    if (output) {
-        outputData = output->getData();
-        nChannels = output->getNumChannels();
-    } else {
-        outputData = input->getData();
-        nChannels = input->getNumChannels();
+    const unsigned char* ranges[3] =
+        {m_channel1Range, m_channel2Range, m_channel3Range};
+
+    // Each range table must be one or two runs of passing values
+    m_blockRanges = true;
+    unsigned char starts[3][2];
+    unsigned char widths[3][2];
+    for (int channel = 0; channel < 3; ++channel)
+    {
+        const unsigned char* range = ranges[channel];
+        int runs = 0;
+        for (int value = 0; value < 256; ++value)
+        {
+            if (!range[value] || (value > 0 && range[value - 1]))
+                continue;
+
+            int end = value;
+            while ((end < 255) && range[end + 1])
+                end++;
+            
+            if (runs < 2)
+            {
+                starts[channel][runs] = value;
+                widths[channel][runs] = end - value;
+            }
+            runs++;
+        }
+
+        if ((0 == runs) || (runs > 2))
+            m_blockRanges = false;
+        else if (1 == runs)
+        {
+            starts[channel][1] = starts[channel][0];
+            widths[channel][1] = widths[channel][0];
+        }
     }
 
-    for (int i = 0; i < numPixels; ++i)
+    // Lay them out the same way as 32 pixels of data
+    if (m_blockRanges)
     {
-        unsigned char result = 
-            m_channel1Range[*inputData] & 
-            m_channel2Range[*(inputData + 1)] &
-            m_channel3Range[*(inputData + 2)];
-        
-        for (int k = 0; k < nChannels; k++, outputData++) {
-            *outputData = result;
+        for (int i = 0; i < 96; ++i)
+        {
+            for (int run = 0; run < 2; ++run)
+            {
+                m_blockStart[run][i] = starts[i % 3][run];
+                m_blockWidth[run][i] = widths[i % 3][run];
+            }
         }
-        
-        inputData += 3;
     }
 }
 
+void ColorFilter::filterImage(Image* input, Image* output)
+{
+    filter(input, output, false);
+}
+
 void ColorFilter::inverseFilterImage(Image* input, Image *output)
+{
+    filter(input, output, true);
+}
+
+void ColorFilter::filter(Image* input, Image* output, bool inverse)
 {
     int numPixels = input->getWidth() * input->getHeight();
     int nChannels;
@@ -136,9 +264,35 @@ void ColorFilter::inverseFilterImage(Image* input, Image *output)
         nChannels = input->getNumChannels();
     }
 
+    // Do as much as we can in blocks of pixels, then finish up one by one
+    int done = 0;
+    if (m_blockRanges && (3 == nChannels))
+    {
+        if (KERNEL_AVX2 == m_kernel)
+        {
+            done = detail::colorFilterAVX2(inputData, outputData, numPixels,
+                                           m_blockStart, m_blockWidth,
+                                           inverse);
+        }
+        else if (KERNEL_SSE2 == m_kernel)
+        {
+            done = filterBlocks(inputData, outputData, numPixels, inverse);
+        }
+    }
+    
+    filterPixels(inputData + done * 3, outputData + done * nChannels,
+                 numPixels - done, nChannels, inverse);
+}
+
+void ColorFilter::filterPixels(unsigned char* inputData,
+                               unsigned char* outputData,
+                               int numPixels, int nChannels, bool inverse)
+{
+    unsigned char flip = inverse ? 255 : 0;
+    
     for (int i = 0; i < numPixels; ++i)
     {
-        unsigned char result = 255 * !(
+        unsigned char result = flip ^ (
             m_channel1Range[*inputData] & 
             m_channel2Range[*(inputData + 1)] &
             m_channel3Range[*(inputData + 2)]);
@@ -151,8 +305,112 @@ void ColorFilter::inverseFilterImage(Image* input, Image *output)
     }
 }
 
+#ifdef __SSE2__
+
+/** Byte i of the result is byte i + N of the stream a, b */
+template<int N>
+static inline __m128i nextBytes(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_srli_si128(a, N), _mm_slli_si128(b, 16 - N));
+}
+
+/** Byte i of the result is byte i - N of the stream a, b */
+template<int N>
+static inline __m128i prevBytes(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_slli_si128(b, N), _mm_srli_si128(a, 16 - N));
+}
+
+/** All ones in the bytes where (value - start) <= width, unsigned */
+static inline __m128i inInterval(__m128i value, __m128i start, __m128i width)
+{
+    __m128i offset = _mm_sub_epi8(value, start);
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, width), offset);
+}
+
+int ColorFilter::filterBlocks(const unsigned char* inputData,
+                              unsigned char* outputData,
+                              int numPixels, bool inverse)
+{
+    // Marks the first byte of each pixel in 48 bytes (16 pixels)
+    static const unsigned char pixelStart[48] = {
+        255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255,
+        0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0,
+        0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0 };
+    
+    __m128i start1[3], width1[3], start2[3], width2[3], first[3];
+    for (int p = 0; p < 3; ++p)
+    {
+        start1[p] = _mm_loadu_si128((const __m128i*)&m_blockStart[0][16 * p]);
+        width1[p] = _mm_loadu_si128((const __m128i*)&m_blockWidth[0][16 * p]);
+        start2[p] = _mm_loadu_si128((const __m128i*)&m_blockStart[1][16 * p]);
+        width2[p] = _mm_loadu_si128((const __m128i*)&m_blockWidth[1][16 * p]);
+        first[p] = _mm_loadu_si128((const __m128i*)&pixelStart[16 * p]);
+    }
+    __m128i flip = inverse ? _mm_set1_epi8((char)255) : _mm_setzero_si128();
+
+    int blocks = numPixels / 16;
+    for (int b = 0; b < blocks; ++b)
+    {
+        // Test every byte against the range of its channel
+        __m128i pass[3];
+        for (int p = 0; p < 3; ++p)
+        {
+            __m128i value =
+                _mm_loadu_si128((const __m128i*)(inputData + 16 * p));
+            pass[p] = _mm_or_si128(inInterval(value, start1[p], width1[p]),
+                                   inInterval(value, start2[p], width2[p]));
+        }
+
+        // Combine the three channels into the first byte of each pixel
+        __m128i zero = _mm_setzero_si128();
+        __m128i result[3];
+        result[0] = _mm_and_si128(
+            _mm_and_si128(pass[0], nextBytes<1>(pass[0], pass[1])),
+            nextBytes<2>(pass[0], pass[1]));
+        result[1] = _mm_and_si128(
+            _mm_and_si128(pass[1], nextBytes<1>(pass[1], pass[2])),
+            nextBytes<2>(pass[1], pass[2]));
+        result[2] = _mm_and_si128(
+            _mm_and_si128(pass[2], nextBytes<1>(pass[2], zero)),
+            nextBytes<2>(pass[2], zero));
+        for (int p = 0; p < 3; ++p)
+            result[p] = _mm_and_si128(result[p], first[p]);
+
+        // Then spread it back over the other two bytes
+        __m128i output[3];
+        output[0] = _mm_or_si128(
+            _mm_or_si128(result[0], prevBytes<1>(zero, result[0])),
+            prevBytes<2>(zero, result[0]));
+        output[1] = _mm_or_si128(
+            _mm_or_si128(result[1], prevBytes<1>(result[0], result[1])),
+            prevBytes<2>(result[0], result[1]));
+        output[2] = _mm_or_si128(
+            _mm_or_si128(result[2], prevBytes<1>(result[1], result[2])),
+            prevBytes<2>(result[1], result[2]));
+
+        // Only write once everything is read, so in place filtering works
+        for (int p = 0; p < 3; ++p)
+        {
+            _mm_storeu_si128((__m128i*)(outputData + 16 * p),
+                             _mm_xor_si128(output[p], flip));
+        }
+
+        inputData += 48;
+        outputData += 48;
+    }
+
+    return blocks * 16;
+}
+
+#else // __SSE2__
 
+int ColorFilter::filterBlocks(const unsigned char*, unsigned char*, int, bool)
+{
+    return 0;
+}
 
+#endif // __SSE2__
 
 void ColorFilter::setChannel1Low(int value)
 {
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/ColorFilterAVX2.cpp
+ */
+
+// This file is built with AVX2 enabled, so it includes nothing that could
+// leave AVX2 copies of shared inline functions for the rest of the library
+// to link against.  ColorFilter only calls in after checking the CPU.
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ram {
+namespace vision {
+namespace detail {
+
+#ifdef __AVX2__
+
+/** Byte i of the result is byte i + N of the stream a, b */
+template<int N>
+static inline __m256i nextBytes(__m256i a, __m256i b)
+{
+    // alignr works within each 128 bit lane, so line up the high half of a
+    // with the low half of b to cross the middle
+    __m256i middle = _mm256_permute2x128_si256(a, b, 0x21);
+    return _mm256_alignr_epi8(middle, a, N);
+}
+
+/** Byte i of the result is byte i - N of the stream a, b */
+template<int N>
+static inline __m256i prevBytes(__m256i a, __m256i b)
+{
+    __m256i middle = _mm256_permute2x128_si256(a, b, 0x21);
+    return _mm256_alignr_epi8(b, middle, 16 - N);
+}
+
+/** All ones in the bytes where (value - start) <= width, unsigned */
+static inline __m256i inInterval(__m256i value, __m256i start, __m256i width)
+{
+    __m256i offset = _mm256_sub_epi8(value, start);
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, width), offset);
+}
+
+/** Filters 32 pixels at a time, the same way as ColorFilter::filterBlocks
+ *
+ *  @return  The number of pixels filtered, the rest are left for
+ *           ColorFilter::filterPixels
+ */
+int colorFilterAVX2(const unsigned char* inputData, unsigned char* outputData,
+                    int numPixels, const unsigned char starts[2][96],
+                    const unsigned char widths[2][96], bool inverse)
+{
+    // Marks the first byte of each pixel in 96 bytes (32 pixels)
+    static const unsigned char pixelStart[96] = {
+        255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255,
+        0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0,
+        0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0,
+        255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255,
+        0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0,
+        0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0, 255, 0, 0 };
+
+    __m256i start1[3], width1[3], start2[3], width2[3], first[3];
+    for (int p = 0; p < 3; ++p)
+    {
+        start1[p] = _mm256_loadu_si256((const __m256i*)&starts[0][32 * p]);
+        width1[p] = _mm256_loadu_si256((const __m256i*)&widths[0][32 * p]);
+        start2[p] = _mm256_loadu_si256((const __m256i*)&starts[1][32 * p]);
+        width2[p] = _mm256_loadu_si256((const __m256i*)&widths[1][32 * p]);
+        first[p] = _mm256_loadu_si256((const __m256i*)&pixelStart[32 * p]);
+    }
+    __m256i flip = inverse ? _mm256_set1_epi8((char)255) :
+        _mm256_setzero_si256();
+
+    int blocks = numPixels / 32;
+    for (int b = 0; b < blocks; ++b)
+    {
+        // Test every byte against the range of its channel
+        __m256i pass[3];
+        for (int p = 0; p < 3; ++p)
+        {
+            __m256i value =
+                _mm256_loadu_si256((const __m256i*)(inputData + 32 * p));
+            pass[p] = _mm256_or_si256(
+                inInterval(value, start1[p], width1[p]),
+                inInterval(value, start2[p], width2[p]));
+        }
+
+        // Combine the three channels into the first byte of each pixel
+        __m256i zero = _mm256_setzero_si256();
+        __m256i result[3];
+        result[0] = _mm256_and_si256(
+            _mm256_and_si256(pass[0], nextBytes<1>(pass[0], pass[1])),
+            nextBytes<2>(pass[0], pass[1]));
+        result[1] = _mm256_and_si256(
+            _mm256_and_si256(pass[1], nextBytes<1>(pass[1], pass[2])),
+            nextBytes<2>(pass[1], pass[2]));
+        result[2] = _mm256_and_si256(
+            _mm256_and_si256(pass[2], nextBytes<1>(pass[2], zero)),
+            nextBytes<2>(pass[2], zero));
+        for (int p = 0; p < 3; ++p)
+            result[p] = _mm256_and_si256(result[p], first[p]);
+
+        // Then spread it back over the other two bytes
+        __m256i output[3];
+        output[0] = _mm256_or_si256(
+            _mm256_or_si256(result[0], prevBytes<1>(zero, result[0])),
+            prevBytes<2>(zero, result[0]));
+        output[1] = _mm256_or_si256(
+            _mm256_or_si256(result[1], prevBytes<1>(result[0], result[1])),
+            prevBytes<2>(result[0], result[1]));
+        output[2] = _mm256_or_si256(
+            _mm256_or_si256(result[2], prevBytes<1>(result[1], result[2])),
+            prevBytes<2>(result[1], result[2]));
+
+        // Only write once everything is read, so in place filtering works
+        for (int p = 0; p < 3; ++p)
+        {
+            _mm256_storeu_si256((__m256i*)(outputData + 32 * p),
+                                _mm256_xor_si256(output[p], flip));
+        }
+
+        inputData += 96;
+        outputData += 96;
+    }
+
+    return blocks * 32;
+}
+
+bool colorFilterAVX2Built()
+{
+    return true;
+}
+
+#else // __AVX2__
+
+int colorFilterAVX2(const unsigned char*, unsigned char*, int,
+                    const unsigned char[2][96], const unsigned char[2][96],
+                    bool)
+{
+    return 0;
+}
+
+bool colorFilterAVX2Built()
+{
+    return false;
+}
+
+#endif // __AVX2__
+
+} // namespace detail
+} // namespace vision
+} // namespace ram
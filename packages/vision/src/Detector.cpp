@@ -19,10 +19,35 @@ namespace vision {
 
 Detector::Detector(core::EventHubPtr eventHub) :
     core::EventPublisher(eventHub),
-    m_propertySet(new core::PropertySet())
+    m_propertySet(new core::PropertySet()),
+    m_imageCache(0),
+    m_localCache(0)
 {
 }
 
+Detector::~Detector()
+{
+    delete m_localCache;
+}
+
+void Detector::setImageCache(ImageCache* cache)
+{
+    m_imageCache = cache;
+}
+
+Image* Detector::getDerivedImage(Image* input, ImageCache::Derivation which)
+{
+    if (m_imageCache && (m_imageCache->getSource() == input))
+        return m_imageCache->get(which);
+
+    // Not the shared frame, we can't know if the input changed since the
+    // last call so always start over
+    if (!m_localCache)
+        m_localCache = new ImageCache();
+    m_localCache->setSource(input);
+    return m_localCache->get(which);
+}
+
 core::PropertySetPtr Detector::getPropertySet()
 {
     return m_propertySet;
@@ -20,6 +20,7 @@
 // Project Includes
 #include "vision/include/Camera.h"
 #include "vision/include/OpenCVImage.h"
+#include "vision/include/ImagePool.h"
 #include "vision/include/DuctDetector.h"
 #include "vision/include/Events.h"
 #include "vision/include/main.h"
@@ -152,8 +153,7 @@ DuctDetector::~DuctDetector()
     delete m_workingPercents;
     delete m_blackMasked;
     delete m_yellowMasked;
-    cvReleaseImage(&m_src);
-    cvReleaseImage(&m_dst);
+    cvReleaseMemStorage(&m_storage);
 }
 
 void DuctDetector::mergeBlobs(std::vector<BlobDetector::Blob> *allBlobs,
@@ -276,8 +276,7 @@ void DuctDetector::init(core::ConfigNode config)
     m_uppedGrowThreshX = config["uppedGrowThreshX"].asDouble(.5);
     m_uppedGrowThreshY = config["uppedGrowThreshY"].asDouble(.05);
 
-    m_src = cvCreateImage(cvSize(640,480), 8, 1);
-    m_dst = cvCreateImage(cvSize(640,480), 8, 1);
+    m_storage = cvCreateMemStorage(0);
 }
     
 void DuctDetector::processImage(Image* input, Image* output)
@@ -292,15 +291,6 @@ void DuctDetector::processImage(Image* input, Image* output)
     
     m_fullDuct = empty;
     m_working->copyFrom(input);
-    if (m_working->asIplImage()->width != m_src->width 
-        || m_working->asIplImage()->height != m_src->height)
-    {
-        cvReleaseImage(&m_src);
-        cvReleaseImage(&m_dst);
-
-        m_src = cvCreateImage(cvGetSize(m_working->asIplImage()),8,1);
-        m_dst = cvCreateImage(cvGetSize(m_working->asIplImage()),8,1);
-    }
     if (output)
     {
         output->copyFrom(m_working);
@@ -311,12 +301,15 @@ void DuctDetector::processImage(Image* input, Image* output)
     to_ratios(m_workingPercents->asIplImage());
     m_possiblyAligned = false;
     
-    cvCvtColor(m_working->asIplImage(),m_src,CV_BGR2GRAY);
-    CvMemStorage* storage = cvCreateMemStorage(0);
+    // Canny only reads the gray image so it can use the shared one
+    ImagePool::Scoped edges(ImagePool::getDefault(), input->getWidth(),
+                            input->getHeight(), Image::PF_GRAY_8);
+    cvClearMemStorage(m_storage);
     CvSeq* lines = 0;
-    cvCanny(m_src, m_dst, 50, 200, 3 );
+    cvCanny(getDerivedImage(input, ImageCache::GRAY)->asIplImage(),
+            edges->asIplImage(), 50, 200, 3 );
     
-    lines = cvHoughLines2(m_dst, storage, CV_HOUGH_PROBABILISTIC, 1, CV_PI/180, 10, 70, 30 );
+    lines = cvHoughLines2(edges->asIplImage(), m_storage, CV_HOUGH_PROBABILISTIC, 1, CV_PI/180, 10, 70, 30 );
     CvPoint start,end;
 	
     start.x=start.y=end.x=end.y=0;
@@ -10,6 +10,7 @@
 // Project Includes
 #include "core/include/Feature.h"
 #include "vision/include/Events.h"
+#include "vision/include/Frame.h"
 
 RAM_CORE_EVENT_TYPE(ram::vision::EventType, LIGHT_FOUND);
 RAM_CORE_EVENT_TYPE(ram::vision::EventType, LIGHT_LOST);
@@ -100,16 +101,30 @@ RAM_VISION_BARBED_WIREEVENT;
 static ram::core::SpecificEventConverter<ram::vision::HedgeEvent>
 RAM_VISION_HEDGEEVENT;
 
+static ram::core::SpecificEventConverter<ram::vision::DetectorTimingEvent>
+RAM_VISION_DETECTORTIMINGEVENT;
+
+static ram::core::SpecificEventConverter<ram::vision::RecorderWriteEvent>
+RAM_VISION_RECORDERWRITEEVENT;
+
 #endif // RAM_WITH_WRAPPERS
 
 namespace ram {
 namespace vision {
 
+ImageEvent::ImageEvent(FramePtr frame_) :
+    image(frame_ ? frame_->getImage() : 0),
+    frame(frame_)
+{
+}
+
 core::EventPtr ImageEvent::clone()
 {
     ImageEventPtr event = ImageEventPtr(new ImageEvent());
     copyInto(event);
-    // Not yet implemetned
+    // Shares the frame rather than copying the image
+    event->image = image;
+    event->frame = frame;
     return event;
 }
 
@@ -226,6 +241,35 @@ core::EventPtr HedgeEvent::clone()
     return event;
 }
 
+core::EventPtr DetectorTimingEvent::clone()
+{
+    DetectorTimingEventPtr event =
+        DetectorTimingEventPtr(new DetectorTimingEvent());
+    copyInto(event);
+    event->detector = detector;
+    event->frames = frames;
+    event->droppedFrames = droppedFrames;
+    event->minTime = minTime;
+    event->meanTime = meanTime;
+    event->maxTime = maxTime;
+    return event;
+}
+
+core::EventPtr RecorderWriteEvent::clone()
+{
+    RecorderWriteEventPtr event =
+        RecorderWriteEventPtr(new RecorderWriteEvent());
+    copyInto(event);
+    event->queueDepth = queueDepth;
+    event->peakQueueDepth = peakQueueDepth;
+    event->bytesPerSecond = bytesPerSecond;
+    event->writesPerSecond = writesPerSecond;
+    event->writeTime = writeTime;
+    event->droppedFrames = droppedFrames;
+    event->blockedTime = blockedTime;
+    return event;
+}
+
 
     
 } // namespace vision
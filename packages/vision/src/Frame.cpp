@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/Frame.cpp
+ */
+
+// Library Includes
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "vision/include/Frame.h"
+#include "vision/include/OpenCVImage.h"
+
+namespace ram {
+namespace vision {
+
+Frame::Frame(Image* image) :
+    m_image(image),
+    m_sequence(0),
+    m_timeStamp(0)
+{
+}
+
+Frame::~Frame()
+{
+    delete m_image;
+}
+
+Image* Frame::getImage() const
+{
+    return m_image;
+}
+
+boost::uint64_t Frame::getSequence() const
+{
+    return m_sequence;
+}
+
+double Frame::getTimeStamp() const
+{
+    return m_timeStamp;
+}
+
+void Frame::setCaptureInfo(boost::uint64_t sequence, double timeStamp)
+{
+    m_sequence = sequence;
+    m_timeStamp = timeStamp;
+}
+
+FramePoolPtr FramePool::create(size_t maxFree)
+{
+    return FramePoolPtr(new FramePool(maxFree));
+}
+
+FramePool::FramePool(size_t maxFree) :
+    m_maxFree(maxFree),
+    m_frameCount(0)
+{
+}
+
+FramePool::~FramePool()
+{
+    BOOST_FOREACH(Frame* frame, m_free)
+    {
+        delete frame;
+    }
+}
+
+FramePtr FramePool::acquire(size_t width, size_t height)
+{
+    Frame* frame = 0;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (!m_free.empty())
+        {
+            frame = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            m_frameCount++;
+        }
+    }
+
+    // The camera changed size, so the old buffer is no use
+    if (frame && ((frame->getImage()->getWidth() != width) ||
+                  (frame->getImage()->getHeight() != height)))
+    {
+        delete frame;
+        frame = 0;
+    }
+
+    if (!frame)
+        frame = new Frame(new OpenCVImage((int)width, (int)height));
+
+    frame->setCaptureInfo(0, 0);
+    return FramePtr(frame, Releaser(shared_from_this()));
+}
+
+size_t FramePool::getFrameCount()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_frameCount;
+}
+
+size_t FramePool::getFreeCount()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_free.size();
+}
+
+void FramePool::release(Frame* frame)
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_free.size() < m_maxFree)
+        {
+            m_free.push_back(frame);
+            return;
+        }
+        m_frameCount--;
+    }
+
+    delete frame;
+}
+
+} // namespace vision
+} // namespace ram
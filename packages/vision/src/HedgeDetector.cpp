@@ -139,9 +139,6 @@ bool HedgeDetector::processColor(Image* input, Image* output,
                                  BlobDetector::Blob& outBlob)
 {
     output->copyFrom(input);
-    output->setPixelFormat(Image::PF_RGB_8);
-    output->setPixelFormat(Image::PF_LCHUV_8);
-
     filter.filterImage(output);
 
     // Erode and dilate the image (only if necessary)
@@ -155,10 +152,7 @@ bool HedgeDetector::processColor(Image* input, Image* output,
         cvDilate(img, img, NULL, m_dilateIterations);
     }
 
-    OpenCVImage debug(output->getWidth(), output->getHeight(),
-                              Image::PF_BGR_8);
-    m_blobDetector.processImage(output, &debug);
-    //Image::showImage(&debug);
+    m_blobDetector.processImage(output);
     BlobDetector::BlobList blobs = m_blobDetector.getBlobs();
 
     BOOST_FOREACH(BlobDetector::Blob blob, blobs)
@@ -229,7 +223,8 @@ void HedgeDetector::processImage(Image* input, Image* output)
     BlobDetector::Blob hedgeBlob, leftBlob, rightBlob;
     bool found = false;
 
-    if((found = processColor(frame, greenFrame, *m_colorFilter,
+    if((found = processColor(getDerivedImage(input, ImageCache::LCHUV),
+                             greenFrame, *m_colorFilter,
                              leftBlob, rightBlob, hedgeBlob))) {
         publishFoundEvent(hedgeBlob, leftBlob, rightBlob);
 
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/ImageCache.cpp
+ */
+
+// Library Includes
+#include "cv.h"
+
+// Project Includes
+#include "vision/include/ImageCache.h"
+#include "vision/include/OpenCVImage.h"
+
+namespace ram {
+namespace vision {
+
+ImageCache::ImageCache() :
+    m_source(0),
+    m_computeCount(0)
+{
+    for (int i = 0; i < DERIVATION_COUNT; ++i)
+    {
+        m_images[i] = 0;
+        m_valid[i] = false;
+    }
+}
+
+ImageCache::~ImageCache()
+{
+    for (int i = 0; i < DERIVATION_COUNT; ++i)
+        delete m_images[i];
+}
+
+void ImageCache::setSource(Image* source)
+{
+    m_source = source;
+    for (int i = 0; i < DERIVATION_COUNT; ++i)
+        m_valid[i] = false;
+}
+
+Image* ImageCache::getSource() const
+{
+    return m_source;
+}
+
+Image* ImageCache::get(Derivation which)
+{
+    assert(m_source && "No source image to derive from");
+    assert((0 <= which) && (which < DERIVATION_COUNT) &&
+           "Invalid derivation");
+
+    // Everyone else asking for the same image waits for the first to
+    // compute it
+    boost::mutex::scoped_lock lock(m_mutexes[which]);
+    if (!m_valid[which])
+    {
+        derive(which);
+        m_valid[which] = true;
+
+        boost::mutex::scoped_lock countLock(m_countMutex);
+        m_computeCount++;
+    }
+
+    return m_images[which];
+}
+
+size_t ImageCache::getComputeCount()
+{
+    boost::mutex::scoped_lock lock(m_countMutex);
+    return m_computeCount;
+}
+
+void ImageCache::derive(Derivation which)
+{
+    size_t width = m_source->getWidth();
+    size_t height = m_source->getHeight();
+    
+    switch (which)
+    {
+        case GRAY:
+            cvCvtColor(m_source->asIplImage(),
+                       buffer(GRAY, width, height,
+                              Image::PF_GRAY_8)->asIplImage(),
+                       CV_BGR2GRAY);
+            break;
+
+        case LUV:
+            cvCvtColor(m_source->asIplImage(),
+                       buffer(LUV, width, height,
+                              Image::PF_LUV_8)->asIplImage(),
+                       CV_BGR2Luv);
+            break;
+
+        case HSV:
+            cvCvtColor(m_source->asIplImage(),
+                       buffer(HSV, width, height,
+                              Image::PF_HSV_8)->asIplImage(),
+                       CV_BGR2HSV);
+            break;
+
+        case LCHUV:
+        {
+            // Only reachable through RGB, done in place in our own copy
+            Image* image = buffer(LCHUV, width, height, Image::PF_LCHUV_8);
+            image->copyFrom(m_source);
+            image->setPixelFormat(Image::PF_RGB_8);
+            image->setPixelFormat(Image::PF_LCHUV_8);
+        }
+            break;
+
+        case HALF:
+            cvPyrDown(m_source->asIplImage(),
+                      buffer(HALF, (width + 1) / 2, (height + 1) / 2,
+                             m_source->getPixelFormat())->asIplImage());
+            break;
+
+        case QUARTER:
+        {
+            // Built from the half sized image, which others likely want too
+            Image* half = get(HALF);
+            cvPyrDown(half->asIplImage(),
+                      buffer(QUARTER, (half->getWidth() + 1) / 2,
+                             (half->getHeight() + 1) / 2,
+                             m_source->getPixelFormat())->asIplImage());
+        }
+            break;
+
+        default:
+            assert(false && "Invalid derivation");
+            break;
+    }
+}
+
+Image* ImageCache::buffer(Derivation which, size_t width, size_t height,
+                          Image::PixelFormat format)
+{
+    Image* image = m_images[which];
+    if (!image || (image->getWidth() != width) ||
+        (image->getHeight() != height) ||
+        (image->getPixelFormat() != format))
+    {
+        delete image;
+        image = new OpenCVImage(width, height, format);
+        m_images[which] = image;
+    }
+    return image;
+}
+
+} // namespace vision
+} // namespace ram
@@ -10,6 +10,7 @@
 // Project Includes
 #include "vision/include/ImageCamera.h"
 #include "vision/include/OpenCVImage.h"
+#include "vision/include/ImagePool.h"
 #include "cv.h"
 namespace ram {
 namespace vision {
@@ -29,11 +30,12 @@ ImageCamera::~ImageCamera()
 
 void ImageCamera::newImage(ram::vision::Image* image)
 {
-	OpenCVImage sizedImage(m_width, m_height);
+    // Only needed until capturedImage copies it into the frame
+    ImagePool::Scoped sizedImage(ImagePool::getDefault(), m_width, m_height);
 	IplImage* img = image->asIplImage();
-	IplImage* dest = sizedImage.asIplImage();
+	IplImage* dest = sizedImage->asIplImage();
 	cvResize(img,dest);
-    capturedImage(&sizedImage);
+    capturedImage(sizedImage.get());
 }
 
 void ImageCamera::update(double)
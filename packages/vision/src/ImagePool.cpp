@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/ImagePool.cpp
+ */
+
+// STD Includes
+#include <cassert>
+
+// Library Includes
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "vision/include/ImagePool.h"
+#include "vision/include/OpenCVImage.h"
+
+namespace ram {
+namespace vision {
+
+ImagePool::Scoped::Scoped(ImagePool* pool, size_t width, size_t height,
+                          Image::PixelFormat fmt) :
+    m_pool(pool),
+    m_image(pool->acquire(width, height, fmt))
+{
+}
+
+ImagePool::Scoped::~Scoped()
+{
+    m_pool->release(m_image);
+}
+    
+ImagePool::ImagePool(size_t maxFree) :
+    m_maxFree(maxFree)
+{
+    m_free.reserve(maxFree + 1);
+    
+    m_stats.acquires = 0;
+    m_stats.allocations = 0;
+    m_stats.discards = 0;
+    m_stats.outstanding = 0;
+    m_stats.free = 0;
+}
+
+ImagePool::~ImagePool()
+{
+    assert(0 == m_stats.outstanding && "Images still acquired from pool");
+    clear();
+}
+
+ImagePool* ImagePool::getDefault()
+{
+    static ImagePool pool;
+    return &pool;
+}
+
+Image* ImagePool::acquire(size_t width, size_t height, Image::PixelFormat fmt)
+{
+    assert((Image::PF_START < fmt) && (fmt < Image::PF_END) &&
+           "Invalid pixel format");
+    
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stats.acquires++;
+        m_stats.outstanding++;
+        
+        // Newest first, it is most likely to still be in the cache
+        for (size_t i = m_free.size(); i > 0; --i)
+        {
+            Image* image = m_free[i - 1];
+            if ((image->getWidth() == width) &&
+                (image->getHeight() == height) &&
+                (image->getPixelFormat() == fmt))
+            {
+                m_free.erase(m_free.begin() + (i - 1));
+                return image;
+            }
+        }
+
+        m_stats.allocations++;
+    }
+
+    return new OpenCVImage(width, height, fmt);
+}
+
+void ImagePool::release(Image* image)
+{
+    assert(image && "Can't release a null image");
+    
+    Image* discard = 0;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        assert(m_stats.outstanding > 0 && "Image not from this pool");
+        m_stats.outstanding--;
+
+        // Make room by dropping the image which has gone unused longest
+        m_free.push_back(image);
+        if (m_free.size() > m_maxFree)
+        {
+            discard = m_free.front();
+            m_free.erase(m_free.begin());
+            m_stats.discards++;
+        }
+    }
+
+    delete discard;
+}
+
+void ImagePool::clear()
+{
+    std::vector<Image*> images;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        images.swap(m_free);
+        m_free.reserve(m_maxFree + 1);
+    }
+    
+    BOOST_FOREACH(Image* image, images)
+    {
+        delete image;
+    }
+}
+
+ImagePool::Stats ImagePool::getStats()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    Stats stats = m_stats;
+    stats.free = m_free.size();
+    return stats;
+}
+
+} // namespace vision
+} // namespace ram
@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/ImageStream.cpp
+ */
+
+// STD Includes
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+// Library Includes
+#include "cv.h"
+#include "highgui.h"
+
+// Project Includes
+#include "vision/include/ImageStream.h"
+#include "vision/include/OpenCVImage.h"
+#include "vision/include/quicklz.h"
+
+namespace ram {
+namespace vision {
+
+static const boost::uint32_t REQUEST_MAGIC = 0x52414D53; // "RAMS"
+static const boost::uint32_t FRAME_MAGIC = 0x52414D46; // "RAMF"
+
+/** Extra room QuickLZ may need when data does not compress */
+static const size_t QLZ_OVERHEAD = 400;
+
+static void putU16(unsigned char* buffer, boost::uint16_t value)
+{
+    buffer[0] = (unsigned char)(value >> 8);
+    buffer[1] = (unsigned char)value;
+}
+
+static void putU32(unsigned char* buffer, boost::uint32_t value)
+{
+    buffer[0] = (unsigned char)(value >> 24);
+    buffer[1] = (unsigned char)(value >> 16);
+    buffer[2] = (unsigned char)(value >> 8);
+    buffer[3] = (unsigned char)value;
+}
+
+static boost::uint16_t getU16(const unsigned char* buffer)
+{
+    return (boost::uint16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static boost::uint32_t getU32(const unsigned char* buffer)
+{
+    return ((boost::uint32_t)buffer[0] << 24) |
+        ((boost::uint32_t)buffer[1] << 16) |
+        ((boost::uint32_t)buffer[2] << 8) | (boost::uint32_t)buffer[3];
+}
+
+/** Copies the rows of a BGR image next to each other, dropping padding */
+static void packRows(Image* image, unsigned char* dest)
+{
+    IplImage* ipl = image->asIplImage();
+    assert(3 == ipl->nChannels && "Only BGR images can be streamed");
+
+    size_t rowSize = image->getWidth() * 3;
+    for (size_t y = 0; y < image->getHeight(); ++y)
+    {
+        memcpy(dest + y * rowSize, ipl->imageData + y * ipl->widthStep,
+               rowSize);
+    }
+}
+
+/** Reverses packRows */
+static void unpackRows(const unsigned char* source, Image* image)
+{
+    IplImage* ipl = image->asIplImage();
+    size_t rowSize = image->getWidth() * 3;
+    for (size_t y = 0; y < image->getHeight(); ++y)
+    {
+        memcpy(ipl->imageData + y * ipl->widthStep, source + y * rowSize,
+               rowSize);
+    }
+}
+
+ImageStream::Request::Request() :
+    width(0),
+    height(0),
+    codec(JPEG),
+    quality(0)
+{
+}
+
+ImageStream::FrameHeader::FrameHeader() :
+    sequence(0),
+    width(0),
+    height(0),
+    codec(RAW),
+    size(0)
+{
+}
+
+ImageStream::ImageStream() :
+    m_scratch(std::max(QLZ_SCRATCH_COMPRESS, QLZ_SCRATCH_DECOMPRESS)),
+    m_image(0)
+{
+}
+
+ImageStream::~ImageStream()
+{
+    delete m_image;
+}
+
+void ImageStream::packRequest(const Request& request, unsigned char* buffer)
+{
+    putU32(buffer, REQUEST_MAGIC);
+    buffer[4] = VERSION;
+    buffer[5] = (unsigned char)request.codec;
+    buffer[6] = (unsigned char)request.quality;
+    buffer[7] = 0;
+    putU16(buffer + 8, request.width);
+    putU16(buffer + 10, request.height);
+}
+
+bool ImageStream::unpackRequest(const unsigned char* buffer,
+                                Request& request)
+{
+    if ((REQUEST_MAGIC != getU32(buffer)) || (VERSION != buffer[4]) ||
+        (buffer[5] >= CODEC_END) || (buffer[6] > 100))
+    {
+        return false;
+    }
+
+    request.codec = (Codec)buffer[5];
+    request.quality = buffer[6];
+    request.width = getU16(buffer + 8);
+    request.height = getU16(buffer + 10);
+    return true;
+}
+
+void ImageStream::packHeader(const FrameHeader& header,
+                             unsigned char* buffer)
+{
+    putU32(buffer, FRAME_MAGIC);
+    putU32(buffer + 4, header.sequence);
+    putU16(buffer + 8, header.width);
+    putU16(buffer + 10, header.height);
+    buffer[12] = (unsigned char)header.codec;
+    buffer[13] = buffer[14] = buffer[15] = 0;
+    putU32(buffer + 16, header.size);
+}
+
+bool ImageStream::unpackHeader(const unsigned char* buffer,
+                               FrameHeader& header)
+{
+    if ((FRAME_MAGIC != getU32(buffer)) || (buffer[12] >= CODEC_END))
+        return false;
+
+    header.sequence = getU32(buffer + 4);
+    header.width = getU16(buffer + 8);
+    header.height = getU16(buffer + 10);
+    header.codec = (Codec)buffer[12];
+    header.size = getU32(buffer + 16);
+
+    // No codec makes an image much bigger than its raw pixels, so anything
+    // more is a corrupt stream and not worth allocating memory for
+    size_t rawSize = (size_t)header.width * header.height * 3;
+    return (0 < rawSize) && (header.size <= 2 * rawSize + QLZ_OVERHEAD);
+}
+
+const std::vector<unsigned char>& ImageStream::encode(Image* image,
+                                                      Codec codec,
+                                                      int quality)
+{
+    size_t rawSize = image->getWidth() * image->getHeight() * 3;
+
+    switch (codec)
+    {
+        case RAW:
+            m_data.resize(rawSize);
+            packRows(image, &m_data[0]);
+            break;
+
+        case QUICKLZ:
+        {
+            m_raw.resize(rawSize);
+            packRows(image, &m_raw[0]);
+
+            m_data.resize(rawSize + QLZ_OVERHEAD);
+            size_t size = qlz_compress(&m_raw[0], (char*)&m_data[0], rawSize,
+                                       &m_scratch[0]);
+            m_data.resize(size);
+        }
+            break;
+
+        case JPEG:
+        {
+            std::vector<int> params;
+            if (quality > 0)
+            {
+                params.push_back(CV_IMWRITE_JPEG_QUALITY);
+                params.push_back(quality);
+            }
+            cv::imencode(".jpg", cv::Mat(image->asIplImage()), m_data,
+                         params);
+        }
+            break;
+
+        default:
+            assert(false && "Invalid codec");
+            break;
+    }
+
+    return m_data;
+}
+
+Image* ImageStream::decode(const FrameHeader& header,
+                           const std::vector<unsigned char>& data)
+{
+    size_t rawSize = (size_t)header.width * header.height * 3;
+    if (0 == rawSize)
+        return 0;
+
+    switch (header.codec)
+    {
+        case RAW:
+        {
+            if (data.size() != rawSize)
+                return 0;
+
+            Image* image = decodeImage(header.width, header.height);
+            unpackRows(&data[0], image);
+            return image;
+        }
+
+        case QUICKLZ:
+        {
+            if ((data.size() < 9) ||
+                (qlz_size_compressed((const char*)&data[0]) != data.size()) ||
+                (qlz_size_decompressed((const char*)&data[0]) != rawSize))
+            {
+                return 0;
+            }
+
+            // Returns 0 when the data is corrupt (QLZ_MEMORY_SAFE)
+            m_raw.resize(rawSize);
+            if (qlz_decompress((const char*)&data[0], &m_raw[0],
+                               &m_scratch[0]) != rawSize)
+            {
+                return 0;
+            }
+
+            Image* image = decodeImage(header.width, header.height);
+            unpackRows(&m_raw[0], image);
+            return image;
+        }
+
+        case JPEG:
+        {
+            // Garbage data can either throw or give back an empty image
+            cv::Mat mat;
+            try
+            {
+                mat = cv::imdecode(cv::Mat(data), 1);
+            }
+            catch (cv::Exception&)
+            {
+                return 0;
+            }
+            if (mat.empty() || (mat.cols != header.width) ||
+                (mat.rows != header.height))
+            {
+                return 0;
+            }
+
+            IplImage ipl = (IplImage) mat;
+            OpenCVImage decoded(&ipl, false);
+            Image* image = decodeImage(header.width, header.height);
+            image->copyFrom(&decoded);
+            return image;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+Image* ImageStream::decodeImage(int width, int height)
+{
+    if (!m_image || ((int)m_image->getWidth() != width) ||
+        ((int)m_image->getHeight() != height))
+    {
+        delete m_image;
+        m_image = new OpenCVImage(width, height, Image::PF_BGR_8);
+    }
+    return m_image;
+}
+
+} // namespace vision
+} // namespace ram
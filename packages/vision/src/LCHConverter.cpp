@@ -26,6 +26,12 @@ bool LCHConverter::lookupInit = false;
 
 unsigned char LCHConverter::rgb2lchLookup[256][256][256][3] = {{{{0}}}};
 
+boost::once_flag LCHConverter::lookupLoad = BOOST_ONCE_INIT;
+
+double LCHConverter::gammaTable[256] = {0};
+
+boost::once_flag LCHConverter::gammaInit = BOOST_ONCE_INIT;
+
 // gamma correction factor
 static double gamma = 2.2; // sRGB
     
@@ -188,36 +194,126 @@ void LCHConverter::convert(vision::Image* image)
 {
     assert(image->getPixelFormat() == Image::PF_RGB_8 && "Incorrect Pixel Format");
 
-    bool lookupTableAvailable = true;
-    if(!lookupInit)
-        lookupTableAvailable = loadLookupTable();
+    boost::call_once(&LCHConverter::loadLookupTableOnce, lookupLoad);
     
     unsigned char *data = (unsigned char *) image->getData();
 
     unsigned int numpixels = image->getWidth() * image->getHeight();
-    for(unsigned int pix = 0; pix < numpixels; pix++)
+    if (lookupInit)
     {
-        unsigned char ch1 = data[0];
-        unsigned char ch2 = data[1];
-        unsigned char ch3 = data[2];
-
-        if (lookupTableAvailable) {
-            unsigned char *tablePos = rgb2lchLookup[ch1][ch2][ch3];
-            ch1 = tablePos[0];
-            ch2 = tablePos[1];
-            ch3 = tablePos[2];
-        } else {
-            convertPixel(ch1, ch2, ch3);
+        for(unsigned int pix = 0; pix < numpixels; pix++)
+        {
+            unsigned char *tablePos = rgb2lchLookup[data[0]][data[1]][data[2]];
+            data[0] = tablePos[0];
+            data[1] = tablePos[1];
+            data[2] = tablePos[2];
+            data += 3;
         }
+    }
+    else
+    {
+        convertPixels(data, numpixels);
+    }
+}
+
+void LCHConverter::createGammaTable()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        double ch1 = (double) i / 255, ch2 = 0, ch3 = 0;
+        invGammaCorrection(&ch1, &ch2, &ch3);
+        gammaTable[i] = ch1;
+    }
+}
 
-        data[0] = ch1;
-        data[1] = ch2;
-        data[2] = ch3;
+void LCHConverter::convertPixels(unsigned char* data, size_t count)
+{
+    boost::call_once(&LCHConverter::createGammaTable, gammaInit);
+
+    // Every step does the same operations in the same order as the single
+    // pixel functions, so the results match convertPixel to the bit
+    const double m00 = rgb2xyzTransform[0][0], m01 = rgb2xyzTransform[0][1],
+        m02 = rgb2xyzTransform[0][2], m10 = rgb2xyzTransform[1][0],
+        m11 = rgb2xyzTransform[1][1], m12 = rgb2xyzTransform[1][2],
+        m20 = rgb2xyzTransform[2][0], m21 = rgb2xyzTransform[2][1],
+        m22 = rgb2xyzTransform[2][2];
+
+    double ch1[BLOCK_SIZE], ch2[BLOCK_SIZE], ch3[BLOCK_SIZE];
+    double up[BLOCK_SIZE], vp[BLOCK_SIZE], yr[BLOCK_SIZE];
+
+    while (count > 0)
+    {
+        size_t n = (count < BLOCK_SIZE) ? count : BLOCK_SIZE;
 
-        data += 3;
+        for (size_t i = 0; i < n; i++)
+        {
+            ch1[i] = gammaTable[data[3 * i]];
+            ch2[i] = gammaTable[data[3 * i + 1]];
+            ch3[i] = gammaTable[data[3 * i + 2]];
+        }
+
+        // rgb2xyz, then the parts of xyz2luv that don't need pow
+        for (size_t i = 0; i < n; i++)
+        {
+            double X = m00 * ch1[i] + m01 * ch2[i] + m02 * ch3[i];
+            double Y = m10 * ch1[i] + m11 * ch2[i] + m12 * ch3[i];
+            double Z = m20 * ch1[i] + m21 * ch2[i] + m22 * ch3[i];
+
+            double pxDenom = (X + (15 * Y) + (3 * Z));
+            up[i] = (4 * X) / pxDenom;
+            vp[i] = (9 * Y) / pxDenom;
+            yr[i] = Y / Y_ref;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (yr[i] > eps)
+                ch1[i] = 116 * pow(yr[i], .3333) - 16;
+            else
+                ch1[i] = kappa * yr[i];
+        }
+
+        // The rest of xyz2luv and the chrominance of luv2lch_uv
+        for (size_t i = 0; i < n; i++)
+        {
+            double L = ch1[i];
+            double u = 13 * L * (up[i] - u_prime_ref);
+            double v = 13 * L * (vp[i] - v_prime_ref);
+            ch1[i] = L*2.55;
+            ch2[i] = sqrt(u*u + v*v);
+            up[i] = u;
+            vp[i] = v;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            double h = atan2(vp[i], up[i]) / math::Math::PI;
+            while(h < 0)
+                h += 2;
+            while(h > 2)
+                h -= 2;
+            ch3[i] = h * 127.5;
+        }
+
+        // Through int, the same way convertPixel's conversions compile
+        for (size_t i = 0; i < n; i++)
+        {
+            data[3 * i] = (unsigned char)(int) ch1[i];
+            data[3 * i + 1] = (unsigned char)(int) ch2[i];
+            data[3 * i + 2] = (unsigned char)(int) ch3[i];
+        }
+
+        data += 3 * n;
+        count -= n;
     }
 }
 
+void LCHConverter::loadLookupTableOnce()
+{
+    if (!lookupInit)
+        loadLookupTable();
+}
+
 void LCHConverter::convertPixel(unsigned char &r,
                                 unsigned char &g,
                                 unsigned char &b)
@@ -279,7 +375,10 @@ bool LCHConverter::loadLookupTable()
 {
     std::ifstream lookupFile;
     char *data = (char *) &rgb2lchLookup[0][0][0][0];
-    std::string baseDir(getenv("RAM_SVN_DIR"));
+    const char* svnDir = getenv("RAM_SVN_DIR");
+    if (!svnDir)
+        return false;
+    std::string baseDir(svnDir);
     lookupFile.open((baseDir + "/rgb2luvLookup.bin").c_str(),
                     std::ios::in | std::ios::binary);
     
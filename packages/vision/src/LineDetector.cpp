@@ -291,6 +291,7 @@ int LineDetector::houghTransform()
             LineDetector::Line(pt1, pt2, math::Radian(theta), rho));
     }
 
+    cvReleaseMemStorage(&storage);
     return m_lines.size();
 }
 
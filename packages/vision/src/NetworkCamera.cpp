@@ -14,89 +14,91 @@
 #include <boost/asio.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
-#include <highgui.h>
 
 // Project includes
 #include "vision/include/NetworkCamera.h"
-#include "vision/include/NetworkRecorder.h"
-#include "vision/include/OpenCVImage.h"
+#include "vision/include/Image.h"
 
 namespace ram {
 namespace vision {
 
-NetworkCamera::NetworkCamera(std::string hostname, boost::uint16_t port)
+NetworkCamera::NetworkCamera(std::string hostname, boost::uint16_t port,
+                             int width, int height,
+                             ImageStream::Codec codec, int quality)
     : m_hostname(hostname)
     , m_port(boost::lexical_cast<std::string>(port))
-    , m_width(320)
-    , m_height(240)
+    , m_socket(io_service)
+    , m_connected(false)
+    , m_lastSequence(0)
+    , m_width(width ? width : 320)
+    , m_height(height ? height : 240)
+    , m_droppedFrames(0)
 {
+    m_request.width = width;
+    m_request.height = height;
+    m_request.codec = codec;
+    m_request.quality = quality;
 }
 
 NetworkCamera::~NetworkCamera()
 {
+    // Wake up an update blocked waiting for the next image
+    if (m_connected)
+    {
+        boost::system::error_code error;
+        m_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+    }
+
     // Have to stop background capture before we release the capture!
     cleanup();
 }
 
 void NetworkCamera::update(double timestep)
 {
-    using namespace boost::asio::ip;
+    if (!m_connected && !connect())
+        return; // could not connect to host
 
-    tcp::socket socket(io_service);
+    // read in the image data
+    try {
+        unsigned char headerBuffer[ImageStream::HEADER_SIZE];
+        boost::asio::read(m_socket, boost::asio::buffer(headerBuffer));
 
-    tcp::endpoint none;
-    if (m_endpoint == none) {
-        // New connection
-        tcp::resolver resolver(io_service);
-        tcp::resolver::query query(m_hostname, m_port);
+        ImageStream::FrameHeader header;
+        if (!ImageStream::unpackHeader(headerBuffer, header)) {
+            std::cout << "invalid image header received!" << std::endl;
+            disconnect();
+            return;
+        }
 
-        tcp::resolver::iterator iter = resolver.resolve(query);
-        tcp::resolver::iterator end;
-        boost::system::error_code error = boost::asio::error::host_not_found;
-        do {
-            socket.close();
-            socket.connect(*iter, error);
-        } while (error && ++iter != end);
+        m_data.resize(header.size);
+        boost::asio::read(m_socket, boost::asio::buffer(m_data),
+                          boost::asio::transfer_all());
 
-        if (error)
-            return; // could not connect to host
-        else {
-            // Save endpoint for next time
-            m_endpoint = *iter;
+        // The recorder skips frames when we can't keep up
+        if (m_lastSequence && (header.sequence > m_lastSequence + 1))
+        {
+            boost::mutex::scoped_lock lock(m_diagLock);
+            m_droppedFrames += header.sequence - m_lastSequence - 1;
         }
-    } else {
-        boost::system::error_code error;
-        socket.connect(m_endpoint, error);
+        m_lastSequence = header.sequence;
 
-        if (error) {
-            // host has succeeded in the past, but now fails. reset.
-            m_endpoint = none;
+        Image* image = m_stream.decode(header, m_data);
+        if (!image) {
+            std::cout << "could not decode image!" << std::endl;
             return;
         }
-    }
 
-    // read in the image data
-    try {
-        size_t packetSize;
-        boost::asio::read(socket, boost::asio::buffer(
-                              &packetSize, sizeof(size_t)));
-
-        std::vector<unsigned char> buf(packetSize);
-        size_t len = boost::asio::read(
-            socket, boost::asio::buffer(buf), boost::asio::transfer_all());
-        if (len != packetSize) {
-            std::cout << "incorrect number of bytes received!" << std::endl;
-            return;
+        {
+            boost::mutex::scoped_lock lock(m_diagLock);
+            m_width = header.width;
+            m_height = header.height;
         }
 
-        cv::Mat mat = cv::imdecode(cv::Mat(buf), 1);
-        IplImage img = (IplImage) mat;
-        OpenCVImage newImage(&img, false);
-
-        capturedImage(&newImage);
+        capturedImage(image);
     } catch (boost::system::system_error &error) {
         // bad error (don't want to crash though, so don't rethrow)
         std::cout << error.what() << std::endl;
+        disconnect();
     }
 }
 
@@ -131,5 +133,70 @@ double NetworkCamera::currentTime()
     return 0;
 }
 
+boost::uint32_t NetworkCamera::droppedFrames()
+{
+    boost::mutex::scoped_lock lock(m_diagLock);
+    return m_droppedFrames;
+}
+
+bool NetworkCamera::connect()
+{
+    using namespace boost::asio::ip;
+
+    boost::system::error_code error = boost::asio::error::host_not_found;
+
+    tcp::endpoint none;
+    if (m_endpoint == none) {
+        // New connection
+        tcp::resolver resolver(io_service);
+        tcp::resolver::query query(m_hostname, m_port);
+
+        tcp::resolver::iterator iter = resolver.resolve(query, error);
+        tcp::resolver::iterator end;
+        while (iter != end) {
+            m_socket.close();
+            m_socket.connect(*iter, error);
+            if (!error)
+                break;
+            ++iter;
+        }
+
+        if (error)
+            return false;
+
+        // Save endpoint for next time
+        m_endpoint = *iter;
+    } else {
+        m_socket.connect(m_endpoint, error);
+
+        if (error) {
+            // host has succeeded in the past, but now fails. reset.
+            m_socket.close();
+            m_endpoint = none;
+            return false;
+        }
+    }
+
+    // Ask for the stream, the images follow until the connection closes
+    unsigned char requestBuffer[ImageStream::REQUEST_SIZE];
+    ImageStream::packRequest(m_request, requestBuffer);
+    boost::asio::write(m_socket, boost::asio::buffer(requestBuffer), error);
+    if (error) {
+        m_socket.close();
+        return false;
+    }
+
+    m_connected = true;
+    m_lastSequence = 0;
+    return true;
+}
+
+void NetworkCamera::disconnect()
+{
+    boost::system::error_code error;
+    m_socket.close(error);
+    m_connected = false;
+}
+
 } // namespace vision
 } // namespace ram
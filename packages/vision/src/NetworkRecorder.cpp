@@ -18,8 +18,9 @@
 // Library Includes
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
-#include <highgui.h>
+#include "cv.h"
 
 // Project Includes
 #include "vision/include/NetworkRecorder.h"
@@ -41,7 +42,8 @@ NetworkRecorder::NetworkRecorder(Camera* camera,
                                  int recordWidth, int recordHeight) :
     Recorder(camera, policy, policyArg, recordWidth, recordHeight),
     m_acceptor(io_service, tcp::endpoint(tcp::v4(), port)),
-    m_buffer(new OpenCVImage()) // size will be changed by copyFrom
+    m_buffer(new OpenCVImage()), // size will be changed by copyFrom
+    m_sequence(0)
 {
     start_accept();
     m_bthread = new boost::thread(
@@ -55,13 +57,22 @@ NetworkRecorder::~NetworkRecorder()
     cleanUp();
     io_service.stop();
     m_bthread->join();
+    delete m_bthread;
+
+    m_clients.clear();
     delete m_buffer;
 }
 
+size_t NetworkRecorder::getClientCount()
+{
+    boost::mutex::scoped_lock lock(m_clientLock);
+    return m_clients.size();
+}
+
 void NetworkRecorder::start_accept()
 {
     Connection::pointer new_connection =
-        Connection::create(m_acceptor.io_service());
+        Connection::create(io_service, this);
 
     m_acceptor.async_accept(
         new_connection->socket(),
@@ -73,44 +84,129 @@ void NetworkRecorder::handle_accept(Connection::pointer new_connection,
                                     const boost::system::error_code& error)
 {
     if (!error)
-    {
-        {
-            OpenCVImage image;
-            {
-                boost::mutex::scoped_lock lock(m_lock);
-                image.copyFrom(m_buffer);
-                image.setSize(160, 120);
-            }
-
-            new_connection->sendImage(&image);
-        }
+        new_connection->start();
 
+    // Only stop accepting when we are shutting down
+    if (error != ba::error::operation_aborted)
         start_accept();
-    }
 }
 
 void NetworkRecorder::recordFrame(Image* image)
+{
+    {
+        boost::mutex::scoped_lock lock(m_lock);
+        m_buffer->copyFrom(image);
+        m_sequence++;
+    }
+
+    // Encoding and sending is done on the network thread
+    io_service.post(boost::bind(&NetworkRecorder::sendToClients, this));
+}
+
+bool NetworkRecorder::latestFrame(boost::uint32_t& sequence, Image* image)
 {
     boost::mutex::scoped_lock lock(m_lock);
-    m_buffer->copyFrom(image);
+    if (m_sequence == sequence)
+        return false;
+
+    image->copyFrom(m_buffer);
+    sequence = m_sequence;
+    return true;
+}
+
+void NetworkRecorder::sendToClients()
+{
+    // Only this thread changes the set so it does not need locking here
+    BOOST_FOREACH(Connection::pointer client, m_clients)
+    {
+        client->sendLatest();
+    }
+}
+
+void NetworkRecorder::addClient(Connection::pointer client)
+{
+    boost::mutex::scoped_lock lock(m_clientLock);
+    m_clients.insert(client);
+}
+
+void NetworkRecorder::removeClient(Connection::pointer client)
+{
+    boost::mutex::scoped_lock lock(m_clientLock);
+    m_clients.erase(client);
 }
     
 NetworkRecorder::Connection::pointer
-NetworkRecorder::Connection::create(ba::io_service& io)
+NetworkRecorder::Connection::create(ba::io_service& io,
+                                    NetworkRecorder* recorder)
 {
     return NetworkRecorder::Connection::pointer(
-        new NetworkRecorder::Connection(io));
+        new NetworkRecorder::Connection(io, recorder));
+}
+
+NetworkRecorder::Connection::~Connection()
+{
+    delete m_frame;
+    delete m_scaled;
 }
 
-void NetworkRecorder::Connection::sendImage(Image *img)
+void NetworkRecorder::Connection::start()
 {
-    std::vector<unsigned char> buf;
-    cv::imencode(".jpg", cv::Mat(img->asIplImage()), buf);
+    ba::async_read(m_socket,
+                   ba::buffer(m_requestBuffer, ImageStream::REQUEST_SIZE),
+                   boost::bind(&Connection::handleRequest, shared_from_this(),
+                               ba::placeholders::error));
+}
+
+void NetworkRecorder::Connection::sendLatest()
+{
+    if (m_writing)
+        return;
+
+    // Skips straight to the newest frame if the client fell behind
+    if (!m_recorder->latestFrame(m_lastSequence, m_frame))
+        return;
 
-    // send compressed data
-    size_t len = buf.size();
-    ba::write(m_socket, ba::buffer(&len, sizeof(size_t)));
-    ba::write(m_socket, ba::buffer(buf), ba::transfer_all());
+    int width = m_frame->getWidth();
+    int height = m_frame->getHeight();
+    if (m_request.width && (m_request.width < width))
+        width = m_request.width;
+    if (m_request.height && (m_request.height < height))
+        height = m_request.height;
+
+    Image* image = m_frame;
+    if (((int)m_frame->getWidth() != width) ||
+        ((int)m_frame->getHeight() != height))
+    {
+        if (!m_scaled || ((int)m_scaled->getWidth() != width) ||
+            ((int)m_scaled->getHeight() != height))
+        {
+            delete m_scaled;
+            m_scaled = new OpenCVImage(width, height, Image::PF_BGR_8);
+        }
+        cvResize(m_frame->asIplImage(), m_scaled->asIplImage());
+        image = m_scaled;
+    }
+
+    // The encoded data stays valid until the write finishes
+    const std::vector<unsigned char>& data =
+        m_stream.encode(image, m_request.codec, m_request.quality);
+
+    ImageStream::FrameHeader header;
+    header.sequence = m_lastSequence;
+    header.width = width;
+    header.height = height;
+    header.codec = m_request.codec;
+    header.size = data.size();
+    ImageStream::packHeader(header, m_headerBuffer);
+
+    std::vector<ba::const_buffer> buffers;
+    buffers.push_back(ba::buffer(m_headerBuffer));
+    buffers.push_back(ba::buffer(data));
+
+    m_writing = true;
+    ba::async_write(m_socket, buffers,
+                    boost::bind(&Connection::handleWrite, shared_from_this(),
+                                ba::placeholders::error));
 }
 
 tcp::socket& NetworkRecorder::Connection::socket()
@@ -118,10 +214,56 @@ tcp::socket& NetworkRecorder::Connection::socket()
     return m_socket;
 }
 
-NetworkRecorder::Connection::Connection(ba::io_service& io)
-    : m_socket(io)
+NetworkRecorder::Connection::Connection(ba::io_service& io,
+                                        NetworkRecorder* recorder) :
+    m_socket(io),
+    m_recorder(recorder),
+    m_writing(false),
+    m_lastSequence(0),
+    m_frame(new OpenCVImage()),
+    m_scaled(0)
 {
 }
+
+void NetworkRecorder::Connection::handleRequest(
+    const boost::system::error_code& error)
+{
+    // Scaling up only wastes bandwidth, and a bad request could ask for
+    // gigabytes of image
+    if (error || !ImageStream::unpackRequest(m_requestBuffer, m_request) ||
+        (m_request.width > m_recorder->getRecordingWidth()) ||
+        (m_request.height > m_recorder->getRecordingHeight()))
+    {
+        close();
+        return;
+    }
+
+    // Start with the current frame, then every new one
+    m_recorder->addClient(shared_from_this());
+    sendLatest();
+}
+
+void NetworkRecorder::Connection::handleWrite(
+    const boost::system::error_code& error)
+{
+    m_writing = false;
+    if (error)
+    {
+        close();
+        return;
+    }
+
+    // Catch up with any frames recorded while this one was sent
+    sendLatest();
+}
+
+void NetworkRecorder::Connection::close()
+{
+    m_recorder->removeClient(shared_from_this());
+
+    boost::system::error_code error;
+    m_socket.close(error);
+}
     
 } // namespace vision
 } // namespace ram
@@ -43,7 +43,8 @@ static bool pipeToCenterComparer(PipeDetector::Pipe b1, PipeDetector::Pipe b2)
 OrangePipeDetector::OrangePipeDetector(core::ConfigNode config,
                                        core::EventHubPtr eventHub) :
     PipeDetector(config, eventHub),
-    m_centered(false)
+    m_centered(false),
+    m_working(new OpenCVImage(640, 480))
 {
     init(config);
 }
@@ -150,6 +151,7 @@ void OrangePipeDetector::setUseLUVFilter(bool value)
 
 OrangePipeDetector::~OrangePipeDetector()
 {
+    delete m_working;
 }
 
 void OrangePipeDetector::processImage(Image* input, Image* output)
@@ -163,21 +165,25 @@ void OrangePipeDetector::processImage(Image* input, Image* output)
     
     // Mask orange takes frame, then alter image, then strictness (true=more
 
+    // The input frame is shared with other readers, so filter a copy
+    m_working->copyFrom(input);
+
     // Filter the image for the proper color
     if (m_useLUVFilter)
-        filterForOrangeNew(input);
+        filterForOrangeNew(m_working);
     else
-        filterForOrangeOld(input);
+        filterForOrangeOld(m_working);
 
     // 3 x 3 default erosion element, default 3 iterations.
-    cvErode(input->asIplImage(), input->asIplImage(), 0, m_erodeIterations);
+    cvErode(m_working->asIplImage(), m_working->asIplImage(), 0,
+            m_erodeIterations);
 
     // Debug display
     if (output)
-        output->copyFrom(input);
+        output->copyFrom(m_working);
 
     // Find all of our pipes
-    PipeDetector::processImage(input, output);
+    PipeDetector::processImage(m_working, output);
     PipeDetector::PipeList pipes = getPipes();
 
     // Determine if we found any pipes
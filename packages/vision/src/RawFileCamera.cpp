@@ -9,10 +9,13 @@
 
 // STD Includes
 #include <cstdio>
+#include <algorithm>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 
 // Library Includes
+#include <boost/bind.hpp>
 
 // Project Includes
 #include "vision/include/RawFileCamera.h"
@@ -30,8 +33,23 @@ RawFileCamera::RawFileCamera(std::string filename) :
     m_currentTime(0),
     m_currentFrame(0),
     m_dataBuffer(0),
+    m_dataBufferSize(0),
+    m_image(0),
     m_file(0),
-    m_fileSize(0)
+    m_fileSize(0),
+    m_indexed(false),
+    m_codec(ImageStream::RAW),
+    m_index(0),
+    m_frameCount(0),
+    m_map(0),
+    m_mapSize(0),
+    m_backImage(0),
+    m_decoder(0),
+    m_nextFrame(0),
+    m_readyFrame(-1),
+    m_readyGood(false),
+    m_corruptFrames(0),
+    m_shutdown(false)
 {
     // Open up the file
     m_file = open(filename.c_str(), O_RDONLY);
@@ -47,13 +65,33 @@ RawFileCamera::RawFileCamera(std::string filename) :
            && "Invalid RawFile magic number");
 
     // Verifty the version
-    assert(header.versionNumber == RawFileRecorder::RMV_VERSION
+    assert(((header.versionNumber == RawFileRecorder::RMV_VERSION) ||
+            (header.versionNumber == RawFileRecorder::RMV_INDEXED_VERSION))
            && "Invalid RawFile version number");
 
     // Set up basic parameters
     m_width = header.width;
     m_height = header.height;
     m_fps = header.framerate;
+
+    if (header.versionNumber == RawFileRecorder::RMV_INDEXED_VERSION)
+    {
+        m_indexed = true;
+        m_codec = (ImageStream::Codec)header.codec;
+        assert((m_codec < ImageStream::CODEC_END) && "Invalid RawFile codec");
+
+        loadIndex(header);
+        if (m_frameCount > 0)
+        {
+            m_duration = m_index[m_frameCount - 1].timestamp + 1 / m_fps;
+            m_image = new OpenCVImage(m_width, m_height, Image::PF_BGR_8);
+            m_backImage = new OpenCVImage(m_width, m_height, Image::PF_BGR_8);
+        }
+
+        m_decoder = new boost::thread(
+            boost::bind(&RawFileCamera::decodeLoop, this));
+        return;
+    }
     
     // Determine File Length
     m_fileSize = lseek(m_file, 0, SEEK_END);
@@ -75,26 +113,48 @@ RawFileCamera::~RawFileCamera()
 {
     // Have to stop background capture before we release the capture!
     cleanup();
+
+    if (m_decoder)
+    {
+        {
+            boost::mutex::scoped_lock lock(m_decodeMutex);
+            m_shutdown = true;
+            m_decodeWanted.notify_all();
+        }
+        m_decoder->join();
+        delete m_decoder;
+    }
+
+    if (m_map)
+        munmap(m_map, m_mapSize);
     
     //fclose(m_file);
     close(m_file);
+    delete m_image;
+    delete m_backImage;
     delete[] m_dataBuffer;
 }
 
 void RawFileCamera::update(double timestep)
 {
+    if (m_indexed)
+    {
+        updateIndexed();
+        return;
+    }
+
     // Grab the next frame
     readNextFrame();
 
-    // Copy image to public side of the interface
-    Image* newImage = new OpenCVImage(m_dataBuffer, width(),
-                                      height(), false, Image::PF_BGR_8);
-
-    // Notfiy everyone that the image is uploaded
-    capturedImage(newImage);
+    // Wrap the buffer once instead of every frame
+    if (!m_image)
+    {
+        m_image = new OpenCVImage(m_dataBuffer, width(), height(), false,
+                                  Image::PF_BGR_8);
+    }
 
-    // Remove the temp image
-    delete newImage;
+    // Copy image to public side of the interface and notify everyone
+    capturedImage(m_image);
 }
 
     
@@ -122,7 +182,9 @@ void RawFileCamera::readNextFrame(bool hurryUp)
     // Resize the picture buffer if needed
     if ((packet.dataSize + sizeof(RawFileRecorder::Packet)) > m_dataBufferSize)
     {
-        delete m_dataBuffer;
+        delete m_image;
+        m_image = 0;
+        delete[] m_dataBuffer;
         m_dataBufferSize = packet.dataSize + sizeof(RawFileRecorder::Packet);
         m_dataBuffer = new unsigned char[m_dataBufferSize];
     }
@@ -180,6 +242,31 @@ double RawFileCamera::duration()
 
 void RawFileCamera::seekToTime(double seconds)
 {
+    if (m_indexed)
+    {
+        // First frame at or after the given time
+        size_t frame = 0;
+        size_t count = m_frameCount;
+        while (count > 0)
+        {
+            size_t half = count / 2;
+            if (m_index[frame + half].timestamp < seconds)
+            {
+                frame += half + 1;
+                count -= half + 1;
+            }
+            else
+            {
+                count = half;
+            }
+        }
+
+        seekTo((int)frame);
+        if (frame < m_frameCount)
+            m_currentTime = m_index[frame].timestamp;
+        return;
+    }
+
     int frameNum = (int)(seconds * fps());
     seekTo(frameNum - 1);
     
@@ -205,6 +292,16 @@ void RawFileCamera::seekTo(int frame)
     /// TODO: make this a slighty smarter seeker
     if (frame < 0)
         frame = 0;
+
+    if (m_indexed)
+    {
+        // The decoder starts on the new frame right away
+        boost::mutex::scoped_lock lock(m_decodeMutex);
+        m_nextFrame = std::min((size_t)frame, m_frameCount);
+        m_readyFrame = -1;
+        m_decodeWanted.notify_all();
+        return;
+    }
     
     int fileOffset = sizeof(RawFileRecorder::Header) +
         (m_dataBufferSize * frame);
@@ -219,5 +316,180 @@ void RawFileCamera::seekTo(int frame)
     assert(ret == fileOffset && "Error seeking in file");
 }
 
+size_t RawFileCamera::frameCount()
+{
+    return m_frameCount;
+}
+
+size_t RawFileCamera::corruptFrames()
+{
+    boost::mutex::scoped_lock lock(m_decodeMutex);
+    return m_corruptFrames;
+}
+
+void RawFileCamera::loadIndex(const RawFileRecorder::Header& header)
+{
+    off_t fileSize = lseek(m_file, 0, SEEK_END);
+    assert(fileSize > 0 && "error reading size");
+
+    // Check for a complete index at the end of the file
+    RawFileRecorder::Trailer trailer = {0};
+    off_t trailerOffset = fileSize - sizeof(RawFileRecorder::Trailer);
+    if (trailerOffset >= (off_t)sizeof(RawFileRecorder::Header))
+    {
+        int readCount = pread(m_file, &trailer,
+                              sizeof(RawFileRecorder::Trailer), trailerOffset);
+        assert(readCount == sizeof(RawFileRecorder::Trailer) && "Error reading");
+    }
+
+    off_t indexSize =
+        (off_t)trailer.frameCount * sizeof(RawFileRecorder::IndexEntry);
+    if ((RawFileRecorder::INDEX_MAGIC_NUMBER == trailer.magicNumber) &&
+        ((off_t)trailer.indexOffset + indexSize == trailerOffset))
+    {
+        m_frameCount = trailer.frameCount;
+        if (0 == m_frameCount)
+            return;
+
+        // Mappings have to start on a page
+        off_t pageSize = sysconf(_SC_PAGESIZE);
+        off_t start = trailer.indexOffset / pageSize * pageSize;
+        m_mapSize = trailer.indexOffset + indexSize - start;
+        m_map = mmap(0, m_mapSize, PROT_READ, MAP_SHARED, m_file, start);
+        assert((MAP_FAILED != m_map) && "Error mapping index");
+
+        m_index = (const RawFileRecorder::IndexEntry*)
+            ((const char*)m_map + (trailer.indexOffset - start));
+        return;
+    }
+
+    // No index, the recording was cut short, so find the whole packets
+    off_t offset = sizeof(RawFileRecorder::Header);
+    while (offset + (off_t)sizeof(RawFileRecorder::Packet) <= fileSize)
+    {
+        RawFileRecorder::Packet packet;
+        int readCount = pread(m_file, &packet, sizeof(RawFileRecorder::Packet),
+                              offset);
+        assert(readCount == sizeof(RawFileRecorder::Packet) && "Error reading");
+
+        off_t next = offset + sizeof(RawFileRecorder::Packet) + packet.dataSize;
+        if ((packet.magicNumber != RawFileRecorder::MAGIC_NUMBER) ||
+            (next > fileSize))
+        {
+            break;
+        }
+
+        RawFileRecorder::IndexEntry entry = {
+            (boost::uint64_t)offset, packet.timestamp, packet.framenum,
+            packet.dataSize};
+        m_scannedIndex.push_back(entry);
+        offset = next;
+    }
+
+    m_frameCount = m_scannedIndex.size();
+    if (m_frameCount > 0)
+        m_index = &m_scannedIndex[0];
+}
+
+void RawFileCamera::decodeLoop()
+{
+    boost::mutex::scoped_lock lock(m_decodeMutex);
+    while (!m_shutdown)
+    {
+        // Wait until the frame wanted next is not decoded yet
+        if ((m_readyFrame == (int)m_nextFrame) ||
+            (m_nextFrame >= m_frameCount))
+        {
+            m_decodeWanted.wait(lock);
+            continue;
+        }
+
+        // update only touches m_backImage once m_readyFrame is set, so it
+        // is safe to fill without the lock
+        size_t frame = m_nextFrame;
+        lock.unlock();
+        bool good = decodeFrame(frame);
+        lock.lock();
+
+        // Throw it away if there was a seek in the mean time
+        if (frame == m_nextFrame)
+        {
+            m_readyFrame = (int)frame;
+            m_readyGood = good;
+            m_decodeReady.notify_all();
+        }
+    }
+}
+
+bool RawFileCamera::decodeFrame(size_t frame)
+{
+    const RawFileRecorder::IndexEntry& entry = m_index[frame];
+
+    ImageStream::FrameHeader header;
+    header.width = m_width;
+    header.height = m_height;
+    header.codec = m_codec;
+    header.size = entry.dataSize;
+
+    m_packetData.resize(entry.dataSize);
+    off_t offset = entry.offset + sizeof(RawFileRecorder::Packet);
+    size_t done = 0;
+    while (done < m_packetData.size())
+    {
+        int readCount = pread(m_file, &m_packetData[done],
+                              m_packetData.size() - done, offset + done);
+        if (readCount == -1)
+            perror("Error in reading");
+        if (readCount <= 0)
+            return false;
+        done += readCount;
+    }
+
+    Image* decoded = m_stream.decode(header, m_packetData);
+    if (!decoded)
+        return false;
+
+    m_backImage->copyFrom(decoded);
+    return true;
+}
+
+void RawFileCamera::updateIndexed()
+{
+    boost::mutex::scoped_lock lock(m_decodeMutex);
+
+    // At the end keep giving out the last frame, like uncompressed files
+    if (m_nextFrame >= m_frameCount)
+    {
+        lock.unlock();
+        if (m_frameCount > 0)
+            capturedImage(m_image);
+        return;
+    }
+
+    while (m_readyFrame != (int)m_nextFrame)
+        m_decodeReady.wait(lock);
+
+    // A corrupt frame repeats the last good one, so playback keeps going
+    if (m_readyGood)
+    {
+        std::swap(m_image, m_backImage);
+    }
+    else
+    {
+        fprintf(stderr, "WARNING: Skipping corrupt frame %u in RawFile\n",
+                (unsigned)m_index[m_nextFrame].framenum);
+        m_corruptFrames++;
+    }
+    m_currentFrame = m_index[m_nextFrame].framenum;
+    m_currentTime = m_index[m_nextFrame].timestamp;
+    m_nextFrame++;
+    m_readyFrame = -1;
+    m_decodeWanted.notify_all();
+    lock.unlock();
+
+    // The decoder is now working on the next frame in the other image
+    capturedImage(m_image);
+}
+
 } // namespace vision
 } // namespace ram
@@ -10,33 +10,50 @@
 
 // STD Includes
 #include <cstdio>
+#include <algorithm>
 
 // Project Includes
 #include "vision/include/RawFileRecorder.h"
 #include "vision/include/Camera.h"
 #include "vision/include/Image.h"
+#include "vision/include/Events.h"
+
+#include "core/include/TimeVal.h"
+
+RAM_CORE_EVENT_TYPE(ram::vision::RawFileRecorder, WRITE_STATS);
 
 namespace ram {
 namespace vision {
 
 const boost::uint32_t RawFileRecorder::MAGIC_NUMBER = 0xC1A55AC5;
 const boost::uint32_t RawFileRecorder::RMV_VERSION = 2;
+const boost::uint32_t RawFileRecorder::RMV_INDEXED_VERSION = 3;
+const boost::uint32_t RawFileRecorder::INDEX_MAGIC_NUMBER = 0xC1A55AC6;
     
 RawFileRecorder::RawFileRecorder(Camera* camera,
                                  Recorder::RecordingPolicy policy,
                                  std::string filename, int policyArg,
-                                 int recordWidth, int recordHeight) :
+                                 int recordWidth, int recordHeight,
+                                 ImageStream::Codec codec,
+                                 AsyncFileWriter::Options options,
+                                 core::EventHubPtr eventHub) :
     Recorder(camera, policy, policyArg, recordWidth, recordHeight),
-    m_file(0),
+    EventPublisher(eventHub),
+    m_writer(0),
     m_framenum(0),
-    m_lastPacketSizeWritten(0)
+    m_lastPacketSizeWritten(0),
+    m_reportStart(core::Updatable::monotonicTime()),
+    m_codec(codec),
+    m_startTime(-1),
+    m_position(0)
 {
     assert((RP_START < policy) && (policy < RP_END) &&
            "Invalid recording policy");
+    assert((0 <= codec) && (codec < ImageStream::CODEC_END) &&
+           "Invalid codec");
 
     // Open our video file
-    m_file = fopen(filename.c_str(), "w");
-    assert(m_file && "Error opening file");
+    m_writer = new AsyncFileWriter(filename, options);
     
     // Determine video FPS (default to 30)
     double fps = 30;
@@ -62,11 +79,14 @@ RawFileRecorder::RawFileRecorder(Camera* camera,
     header.format = (boost::uint32_t)Image::PF_BGR_8;
     header.framerate = fps;
     header.versionNumber = RMV_VERSION;
+    if (ImageStream::RAW != m_codec)
+    {
+        header.versionNumber = RMV_INDEXED_VERSION;
+        header.codec = (boost::uint32_t)m_codec;
+    }
     
-    // Write the header out to disk then flush to disk
-    size_t written = fwrite(&header, sizeof(Header), 1, m_file);
-    assert(written == 1 && "Error writing to disk");
-    fflush(m_file);
+    // Write the header out to disk
+    writeRecord(&header, sizeof(Header));
 
     // Run update as fast as possible
     background(-1);
@@ -77,31 +97,120 @@ RawFileRecorder::~RawFileRecorder()
     // Stop the background thread and events
     cleanUp();
 
-    // Close our file
-    fclose(m_file);
+    if (ImageStream::RAW != m_codec)
+        writeIndex();
+
+    // Write out the remaining frames and close our file
+    delete m_writer;
+}
+
+void RawFileRecorder::flush()
+{
+    m_writer->flush();
+}
+
+AsyncFileWriter::Stats RawFileRecorder::getWriterStats()
+{
+    return m_writer->getStats();
 }
 
 void RawFileRecorder::recordFrame(Image* image)
 {
     // Pack up the header
-    Packet packet;
+    boost::int64_t now = core::Updatable::monotonicTime();
+    if (m_startTime < 0)
+        m_startTime = now;
+
+    Packet packet = {0};
     packet.magicNumber = MAGIC_NUMBER;
     packet.lastPacketSize = m_lastPacketSizeWritten;
     packet.dataSize = image->getWidth() * image->getHeight() * 3;
     packet.framenum = m_framenum;
-    
-    // Write the header
-    size_t written = fwrite(&packet, sizeof(Packet), 1, m_file);
-    assert(written == 1 && "Error packet header to disk");
-    m_lastPacketSizeWritten = written * sizeof(Packet);
-    
-    // Write the date
-    written = fwrite(image->getData(), packet.dataSize, 1, m_file);
-    assert(written == 1 && "Error packet data to disk");
-    m_lastPacketSizeWritten += written * packet.dataSize;
+    packet.timestamp = (double)(now - m_startTime) / core::USEC_PER_SEC;
+
+    const void* data = image->getData();
+    if (ImageStream::RAW != m_codec)
+    {
+        const std::vector<unsigned char>& encoded =
+            m_stream.encode(image, m_codec);
+        packet.dataSize = encoded.size();
+        data = &encoded[0];
+    }
+
+    // Queue the header and data, unless the disk is too far behind, then
+    // the whole frame is dropped but still counted so times stay right
+    if (m_writer->beginRecord(sizeof(Packet) + packet.dataSize))
+    {
+        m_writer->write(&packet, sizeof(Packet));
+        m_writer->write(data, packet.dataSize);
+        m_writer->endRecord();
+        m_lastPacketSizeWritten = sizeof(Packet) + packet.dataSize;
+
+        if (ImageStream::RAW != m_codec)
+        {
+            IndexEntry entry = {m_position, packet.timestamp, packet.framenum,
+                                packet.dataSize};
+            m_index.push_back(entry);
+        }
+        m_position += m_lastPacketSizeWritten;
+    }
     
     // Increment out counf of frames recorded
     m_framenum++;
+
+    publishStats();
+}
+
+void RawFileRecorder::publishStats()
+{
+    boost::int64_t now = core::Updatable::monotonicTime();
+    boost::int64_t elapsed = now - m_reportStart;
+    if (elapsed < core::USEC_PER_SEC)
+        return;
+
+    AsyncFileWriter::Stats stats = m_writer->getStats();
+    double seconds = (double)elapsed / core::USEC_PER_SEC;
+
+    RecorderWriteEventPtr event(new RecorderWriteEvent());
+    event->queueDepth = (int)stats.queueDepth;
+    event->peakQueueDepth = (int)stats.peakQueueDepth;
+    event->bytesPerSecond =
+        (stats.bytesWritten - m_reportStats.bytesWritten) / seconds;
+    event->writesPerSecond = (stats.writes - m_reportStats.writes) / seconds;
+    event->writeTime = stats.writeTime - m_reportStats.writeTime;
+    event->droppedFrames =
+        (int)(stats.droppedRecords - m_reportStats.droppedRecords);
+    event->blockedTime = stats.blockedTime - m_reportStats.blockedTime;
+    publish(WRITE_STATS, event);
+
+    m_reportStart = now;
+    m_reportStats = stats;
+    m_writer->resetPeakQueueDepth();
+}
+
+void RawFileRecorder::writeRecord(const void* data, size_t size)
+{
+    m_writer->beginRecord(size, true);
+    m_writer->write(data, size);
+    m_writer->endRecord();
+    m_position += size;
+}
+
+void RawFileRecorder::writeIndex()
+{
+    Trailer trailer = {0};
+    trailer.magicNumber = INDEX_MAGIC_NUMBER;
+    trailer.frameCount = m_index.size();
+    trailer.indexOffset = m_position;
+
+    // Small pieces so they fit however small the write buffers are
+    static const size_t CHUNK = 128;
+    for (size_t i = 0; i < m_index.size(); i += CHUNK)
+    {
+        size_t count = std::min(CHUNK, m_index.size() - i);
+        writeRecord(&m_index[i], count * sizeof(IndexEntry));
+    }
+    writeRecord(&trailer, sizeof(Trailer));
 }
 
 } // namespace vision
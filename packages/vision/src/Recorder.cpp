@@ -15,6 +15,7 @@
 
 // Library Includes
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
@@ -26,6 +27,7 @@
 #include "vision/include/OpenCVImage.h"
 #include "vision/include/Camera.h"
 #include "vision/include/Events.h"
+#include "vision/include/Frame.h"
 
 #include "vision/include/FileRecorder.h"
 #include "vision/include/RawFileRecorder.h"
@@ -46,9 +48,9 @@ Recorder::Recorder(Camera* camera, Recorder::RecordingPolicy policy,
     m_policyArg(policyArg),
     m_width(recordWidth),
     m_height(recordHeight),
-    m_newFrame(false),
+    m_lastSequence(0),
+    m_droppedFrames(0),
     m_camera(camera),
-    m_frameFromCamera(new OpenCVImage(camera->width(), camera->height())),
     m_frameResized(new OpenCVImage(recordWidth, recordHeight)),
     m_currentTime(0),
     m_nextRecordTime(0)
@@ -69,7 +71,6 @@ Recorder::~Recorder()
            "Recorder::cleanUp() not called by subclass");
     
     delete m_frameResized;
-    delete m_frameFromCamera;
 }
 
 void Recorder::update(double timeSinceLastUpdate)
@@ -93,28 +94,43 @@ void Recorder::update(double timeSinceLastUpdate)
         // FALL THROUGH - based on current time
             
         case NEXT_FRAME:
-            // Check to see if we have a new frame waiting
-            if (m_newFrame)
+        {
+            // Take the new frame waiting, if any, it is shared with the
+            // camera so we record straight from it without a copy
+            FramePtr frame;
             {
-                // Get a working copy of new frame from the camera
-                m_camera->getImage(m_frameFromCamera);
+                boost::mutex::scoped_lock lock(m_mutex);
+                frame.swap(m_pendingFrame);
+                
+                // Skip frames we have already recorded
+                if (frame && frame->getSequence() <= m_lastSequence)
+                    frame = FramePtr();
 
-                if(m_frameFromCamera->getWidth() != m_width ||
-                   m_frameFromCamera->getHeight() != m_height)
+                if (frame)
+                {
+                    if (m_lastSequence)
+                    {
+                        m_droppedFrames +=
+                            frame->getSequence() - m_lastSequence - 1;
+                    }
+                    m_lastSequence = frame->getSequence();
+                }
+            }
+            
+            if (frame)
+            {
+                Image* image = frame->getImage();
+                if(image->getWidth() != m_width ||
+                   image->getHeight() != m_height)
                 {
-                    cvResize(m_frameFromCamera->asIplImage(),
+                    cvResize(image->asIplImage(),
                              m_frameResized->asIplImage());
                     
                     recordFrame(m_frameResized);
                 }
                 else
                 {
-                    recordFrame(m_frameFromCamera);
-                }
-
-                {
-                    boost::mutex::scoped_lock lock(m_mutex);
-                    m_newFrame = false;
+                    recordFrame(image);
                 }
             }
             else
@@ -126,6 +142,7 @@ void Recorder::update(double timeSinceLastUpdate)
                 else if (backgrounded())
                     core::TimeVal::sleep(1.0/30.0);
             }
+        }
             break;
 
         default:
@@ -138,7 +155,7 @@ void Recorder::background(int interval)
 {
     {
         boost::mutex::scoped_lock lock(m_mutex);
-        m_newFrame = false;
+        m_pendingFrame = FramePtr();
     }
     Updatable::background(interval);
 }
@@ -153,12 +170,19 @@ size_t Recorder::getRecordingHeight() const
     return m_height;
 }
 
+boost::uint64_t Recorder::getDroppedFrames()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_droppedFrames;
+}
+
 Recorder* Recorder::createRecorderFromString(const std::string& str,
                                              Camera* camera,
                                              std::string& message,
                                              Recorder::RecordingPolicy policy,
                                              int policyArg,
-                                             std::string recorderDir)
+                                             std::string recorderDir,
+                                             core::EventHubPtr eventHub)
 {
     static boost::regex port("(\\d{1,5})");
     static boost::regex typeArg("([^(]+)(\\(([^)]+)\\))?");
@@ -179,19 +203,76 @@ Recorder* Recorder::createRecorderFromString(const std::string& str,
     if (argStr.size() > 0)
         ba::split(args, argStr, ba::is_any_of(","));
     
+    // Numbers are the size, the rest are options for the file writer
+    std::vector<std::string> sizeArgs;
+    AsyncFileWriter::Options writerOptions;
+    std::stringstream optionsMessage;
+    BOOST_FOREACH(std::string arg, args)
+    {
+        ba::trim(arg);
+        std::string::size_type equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value;
+        if (std::string::npos != equals)
+            value = arg.substr(equals + 1);
+
+        if ("direct" == name)
+        {
+            writerOptions.direct = value.empty() || ("1" == value) ||
+                ("true" == value);
+        }
+        else if ("preallocate" == name)
+        {
+            // lexical_cast would take "-1" and wrap it around
+            try {
+                if (value.empty() || (std::string::npos !=
+                                      value.find_first_not_of("0123456789")))
+                {
+                    throw boost::bad_lexical_cast();
+                }
+                writerOptions.preallocate =
+                    boost::lexical_cast<boost::uint64_t>(value) * 1024 * 1024;
+            } catch (boost::bad_lexical_cast&) {
+                std::cerr << "Invalid preallocate size: " << value
+                          << std::endl;
+                return 0;
+            }
+        }
+        else if (("drop" == name) && ("newest" == value))
+        {
+            writerOptions.dropPolicy = AsyncFileWriter::DROP_NEWEST;
+        }
+        else if (("drop" == name) && ("block" == value))
+        {
+            writerOptions.dropPolicy = AsyncFileWriter::BLOCK;
+        }
+        else if (!arg.empty() &&
+                 (std::string::npos == arg.find_first_not_of("0123456789")))
+        {
+            sizeArgs.push_back(arg);
+            continue;
+        }
+        else
+        {
+            std::cerr << "Invalid recorder option: " << arg << std::endl;
+            return 0;
+        }
+        optionsMessage << " " << arg;
+    }
 
     // The first two args are always size
-    if (args.size() == 1u)
+    if (sizeArgs.size() == 1u)
     {
-        std::cerr << "Invalid number of args: " << args.size() << std::endl;
+        std::cerr << "Invalid number of args: " << sizeArgs.size()
+                  << std::endl;
         return 0;
     }
     int width = 640;
     int height = 480;
-    if (args.size() >= 2u)
+    if (sizeArgs.size() >= 2u)
     {
-        width = boost::lexical_cast<int>(args[0]);
-        height = boost::lexical_cast<int>(args[1]);
+        width = boost::lexical_cast<int>(sizeArgs[0]);
+        height = boost::lexical_cast<int>(sizeArgs[1]);
         assert(width > 0 && "Record width must be positive");
         assert(height > 0 && "Record height must be positive");
     }
@@ -225,7 +306,17 @@ Recorder* Recorder::createRecorderFromString(const std::string& str,
         {
             ss << " as raw .rmv";
             recorder = new vision::RawFileRecorder(camera, policy, fullPath,
-                                                   policyArg, width, height);
+                                                   policyArg, width, height,
+                                                   ImageStream::RAW,
+                                                   writerOptions, eventHub);
+        }
+        else if (".rmvz" == extension)
+        {
+            ss << " as QuickLZ compressed .rmvz";
+            recorder = new vision::RawFileRecorder(camera, policy, fullPath,
+                                                   policyArg, width, height,
+                                                   ImageStream::QUICKLZ,
+                                                   writerOptions, eventHub);
         }
         else
         {
@@ -235,6 +326,15 @@ Recorder* Recorder::createRecorderFromString(const std::string& str,
         }
     }
 
+    // Only the raw file recorders write through an AsyncFileWriter
+    if (!optionsMessage.str().empty())
+    {
+        if (dynamic_cast<vision::RawFileRecorder*>(recorder))
+            ss << ", options:" << optionsMessage.str();
+        else
+            ss << ", ignoring options:" << optionsMessage.str();
+    }
+
     message = ss.str();
     return recorder;
 }
@@ -247,15 +347,22 @@ void Recorder::cleanUp()
 
 void Recorder::waitForImage(Camera* camera)
 {
-    camera->waitForImage(0);
+    // A frame can arrive after update checked for one but before we start
+    // waiting, so don't wait for longer than a frame before checking again
+    boost::xtime timeout = {0, (int)(1e6 * 1000/33)}; // 33 milliseconds
+    camera->waitForImage(0, timeout);
 }
     
 void Recorder::newImageCapture(core::EventPtr event)
 {
-    // Do as little as possible here.  Let the recorder know a
-    // new frame is available.
+    // Do as little as possible here.  Just hold onto the frame, replacing
+    // any we have not gotten to yet.
+    ImageEventPtr imageEvent = boost::dynamic_pointer_cast<ImageEvent>(event);
+    if (!imageEvent || !imageEvent->frame)
+        return;
+    
     boost::mutex::scoped_lock lock(m_mutex);
-    m_newFrame = true;
+    m_pendingFrame = imageEvent->frame;
 }
 
 } // namespace vision
@@ -390,9 +390,8 @@ void RedLightDetector::filterForRedOld(IplImage* image, IplImage* flashFrame)
 void RedLightDetector::filterForRedNew(IplImage* image)
 {
     cvCvtColor(image, image, CV_BGR2Luv);
-    Image* tmpImage = new OpenCVImage(image, false);
-    m_filter->filterImage(tmpImage);
-    delete tmpImage;
+    OpenCVImage tmpImage(image, false);
+    m_filter->filterImage(&tmpImage);
 }
     
 void RedLightDetector::publishFoundEvent(double lightPixelRadius)
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/src/TrackingWindow.cpp
+ */
+
+// STD Includes
+#include <cmath>
+#include <algorithm>
+
+// Library Includes
+#include "cv.h"
+#include <boost/foreach.hpp>
+
+// Project Includes
+#include "vision/include/TrackingWindow.h"
+#include "vision/include/OpenCVImage.h"
+#include "vision/include/LCHConverter.h"
+
+#include "core/include/PropertySet.h"
+
+namespace ram {
+namespace vision {
+
+/** Makes a header for part of an 8 bit, 3 channel image without copying */
+static void regionHeader(IplImage* header, Image* image,
+                         const RegionOfInterest& region)
+{
+    IplImage* full = image->asIplImage();
+    cvInitImageHeader(header, cvSize(region.width(), region.height()),
+                      IPL_DEPTH_8U, 3);
+    cvSetData(header, full->imageData + region.minY() * full->widthStep +
+              region.minX() * 3, full->widthStep);
+}
+
+TrackingWindow::TrackingWindow() :
+    m_enabled(false),
+    m_margin(0.5),
+    m_minMargin(16),
+    m_fullSearchInterval(15),
+    m_maxLevel(0),
+    m_minLevelSize(32),
+    m_tracking(false),
+    m_velocityX(0),
+    m_velocityY(0),
+    m_framesSinceFullSearch(0),
+    m_windowed(false),
+    m_frameWidth(0),
+    m_frameHeight(0),
+    m_region(0, 1, 0, 1),
+    m_level(0),
+    m_windowedFrames(0),
+    m_fullFrames(0)
+{
+    for (int i = 0; i < WINDOW_FORMAT_COUNT; ++i)
+        m_windows[i] = 0;
+}
+
+TrackingWindow::~TrackingWindow()
+{
+    for (int i = 0; i < WINDOW_FORMAT_COUNT; ++i)
+        delete m_windows[i];
+}
+
+void TrackingWindow::addPropertiesToSet(core::PropertySetPtr propSet,
+                                        core::ConfigNode* config)
+{
+    propSet->addProperty(*config, false, "roiEnabled",
+        "Only search near the target once it is found", false, &m_enabled);
+
+    propSet->addProperty(*config, false, "roiMargin",
+        "Fraction of the target size to search on each side",
+        0.5, &m_margin, 0.0, 5.0);
+
+    propSet->addProperty(*config, false, "roiMinMargin",
+        "Fewest pixels to search on each side of the target",
+        16, &m_minMargin, 0, 640);
+
+    propSet->addProperty(*config, false, "roiFullSearchInterval",
+        "Frames between searches of the whole image",
+        15, &m_fullSearchInterval, 1, 300);
+
+    propSet->addProperty(*config, false, "roiMaxLevel",
+        "Most times to halve the search window resolution",
+        0, &m_maxLevel, 0, 4);
+
+    propSet->addProperty(*config, false, "roiMinLevelSize",
+        "Smallest target size in pixels after halving",
+        32, &m_minLevelSize, 1, 640);
+}
+
+void TrackingWindow::copySettings(const TrackingWindow& other)
+{
+    m_enabled = other.m_enabled;
+    m_margin = other.m_margin;
+    m_minMargin = other.m_minMargin;
+    m_fullSearchInterval = other.m_fullSearchInterval;
+    m_maxLevel = other.m_maxLevel;
+    m_minLevelSize = other.m_minLevelSize;
+}
+
+void TrackingWindow::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+void TrackingWindow::setMaxLevel(int level)
+{
+    m_maxLevel = level;
+}
+
+bool TrackingWindow::beginFrame(int width, int height)
+{
+    m_frameWidth = width;
+    m_frameHeight = height;
+    m_windowed = false;
+    m_region = RegionOfInterest(0, width, 0, height);
+    m_level = 0;
+
+    if (m_enabled && m_tracking &&
+        (m_framesSinceFullSearch < m_fullSearchInterval))
+    {
+        // Grow the last bounds by the margin and the distance the target
+        // has been moving, centered on where it should be now
+        int marginX = std::max(m_minMargin,
+                               (int)(m_margin * m_target.getWidth())) +
+            (int)std::fabs(m_velocityX);
+        int marginY = std::max(m_minMargin,
+                               (int)(m_margin * m_target.getHeight())) +
+            (int)std::fabs(m_velocityY);
+        int shiftX = (int)m_velocityX;
+        int shiftY = (int)m_velocityY;
+
+        int minX = std::max(0, m_target.getMinX() + shiftX - marginX);
+        int maxX = std::min(width, m_target.getMaxX() + 1 + shiftX + marginX);
+        int minY = std::max(0, m_target.getMinY() + shiftY - marginY);
+        int maxY = std::min(height,
+                            m_target.getMaxY() + 1 + shiftY + marginY);
+
+        if ((minX < maxX) && (minY < maxY))
+        {
+            m_windowed = true;
+            m_region = RegionOfInterest(minX, maxX, minY, maxY);
+
+            // Only shrink while the target stays big enough to find
+            int targetSize = std::min(m_target.getWidth(),
+                                      m_target.getHeight());
+            while ((m_level < m_maxLevel) &&
+                   ((targetSize >> (m_level + 1)) >= m_minLevelSize))
+            {
+                m_level++;
+            }
+        }
+    }
+
+    if (m_windowed)
+    {
+        m_framesSinceFullSearch++;
+        m_windowedFrames++;
+    }
+    else
+    {
+        m_framesSinceFullSearch = 0;
+        m_fullFrames++;
+    }
+
+    return m_windowed;
+}
+
+RegionOfInterest TrackingWindow::getRegion() const
+{
+    return m_region;
+}
+
+int TrackingWindow::getLevel() const
+{
+    return m_level;
+}
+
+Image* TrackingWindow::extract(Image* frame, Image::PixelFormat format)
+{
+    assert(frame->getNumChannels() == 3 && "Frame must be BGR");
+    assert(((Image::PF_BGR_8 == format) || (Image::PF_RGB_8 == format) ||
+            (Image::PF_LCHUV_8 == format)) && "Unsupported window format");
+
+    int width = std::max(1, m_region.width() >> m_level);
+    int height = std::max(1, m_region.height() >> m_level);
+
+    IplImage source;
+    regionHeader(&source, frame, m_region);
+
+    Image* window = windowImage(width, height, Image::PF_BGR_8);
+    if (0 == m_level)
+        cvCopy(&source, window->asIplImage());
+    else
+        cvResize(&source, window->asIplImage(), CV_INTER_AREA);
+
+    if (Image::PF_BGR_8 != format)
+    {
+        window = windowImage(width, height, Image::PF_RGB_8);
+        cvCvtColor(window->asIplImage(), window->asIplImage(), CV_BGR2RGB);
+    }
+
+    if (Image::PF_LCHUV_8 == format)
+    {
+        LCHConverter::convert(window);
+        window = windowImage(width, height, Image::PF_LCHUV_8);
+    }
+
+    return window;
+}
+
+void TrackingWindow::paste(Image* window, Image* frame)
+{
+    cvZero(frame->asIplImage());
+
+    IplImage dest;
+    regionHeader(&dest, frame, m_region);
+    if (0 == m_level)
+        cvCopy(window->asIplImage(), &dest);
+    else
+        cvResize(window->asIplImage(), &dest, CV_INTER_NN);
+}
+
+int TrackingWindow::toWindowArea(int framePixels) const
+{
+    // Each level halves both sides
+    return framePixels >> (2 * m_level);
+}
+
+BlobDetector::Blob TrackingWindow::toFrame(const BlobDetector::Blob& blob) const
+{
+    int scale = 1 << m_level;
+    int offsetX = m_region.minX();
+    int offsetY = m_region.minY();
+    int lastX = m_region.maxX() - 1;
+    int lastY = m_region.maxY() - 1;
+
+    // Each window pixel covers a scale by scale block of the frame
+    return BlobDetector::Blob(
+        blob.getSize() * scale * scale,
+        std::min(lastX, blob.getCenterX() * scale + scale / 2 + offsetX),
+        std::min(lastY, blob.getCenterY() * scale + scale / 2 + offsetY),
+        std::min(lastX, blob.getMaxX() * scale + scale - 1 + offsetX),
+        blob.getMinX() * scale + offsetX,
+        std::min(lastY, blob.getMaxY() * scale + scale - 1 + offsetY),
+        blob.getMinY() * scale + offsetY);
+}
+
+BlobDetector::BlobList TrackingWindow::toFrame(
+    const BlobDetector::BlobList& blobs) const
+{
+    BlobDetector::BlobList frameBlobs;
+    frameBlobs.reserve(blobs.size());
+    BOOST_FOREACH(BlobDetector::Blob blob, blobs)
+    {
+        frameBlobs.push_back(toFrame(blob));
+    }
+    return frameBlobs;
+}
+
+void TrackingWindow::found(const BlobDetector::Blob& target)
+{
+    if (m_tracking)
+    {
+        m_velocityX = target.getTrueCenterX() - m_target.getTrueCenterX();
+        m_velocityY = target.getTrueCenterY() - m_target.getTrueCenterY();
+    }
+    else
+    {
+        m_velocityX = 0;
+        m_velocityY = 0;
+    }
+
+    m_target = target;
+    m_tracking = true;
+}
+
+void TrackingWindow::lost()
+{
+    m_tracking = false;
+    m_velocityX = 0;
+    m_velocityY = 0;
+}
+
+bool TrackingWindow::isTracking() const
+{
+    return m_tracking;
+}
+
+size_t TrackingWindow::getWindowedFrames() const
+{
+    return m_windowedFrames;
+}
+
+size_t TrackingWindow::getFullFrames() const
+{
+    return m_fullFrames;
+}
+
+Image* TrackingWindow::windowImage(int width, int height,
+                                   Image::PixelFormat format)
+{
+    size_t size = width * height * 3;
+    if (m_buffer.size() < size)
+    {
+        // The pixels move, so every wrapper points at freed memory
+        m_buffer.resize(size);
+        for (int i = 0; i < WINDOW_FORMAT_COUNT; ++i)
+        {
+            delete m_windows[i];
+            m_windows[i] = 0;
+        }
+    }
+
+    WindowFormat index = WINDOW_BGR;
+    if (Image::PF_RGB_8 == format)
+        index = WINDOW_RGB;
+    else if (Image::PF_LCHUV_8 == format)
+        index = WINDOW_LCHUV;
+
+    // Only remade when the window changes size, the pixels stay in m_buffer
+    Image*& window = m_windows[index];
+    if (!window || ((int)window->getWidth() != width) ||
+        ((int)window->getHeight() != height))
+    {
+        delete window;
+        window = new OpenCVImage(&m_buffer[0], width, height, false, format);
+    }
+    return window;
+}
+
+} // namespace vision
+} // namespace ram
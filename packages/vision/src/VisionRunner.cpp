@@ -10,22 +10,65 @@
 // STD Includes
 #include <utility>
 #include <iostream>
+#include <typeinfo>
+#include <cstdlib>
 
 // Project Includes
 #include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
 
 // Project Includes
 #include "vision/include/VisionRunner.h"
 #include "vision/include/Camera.h"
 #include "vision/include/Detector.h"
+#include "vision/include/Events.h"
+
+RAM_CORE_EVENT_TYPE(ram::vision::VisionRunner, DETECTOR_TIMING);
 
 namespace ram {
 namespace vision {
 
+static const boost::int64_t USEC_PER_SEC = 1000000;
+
+/** Demangled class name of the detector */
+static std::string detectorName(DetectorPtr detector)
+{
+    std::string result(typeid(*detector).name());
+
+#ifdef __GNUC__
+    int status;
+    char* realname = abi::__cxa_demangle(result.c_str(), 0, 0, &status);
+    if (0 == status)
+        result = std::string(realname);
+    free(realname);
+#endif // __GNUC__
+
+    return result;
+}
+
 VisionRunner::VisionRunner(Camera* camera, Recorder::RecordingPolicy policy,
-                           int policyArg) :
-    Recorder(camera, policy, policyArg)
+                           int policyArg, size_t threads,
+                           core::EventHubPtr eventHub) :
+    Recorder(camera, policy, policyArg),
+    EventPublisher(eventHub),
+    m_threadCount(threads),
+    m_shutdown(false),
+    m_workImage(0),
+    m_nextWork(0),
+    m_pendingWork(0),
+    m_reportStart(core::Updatable::monotonicTime()),
+    m_reportDropped(0)
 {
+    if (0 == m_threadCount)
+        m_threadCount = core::Updatable::getCpuCount();
+
+    // We do our share of the work, so one less
+    for (size_t i = 1; i < m_threadCount; ++i)
+        m_workers.create_thread(boost::bind(&VisionRunner::workerLoop, this));
 }
 
 VisionRunner::~VisionRunner()
@@ -34,6 +77,18 @@ VisionRunner::~VisionRunner()
     
     // stop background thread, and wait till it joins
     Updatable::unbackground(true);
+
+    {
+        boost::mutex::scoped_lock lock(m_workMutex);
+        m_shutdown = true;
+        m_workReady.notify_all();
+    }
+    m_workers.join_all();
+}
+
+size_t VisionRunner::getThreadCount()
+{
+    return m_threadCount;
 }
     
 void VisionRunner::update(double timestep)
@@ -87,11 +142,113 @@ void VisionRunner::recordFrame(Image* image)
     if(processDetectorChanges() || (m_detectors.size() == 0))
         return;
 
-    // Have each detector process the image
-    BOOST_FOREACH(DetectorPtr detector, m_detectors)
+    // Have each detector process the image, it is the camera's shared frame
+    // so detectors only read from it
+    runDetectors(image);
+    updateTiming();
+}
+
+void VisionRunner::runDetectors(Image* image)
+{
+    boost::mutex::scoped_lock lock(m_workMutex);
+    m_work.assign(m_detectors.begin(), m_detectors.end());
+    m_workTimes.assign(m_work.size(), 0);
+    m_workImage = image;
+    m_imageCache.setSource(image);
+    m_nextWork = 0;
+    m_pendingWork = m_work.size();
+
+    // No need to wake anyone up for a single detector
+    if (m_work.size() > 1)
+        m_workReady.notify_all();
+
+    // Help out, then wait for the stragglers
+    while (runNextDetector(lock)) {}
+    while (m_pendingWork > 0)
+        m_workDone.wait(lock);
+
+    m_workImage = 0;
+    m_imageCache.setSource(0);
+}
+
+bool VisionRunner::runNextDetector(boost::mutex::scoped_lock& lock)
+{
+    if (m_nextWork >= m_work.size())
+        return false;
+
+    size_t index = m_nextWork++;
+    DetectorPtr detector = m_work[index];
+    Image* image = m_workImage;
+
+    lock.unlock();
+    boost::int64_t start = core::Updatable::monotonicTime();
+    detector->setImageCache(&m_imageCache);
+    detector->processImage(image);
+    detector->setImageCache(0);
+    boost::int64_t end = core::Updatable::monotonicTime();
+    lock.lock();
+
+    m_workTimes[index] = (end - start) / (double)USEC_PER_SEC;
+    m_pendingWork--;
+    if (0 == m_pendingWork)
+        m_workDone.notify_all();
+    return true;
+}
+
+void VisionRunner::workerLoop()
+{
+    boost::mutex::scoped_lock lock(m_workMutex);
+    while (!m_shutdown)
+    {
+        if (!runNextDetector(lock))
+            m_workReady.wait(lock);
+    }
+}
+
+void VisionRunner::updateTiming()
+{
+    for (size_t i = 0; i < m_work.size(); ++i)
+    {
+        DetectorTiming& timing = m_timing[m_work[i]];
+        double time = m_workTimes[i];
+        if ((0 == timing.frames) || (time < timing.minTime))
+            timing.minTime = time;
+        if (time > timing.maxTime)
+            timing.maxTime = time;
+        timing.sumTime += time;
+        timing.frames++;
+    }
+
+    {
+        // Let go of the detectors, they might have been removed
+        boost::mutex::scoped_lock lock(m_workMutex);
+        m_work.clear();
+    }
+
+    // Publish and reset once a second
+    boost::int64_t now = core::Updatable::monotonicTime();
+    if ((now - m_reportStart) < USEC_PER_SEC)
+        return;
+
+    boost::uint64_t dropped = getDroppedFrames();
+    typedef std::map<DetectorPtr, DetectorTiming>::value_type TimingPair;
+    BOOST_FOREACH(TimingPair& pair, m_timing)
     {
-        detector->processImage(image);
+        DetectorTiming& timing = pair.second;
+        DetectorTimingEventPtr event(new DetectorTimingEvent());
+        event->detector = detectorName(pair.first);
+        event->frames = timing.frames;
+        event->droppedFrames = (int)(dropped - m_reportDropped);
+        event->minTime = timing.minTime;
+        event->meanTime = timing.sumTime / timing.frames;
+        event->maxTime = timing.maxTime;
+        publish(DETECTOR_TIMING, event);
     }
+
+    // Start over, which also forgets removed detectors
+    m_timing.clear();
+    m_reportStart = now;
+    m_reportDropped = dropped;
 }
     
 void VisionRunner::waitForImage(Camera* camera)
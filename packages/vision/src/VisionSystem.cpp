@@ -8,6 +8,7 @@
  */
 
 #include <iostream>
+#include <algorithm>
 
 // Library Includes
 #include <boost/foreach.hpp>
@@ -103,6 +104,8 @@ VisionSystem::VisionSystem(CameraPtr forward, CameraPtr downward,
     
 void VisionSystem::init(core::ConfigNode config, core::EventHubPtr eventHub)
 {
+    m_eventHub = eventHub;
+
     if (!m_forwardCamera)
     {
         core::ConfigNode cameraConfig(config["ForwardCamera"]);
@@ -141,9 +144,13 @@ void VisionSystem::init(core::ConfigNode config, core::EventHubPtr eventHub)
     if (config.exists("DownwardRecorders"))
         createRecordersFromConfig(config["DownwardRecorders"], m_downwardCamera);
     
-    // Detector runners (go as fast as possible)
-    m_forward = new VisionRunner(m_forwardCamera.get(), Recorder::NEXT_FRAME);
-    m_downward = new VisionRunner(m_downwardCamera.get(), Recorder::NEXT_FRAME);
+    // Detector runners (go as fast as possible), 0 threads means one per CPU
+    size_t detectorThreads =
+        (size_t)std::max(0, config["detectorThreads"].asInt(0));
+    m_forward = new VisionRunner(m_forwardCamera.get(), Recorder::NEXT_FRAME,
+                                 0, detectorThreads, eventHub);
+    m_downward = new VisionRunner(m_downwardCamera.get(), Recorder::NEXT_FRAME,
+                                  0, detectorThreads, eventHub);
 
     // Detectors
     m_redLightDetector = DetectorPtr(
@@ -207,7 +214,7 @@ void VisionSystem::createRecorder(CameraPtr camera, std::string recorderString,
     std::string message;
     Recorder* recorder = Recorder::createRecorderFromString(
         recorderString, camera.get(), message, policy, policyArg,
-        core::Logging::getLogDir().string());
+        core::Logging::getLogDir().string(), m_eventHub);
     if (debugPrint)
         std::cout << "RECORDING>>>> "  << message << std::endl;
 
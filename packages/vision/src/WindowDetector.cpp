@@ -64,7 +64,6 @@ WindowDetector::~WindowDetector()
     delete m_blueFilter;
 
     delete frame;
-    delete tempFrame;
     delete redFrame;
     delete greenFrame;
     delete yellowFrame;
@@ -163,7 +162,6 @@ void WindowDetector::init(core::ConfigNode config)
     
     // Working images
     frame = new OpenCVImage(640, 480, Image::PF_BGR_8);
-    tempFrame = new OpenCVImage(640, 480, Image::PF_BGR_8);
     redFrame = new OpenCVImage(640, 480, Image::PF_BGR_8);
     greenFrame = new OpenCVImage(640, 480, Image::PF_BGR_8);
     yellowFrame = new OpenCVImage(640, 480, Image::PF_BGR_8);
@@ -182,11 +180,7 @@ bool WindowDetector::processColor(Image* input, Image* output,
                                   BlobDetector::Blob& outerBlob,
                                   BlobDetector::Blob& innerBlob)
 {
-    tempFrame->copyFrom(input);
-    tempFrame->setPixelFormat(Image::PF_RGB_8);
-    tempFrame->setPixelFormat(Image::PF_LCHUV_8);
-
-    filter.filterImage(tempFrame, output);
+    filter.filterImage(input, output);
 
     // Erode the image (only if necessary)
     IplImage* img = output->asIplImage();
@@ -216,7 +210,7 @@ bool WindowDetector::processColor(Image* input, Image* output,
             m_minWidth <= blob.getWidth() &&
             m_minPixelPercentage <= pixelPercentage &&
             m_maxPixelPercentage >= pixelPercentage &&
-            processBackground(tempFrame, filter, blob, innerBlob))
+            processBackground(input, filter, blob, innerBlob))
         {
             int outerCenterX = (blob.getMaxX() - blob.getMinX()) / 2 + blob.getMinX();
             int innerCenterX = (innerBlob.getMaxX() - innerBlob.getMinX()) /
@@ -279,12 +273,15 @@ void WindowDetector::processImage(Image* input, Image* output)
 {
     frame->copyFrom(input);
 
+    // Every color is found in the LCh version of the frame
+    Image* lch = getDerivedImage(input, ImageCache::LCHUV);
+
     BlobDetector::Blob redBlob, greenBlob, yellowBlob, blueBlob;
     BlobDetector::Blob innerRedBlob, innerGreenBlob, innerYellowBlob, innerBlueBlob;
     bool redFound = false, greenFound = false,
         yellowFound = false, blueFound = false;
 
-    if ((redFound = processColor(frame, redFrame, *m_redFilter,
+    if ((redFound = processColor(lch, redFrame, *m_redFilter,
                                  redBlob, innerRedBlob))) {
         publishFoundEvent(redBlob, Color::RED);
     } else {
@@ -295,7 +292,7 @@ void WindowDetector::processImage(Image* input, Image* output)
     }
     m_redFound = redFound;
 
-    if ((greenFound = processColor(frame, greenFrame, *m_greenFilter,
+    if ((greenFound = processColor(lch, greenFrame, *m_greenFilter,
                                   greenBlob, innerGreenBlob))) {
         publishFoundEvent(greenBlob, Color::GREEN);
     } else {
@@ -306,7 +303,7 @@ void WindowDetector::processImage(Image* input, Image* output)
     }
     m_greenFound = greenFound;
 
-    if ((yellowFound = processColor(frame, yellowFrame, *m_yellowFilter,
+    if ((yellowFound = processColor(lch, yellowFrame, *m_yellowFilter,
                                     yellowBlob, innerYellowBlob))) {
         publishFoundEvent(yellowBlob, Color::YELLOW);
     } else {
@@ -317,7 +314,7 @@ void WindowDetector::processImage(Image* input, Image* output)
     }
     m_yellowFound = yellowFound;
 
-    if ((blueFound = processColor(frame, blueFrame, *m_blueFilter,
+    if ((blueFound = processColor(lch, blueFrame, *m_blueFilter,
                                   blueBlob, innerBlueBlob))) {
         publishFoundEvent(blueBlob, Color::BLUE);
     } else {
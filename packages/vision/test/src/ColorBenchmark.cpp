@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/ColorBenchmark.cpp
+ */
+
+// STD Includes
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+// Project Includes
+// For access to the full lookup table
+#define private public
+#include "vision/include/ColorFilter.h"
+#include "vision/include/LCHConverter.h"
+#undef private
+
+#include "vision/include/OpenCVImage.h"
+#include "core/include/TimeVal.h"
+
+using namespace ram;
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+
+/** Fills the image with a repeatable spread of colors */
+static void fillImage(vision::Image* image)
+{
+    unsigned char* data = image->getData();
+    srand(42);
+    for (int i = 0; i < WIDTH * HEIGHT * 3; ++i)
+        data[i] = (unsigned char)(rand() % 256);
+}
+
+/** Prints the megapixels per second for the given run time */
+static void report(const std::string& name, int iterations, double seconds)
+{
+    double megapixels = (double)WIDTH * HEIGHT * iterations / 1e6;
+    std::cout << std::setw(30) << std::left << name
+              << std::setw(10) << std::right << std::fixed
+              << std::setprecision(1) << megapixels / seconds
+              << " MP/s" << std::endl;
+}
+
+/** Seconds since the given start time */
+static double since(const core::TimeVal& start)
+{
+    return core::TimeVal::timeOfDay().get_double() - start.get_double();
+}
+
+static void benchmarkFilter(int iterations)
+{
+    vision::OpenCVImage input(WIDTH, HEIGHT, vision::Image::PF_BGR_8);
+    vision::OpenCVImage output(WIDTH, HEIGHT, vision::Image::PF_BGR_8);
+    fillImage(&input);
+
+    // Ranges like the ones the detectors use
+    vision::ColorFilter filter(20, 200, 40, 180, 100, 250);
+    
+    const char* names[] = {"scalar", "SSE2", "AVX2"};
+    vision::ColorFilter::Kernel kernels[] = {
+        vision::ColorFilter::KERNEL_SCALAR,
+        vision::ColorFilter::KERNEL_SSE2,
+        vision::ColorFilter::KERNEL_AVX2
+    };
+    for (int k = 0; k < 3; ++k)
+    {
+        std::string name = std::string("ColorFilter (") + names[k] + ")";
+        if (!vision::ColorFilter::kernelSupported(kernels[k]))
+        {
+            std::cout << name << " not supported here" << std::endl;
+            continue;
+        }
+        filter.setKernel(kernels[k]);
+
+        core::TimeVal start = core::TimeVal::timeOfDay();
+        for (int i = 0; i < iterations; ++i)
+            filter.filterImage(&input, &output);
+        report(name, iterations, since(start));
+
+        start = core::TimeVal::timeOfDay();
+        for (int i = 0; i < iterations; ++i)
+            filter.inverseFilterImage(&input, &output);
+        report(name + " inverse", iterations, since(start));
+    }
+}
+
+static void benchmarkLCH(int iterations)
+{
+    vision::OpenCVImage source(WIDTH, HEIGHT, vision::Image::PF_RGB_8);
+    vision::OpenCVImage image(WIDTH, HEIGHT, vision::Image::PF_RGB_8);
+    fillImage(&source);
+    int numPixels = WIDTH * HEIGHT;
+
+    // The exact math is slow, so only do a single frame of it
+    image.copyFrom(&source);
+    unsigned char* data = image.getData();
+    core::TimeVal start = core::TimeVal::timeOfDay();
+    for (int i = 0; i < numPixels; ++i, data += 3)
+        vision::LCHConverter::convertPixel(data[0], data[1], data[2]);
+    report("LCH (exact math)", 1, since(start));
+
+    start = core::TimeVal::timeOfDay();
+    for (int i = 0; i < iterations; ++i)
+    {
+        image.copyFrom(&source);
+        vision::LCHConverter::convertPixels(image.getData(), numPixels);
+    }
+    report("LCH (blocked direct math)", iterations, since(start));
+
+    // Without the table file, fill the table in memory so the two can
+    // still be compared
+    if (!(getenv("RAM_SVN_DIR") && vision::LCHConverter::loadLookupTable()))
+    {
+        std::cout << "No full lookup table in $RAM_SVN_DIR, building it "
+                  << "in memory" << std::endl;
+        unsigned char* table =
+            &vision::LCHConverter::rgb2lchLookup[0][0][0][0];
+        for (int i = 0; i < 256 * 256 * 256; ++i)
+        {
+            table[i * 3] = (unsigned char)(i >> 16);
+            table[i * 3 + 1] = (unsigned char)(i >> 8);
+            table[i * 3 + 2] = (unsigned char)i;
+        }
+        vision::LCHConverter::convertPixels(table, 256 * 256 * 256);
+        vision::LCHConverter::lookupInit = true;
+    }
+
+    start = core::TimeVal::timeOfDay();
+    for (int i = 0; i < iterations; ++i)
+    {
+        image.copyFrom(&source);
+        vision::LCHConverter::convert(&image);
+    }
+    report("LCH (48MB lookup table)", iterations, since(start));
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = 100;
+    if (argc > 1)
+        iterations = atoi(argv[1]);
+
+    if (iterations < 1)
+    {
+        std::cout << "Usage: ColorBenchmark [iterations]\n\n"
+            "Times color filtering and LCh conversion of "
+                  << WIDTH << "x" << HEIGHT << " frames" << std::endl;
+        return 1;
+    }
+
+    benchmarkFilter(iterations);
+    benchmarkLCH(iterations);
+    return 0;
+}
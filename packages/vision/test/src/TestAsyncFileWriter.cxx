@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestAsyncFileWriter.cxx
+ */
+
+// STD Includes
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem.hpp>
+
+// Project Includes
+#include "vision/include/AsyncFileWriter.h"
+#include "vision/test/include/Utility.h"
+
+using namespace ram;
+namespace bf = boost::filesystem;
+
+SUITE(AsyncFileWriter) {
+
+struct Fixture
+{
+    Fixture()
+    {
+        std::stringstream ss;
+        ss << "AsyncFileWriterTest" << "_" << vision::getPid() << ".dat";
+        filename = ss.str();
+    }
+
+    ~Fixture()
+    {
+        bf::path file(filename);
+        if (bf::exists(file))
+            bf::remove(file);
+    }
+
+    std::string contents()
+    {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return ss.str();
+    }
+
+    std::string filename;
+};
+
+/** Writes a record of the given size, its index followed by a fill byte */
+static bool writeRecord(vision::AsyncFileWriter& writer, boost::uint32_t index,
+                        size_t size)
+{
+    if (!writer.beginRecord(size))
+        return false;
+
+    std::vector<unsigned char> fill(size - sizeof(index),
+                                    (unsigned char)index);
+    writer.write(&index, sizeof(index));
+    writer.write(&fill[0], fill.size());
+    writer.endRecord();
+    return true;
+}
+
+/** Checks the file holds whole records with increasing indices
+ *
+ *  @return  The number of records
+ */
+static size_t checkRecords(const std::string& data, size_t size)
+{
+    CHECK_EQUAL(0u, data.size() % size);
+
+    boost::uint32_t last = 0;
+    size_t count = data.size() / size;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const char* record = data.data() + i * size;
+        boost::uint32_t index;
+        memcpy(&index, record, sizeof(index));
+        if (i > 0)
+            CHECK(index > last);
+        last = index;
+
+        for (size_t j = sizeof(index); j < size; ++j)
+        {
+            if ((unsigned char)record[j] != (unsigned char)index)
+            {
+                CHECK(false && "Record corrupted");
+                return count;
+            }
+        }
+    }
+    return count;
+}
+
+TEST_FIXTURE(Fixture, WriteAndFlush)
+{
+    vision::AsyncFileWriter::Options options;
+    options.bufferSize = 8192;
+    options.bufferCount = 4;
+    options.dropPolicy = vision::AsyncFileWriter::BLOCK;
+    vision::AsyncFileWriter writer(filename, options);
+
+    // Records which do not line up with the buffers
+    for (boost::uint32_t i = 0; i < 50; ++i)
+        CHECK(writeRecord(writer, i, 1000));
+
+    writer.flush();
+    CHECK_EQUAL(50u, checkRecords(contents(), 1000));
+
+    vision::AsyncFileWriter::Stats stats = writer.getStats();
+    CHECK_EQUAL(50000u, stats.bytesWritten);
+    CHECK(stats.writes > 0);
+    CHECK(stats.writes <= 50);
+    CHECK_EQUAL(0u, stats.queueDepth);
+    CHECK_EQUAL(0u, stats.droppedRecords);
+}
+
+TEST_FIXTURE(Fixture, CloseWritesRemaining)
+{
+    {
+        vision::AsyncFileWriter writer(filename);
+        for (boost::uint32_t i = 0; i < 10; ++i)
+            writeRecord(writer, i, 333);
+    }
+    CHECK_EQUAL(10u, checkRecords(contents(), 333));
+}
+
+TEST_FIXTURE(Fixture, DropNewest)
+{
+    // Far more data than the two small buffers can hold at once
+    vision::AsyncFileWriter::Options options;
+    options.bufferSize = 4096;
+    options.bufferCount = 2;
+    options.dropPolicy = vision::AsyncFileWriter::DROP_NEWEST;
+
+    size_t written = 0;
+    boost::uint64_t dropped = 0;
+    {
+        vision::AsyncFileWriter writer(filename, options);
+        for (boost::uint32_t i = 0; i < 2000; ++i)
+        {
+            if (writeRecord(writer, i, 3000))
+                written++;
+        }
+        dropped = writer.getStats().droppedRecords;
+    }
+
+    // Dropped records are gone completely, the rest is intact
+    CHECK_EQUAL(2000u, written + dropped);
+    CHECK_EQUAL(written, checkRecords(contents(), 3000));
+}
+
+TEST_FIXTURE(Fixture, Block)
+{
+    vision::AsyncFileWriter::Options options;
+    options.bufferSize = 4096;
+    options.bufferCount = 2;
+    options.dropPolicy = vision::AsyncFileWriter::BLOCK;
+
+    {
+        vision::AsyncFileWriter writer(filename, options);
+        for (boost::uint32_t i = 0; i < 2000; ++i)
+            CHECK(writeRecord(writer, i, 3000));
+
+        vision::AsyncFileWriter::Stats stats = writer.getStats();
+        CHECK_EQUAL(0u, stats.droppedRecords);
+        CHECK(stats.blockedTime >= 0);
+    }
+
+    CHECK_EQUAL(2000u, checkRecords(contents(), 3000));
+}
+
+#ifdef RAM_LINUX
+TEST(WriteError)
+{
+    // Every write to /dev/full fails with ENOSPC, the writer must drop the
+    // buffers instead of retrying them forever
+    vision::AsyncFileWriter::Options options;
+    options.bufferSize = 4096;
+    options.bufferCount = 2;
+    options.dropPolicy = vision::AsyncFileWriter::BLOCK;
+
+    vision::AsyncFileWriter::Stats stats;
+    {
+        vision::AsyncFileWriter writer("/dev/full", options);
+        for (boost::uint32_t i = 0; i < 20; ++i)
+            CHECK(writeRecord(writer, i, 3000));
+        writer.flush();
+        stats = writer.getStats();
+    }
+
+    CHECK(stats.writeErrors > 0);
+    CHECK_EQUAL(stats.writes, stats.writeErrors);
+    CHECK_EQUAL(0u, stats.bytesWritten);
+}
+#endif // RAM_LINUX
+
+TEST_FIXTURE(Fixture, PeakQueueDepth)
+{
+    vision::AsyncFileWriter::Options options;
+    options.bufferSize = 4096;
+    options.bufferCount = 4;
+    options.dropPolicy = vision::AsyncFileWriter::BLOCK;
+    vision::AsyncFileWriter writer(filename, options);
+
+    for (boost::uint32_t i = 0; i < 100; ++i)
+        writeRecord(writer, i, 3000);
+    writer.flush();
+
+    // Reading the stats leaves the peak alone, only the reset clears it
+    size_t peak = writer.getStats().peakQueueDepth;
+    CHECK(peak > 0);
+    CHECK_EQUAL(peak, writer.getStats().peakQueueDepth);
+    writer.resetPeakQueueDepth();
+    CHECK_EQUAL(0u, writer.getStats().peakQueueDepth);
+}
+
+TEST_FIXTURE(Fixture, Direct)
+{
+    // Same output whether or not the file system supports O_DIRECT
+    vision::AsyncFileWriter::Options options;
+    options.bufferSize = 16384;
+    options.bufferCount = 3;
+    options.direct = true;
+    options.preallocate = 1024 * 1024;
+    options.dropPolicy = vision::AsyncFileWriter::BLOCK;
+
+    {
+        vision::AsyncFileWriter writer(filename, options);
+        for (boost::uint32_t i = 0; i < 30; ++i)
+            writeRecord(writer, i, 1001);
+
+        // Flushing part of a block must not break later writes
+        writer.flush();
+        CHECK_EQUAL(30u, checkRecords(contents(), 1001));
+
+        for (boost::uint32_t i = 30; i < 100; ++i)
+            writeRecord(writer, i, 1001);
+    }
+
+    // Preallocation must not change the size
+    CHECK_EQUAL(100u * 1001u, bf::file_size(filename));
+    CHECK_EQUAL(100u, checkRecords(contents(), 1001));
+}
+
+} // SUITE(AsyncFileWriter)
@@ -9,9 +9,13 @@
 
 // STD Includes
 #include <signal.h>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
+#include <boost/foreach.hpp>
 
 // Project Includes
 // Make data a public member
@@ -251,4 +255,144 @@ TEST_FIXTURE(BlobDetectorFixture, minBlobSize)
     CHECK_EQUAL(200, blob.getCenterY());
 }
 
+TEST_FIXTURE(BlobDetectorFixture, edgeBlobs)
+{
+    vision::makeColor(&input, 0, 0, 0);
+
+    // Touches the top left corner, the right edge and the bottom edge
+    drawSquare(&input, 10, 10, 20, 20, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 630, 240, 20, 40, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 320, 470, 40, 20, 0, CV_RGB(255,255,255));
+    vision::OpenCVImage original(640, 480);
+    original.copyFrom(&input);
+
+    detector.processImage(&input);
+
+    // Edge pixels count as well, and the image is left alone
+    CHECK_EQUAL(3u, detector.getBlobs().size());
+    BOOST_FOREACH(vision::BlobDetector::Blob blob, detector.getBlobs())
+    {
+        if (blob.getMinX() == 0)
+            CHECK_EQUAL(0, blob.getMinY());
+        else if (blob.getMaxX() == 639)
+            CHECK_EQUAL(220, blob.getMinY());
+        else
+            CHECK_EQUAL(479, blob.getMaxY());
+    }
+    CHECK_ARRAY_EQUAL(original.getData(), input.getData(), 640 * 480 * 3);
+}
+
+TEST_FIXTURE(BlobDetectorFixture, joinedBranches)
+{
+    vision::makeColor(&input, 0, 0, 0);
+
+    // A comb whose teeth are only joined along the bottom, so each tooth
+    // starts out as its own blob
+    for (int x = 105; x < 300; x += 20)
+        drawSquare(&input, x, 150, 10, 100, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 195, 205, 200, 10, 0, CV_RGB(255,255,255));
+
+    // A spiral, which has to be joined back together several times
+    drawSquare(&input, 450, 100, 100, 10, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 495, 150, 10, 100, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 450, 195, 100, 10, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 405, 170, 10, 60, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 440, 145, 80, 10, 0, CV_RGB(255,255,255));
+
+    detector.processImage(&input);
+
+    CHECK_EQUAL(2u, detector.getBlobs().size());
+}
+
+TEST_FIXTURE(BlobDetectorFixture, regionOfInterest)
+{
+    vision::makeColor(&input, 0, 0, 0);
+
+    // One blob inside, one straddling the edge and one outside
+    drawSquare(&input, 200, 200, 40, 40, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 300, 200, 40, 40, 0, CV_RGB(255,255,255));
+    drawSquare(&input, 500, 400, 40, 40, 0, CV_RGB(255,255,255));
+
+    // Maximums are exclusive
+    detector.processImage(&input, vision::RegionOfInterest(100, 300, 100, 300));
+
+    CHECK_EQUAL(2u, detector.getBlobs().size());
+    vision::BlobDetector::Blob blob = detector.getBlobs()[1];
+    CHECK_EQUAL(280, blob.getMinX());
+    CHECK_EQUAL(299, blob.getMaxX());
+    CHECK_EQUAL(180, blob.getMinY());
+    CHECK_EQUAL(220, blob.getMaxY());
+
+    // Regions off the image are clipped
+    detector.processImage(&input, vision::RegionOfInterest(400, 800, 300, 600));
+    CHECK_EQUAL(1u, detector.getBlobs().size());
+}
+
+TEST(randomMask)
+{
+    // Odd width so the rows are padded
+    vision::OpenCVImage input(101, 67);
+    IplImage* img = input.asIplImage();
+    int width = img->width;
+    int height = img->height;
+    unsigned char* data = (unsigned char*)img->imageData;
+
+    std::srand(42);
+    for (int i = 0; i < img->widthStep * height; ++i)
+        data[i] = (std::rand() % 100) < 45 ? 255 : 0;
+
+    // Compare against a simple flood fill
+    std::vector<int> labels(width * height, -1);
+    std::vector<int> sizes;
+    for (int start = 0; start < width * height; ++start)
+    {
+        int startX = start % width;
+        int startY = start / width;
+        if (labels[start] >= 0 ||
+            !data[startY * img->widthStep + startX * 3])
+        {
+            continue;
+        }
+
+        labels[start] = sizes.size();
+        sizes.push_back(0);
+        std::vector<int> stack(1, start);
+        while (!stack.empty())
+        {
+            int index = stack.back();
+            stack.pop_back();
+            sizes.back()++;
+
+            int x = index % width;
+            int y = index / width;
+            int nx[4] = {x - 1, x + 1, x, x};
+            int ny[4] = {y, y, y - 1, y + 1};
+            for (int i = 0; i < 4; ++i)
+            {
+                if (nx[i] < 0 || nx[i] >= width || ny[i] < 0 ||
+                    ny[i] >= height)
+                {
+                    continue;
+                }
+                int next = ny[i] * width + nx[i];
+                if (labels[next] < 0 &&
+                    data[ny[i] * img->widthStep + nx[i] * 3])
+                {
+                    labels[next] = labels[start];
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+    std::sort(sizes.begin(), sizes.end(), std::greater<int>());
+
+    vision::BlobDetector detector;
+    detector.processImage(&input);
+    vision::BlobDetector::BlobList blobs = detector.getBlobs();
+
+    CHECK_EQUAL(sizes.size(), blobs.size());
+    for (size_t i = 0; i < std::min(sizes.size(), blobs.size()); ++i)
+        CHECK_EQUAL(sizes[i], blobs[i].getSize());
+}
+
 } // SUITE(BlobDetector)
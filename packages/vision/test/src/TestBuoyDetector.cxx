@@ -20,6 +20,7 @@
 #include "vision/test/include/Utility.h"
 
 #include "core/include/EventHub.h"
+#include "core/include/PropertySet.h"
 
 static const std::string CONFIG =       
     "{"
@@ -180,4 +181,39 @@ TEST_FIXTURE(BuoyDetectorFixture, AlmostHit)
     CHECK(almostHit);
 }
 
+TEST_FIXTURE(BuoyDetectorFixture, TrackedInWindow)
+{
+    detector.getPropertySet()->getProperty("roiEnabled")->set(true);
+    double x, y;
+
+    // Found by searching the whole frame
+    vision::makeColor(&input, 0, 0, 0);
+    vision::drawCircle(&input, 320, 240, 50, cvScalar(0, 0, 255));
+    processImage(&input);
+    CHECK(found);
+
+    // Moving a little stays inside the window
+    vision::makeColor(&input, 0, 0, 0);
+    vision::drawCircle(&input, 350, 260, 50, cvScalar(0, 0, 255));
+    processImage(&input);
+    CHECK(found);
+    vision::Detector::imageToAICoordinates(&input, 350, 260, x, y);
+    CHECK_CLOSE(x, event->x, 0.02);
+    CHECK_CLOSE(y, event->y, 0.02);
+
+    // Jumping outside the window loses it for a frame, then the whole
+    // frame is searched again
+    vision::makeColor(&input, 0, 0, 0);
+    vision::drawCircle(&input, 100, 100, 50, cvScalar(0, 0, 255));
+    processImage(&input);
+    CHECK(!found);
+
+    processImage(&input);
+    CHECK(found);
+    vision::Detector::imageToAICoordinates(&input, 100, 100, x, y);
+    CHECK_CLOSE(x, event->x, 0.02);
+    CHECK_CLOSE(y, event->y, 0.02);
+    CHECK_EQUAL(vision::Color::RED, event->color);
+}
+
 } // SUITE(BuoyDetector)
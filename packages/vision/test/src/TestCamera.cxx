@@ -20,6 +20,7 @@
 #include "vision/include/Camera.h"
 #include "vision/include/OpenCVImage.h"
 #include "vision/include/Events.h"
+#include "vision/include/Frame.h"
 
 #include "vision/test/include/UnitTestChecks.h"
 #include "vision/test/include/MockCamera.h"
@@ -115,4 +116,45 @@ TEST_FIXTURE(CameraFixture, event_IMAGE_CAPTURED)
     delete expectedCap;
 }
 
+struct FrameFixture
+{
+    void frameHandler(ram::core::EventPtr event)
+    {
+        frames.push_back(boost::dynamic_pointer_cast<ImageEvent>(event)->frame);
+    }
+
+    std::vector<FramePtr> frames;
+};
+
+TEST_FIXTURE(FrameFixture, getFrame)
+{
+    Image* expected = new OpenCVImage(10, 10);
+    MockCamera camera(expected);
+    CHECK(!camera.getFrame());
+
+    camera.subscribe(ram::vision::Camera::IMAGE_CAPTURED,
+                     boost::bind(&FrameFixture::frameHandler, this, _1));
+    camera.update(0);
+    camera.update(0);
+
+    // The event shares the frame instead of copying it
+    FramePtr frame = camera.getFrame();
+    CHECK_EQUAL(2u, frames.size());
+    CHECK_EQUAL(frame.get(), frames[1].get());
+    CHECK(frames[0].get() != frames[1].get());
+
+    // Sequence numbers increase by one per capture
+    CHECK_EQUAL(1u, frames[0]->getSequence());
+    CHECK_EQUAL(2u, frames[1]->getSequence());
+    CHECK(frames[0]->getTimeStamp() <= frames[1]->getTimeStamp());
+    CHECK_CLOSE(*expected, *frame->getImage(), 0);
+
+    // Frames still held stay the same after new captures
+    camera.update(0);
+    CHECK_EQUAL(2u, frame->getSequence());
+    CHECK_EQUAL(3u, camera.getFrame()->getSequence());
+
+    delete expected;
+}
+
 } // SUITE(Camera)
@@ -168,4 +168,131 @@ TEST_FIXTURE(ColorFilterFixture, testSingleChannel)
 }
 
 
+/** Whether the value is in the filter range, including wrap around ones */
+static bool inRange(int value, int low, int high)
+{
+    if (low <= high)
+        return (low <= value) && (value <= high);
+    return (value <= high) || (low <= value);
+}
+
+TEST_FIXTURE(ColorFilterFixture, MatchesRanges)
+{
+    // Not a whole number of 16 pixel blocks, and no 255
+    // so the wrap around ranges can be checked simply
+    vision::OpenCVImage input(40, 13, vision::Image::PF_BGR_8);
+    unsigned char* data = input.getData();
+    size_t numPixels = 40 * 13;
+    for (size_t i = 0; i < numPixels * 3; ++i)
+        data[i] = (unsigned char)((i * 97 + i / 7) % 255);
+
+    int ranges[][6] = {
+        {20, 200, 0, 254, 0, 254},   // One channel
+        {100, 250, 40, 160, 150, 200}, // All three
+        {200, 30, 10, 240, 220, 50},  // Wrap around
+        {77, 77, 0, 254, 0, 254},     // Single value
+        {0, 254, 0, 254, 0, 254},     // Everything
+    };
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r)
+    {
+        int* range = ranges[r];
+        vision::ColorFilter filter(range[0], range[1], range[2], range[3],
+                                   range[4], range[5]);
+
+        vision::OpenCVImage output(40, 13, vision::Image::PF_BGR_8);
+        vision::OpenCVImage inverse(40, 13, vision::Image::PF_BGR_8);
+        vision::OpenCVImage gray(40, 13, vision::Image::PF_GRAY_8);
+        vision::OpenCVImage inPlace(40, 13, vision::Image::PF_BGR_8);
+        inPlace.copyFrom(&input);
+        filter.filterImage(&input, &output);
+        filter.inverseFilterImage(&input, &inverse);
+        filter.filterImage(&input, &gray);
+        filter.filterImage(&inPlace);
+
+        int wrong = 0;
+        for (size_t i = 0; i < numPixels; ++i)
+        {
+            unsigned char* pixel = data + i * 3;
+            unsigned char expected =
+                (inRange(pixel[0], range[0], range[1]) &&
+                 inRange(pixel[1], range[2], range[3]) &&
+                 inRange(pixel[2], range[4], range[5])) ? 255 : 0;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                wrong += output.getData()[i * 3 + k] != expected;
+                wrong += inverse.getData()[i * 3 + k] != (255 - expected);
+                wrong += inPlace.getData()[i * 3 + k] != expected;
+            }
+            wrong += gray.getData()[i] != expected;
+        }
+        CHECK_EQUAL(0, wrong);
+    }
+}
+
+TEST_FIXTURE(ColorFilterFixture, KernelsMatchScalar)
+{
+    // Rows without padding, but not a whole number of blocks, so every
+    // kernel leaves some pixels for the scalar code
+    const int width = 68, height = 9;
+    vision::OpenCVImage input(width, height, vision::Image::PF_BGR_8);
+    unsigned char* data = input.getData();
+    size_t size = width * height * 3;
+    for (size_t i = 0; i < size; ++i)
+        data[i] = (unsigned char)((i * 131 + i / 5) % 256);
+
+    int ranges[][6] = {
+        {20, 200, 0, 255, 0, 255},
+        {100, 250, 40, 160, 150, 200},
+        {200, 30, 10, 240, 220, 50},
+        {77, 77, 0, 255, 0, 255},
+        {0, 255, 0, 255, 0, 255},
+    };
+
+    vision::ColorFilter::Kernel kernels[] = {
+        vision::ColorFilter::KERNEL_SSE2,
+        vision::ColorFilter::KERNEL_AVX2
+    };
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r)
+    {
+        int* range = ranges[r];
+        vision::ColorFilter filter(range[0], range[1], range[2], range[3],
+                                   range[4], range[5]);
+
+        filter.setKernel(vision::ColorFilter::KERNEL_SCALAR);
+        vision::OpenCVImage expected(width, height, vision::Image::PF_BGR_8);
+        vision::OpenCVImage expectedInverse(width, height,
+                                            vision::Image::PF_BGR_8);
+        filter.filterImage(&input, &expected);
+        filter.inverseFilterImage(&input, &expectedInverse);
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+        {
+            if (!vision::ColorFilter::kernelSupported(kernels[k]))
+                continue;
+            filter.setKernel(kernels[k]);
+
+            vision::OpenCVImage output(width, height,
+                                       vision::Image::PF_BGR_8);
+            vision::OpenCVImage inverse(width, height,
+                                        vision::Image::PF_BGR_8);
+            vision::OpenCVImage inPlace(width, height,
+                                        vision::Image::PF_BGR_8);
+            inPlace.copyFrom(&input);
+            filter.filterImage(&input, &output);
+            filter.inverseFilterImage(&input, &inverse);
+            filter.filterImage(&inPlace);
+
+            CHECK_ARRAY_EQUAL(expected.getData(), output.getData(),
+                              (int)size);
+            CHECK_ARRAY_EQUAL(expectedInverse.getData(), inverse.getData(),
+                              (int)size);
+            CHECK_ARRAY_EQUAL(expected.getData(), inPlace.getData(),
+                              (int)size);
+        }
+    }
+}
+
 } // SUITE(ColorFilter)
@@ -19,6 +19,7 @@
 #include "vision/include/OpenCVImage.h"
 #include "vision/include/Image.h"
 #include "vision/include/Events.h"
+#include "vision/include/ImagePool.h"
 #include "vision/test/include/Utility.h"
 
 #include "core/include/EventHub.h"
@@ -503,5 +504,25 @@ TEST_FIXTURE(DuctDetectorFixture, LowerRightFront)
     CHECK_CLOSE(expectedY, detector.getY(), 0.05);
 }
 
+TEST_FIXTURE(DuctDetectorFixture, PoolSteadyState)
+{
+    vision::OpenCVImage image(640, 480);
+    vision::OpenCVImage output(640, 480);
+    makeColor(&image, 0, 0, 255);
+    drawFrontDuct(&image, 640/2, 480/2);
+
+    // The first frame fills the pool with the scratch images it needs
+    vision::ImagePool* pool = vision::ImagePool::getDefault();
+    detector.processImage(&image, &output);
+    vision::ImagePool::Stats warm = pool->getStats();
+
+    for (int i = 0; i < 5; ++i)
+        detector.processImage(&image, &output);
+
+    vision::ImagePool::Stats stats = pool->getStats();
+    CHECK_EQUAL(warm.allocations, stats.allocations);
+    CHECK(stats.acquires > warm.acquires);
+    CHECK_EQUAL(0u, stats.outstanding);
+}
 
 } // SUITE(DuctDetector)
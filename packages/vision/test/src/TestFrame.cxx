@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestFrame.cxx
+ */
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "vision/include/Frame.h"
+#include "vision/include/Image.h"
+
+using namespace ram::vision;
+
+SUITE(Frame) {
+
+TEST(Recycle)
+{
+    FramePoolPtr pool = FramePool::create(2);
+    FramePtr first = pool->acquire(640, 480);
+    Image* image = first->getImage();
+    CHECK(image);
+    CHECK_EQUAL(1u, pool->getFrameCount());
+
+    // Releasing the last reference hands the frame back
+    first->setCaptureInfo(5, 1.5);
+    first = FramePtr();
+    CHECK_EQUAL(1u, pool->getFreeCount());
+
+    // And it comes back out, reset
+    FramePtr second = pool->acquire(640, 480);
+    CHECK_EQUAL(image, second->getImage());
+    CHECK_EQUAL(0u, second->getSequence());
+    CHECK_EQUAL(0u, pool->getFreeCount());
+    CHECK_EQUAL(1u, pool->getFrameCount());
+}
+
+TEST(MaxFree)
+{
+    FramePoolPtr pool = FramePool::create(2);
+    std::vector<FramePtr> frames;
+    for (int i = 0; i < 4; ++i)
+        frames.push_back(pool->acquire(640, 480));
+    CHECK_EQUAL(4u, pool->getFrameCount());
+
+    // Only two are kept around, the rest are freed
+    frames.clear();
+    CHECK_EQUAL(2u, pool->getFreeCount());
+    CHECK_EQUAL(2u, pool->getFrameCount());
+}
+
+TEST(SizeChange)
+{
+    FramePoolPtr pool = FramePool::create(2);
+    FramePtr frame = pool->acquire(320, 240);
+    CHECK_EQUAL(320u, frame->getImage()->getWidth());
+    CHECK_EQUAL(240u, frame->getImage()->getHeight());
+    frame = FramePtr();
+
+    // The released frame is the wrong size, so a new one is made
+    frame = pool->acquire(640, 480);
+    CHECK_EQUAL(640u, frame->getImage()->getWidth());
+    CHECK_EQUAL(480u, frame->getImage()->getHeight());
+    CHECK_EQUAL(1u, pool->getFrameCount());
+    CHECK_EQUAL(0u, pool->getFreeCount());
+}
+
+TEST(OutlivesPool)
+{
+    FramePtr frame;
+    {
+        FramePoolPtr pool = FramePool::create();
+        frame = pool->acquire(640, 480);
+    }
+
+    // The frame keeps the pool alive, so this is still safe
+    frame->setCaptureInfo(1, 0);
+    CHECK_EQUAL(1u, frame->getSequence());
+    frame = FramePtr();
+}
+
+} // SUITE(Frame)
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestImageCache.cxx
+ */
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "vision/include/ImageCache.h"
+#include "vision/include/Detector.h"
+#include "vision/include/OpenCVImage.h"
+
+#include "vision/test/include/UnitTestChecks.h"
+
+using namespace ram;
+
+/** Asks for the gray scale version of whatever it is given */
+class GrayDetector : public vision::Detector
+{
+public:
+    GrayDetector() : gray(0) {}
+
+    virtual void processImage(vision::Image* input, vision::Image* output)
+    {
+        gray = getDerivedImage(input, vision::ImageCache::GRAY);
+    }
+
+    vision::Image* gray;
+};
+
+struct ImageCacheFixture
+{
+    ImageCacheFixture() :
+        source(64, 48, vision::Image::PF_BGR_8)
+    {
+        unsigned char* data = source.getData();
+        for (size_t i = 0; i < 64 * 48 * 3; ++i)
+            data[i] = (unsigned char)(i % 251);
+    }
+
+    vision::OpenCVImage source;
+    vision::ImageCache cache;
+};
+
+SUITE(ImageCache) {
+
+TEST_FIXTURE(ImageCacheFixture, ComputeOnce)
+{
+    cache.setSource(&source);
+    CHECK_EQUAL(&source, cache.getSource());
+
+    vision::Image* gray = cache.get(vision::ImageCache::GRAY);
+    CHECK_EQUAL(vision::Image::PF_GRAY_8, gray->getPixelFormat());
+    CHECK_EQUAL(64u, gray->getWidth());
+    CHECK_EQUAL(48u, gray->getHeight());
+    CHECK_EQUAL(1u, cache.getComputeCount());
+
+    // Second request is the same image
+    CHECK_EQUAL(gray, cache.get(vision::ImageCache::GRAY));
+    CHECK_EQUAL(1u, cache.getComputeCount());
+
+    // A new source recomputes into the same buffer
+    cache.setSource(&source);
+    CHECK_EQUAL(gray, cache.get(vision::ImageCache::GRAY));
+    CHECK_EQUAL(2u, cache.getComputeCount());
+}
+
+TEST_FIXTURE(ImageCacheFixture, LCHUV)
+{
+    // Same conversion the detectors do themselves
+    vision::Image* expected = new vision::OpenCVImage(64, 48);
+    expected->copyFrom(&source);
+    expected->setPixelFormat(vision::Image::PF_RGB_8);
+    expected->setPixelFormat(vision::Image::PF_LCHUV_8);
+
+    cache.setSource(&source);
+    vision::Image* lch = cache.get(vision::ImageCache::LCHUV);
+    CHECK_EQUAL(vision::Image::PF_LCHUV_8, lch->getPixelFormat());
+    CHECK_CLOSE(*expected, *lch, 0);
+
+    // The source is left alone
+    CHECK_EQUAL(vision::Image::PF_BGR_8, source.getPixelFormat());
+
+    delete expected;
+}
+
+TEST_FIXTURE(ImageCacheFixture, Pyramid)
+{
+    cache.setSource(&source);
+    vision::Image* quarter = cache.get(vision::ImageCache::QUARTER);
+    CHECK_EQUAL(16u, quarter->getWidth());
+    CHECK_EQUAL(12u, quarter->getHeight());
+    CHECK_EQUAL(vision::Image::PF_BGR_8, quarter->getPixelFormat());
+
+    // The half sized image was made on the way
+    CHECK_EQUAL(2u, cache.getComputeCount());
+    vision::Image* half = cache.get(vision::ImageCache::HALF);
+    CHECK_EQUAL(32u, half->getWidth());
+    CHECK_EQUAL(24u, half->getHeight());
+    CHECK_EQUAL(2u, cache.getComputeCount());
+}
+
+TEST_FIXTURE(ImageCacheFixture, SharedByDetectors)
+{
+    GrayDetector first;
+    GrayDetector second;
+    
+    cache.setSource(&source);
+    first.setImageCache(&cache);
+    second.setImageCache(&cache);
+    first.processImage(&source, 0);
+    second.processImage(&source, 0);
+
+    CHECK_EQUAL(first.gray, second.gray);
+    CHECK_EQUAL(cache.get(vision::ImageCache::GRAY), first.gray);
+    CHECK_EQUAL(1u, cache.getComputeCount());
+
+    // Images other than the source are converted on their own
+    vision::OpenCVImage other(32, 32, vision::Image::PF_BGR_8);
+    first.processImage(&other, 0);
+    CHECK(first.gray != second.gray);
+    CHECK_EQUAL(32u, first.gray->getWidth());
+    CHECK_EQUAL(1u, cache.getComputeCount());
+}
+
+} // SUITE(ImageCache)
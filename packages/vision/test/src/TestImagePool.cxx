@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestImagePool.cxx
+ */
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "vision/include/ImagePool.h"
+#include "vision/include/Image.h"
+#include "vision/include/ImageCamera.h"
+#include "vision/include/OpenCVImage.h"
+
+using namespace ram::vision;
+
+SUITE(ImagePool) {
+
+TEST(Reuse)
+{
+    ImagePool pool;
+    Image* image = pool.acquire(320, 240, Image::PF_GRAY_8);
+    CHECK_EQUAL(320u, image->getWidth());
+    CHECK_EQUAL(240u, image->getHeight());
+    CHECK_EQUAL(1u, image->getNumChannels());
+    CHECK_EQUAL(1u, pool.getStats().outstanding);
+    pool.release(image);
+
+    // Steady state use allocates nothing new
+    for (int i = 0; i < 10; ++i)
+    {
+        Image* again = pool.acquire(320, 240, Image::PF_GRAY_8);
+        CHECK_EQUAL(image, again);
+        pool.release(again);
+    }
+
+    ImagePool::Stats stats = pool.getStats();
+    CHECK_EQUAL(11u, stats.acquires);
+    CHECK_EQUAL(1u, stats.allocations);
+    CHECK_EQUAL(0u, stats.outstanding);
+    CHECK_EQUAL(1u, stats.free);
+}
+
+TEST(MatchesSizeAndFormat)
+{
+    ImagePool pool;
+    Image* gray = pool.acquire(320, 240, Image::PF_GRAY_8);
+    Image* color = pool.acquire(320, 240, Image::PF_BGR_8);
+    Image* small = pool.acquire(160, 120, Image::PF_BGR_8);
+    pool.release(gray);
+    pool.release(color);
+    pool.release(small);
+
+    CHECK_EQUAL(3u, pool.getStats().allocations);
+    CHECK_EQUAL(3u, pool.getStats().free);
+
+    Image* image = pool.acquire(320, 240, Image::PF_BGR_8);
+    CHECK_EQUAL(color, image);
+    pool.release(image);
+    image = pool.acquire(320, 240, Image::PF_GRAY_8);
+    CHECK_EQUAL(gray, image);
+    pool.release(image);
+    
+    CHECK_EQUAL(3u, pool.getStats().allocations);
+}
+
+TEST(MaxFree)
+{
+    ImagePool pool(2);
+    std::vector<Image*> images;
+    for (int i = 0; i < 4; ++i)
+        images.push_back(pool.acquire(64, 48));
+    for (int i = 0; i < 4; ++i)
+        pool.release(images[i]);
+
+    // The oldest two are dropped
+    ImagePool::Stats stats = pool.getStats();
+    CHECK_EQUAL(2u, stats.free);
+    CHECK_EQUAL(2u, stats.discards);
+    CHECK_EQUAL(images[3], pool.acquire(64, 48));
+    CHECK_EQUAL(images[2], pool.acquire(64, 48));
+    pool.release(images[2]);
+    pool.release(images[3]);
+
+    pool.clear();
+    CHECK_EQUAL(0u, pool.getStats().free);
+}
+
+TEST(Scoped)
+{
+    ImagePool pool;
+    Image* image = 0;
+    {
+        ImagePool::Scoped scoped(&pool, 64, 48, Image::PF_GRAY_8);
+        image = scoped.get();
+        CHECK_EQUAL(64u, scoped->getWidth());
+        CHECK_EQUAL(1u, pool.getStats().outstanding);
+    }
+    CHECK_EQUAL(0u, pool.getStats().outstanding);
+    
+    ImagePool::Scoped scoped(&pool, 64, 48, Image::PF_GRAY_8);
+    CHECK_EQUAL(image, scoped.get());
+}
+
+TEST(CameraSteadyState)
+{
+    ImageCamera camera(320, 240, 30);
+    OpenCVImage input(640, 480, Image::PF_BGR_8);
+    OpenCVImage output(320, 240, Image::PF_BGR_8);
+
+    // Resizing the first image fills the pool, later ones reuse it
+    ImagePool* pool = ImagePool::getDefault();
+    camera.newImage(&input);
+    ImagePool::Stats warm = pool->getStats();
+
+    for (int i = 0; i < 5; ++i)
+        camera.newImage(&input);
+    camera.getImage(&output);
+
+    ImagePool::Stats stats = pool->getStats();
+    CHECK_EQUAL(warm.allocations, stats.allocations);
+    CHECK_EQUAL(warm.acquires + 5, stats.acquires);
+    CHECK_EQUAL(0u, stats.outstanding);
+    CHECK_EQUAL(320u, output.getWidth());
+}
+
+} // SUITE(ImagePool)
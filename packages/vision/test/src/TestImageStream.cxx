@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestImageStream.cxx
+ */
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "vision/include/ImageStream.h"
+#include "vision/include/OpenCVImage.h"
+
+#include "vision/test/include/UnitTestChecks.h"
+#include "vision/test/include/Utility.h"
+
+using namespace ram::vision;
+
+SUITE(ImageStream) {
+
+TEST(Request)
+{
+    ImageStream::Request request;
+    request.width = 320;
+    request.height = 240;
+    request.codec = ImageStream::QUICKLZ;
+    request.quality = 80;
+
+    unsigned char buffer[ImageStream::REQUEST_SIZE];
+    ImageStream::packRequest(request, buffer);
+
+    // Sent in network byte order
+    CHECK_EQUAL('R', buffer[0]);
+    CHECK_EQUAL(320 >> 8, buffer[8]);
+    CHECK_EQUAL(320 & 0xFF, buffer[9]);
+
+    ImageStream::Request result;
+    CHECK(ImageStream::unpackRequest(buffer, result));
+    CHECK_EQUAL(320, result.width);
+    CHECK_EQUAL(240, result.height);
+    CHECK_EQUAL(ImageStream::QUICKLZ, result.codec);
+    CHECK_EQUAL(80, result.quality);
+
+    // Garbage is turned away
+    buffer[0] = 'X';
+    CHECK(!ImageStream::unpackRequest(buffer, result));
+}
+
+TEST(Header)
+{
+    ImageStream::FrameHeader header;
+    header.sequence = 0x01020304;
+    header.width = 640;
+    header.height = 480;
+    header.codec = ImageStream::RAW;
+    header.size = 640 * 480 * 3;
+
+    unsigned char buffer[ImageStream::HEADER_SIZE];
+    ImageStream::packHeader(header, buffer);
+
+    ImageStream::FrameHeader result;
+    CHECK(ImageStream::unpackHeader(buffer, result));
+    CHECK_EQUAL(0x01020304u, result.sequence);
+    CHECK_EQUAL(640, result.width);
+    CHECK_EQUAL(480, result.height);
+    CHECK_EQUAL(ImageStream::RAW, result.codec);
+    CHECK_EQUAL(640u * 480 * 3, result.size);
+
+    // Sizes no codec could produce are corrupt
+    header.size = 100 * 1000 * 1000;
+    ImageStream::packHeader(header, buffer);
+    CHECK(!ImageStream::unpackHeader(buffer, result));
+}
+
+TEST(RawRoundTrip)
+{
+    // Odd width so the rows are padded in memory
+    OpenCVImage image(161, 121, Image::PF_BGR_8);
+    makeColor(&image, 0, 0, 0);
+    drawSquare(&image, 80, 60, 40, 20, 0, CV_RGB(255, 128, 0));
+
+    ImageStream encoder;
+    const std::vector<unsigned char>& data =
+        encoder.encode(&image, ImageStream::RAW);
+    CHECK_EQUAL(161u * 121 * 3, data.size());
+
+    ImageStream::FrameHeader header;
+    header.width = 161;
+    header.height = 121;
+    header.codec = ImageStream::RAW;
+
+    ImageStream decoder;
+    Image* result = decoder.decode(header, data);
+    CHECK(result);
+    if (result)
+    {
+        Image* expected = &image;
+        CHECK_CLOSE(*expected, *result, 0);
+    }
+
+    // Short data is rejected
+    std::vector<unsigned char> shortData(data.begin(), data.end() - 1);
+    CHECK(!decoder.decode(header, shortData));
+}
+
+TEST(QuickLZRoundTrip)
+{
+    OpenCVImage image(640, 480, Image::PF_BGR_8);
+    makeColor(&image, 30, 60, 90);
+    drawSquare(&image, 320, 240, 100, 50, 0, CV_RGB(0, 255, 0));
+
+    ImageStream encoder;
+    std::vector<unsigned char> data =
+        encoder.encode(&image, ImageStream::QUICKLZ);
+    CHECK(data.size() < 640u * 480 * 3 / 10);
+
+    ImageStream::FrameHeader header;
+    header.width = 640;
+    header.height = 480;
+    header.codec = ImageStream::QUICKLZ;
+
+    ImageStream decoder;
+    Image* result = decoder.decode(header, data);
+    CHECK(result);
+    if (result)
+    {
+        Image* expected = &image;
+        CHECK_CLOSE(*expected, *result, 0);
+    }
+
+    // The wrong size is caught before decompressing
+    header.width = 320;
+    CHECK(!decoder.decode(header, data));
+}
+
+TEST(CorruptData)
+{
+    OpenCVImage image(64, 48, Image::PF_BGR_8);
+    makeColor(&image, 30, 60, 90);
+    drawSquare(&image, 32, 24, 10, 10, 0, CV_RGB(0, 255, 0));
+
+    ImageStream encoder;
+    std::vector<unsigned char> data =
+        encoder.encode(&image, ImageStream::QUICKLZ);
+
+    ImageStream::FrameHeader header;
+    header.width = 64;
+    header.height = 48;
+    header.codec = ImageStream::QUICKLZ;
+
+    // Scrambled data behind a good QuickLZ header is dropped, not decoded
+    // past the end of the buffers
+    for (size_t i = 9; i < data.size(); ++i)
+        data[i] = (unsigned char)(i * 37);
+    ImageStream decoder;
+    CHECK(!decoder.decode(header, data));
+
+    // Garbage is no JPEG either
+    header.codec = ImageStream::JPEG;
+    CHECK(!decoder.decode(header, data));
+
+    // Nothing to decode
+    header.width = 0;
+    header.codec = ImageStream::RAW;
+    CHECK(!decoder.decode(header, std::vector<unsigned char>()));
+}
+
+} // SUITE(ImageStream)
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestLCHConverter.cxx
+ */
+
+// STD Includes
+#include <vector>
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "vision/include/LCHConverter.h"
+#include "vision/include/OpenCVImage.h"
+
+using namespace ram;
+
+SUITE(LCHConverter) {
+
+TEST(ConvertImage)
+{
+    vision::OpenCVImage image(40, 30, vision::Image::PF_RGB_8);
+    unsigned char* data = image.getData();
+    size_t size = 40 * 30 * 3;
+    for (size_t i = 0; i < size; ++i)
+        data[i] = (unsigned char)((i * 37) % 256);
+
+    vision::OpenCVImage expected(40, 30, vision::Image::PF_RGB_8);
+    expected.copyFrom(&image);
+    unsigned char* expectedData = expected.getData();
+    for (size_t i = 0; i < size; i += 3)
+    {
+        vision::LCHConverter::convertPixel(
+            expectedData[i], expectedData[i + 1], expectedData[i + 2]);
+    }
+
+    image.setPixelFormat(vision::Image::PF_LCHUV_8);
+    CHECK_EQUAL(vision::Image::PF_LCHUV_8, image.getPixelFormat());
+    CHECK_ARRAY_EQUAL(expectedData, image.getData(), (int)size);
+}
+
+TEST(ConvertPixelsExact)
+{
+    // Every color, a slice of the cube with the same red value at a time
+    std::vector<unsigned char> pixels(256 * 256 * 3);
+    std::vector<unsigned char> expected(256 * 256 * 3);
+    int mismatches = 0;
+    for (int r = 0; r < 256; ++r)
+    {
+        for (int g = 0; g < 256; ++g)
+        {
+            for (int b = 0; b < 256; ++b)
+            {
+                size_t i = (g * 256 + b) * 3;
+                pixels[i] = r;
+                pixels[i + 1] = g;
+                pixels[i + 2] = b;
+            }
+        }
+        expected = pixels;
+        for (size_t i = 0; i < expected.size(); i += 3)
+        {
+            vision::LCHConverter::convertPixel(
+                expected[i], expected[i + 1], expected[i + 2]);
+        }
+
+        vision::LCHConverter::convertPixels(&pixels[0], 256 * 256);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            if (pixels[i] != expected[i])
+                ++mismatches;
+        }
+    }
+    CHECK_EQUAL(0, mismatches);
+}
+
+} // SUITE(LCHConverter)
@@ -4,7 +4,7 @@
  * All rights reserved.
  *
  * Author: Joseph Lisee <jlisee@umd.edu>
- * File:  packages/vision/test/src/TestFileRecorder.cxx
+ * File:  packages/vision/test/src/TestNetworkRecorder.cxx
  */
 
 // Not tested yet on windows or Mac, so just go for Linux
@@ -16,6 +16,7 @@
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
 #include <boost/foreach.hpp>
+#include <boost/asio.hpp>
 
 // Project Includes
 #include "vision/include/NetworkRecorder.h"
@@ -57,8 +58,7 @@ TEST_FIXTURE(RecorderFixture, CreateDestroy)
     vision::NetworkRecorder recorder(camera, vision::Recorder::NEXT_FRAME,
                                      TEST_PORT);
 }
-/* LOCKS UP! Some kind of race condition!
-TEST_FIXTURE(RecorderFixture, Update)
+TEST_FIXTURE(RecorderFixture, Stream)
 {
     camera->background(-1);
     vision::NetworkRecorder recorder(camera, vision::Recorder::NEXT_FRAME,
@@ -68,31 +68,33 @@ TEST_FIXTURE(RecorderFixture, Update)
     std::vector<vision::Image*> images;
     for (int i = 0; i < 20; ++i)
     {
-        vision::Image* image = new vision::OpenCVImage(640,480);
-        vision::makeColor(image, i * 20, 0, 0);
+        vision::Image* image =
+            new vision::OpenCVImage(640, 480, vision::Image::PF_BGR_8);
+        vision::makeColor(image, i * 10, 0, 0);
         images.push_back(image);
     }
 
-    // Wait for the network recorder to be ready for clients
-    recorder.waitForAccepting();
-    
-    // Create the network camera
+    // Create the network camera, lossless at full size
     vision::NetworkCamera*  networkCamera =
-        new vision::NetworkCamera("localhost", TEST_PORT);
+        new vision::NetworkCamera("localhost", TEST_PORT, 0, 0,
+                                  vision::ImageStream::RAW);
     
     // Record each image
-    vision::Image* actual = new vision::OpenCVImage(640, 480);
+    vision::Image* actual =
+        new vision::OpenCVImage(640, 480, vision::Image::PF_BGR_8);
     BOOST_FOREACH(vision::Image* image, images)
     {
         // Set our new image, and send it across the network
         camera->setNewImage(image);
         camera->update(0);
         
-        // Read the image back
+        // Read the image back, all over the same connection
         networkCamera->update(0);
         networkCamera->getImage(actual);
         CHECK_CLOSE(*image, *actual, 0);
+        CHECK_EQUAL(1u, recorder.getClientCount());
     }
+    CHECK_EQUAL(0u, networkCamera->droppedFrames());
 
     // Free Images
     BOOST_FOREACH(vision::Image* image, images)
@@ -106,7 +108,115 @@ TEST_FIXTURE(RecorderFixture, Update)
     // Shutdown the client before we shutdown the NetworkRecorder
     delete networkCamera;
 }
-*/
+
+TEST_FIXTURE(RecorderFixture, NegotiatedSizeAndCodec)
+{
+    camera->background(-1);
+    vision::NetworkRecorder recorder(camera, vision::Recorder::NEXT_FRAME,
+                                     TEST_PORT);
+
+    vision::OpenCVImage image(640, 480, vision::Image::PF_BGR_8);
+    vision::makeColor(&image, 0, 0, 0);
+    vision::drawSquare(&image, 320, 240, 200, 100, 0, CV_RGB(0, 255, 0));
+    
+    vision::NetworkCamera small("localhost", TEST_PORT, 320, 240,
+                                vision::ImageStream::QUICKLZ);
+    vision::NetworkCamera full("localhost", TEST_PORT, 0, 0,
+                               vision::ImageStream::QUICKLZ);
+
+    camera->setNewImage(&image);
+    camera->update(0);
+
+    vision::OpenCVImage expected(640, 480, vision::Image::PF_BGR_8);
+    expected.copyFrom(&image);
+    expected.setSize(320, 240);
+    
+    vision::OpenCVImage actual(640, 480, vision::Image::PF_BGR_8);
+    small.update(0);
+    small.getImage(&actual);
+    CHECK_EQUAL(320u, small.width());
+    CHECK_CLOSE(&expected, &actual, 0);
+
+    full.update(0);
+    full.getImage(&actual);
+    CHECK_EQUAL(640u, full.width());
+    CHECK_CLOSE(&image, &actual, 0);
+    
+    camera->unbackground();
+}
+
+TEST_FIXTURE(RecorderFixture, OversizedRequestRefused)
+{
+    vision::NetworkRecorder recorder(camera, vision::Recorder::NEXT_FRAME,
+                                     TEST_PORT);
+
+    namespace ba = boost::asio;
+    ba::io_service io;
+    ba::ip::tcp::socket socket(io);
+    socket.connect(ba::ip::tcp::endpoint(
+                       ba::ip::address::from_string("127.0.0.1"), TEST_PORT));
+
+    // Far bigger than the 640x480 the recorder records at
+    vision::ImageStream::Request request;
+    request.width = 60000;
+    request.height = 60000;
+    unsigned char buffer[vision::ImageStream::REQUEST_SIZE];
+    vision::ImageStream::packRequest(request, buffer);
+    ba::write(socket, ba::buffer(buffer));
+
+    // The recorder hangs up instead of sending frames
+    unsigned char header[vision::ImageStream::HEADER_SIZE];
+    boost::system::error_code error;
+    ba::read(socket, ba::buffer(header), error);
+    CHECK(error);
+    CHECK_EQUAL(0u, recorder.getClientCount());
+}
+
+TEST_FIXTURE(RecorderFixture, SlowClientSkipsFrames)
+{
+    camera->background(-1);
+    vision::NetworkRecorder recorder(camera, vision::Recorder::NEXT_FRAME,
+                                     TEST_PORT);
+    vision::NetworkCamera networkCamera("localhost", TEST_PORT, 0, 0,
+                                        vision::ImageStream::RAW);
+
+    vision::OpenCVImage image(640, 480, vision::Image::PF_BGR_8);
+    vision::OpenCVImage actual(640, 480, vision::Image::PF_BGR_8);
+
+    // Start the stream
+    vision::makeColor(&image, 0, 0, 0);
+    camera->setNewImage(&image);
+    camera->update(0);
+    networkCamera.update(0);
+
+    // Record far more than the socket can buffer without reading any
+    const int FRAMES = 40;
+    for (int i = 1; i <= FRAMES; ++i)
+    {
+        vision::makeColor(&image, i * 5, 0, 0);
+        camera->setNewImage(&image);
+        camera->update(0);
+        core::TimeVal::sleep(0.01);
+    }
+
+    // The newest frame comes through without reading all the stale ones
+    int reads = 0;
+    unsigned char red = 0;
+    while ((red != FRAMES * 5) && (reads < FRAMES))
+    {
+        networkCamera.update(0);
+        networkCamera.getImage(&actual);
+        red = actual.getData()[2];
+        reads++;
+    }
+
+    CHECK_EQUAL(FRAMES * 5, red);
+    CHECK(reads < FRAMES);
+    CHECK(networkCamera.droppedFrames() > 0);
+    
+    camera->unbackground();
+}
+
 } // SUITE(NetworkRecorder)
 
 #endif // RAM_LINUX
@@ -11,6 +11,7 @@
 #include <sstream>
 #include <string>
 #include <cstdio>
+#include <unistd.h>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
@@ -55,10 +56,36 @@ struct Fixture
 	    bf::remove(movieFile);
             
         delete camera;
+
+        BOOST_FOREACH(vision::Image* image, images)
+        {
+            delete image;
+        }
+    }
+
+    /** Records IMAGE_COUNT different images to the file */
+    void record(vision::ImageStream::Codec codec)
+    {
+        vision::RawFileRecorder recorder(camera, vision::Recorder::NEXT_FRAME,
+                                         filename, 0, 640, 480, codec);
+        recorder.unbackground(true);
+
+        for (int i = 0; i < IMAGE_COUNT; ++i)
+        {
+            vision::Image* image =
+                new vision::OpenCVImage(640, 480, vision::Image::PF_BGR_8);
+            vision::makeColor(image, i * 20 + 10, 0, 0);
+            images.push_back(image);
+
+            camera->setNewImage(image);
+            camera->update(0);
+            recorder.update(1.0/30);
+        }
     }
 
     MockCamera* camera;
     std::string filename;
+    std::vector<vision::Image*> images;
 };
     
 
@@ -86,6 +113,10 @@ TEST_FIXTURE(Fixture, Update)
         recorder.update(1.0/30);
     }
 
+    // Frames are written in the background
+    recorder.flush();
+    CHECK_EQUAL(0u, recorder.getWriterStats().droppedRecords);
+
     // Check Results
     vision::Image* actual = new vision::OpenCVImage(640, 480,
                                                     vision::Image::PF_BGR_8);
@@ -123,4 +154,111 @@ TEST_FIXTURE(Fixture, Update)
     
 }
 
+TEST_FIXTURE(Fixture, Compressed)
+{
+    record(vision::ImageStream::QUICKLZ);
+
+    // Flat images compress to almost nothing
+    CHECK(bf::file_size(filename) < IMAGE_COUNT * 640 * 480 * 3 / 10);
+
+    vision::RawFileCamera movieCamera(filename.c_str());
+    CHECK_EQUAL(30u, movieCamera.fps());
+    CHECK_EQUAL(640u, movieCamera.width());
+    CHECK_EQUAL(480u, movieCamera.height());
+    CHECK_EQUAL((size_t)IMAGE_COUNT, movieCamera.frameCount());
+
+    vision::OpenCVImage actualImage(640, 480, vision::Image::PF_BGR_8);
+    vision::Image& actual = actualImage;
+    double lastTime = -1;
+    BOOST_FOREACH(vision::Image* expected, images)
+    {
+        movieCamera.update(0);
+        movieCamera.getImage(&actual);
+        CHECK_CLOSE(*expected, actual, 0);
+
+        CHECK(movieCamera.currentTime() >= lastTime);
+        lastTime = movieCamera.currentTime();
+    }
+    CHECK(movieCamera.duration() > lastTime);
+}
+
+TEST_FIXTURE(Fixture, CompressedSeek)
+{
+    record(vision::ImageStream::QUICKLZ);
+
+    vision::RawFileCamera movieCamera(filename.c_str());
+    vision::OpenCVImage actualImage(640, 480, vision::Image::PF_BGR_8);
+    vision::Image& actual = actualImage;
+
+    movieCamera.seekTo(5);
+    movieCamera.update(0);
+    movieCamera.getImage(&actual);
+    CHECK_CLOSE(*images[5], actual, 0);
+
+    // Back to the start, the frame decoded ahead is thrown away
+    movieCamera.seekToTime(0);
+    movieCamera.update(0);
+    movieCamera.getImage(&actual);
+    CHECK_CLOSE(*images[0], actual, 0);
+    movieCamera.update(0);
+    movieCamera.getImage(&actual);
+    CHECK_CLOSE(*images[1], actual, 0);
+}
+
+TEST_FIXTURE(Fixture, CompressedWithoutIndex)
+{
+    record(vision::ImageStream::QUICKLZ);
+
+    // Cut off the index like a crash would
+    boost::uintmax_t size = bf::file_size(filename);
+    CHECK_EQUAL(0, truncate(filename.c_str(), size -
+                            sizeof(vision::RawFileRecorder::Trailer) - 1));
+
+    vision::RawFileCamera movieCamera(filename.c_str());
+    CHECK_EQUAL((size_t)IMAGE_COUNT, movieCamera.frameCount());
+
+    vision::OpenCVImage actualImage(640, 480, vision::Image::PF_BGR_8);
+    vision::Image& actual = actualImage;
+    movieCamera.seekTo(IMAGE_COUNT - 1);
+    movieCamera.update(0);
+    movieCamera.getImage(&actual);
+    CHECK_CLOSE(*images[IMAGE_COUNT - 1], actual, 0);
+}
+
+TEST_FIXTURE(Fixture, CompressedCorruptFrame)
+{
+    record(vision::ImageStream::QUICKLZ);
+
+    // Scramble the data of the fourth frame, past its QuickLZ header
+    FILE* file = fopen(filename.c_str(), "r+b");
+    CHECK(file);
+    fseek(file, sizeof(vision::RawFileRecorder::Header), SEEK_SET);
+    vision::RawFileRecorder::Packet packet;
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK_EQUAL(1u, fread(&packet, sizeof(packet), 1, file));
+        if (i < 3)
+            fseek(file, packet.dataSize, SEEK_CUR);
+    }
+    fseek(file, 9, SEEK_CUR);
+    std::vector<unsigned char> garbage(packet.dataSize - 9);
+    for (size_t i = 0; i < garbage.size(); ++i)
+        garbage[i] = (unsigned char)(i * 37);
+    fwrite(&garbage[0], 1, garbage.size(), file);
+    fclose(file);
+
+    vision::RawFileCamera movieCamera(filename.c_str());
+    vision::OpenCVImage actualImage(640, 480, vision::Image::PF_BGR_8);
+    vision::Image& actual = actualImage;
+
+    // The corrupt frame repeats the one before it
+    for (int i = 0; i < 5; ++i)
+    {
+        movieCamera.update(0);
+        movieCamera.getImage(&actual);
+        CHECK_CLOSE(*images[(3 == i) ? 2 : i], actual, 0);
+    }
+    CHECK_EQUAL(1u, movieCamera.corruptFrames());
+}
+
 } // SUITE(RawFileRecorder)
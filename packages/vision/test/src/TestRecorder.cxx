@@ -8,16 +8,20 @@
  */
 
 #include <iostream>
+#include <sstream>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
 #include <boost/foreach.hpp>
+#include <boost/filesystem.hpp>
 
 // Project Includes
 #include "vision/test/include/MockRecorder.h"
 #include "vision/test/include/MockCamera.h"
 #include "vision/include/OpenCVImage.h"
 #include "vision/include/NetworkRecorder.h"
+#include "vision/include/RawFileRecorder.h"
+#include "vision/include/Frame.h"
 
 #include "vision/test/include/MockCamera.h"
 #include "vision/test/include/UnitTestChecks.h"
@@ -111,6 +115,32 @@ TEST_FIXTURE(RecorderFixture, Update_MAX_RATE)
     }
 }
 
+TEST_FIXTURE(RecorderFixture, DroppedFrames)
+{
+    MockRecorder recorder(camera, vision::Recorder::NEXT_FRAME);
+    vision::OpenCVImage image(640, 480);
+    camera->setNewImage(&image);
+
+    camera->update(0);
+    recorder.update(1.0/30);
+    CHECK_EQUAL(1u, recorder.imageCRCs.size());
+    CHECK_EQUAL(0u, recorder.getDroppedFrames());
+
+    // Only the newest of these gets recorded
+    for (int i = 0; i < 3; ++i)
+        camera->update(0);
+    recorder.update(1.0/30);
+    CHECK_EQUAL(2u, recorder.imageCRCs.size());
+    CHECK_EQUAL(2u, recorder.getDroppedFrames());
+
+    // Nothing new, so nothing recorded
+    recorder.update(1.0/30);
+    CHECK_EQUAL(2u, recorder.imageCRCs.size());
+
+    // Recorded straight from the camera's frame
+    CHECK_EQUAL(camera->getFrame()->getImage(), recorder.lastRecordedFrame);
+}
+
 TEST_FIXTURE(RecorderFixture, createFromString)
 {
     MockCamera camera;
@@ -134,5 +164,41 @@ TEST_FIXTURE(RecorderFixture, createFromString)
     delete recorder;
 }
 
+TEST_FIXTURE(RecorderFixture, createFromStringOptions)
+{
+    std::stringstream ss;
+    ss << "RecorderOptionsTest_" << vision::getPid() << ".rmv";
+    std::string filename(ss.str());
+
+    std::string message;
+    vision::Recorder* recorder = vision::Recorder::createRecorderFromString(
+        filename + "(320, 240, preallocate=1, drop=block)", camera, message,
+        vision::Recorder::MAX_RATE, 5);
+
+    CHECK(dynamic_cast<vision::RawFileRecorder*>(recorder));
+    CHECK_EQUAL(320u, recorder->getRecordingWidth());
+    CHECK_EQUAL(240u, recorder->getRecordingHeight());
+    CHECK(std::string::npos !=
+          message.find("options: preallocate=1 drop=block"));
+    delete recorder;
+    boost::filesystem::remove(boost::filesystem::path(filename));
+
+    // Bad options don't make a recorder
+    recorder = vision::Recorder::createRecorderFromString(
+        filename + "(drop=sometimes)", camera, message,
+        vision::Recorder::MAX_RATE, 5);
+    CHECK(0 == recorder);
+    CHECK(!boost::filesystem::exists(boost::filesystem::path(filename)));
+
+    const char* badSizes[] = {"abc", "-1", "", "99999999999999999999999"};
+    for (size_t i = 0; i < sizeof(badSizes) / sizeof(badSizes[0]); ++i)
+    {
+        recorder = vision::Recorder::createRecorderFromString(
+            filename + "(preallocate=" + badSizes[i] + ")", camera, message,
+            vision::Recorder::MAX_RATE, 5);
+        CHECK(0 == recorder);
+        CHECK(!boost::filesystem::exists(boost::filesystem::path(filename)));
+    }
+}
 
 } // SUITE(Recorder)
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2010 Robotics at Maryland
+ * All rights reserved.
+ *
+ * File:  packages/vision/test/src/TestTrackingWindow.cxx
+ */
+
+// Library Includes
+#include <UnitTest++/UnitTest++.h>
+
+// Project Includes
+#include "vision/include/TrackingWindow.h"
+#include "vision/include/OpenCVImage.h"
+#include "vision/test/include/Utility.h"
+
+using namespace ram;
+using namespace ram::vision;
+
+/** A blob covering the given inclusive bounds */
+static BlobDetector::Blob makeBlob(int minX, int maxX, int minY, int maxY)
+{
+    return BlobDetector::Blob((maxX - minX + 1) * (maxY - minY + 1),
+                              (minX + maxX) / 2, (minY + maxY) / 2,
+                              maxX, minX, maxY, minY);
+}
+
+SUITE(TrackingWindow) {
+
+TEST(DisabledByDefault)
+{
+    TrackingWindow window;
+    window.found(makeBlob(300, 339, 200, 239));
+
+    CHECK(!window.beginFrame(640, 480));
+    CHECK_EQUAL(640, window.getRegion().width());
+    CHECK_EQUAL(480, window.getRegion().height());
+}
+
+TEST(FullSearchUntilFound)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+
+    CHECK(!window.beginFrame(640, 480));
+    window.lost();
+    CHECK(!window.beginFrame(640, 480));
+
+    window.found(makeBlob(300, 339, 200, 239));
+    CHECK(window.isTracking());
+    CHECK(window.beginFrame(640, 480));
+
+    // Margin of half the 40 pixel size on each side
+    RegionOfInterest region = window.getRegion();
+    CHECK_EQUAL(280, region.minX());
+    CHECK_EQUAL(360, region.maxX());
+    CHECK_EQUAL(180, region.minY());
+    CHECK_EQUAL(260, region.maxY());
+
+    CHECK_EQUAL(2u, window.getFullFrames());
+    CHECK_EQUAL(1u, window.getWindowedFrames());
+}
+
+TEST(FollowsVelocity)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+
+    window.beginFrame(640, 480);
+    window.found(makeBlob(300, 339, 200, 239));
+    window.beginFrame(640, 480);
+    window.found(makeBlob(310, 349, 205, 244));
+
+    // Shifted by the motion and grown by its size
+    CHECK(window.beginFrame(640, 480));
+    RegionOfInterest region = window.getRegion();
+    CHECK_EQUAL(320 - 30, region.minX());
+    CHECK_EQUAL(360 + 30, region.maxX());
+    CHECK_EQUAL(210 - 25, region.minY());
+    CHECK_EQUAL(250 + 25, region.maxY());
+}
+
+TEST(ClippedToFrame)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+
+    window.beginFrame(640, 480);
+    window.found(makeBlob(0, 39, 450, 479));
+    CHECK(window.beginFrame(640, 480));
+
+    RegionOfInterest region = window.getRegion();
+    CHECK_EQUAL(0, region.minX());
+    CHECK_EQUAL(480, region.maxY());
+}
+
+TEST(PeriodicFullSearch)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+
+    CHECK(!window.beginFrame(640, 480));
+    window.found(makeBlob(300, 339, 200, 239));
+    for (int i = 0; i < 15; ++i)
+    {
+        CHECK(window.beginFrame(640, 480));
+        window.found(makeBlob(300, 339, 200, 239));
+    }
+
+    CHECK(!window.beginFrame(640, 480));
+    window.found(makeBlob(300, 339, 200, 239));
+    CHECK(window.beginFrame(640, 480));
+}
+
+TEST(LostSearchesEverything)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+
+    window.beginFrame(640, 480);
+    window.found(makeBlob(300, 339, 200, 239));
+    CHECK(window.beginFrame(640, 480));
+    window.lost();
+
+    CHECK(!window.isTracking());
+    CHECK(!window.beginFrame(640, 480));
+}
+
+TEST(PyramidLevel)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+    window.setMaxLevel(3);
+
+    // Small targets are never shrunk below 32 pixels
+    window.beginFrame(640, 480);
+    window.found(makeBlob(300, 339, 200, 239));
+    window.beginFrame(640, 480);
+    CHECK_EQUAL(0, window.getLevel());
+
+    window.found(makeBlob(200, 329, 100, 229));
+    window.beginFrame(640, 480);
+    CHECK_EQUAL(2, window.getLevel());
+
+    // The full frame is always at full resolution
+    window.lost();
+    window.beginFrame(640, 480);
+    CHECK_EQUAL(0, window.getLevel());
+}
+
+TEST(ToFrame)
+{
+    TrackingWindow window;
+    window.setEnabled(true);
+    window.setMaxLevel(1);
+
+    window.beginFrame(640, 480);
+    window.found(makeBlob(200, 279, 100, 179));
+    CHECK(window.beginFrame(640, 480));
+    CHECK_EQUAL(1, window.getLevel());
+
+    RegionOfInterest region = window.getRegion();
+    BlobDetector::Blob blob =
+        window.toFrame(BlobDetector::Blob(100, 10, 10, 14, 5, 14, 5));
+
+    CHECK_EQUAL(400, blob.getSize());
+    CHECK_EQUAL(region.minX() + 10, blob.getMinX());
+    CHECK_EQUAL(region.minX() + 29, blob.getMaxX());
+    CHECK_EQUAL(region.minY() + 10, blob.getMinY());
+    CHECK_EQUAL(region.minY() + 29, blob.getMaxY());
+    CHECK_EQUAL(region.minX() + 21, blob.getCenterX());
+
+    // Areas shrink by four per level
+    CHECK_EQUAL(100, window.toWindowArea(400));
+}
+
+TEST(Extract)
+{
+    OpenCVImage frame(640, 480, Image::PF_BGR_8);
+    makeColor(&frame, 0, 0, 0);
+    drawSquare(&frame, 320, 240, 40, 40, 0, CV_RGB(255, 0, 0));
+
+    TrackingWindow window;
+    window.setEnabled(true);
+    window.beginFrame(640, 480);
+    window.found(makeBlob(300, 339, 220, 259));
+    CHECK(window.beginFrame(640, 480));
+
+    RegionOfInterest region = window.getRegion();
+    Image* bgr = window.extract(&frame);
+    CHECK_EQUAL((size_t)region.width(), bgr->getWidth());
+    CHECK_EQUAL((size_t)region.height(), bgr->getHeight());
+
+    // Same pixels as the frame at the offset
+    unsigned char* pixel = bgr->getData() +
+        ((240 - region.minY()) * bgr->getWidth() + (320 - region.minX())) * 3;
+    CHECK_EQUAL(0, pixel[0]);
+    CHECK_EQUAL(0, pixel[1]);
+    CHECK_EQUAL(255, pixel[2]);
+
+    Image* rgb = window.extract(&frame, Image::PF_RGB_8);
+    CHECK_EQUAL(Image::PF_RGB_8, rgb->getPixelFormat());
+    pixel = rgb->getData() +
+        ((240 - region.minY()) * rgb->getWidth() + (320 - region.minX())) * 3;
+    CHECK_EQUAL(255, pixel[0]);
+    CHECK_EQUAL(0, pixel[2]);
+
+    // Pasting back lines up with the original
+    OpenCVImage output(640, 480, Image::PF_BGR_8);
+    window.paste(window.extract(&frame), &output);
+    CHECK_EQUAL(255, output.getData()[(240 * 640 + 320) * 3 + 2]);
+    CHECK_EQUAL(0, output.getData()[(10 * 640 + 10) * 3 + 2]);
+
+    // Switching formats back and forth keeps the same images
+    CHECK_EQUAL(rgb, window.extract(&frame, Image::PF_RGB_8));
+    CHECK_EQUAL(bgr, window.extract(&frame));
+}
+
+} // SUITE(TrackingWindow)
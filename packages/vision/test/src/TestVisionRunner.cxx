@@ -10,13 +10,17 @@
 // System Includes
 //#include <unistd.h>
 #include <iostream>
+#include <algorithm>
 
 // Library Includes
 #include <UnitTest++/UnitTest++.h>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
 
 // Project Includes
 #include "vision/include/VisionRunner.h"
 #include "vision/include/OpenCVImage.h"
+#include "vision/include/Events.h"
 
 #include "vision/test/include/MockCamera.h"
 #include "vision/test/include/MockDetector.h"
@@ -27,6 +31,50 @@
 
 using namespace ram;
 
+/** Counts how many detectors are processing an image at once */
+struct Concurrency
+{
+    Concurrency() : running(0), peak(0) {}
+
+    void begin()
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        running++;
+        peak = std::max(peak, running);
+    }
+
+    void end()
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        running--;
+    }
+
+    boost::mutex mutex;
+    int running;
+    int peak;
+};
+
+/** Takes a fixed amount of time on each image */
+class SleepDetector : public vision::Detector
+{
+public:
+    SleepDetector(double seconds, Concurrency* concurrency = 0) :
+        m_seconds(seconds), m_concurrency(concurrency) {}
+
+    virtual void processImage(vision::Image*, vision::Image* = 0)
+    {
+        if (m_concurrency)
+            m_concurrency->begin();
+        core::TimeVal::sleep(m_seconds);
+        if (m_concurrency)
+            m_concurrency->end();
+    }
+
+private:
+    double m_seconds;
+    Concurrency* m_concurrency;
+};
+
 SUITE(VisionRunner) {
 
 struct VisionRunnerFixture
@@ -104,6 +152,54 @@ TEST_FIXTURE(VisionRunnerFixture, Update)
 
     camera->unbackground(true);
 }
+
+struct TimingFixture : public VisionRunnerFixture
+{
+    void timingHandler(core::EventPtr event)
+    {
+        events.push_back(
+            boost::dynamic_pointer_cast<vision::DetectorTimingEvent>(event));
+    }
+
+    std::vector<vision::DetectorTimingEventPtr> events;
+};
+
+TEST_FIXTURE(TimingFixture, ParallelDetectors)
+{
+    vision::VisionRunner runner(camera, vision::Recorder::NEXT_FRAME, 0, 2);
+    CHECK_EQUAL(2u, runner.getThreadCount());
+    runner.subscribe(vision::VisionRunner::DETECTOR_TIMING,
+                     boost::bind(&TimingFixture::timingHandler, this, _1));
+
+    Concurrency concurrency;
+    runner.addDetector(
+        vision::DetectorPtr(new SleepDetector(0.1, &concurrency)));
+    runner.addDetector(
+        vision::DetectorPtr(new SleepDetector(0.1, &concurrency)));
+    runner.unbackground(true);
+
+    // Both detectors work on each frame at the same time, and the timing is
+    // published after a second
+    int frames = 0;
+    while (events.empty() && (frames < 20))
+    {
+        camera->update(0);
+        runner.update(1.0/20);
+        frames++;
+    }
+    CHECK_EQUAL(2, concurrency.peak);
+    CHECK_EQUAL(0, concurrency.running);
+
+    CHECK_EQUAL(2u, events.size());
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        CHECK_EQUAL("SleepDetector", events[i]->detector);
+        CHECK_EQUAL(frames, events[i]->frames);
+        CHECK_EQUAL(0, events[i]->droppedFrames);
+        CHECK_CLOSE(0.1, events[i]->meanTime, 0.02);
+        CHECK(events[i]->minTime <= events[i]->maxTime);
+    }
+}
 #endif
   
 } // SUITE(VisionRunner)
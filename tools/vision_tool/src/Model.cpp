@@ -90,7 +90,7 @@ void Model::openFile(std::string filename)
 
     std::string extension = bfs::path(filename).extension();
 
-    if (".rmv" == extension)
+    if ((".rmv" == extension) || (".rmvz" == extension))
         m_camera = new vision::RawFileCamera(filename);
     else
         m_camera = new vision::OpenCVCamera(filename);
@@ -37,6 +37,11 @@ def expose_publisher(local_ns, cls_name):
     ePublisher.add_registration_code(
         'def("subscribe", &::%s_pysubscribe)' % (cls_name),
         works_on_instance = True )
+    # The overload taking an Event::TypeId only saves C++ code a lookup
+    ePublisher.member_functions(
+        function = lambda f: f.name == 'publish' and 3 == len(f.arguments),
+        allow_empty = True).exclude()
+    
     ePublisher.include_files.append('wrappers/core/include/EventFunctor.h')
     ePublisher.include_files.append('core/include/EventConnection.h')
     return ePublisher
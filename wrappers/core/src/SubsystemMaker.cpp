@@ -18,6 +18,7 @@
 // Project Includes
 #include "core/include/SubsystemMaker.h"
 #include "core/include/SubsystemConverter.h"
+#include "core/include/GILock.h"
 
 namespace bp = boost::python;
 
@@ -36,6 +37,9 @@ struct SubsystemMakerWrapper : ram::core::SubsystemMaker,
     virtual ram::core::SubsystemPtr makeObject(
         ram::core::SubsystemMakerParamType params)
     {
+        // The Application may build subsystems from its startup threads
+        ram::core::ScopedGILock gil;
+        
         bp::override func_makeObject = this->get_override( "makeObject" );
         bp::list deps;
 
@@ -48,7 +52,13 @@ struct SubsystemMakerWrapper : ram::core::SubsystemMaker,
                 ram::core::SubsystemConverter::convertObject(subsystem));
         }
         
-        return func_makeObject(params.first, deps);
+        try {
+            return func_makeObject(params.first, deps);
+        } catch(bp::error_already_set err) {
+            // The error is lost once this thread gives up the GIL
+            PyErr_Print();
+            throw;
+        }
     }
 
     static boost::python::object newObject(